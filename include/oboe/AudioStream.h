@@ -25,6 +25,7 @@
 #include "oboe/ResultWithValue.h"
 #include "oboe/AudioStreamBuilder.h"
 #include "oboe/AudioStreamBase.h"
+#include "oboe/CallbackStatistics.h"
 
 /** WARNING - UNDER CONSTRUCTION - THIS API WILL CHANGE. */
 
@@ -544,6 +545,44 @@ public:
         return mPerformanceHintEnabled;
     }
 
+    /**
+     * Histograms of the timing of the data callbacks. They are only recorded if
+     * AudioStreamBuilder::setCallbackStatisticsEnabled() was called.
+     * They can be read from any thread while the stream is running.
+     *
+     * If Oboe converts the data then these describe the callbacks from the underlying stream,
+     * which include the conversion.
+     *
+     * @return the statistics for this stream
+     */
+    virtual const CallbackStatistics &getCallbackStatistics() const {
+        return mCallbackStatistics;
+    }
+
+    /**
+     * Clear the callback statistics, for example after a change of workload.
+     * This can be called from any thread.
+     */
+    virtual void resetCallbackStatistics() {
+        mCallbackStatistics.reset();
+    }
+
+    /**
+     * Change the quality of the sample rate converter in Oboe while the stream is running.
+     * The new converter is built on the calling thread and crossfaded in by the audio thread.
+     * Do not call this from the data callback or from more than one thread at a time.
+     *
+     * This only works if AudioStreamBuilder::setLiveReconfigurationEnabled() was set and
+     * Oboe converts the sample rate of this stream.
+     *
+     * @param quality of the new converter, not SampleRateConversionQuality::None
+     * @return OK, ErrorIllegalArgument for None, or ErrorInvalidState if the
+     *     quality cannot be changed
+     */
+    virtual Result setSampleRateConversionQuality(SampleRateConversionQuality /* quality */) {
+        return Result::ErrorInvalidState;
+    }
+
 protected:
 
     /**
@@ -694,6 +733,8 @@ private:
     std::atomic<bool>    mErrorCallbackCalled{false};
 
     std::atomic<bool>    mPerformanceHintEnabled{false}; // set only by app
+
+    CallbackStatistics   mCallbackStatistics;
 };
 
 /**
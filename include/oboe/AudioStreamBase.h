@@ -213,6 +213,35 @@ public:
         return mSampleRateConversionQuality;
     }
 
+    /**
+     * @return true if the sample rate conversion quality can be changed while the stream runs
+     */
+    bool isLiveReconfigurationEnabled() const {
+        return mLiveReconfigurationEnabled;
+    }
+
+    /**
+     * @return number of frames processed by each pass through the conversion flowgraph,
+     *     or kUnspecified if Oboe chooses the size
+     */
+    int32_t getFlowGraphBlockSize() const {
+        return mFlowGraphBlockSize;
+    }
+
+    /**
+     * @return true if subnormal floats are flushed to zero during the data callback
+     */
+    bool isDenormalProtectionEnabled() const {
+        return mDenormalProtectionEnabled;
+    }
+
+    /**
+     * @return true if the timing of the data callbacks is recorded
+     */
+    bool isCallbackStatisticsEnabled() const {
+        return mCallbackStatisticsEnabled;
+    }
+
     /**
      * @return the stream's channel mask.
      */
@@ -308,6 +337,14 @@ protected:
     bool                            mFormatConversionAllowed = false;
     // Control whether and how Oboe can convert sample rates to achieve optimal results.
     SampleRateConversionQuality     mSampleRateConversionQuality = SampleRateConversionQuality::None;
+    // Allow AudioStream::setSampleRateConversionQuality() on a running stream.
+    bool                            mLiveReconfigurationEnabled = false;
+    // Frames per pass through the conversion flowgraph. Chosen by Oboe if kUnspecified.
+    int32_t                         mFlowGraphBlockSize = kUnspecified;
+    // Flush subnormal floats to zero during the data callback.
+    bool                            mDenormalProtectionEnabled = false;
+    // Record the timing of the data callbacks in histograms.
+    bool                            mCallbackStatisticsEnabled = false;
 
     /** Validate stream parameters that might not be checked in lower layers */
     virtual Result isValidConfig() {
@@ -324,6 +361,10 @@ protected:
                 return Result::ErrorInvalidFormat;
         }
 
+        if (mFlowGraphBlockSize != kUnspecified && mFlowGraphBlockSize <= 0) {
+            return Result::ErrorIllegalArgument;
+        }
+
         switch (mSampleRateConversionQuality) {
             case SampleRateConversionQuality::None:
             case SampleRateConversionQuality::Fastest:
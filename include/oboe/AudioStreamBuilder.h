@@ -563,6 +563,67 @@ public:
         return this;
     }
 
+    /**
+     * If true, and Oboe converts the sample rate, then the quality of the converter can be
+     * changed while the stream is running with AudioStream::setSampleRateConversionQuality().
+     * The new converter is crossfaded in so there is no need to reopen the stream.
+     * This costs an extra copy of the data in each callback.
+     *
+     * Default is false.
+     */
+    AudioStreamBuilder *setLiveReconfigurationEnabled(bool enabled) {
+        mLiveReconfigurationEnabled = enabled;
+        return this;
+    }
+
+    /**
+     * Specify how many frames are processed by each pass through the flowgraph that Oboe uses
+     * for format, channel count or sample rate conversion.
+     * Larger blocks reduce the overhead per frame but use more cache.
+     *
+     * This has no effect if Oboe does not need to convert the data.
+     *
+     * Default is kUnspecified, which lets Oboe choose a size based on
+     * the burst size and the channel count.
+     *
+     * @param frames number of frames per block or kUnspecified
+     */
+    AudioStreamBuilder *setFlowGraphBlockSize(int32_t frames) {
+        mFlowGraphBlockSize = frames;
+        return this;
+    }
+
+    /**
+     * If true then the CPU treats subnormal floats as zero while the data callback runs.
+     * The previous floating point mode of the callback thread is restored afterwards.
+     *
+     * Filters with feedback, echoes and decaying envelopes produce subnormal values
+     * as the signal fades to silence. On many CPUs those are 10 to 100 times slower,
+     * which can cause glitches in a callback that was fast while the sound was playing.
+     * Enable this if your callback does that kind of processing in floating point.
+     *
+     * This has no effect on CPUs other than x86 and ARM,
+     * or for streams that are read or written without a callback.
+     *
+     * Default is false.
+     */
+    AudioStreamBuilder *setDenormalProtectionEnabled(bool enabled) {
+        mDenormalProtectionEnabled = enabled;
+        return this;
+    }
+
+    /**
+     * If true then the stream records the interval, duration, size and lateness of
+     * each data callback in histograms. Read them with AudioStream::getCallbackStatistics().
+     * This does not change the callback. It costs two clock reads per callback.
+     *
+     * Default is false.
+     */
+    AudioStreamBuilder *setCallbackStatisticsEnabled(bool enabled) {
+        mCallbackStatisticsEnabled = enabled;
+        return this;
+    }
+
     /**
     * Declare the name of the package creating the stream.
     *
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OBOE_CALLBACK_STATISTICS_H
+#define OBOE_CALLBACK_STATISTICS_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace oboe {
+
+/**
+ * A histogram of non-negative integer values with fixed buckets.
+ *
+ * Values below 16 have their own bucket. Above that each power of two is split into
+ * 16 buckets, so a bucket is at most 1/16 of its lower bound wide.
+ * Values of 2^37 or more go into the last bucket.
+ *
+ * record() and reset() must only be called by one thread. record() is wait-free and
+ * does not allocate. The getters can be called from any thread at any time.
+ * A reader that runs at the same time as record() may miss the latest value.
+ */
+class Histogram {
+public:
+    static constexpr int32_t kSubBucketBits = 4;
+    static constexpr int32_t kSubBucketCount = 1 << kSubBucketBits;
+    static constexpr int32_t kMaxExponent = 36;
+    static constexpr int32_t kNumBuckets = (kMaxExponent - kSubBucketBits + 2) * kSubBucketCount;
+
+    Histogram() = default;
+
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+
+    /**
+     * Add a value. Negative values are recorded as zero.
+     * This must only be called by one thread.
+     */
+    void record(int64_t value);
+
+    /**
+     * Clear the histogram. Like record(), this must only be called by the recording thread,
+     * or while nothing is recording.
+     */
+    void reset();
+
+    /**
+     * @return number of values recorded
+     */
+    int64_t getCount() const;
+
+    /**
+     * @return largest value recorded, or 0 if none
+     */
+    int64_t getMaximum() const {
+        return mMaximum.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Estimate a percentile, for example 50 for the median or 99.9.
+     * The result is the upper bound of the bucket that contains the percentile, limited by
+     * the maximum. So it is never less than the value that was recorded.
+     *
+     * @param percent from 0 to 100
+     * @return the percentile, or 0 if no values were recorded
+     */
+    int64_t getPercentile(double percent) const;
+
+    /**
+     * @return number of values in a bucket
+     */
+    int64_t getBucketCount(int32_t index) const {
+        return mBuckets[index].load(std::memory_order_relaxed);
+    }
+
+    static int32_t getBucketIndex(int64_t value);
+
+    /**
+     * @return smallest value in a bucket
+     */
+    static int64_t getBucketLowerBound(int32_t index);
+
+    /**
+     * @return largest value in a bucket
+     */
+    static int64_t getBucketUpperBound(int32_t index);
+
+private:
+    std::atomic<int64_t> mBuckets[kNumBuckets] = {};
+    std::atomic<int64_t> mMaximum{0};
+};
+
+/**
+ * Timing of the data callbacks of a stream.
+ * See AudioStreamBuilder::setCallbackStatisticsEnabled().
+ *
+ * The histograms can be read from any thread while the stream is running.
+ * For example, an app could log getDurationNanos().getPercentile(99.9) once a minute.
+ */
+class CallbackStatistics {
+public:
+    /**
+     * @return time from the start of one callback to the start of the next
+     */
+    const Histogram &getIntervalNanos() const { return mIntervalNanos; }
+
+    /**
+     * @return time spent in the callback, including any data conversion by Oboe
+     */
+    const Histogram &getDurationNanos() const { return mDurationNanos; }
+
+    /**
+     * @return numFrames passed to each callback
+     */
+    const Histogram &getFramesPerCallback() const { return mFramesPerCallback; }
+
+    /**
+     * How late each callback started compared with an ideal schedule that advances
+     * by the duration of the frames of each callback.
+     *
+     * The schedule is moved to any callback that comes early, so it follows the earliest
+     * callbacks. It also moves by 1/1024 of each lateness, so a small difference between
+     * the audio clock and CLOCK_MONOTONIC does not build up.
+     *
+     * @return lateness of each callback except the first
+     */
+    const Histogram &getLatenessNanos() const { return mLatenessNanos; }
+
+    /**
+     * Clear all of the histograms. This can be called from any thread.
+     * They are cleared at the start of the next callback.
+     */
+    void reset();
+
+    /**
+     * Called by the stream after each callback.
+     *
+     * @param beginNanos CLOCK_MONOTONIC time before the callback
+     * @param endNanos CLOCK_MONOTONIC time after the callback
+     */
+    void recordCallback(int64_t beginNanos, int64_t endNanos, int32_t numFrames,
+                        int32_t sampleRate);
+
+private:
+    // A longer gap is treated as a restart of the stream.
+    static constexpr int64_t kRestartGapNanos = 1000 * 1000 * 1000;
+    static constexpr int     kDriftShift = 10;
+
+    Histogram mIntervalNanos;
+    Histogram mDurationNanos;
+    Histogram mFramesPerCallback;
+    Histogram mLatenessNanos;
+
+    // Only used by the callback thread.
+    int64_t mPreviousBeginNanos = -1;
+    double  mIdealBeginNanos = 0.0;
+    std::atomic<bool> mResetRequested{false};
+};
+
+} // namespace oboe
+
+#endif //OBOE_CALLBACK_STATISTICS_H
@@ -26,15 +26,24 @@
 
 namespace oboe {
 
+class FifoControllerSpsc;
+
 class FifoBuffer {
 public:
 	/**
 	 * Construct a `FifoBuffer`.
 	 *
+	 * If singleProducerSingleConsumer is true then a faster implementation is used.
+	 * In that case only one thread may call write() and only one other thread may call
+	 * read() or readNow(). The counters can be read from any thread.
+	 * A capacity that is a power of two is a little faster.
+	 *
 	 * @param bytesPerFrame amount of bytes for one frame
 	 * @param capacityInFrames the capacity of frames in fifo
+	 * @param singleProducerSingleConsumer true if there is one writer thread and one reader thread
 	 */
-    FifoBuffer(uint32_t bytesPerFrame, uint32_t capacityInFrames);
+    FifoBuffer(uint32_t bytesPerFrame, uint32_t capacityInFrames,
+               bool singleProducerSingleConsumer = false);
 
 	/**
 	 * Construct a `FifoBuffer`.
@@ -79,6 +88,53 @@ public:
 	 */
     int32_t write(const void *source, int32_t framesToWrite);
 
+    /**
+     * Up to two contiguous parts of the FIFO storage.
+     * The second part is only used when the region wraps around the end of the storage.
+     */
+    struct Regions {
+        uint8_t *data[2] = {nullptr, nullptr};
+        int32_t  numFrames[2] = {0, 0};
+
+        int32_t getNumFrames() const {
+            return numFrames[0] + numFrames[1];
+        }
+    };
+
+    /**
+     * Get the empty part of the FIFO so the writer can render or convert directly into it.
+     * Nothing is visible to the reader until commitWrite() is called.
+     * Only call this from the writer thread.
+     *
+     * @param numFrames maximum number of frames wanted
+     * @return up to numFrames frames of empty storage, may be fewer if the FIFO is nearly full
+     */
+    Regions acquireWriteRegions(int32_t numFrames);
+
+    /**
+     * Make frames written into the regions from acquireWriteRegions() available to the reader.
+     *
+     * @param numFrames number of frames written, not more than were acquired
+     */
+    void commitWrite(int32_t numFrames);
+
+    /**
+     * Get the full part of the FIFO so the reader can process the data in place.
+     * The storage is not reused by the writer until commitRead() is called.
+     * Only call this from the reader thread.
+     *
+     * @param numFrames maximum number of frames wanted
+     * @return up to numFrames frames of data, may be fewer if the FIFO is nearly empty
+     */
+    Regions acquireReadRegions(int32_t numFrames);
+
+    /**
+     * Release frames from the regions returned by acquireReadRegions() back to the writer.
+     *
+     * @param numFrames number of frames consumed, not more than were acquired
+     */
+    void commitRead(int32_t numFrames);
+
 	/**
 	 * Get the buffer capacity in frames.
 	 *
@@ -101,9 +157,7 @@ public:
 	 *
 	 * @return number of frames actually in the buffer
 	 */
-    uint32_t getFullFramesAvailable() {
-        return mFifo->getFullFramesAvailable();
-    }
+    uint32_t getFullFramesAvailable();
 
 	/**
 	 * Get the amount of bytes per frame.
@@ -119,42 +173,44 @@ public:
 	 *
 	 * @return position of read counter
 	 */
-    uint64_t getReadCounter() const {
-        return mFifo->getReadCounter();
-    }
+    uint64_t getReadCounter() const;
 
 	/**
 	 * Set the position of read counter.
 	 *
 	 * @param n position of read counter
 	 */
-    void setReadCounter(uint64_t n) {
-        mFifo->setReadCounter(n);
-    }
+    void setReadCounter(uint64_t n);
 
 	/**
 	 * Get the position of write counter.
 	 *
 	 * @return position of write counter
 	 */
-    uint64_t getWriteCounter() {
-        return mFifo->getWriteCounter();
-    }
+    uint64_t getWriteCounter();
 
     /**
 	 * Set the position of write counter.
 	 *
 	 * @param n position of write counter
 	 */
-    void setWriteCounter(uint64_t n) {
-        mFifo->setWriteCounter(n);
-    }
+    void setWriteCounter(uint64_t n);
 
 private:
+    // These are templates so that FifoControllerSpsc can be used without virtual calls.
+    template <typename Controller>
+    Regions acquireReadRegionsInternal(Controller &fifo, int32_t numFrames);
+    template <typename Controller>
+    Regions acquireWriteRegionsInternal(Controller &fifo, int32_t numFrames);
+
+    // Split numFrames starting at index into the part before and after the end of the storage.
+    Regions makeRegions(uint32_t index, uint32_t numFrames, uint32_t capacity);
+
     uint32_t mBytesPerFrame;
     uint8_t* mStorage;
     bool     mStorageOwned; // did this object allocate the storage?
     std::unique_ptr<FifoControllerBase> mFifo;
+    std::unique_ptr<FifoControllerSpsc> mFifoSpsc; // used instead of mFifo if not null
     uint64_t mFramesReadCount;
     uint64_t mFramesUnderrunCount;
 };
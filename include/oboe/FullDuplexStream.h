@@ -18,6 +18,7 @@
 #define OBOE_FULL_DUPLEX_STREAM_
 
 #include <cstdint>
+#include <cstring>
 #include "oboe/Definitions.h"
 #include "oboe/AudioStream.h"
 #include "oboe/AudioStreamCallback.h"
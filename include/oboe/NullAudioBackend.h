@@ -0,0 +1,81 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OBOE_NULL_AUDIO_BACKEND_H
+#define OBOE_NULL_AUDIO_BACKEND_H
+
+#include <string>
+
+namespace oboe {
+
+/**
+ * Settings for the null audio backend that AudioStreamBuilder uses when Oboe
+ * is built for a host, eg. a Linux workstation. It is not available on Android.
+ *
+ * A null stream has no audio device. A timer thread calls the data callback
+ * with one burst at a time. The sample rate, channel count and burst size
+ * default to the values in DefaultStreamValues.
+ *
+ * These settings are read when a stream is opened.
+ * Changing them does not affect streams that are already open.
+ */
+class NullAudioBackend {
+public:
+
+    /**
+     * Set how fast the timer thread runs compared to real-time.
+     * For example, 10.0 will call the data callback 10 times more often than a real device.
+     * A speed of 0.0 means the callback will be called as fast as possible.
+     *
+     * The default is 1.0.
+     *
+     * @param speed multiplier of real-time, or 0.0
+     */
+    static void setSpeed(double speed);
+
+    static double getSpeed();
+
+    /**
+     * Write everything played by output streams to a raw file.
+     * The file will contain interleaved samples in the stream's format.
+     * The file is truncated when a stream is opened so only open one output stream at a time.
+     *
+     * @param path file to write, or an empty string to discard the output
+     */
+    static void setOutputFile(const std::string &path);
+
+    static std::string getOutputFile();
+
+    /**
+     * Read the data for input streams from a raw file.
+     * The file must contain interleaved samples in the stream's format.
+     * The file is repeated when the end is reached.
+     *
+     * @param path file to read, or an empty string to record silence
+     */
+    static void setInputFile(const std::string &path);
+
+    static std::string getInputFile();
+
+    /**
+     * Restore the default settings.
+     */
+    static void reset();
+};
+
+} // namespace oboe
+
+#endif //OBOE_NULL_AUDIO_BACKEND_H
@@ -30,11 +30,14 @@
 #include "oboe/AudioStream.h"
 #include "oboe/AudioStreamBase.h"
 #include "oboe/AudioStreamBuilder.h"
+#include "oboe/CallbackStatistics.h"
+#include "oboe/Tracer.h"
 #include "oboe/Utilities.h"
 #include "oboe/Version.h"
 #include "oboe/StabilizedCallback.h"
 #include "oboe/FifoBuffer.h"
 #include "oboe/OboeExtensions.h"
 #include "oboe/FullDuplexStream.h"
+#include "oboe/OfflineConverter.h"
 
 #endif //OBOE_OBOE_H
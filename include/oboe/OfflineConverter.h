@@ -0,0 +1,165 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OBOE_OFFLINE_CONVERTER_H
+#define OBOE_OFFLINE_CONVERTER_H
+
+#include <cstdint>
+#include <string>
+
+#include "oboe/Definitions.h"
+#include "oboe/ResultWithValue.h"
+
+namespace oboe {
+
+/**
+ * Convert the format, channel count and sample rate of audio that is already in memory
+ * or in a file, without a stream. It runs as fast as the CPU allows, which is useful
+ * for rendering, tests and tools.
+ *
+ * The data is processed in large blocks by the same flowgraph that a stream would use
+ * so the output is identical to what a stream would produce, including the latency of
+ * the sample rate converter. The end of the input is followed by silence until
+ * getOutputFrameCount() frames have been written.
+ *
+ * Long inputs can be split into chunks that are converted on several threads.
+ * Each chunk starts where the phase of the resampler repeats, and the resampler is
+ * first run over some earlier input so its history matches. So the chunked output is
+ * identical to the output of a single pass.
+ *
+ * <code>
+ * OfflineConverter converter({AudioFormat::I16, 2, 44100}, {AudioFormat::Float, 2, 48000});
+ * converter.setThreadCount(4);
+ * std::vector<float> output(converter.getOutputFrameCount(numFrames) * 2);
+ * auto result = converter.convert(input, numFrames, output.data(), output.size() / 2);
+ * </code>
+ */
+class OfflineConverter {
+public:
+
+    /**
+     * Description of interleaved PCM data.
+     */
+    struct Format {
+        AudioFormat format = AudioFormat::Float;
+        int32_t channelCount = 2;
+        int32_t sampleRate = 48000;
+        // If both formats have a mask then the channels are mixed for the masks.
+        ChannelMask channelMask = ChannelMask::Unspecified;
+
+        int32_t getBytesPerFrame() const;
+    };
+
+    // Large blocks have less overhead. The port buffers still fit in the L2 cache.
+    static constexpr int32_t kDefaultFramesPerBlock = 1024;
+
+    // Chunks should be long enough that running the resampler before each chunk is cheap.
+    static constexpr int64_t kMinFramesPerChunk = 64 * 1024;
+
+    OfflineConverter(const Format &input,
+                     const Format &output,
+                     SampleRateConversionQuality quality = SampleRateConversionQuality::Medium);
+
+    /**
+     * @param numFrames number of frames in each pass through the graph
+     */
+    void setFramesPerBlock(int32_t numFrames) {
+        mFramesPerBlock = numFrames;
+    }
+
+    int32_t getFramesPerBlock() const {
+        return mFramesPerBlock;
+    }
+
+    /**
+     * Set the number of threads that convert chunks, including the thread that calls convert().
+     * The default is 1.
+     *
+     * @param numThreads number of threads
+     */
+    void setThreadCount(int32_t numThreads) {
+        mThreadCount = numThreads;
+    }
+
+    int32_t getThreadCount() const {
+        return mThreadCount;
+    }
+
+    /**
+     * Set the number of input frames in each chunk. It will be rounded up to a multiple
+     * of the resampler period. By default the input is divided evenly between the threads
+     * but a chunk is at least kMinFramesPerChunk.
+     *
+     * @param numFrames input frames per chunk, or 0 for the default
+     */
+    void setFramesPerChunk(int64_t numFrames) {
+        mFramesPerChunk = numFrames;
+    }
+
+    /**
+     * @param numInputFrames number of input frames
+     * @return number of frames that convert() will write for that input
+     */
+    int64_t getOutputFrameCount(int64_t numInputFrames) const;
+
+    /**
+     * Convert interleaved frames in the input format to the output format.
+     *
+     * @param input input frames
+     * @param numInputFrames number of input frames
+     * @param output buffer for the output frames
+     * @param outputCapacity number of frames that fit in the output,
+     *                       which must be at least getOutputFrameCount(numInputFrames)
+     * @return number of frames written or an error
+     */
+    ResultWithValue<int64_t> convert(const void *input,
+                                     int64_t numInputFrames,
+                                     void *output,
+                                     int64_t outputCapacity);
+
+    /**
+     * Convert a raw file of interleaved PCM, such as one written by NullAudioBackend,
+     * and write the result to a raw file.
+     *
+     * @param inputPath file in the input format
+     * @param outputPath file to write in the output format
+     * @return OK or an error
+     */
+    Result convertFile(const std::string &inputPath, const std::string &outputPath);
+
+private:
+    // Run the input from startInputFrame through a new graph and write the output
+    // for the input from firstInputFrame until endOutputFrame.
+    ResultWithValue<int64_t> convertChunk(const uint8_t *input,
+                                          int64_t numInputFrames,
+                                          int64_t startInputFrame,
+                                          int64_t firstInputFrame,
+                                          uint8_t *output,
+                                          int64_t endOutputFrame);
+
+    static void convertChunkTask(void *context, int32_t chunkIndex);
+
+    const Format                      mInput;
+    const Format                      mOutput;
+    const SampleRateConversionQuality mQuality;
+    int32_t                           mFramesPerBlock = kDefaultFramesPerBlock;
+    int32_t                           mThreadCount = 1;
+    int64_t                           mFramesPerChunk = 0;
+};
+
+} // namespace oboe
+
+#endif //OBOE_OFFLINE_CONVERTER_H
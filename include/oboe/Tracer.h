@@ -0,0 +1,183 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OBOE_TRACER_H
+#define OBOE_TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace oboe {
+
+/**
+ * A low overhead tracer for sections and counters.
+ *
+ * Each event is written as a fixed size binary record with a CLOCK_MONOTONIC timestamp,
+ * the thread ID and the ID of an interned name. Every thread writes to its own ring, so
+ * recording does not take a lock, allocate or format a string.
+ * When a ring is full the oldest records are overwritten.
+ *
+ * The rings are allocated by setEnabled(true), when a stream is opened and by
+ * reserveRings(). A thread claims a free ring with its first event and releases it
+ * when it exits. If no ring is free then the events of that thread are dropped.
+ *
+ * The records can be exported as JSON in the Chrome trace event format,
+ * which can be opened in Perfetto or chrome://tracing.
+ *
+ * On Android the events are also passed to ATrace, so they show up in a systrace,
+ * whenever the system is tracing. That does not depend on setEnabled().
+ *
+ * Intern the names outside of the audio thread, for example at namespace scope:
+ *
+ *     static const uint32_t kRenderName = Tracer::internString("render");
+ *
+ * and then in the callback:
+ *
+ *     ScopedTraceSection section(kRenderName);
+ */
+class Tracer {
+public:
+    static constexpr int32_t kRecordsPerThread = 4096; // must be a power of two
+    static constexpr int32_t kMaxThreads = 32;
+    static constexpr int32_t kMaxNames = 1024;
+    // Free rings kept ready by setEnabled(true) and when a stream is opened.
+    static constexpr int32_t kDefaultReservedRings = 2;
+
+    /**
+     * Load ATrace on Android so the events are passed to systrace.
+     * Oboe calls this when a stream is opened. It can be called more than once.
+     * Call it from a control thread because it loads a library the first time.
+     */
+    static void initialize();
+
+    /**
+     * Allocate rings until at least numThreads are free, so that many new threads can
+     * record without allocating. Call this from a control thread before starting
+     * threads that trace.
+     *
+     * @param numThreads number of free rings, limited by kMaxThreads
+     */
+    static void reserveRings(int32_t numThreads);
+
+    /**
+     * Start or stop recording in the rings. This can be called from any thread.
+     * Records that were already made are kept until clear() is called.
+     */
+    static void setEnabled(bool enabled);
+
+    static bool isEnabled() {
+        return mIsEnabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the ID of a name. The same name always gets the same ID.
+     * This takes a lock and allocates, so call it once outside of the audio thread,
+     * for example when initializing a variable at namespace scope.
+     * It can be called during static initialization.
+     *
+     * @return ID of the name, or 0 if there are already kMaxNames names
+     */
+    static uint32_t internString(const char *name);
+
+    /**
+     * @return the name for an ID or "unknown"
+     */
+    static const char *getString(uint32_t nameId);
+
+    /**
+     * Mark the start of a section on this thread.
+     */
+    static void beginSection(uint32_t nameId) {
+        if (isActive()) {
+            recordEvent(kTypeBegin, nameId, 0);
+        }
+    }
+
+    /**
+     * Mark the end of the last section that was started on this thread.
+     */
+    static void endSection() {
+        if (isActive()) {
+            recordEvent(kTypeEnd, 0, 0);
+        }
+    }
+
+    /**
+     * Record the value of a counter, for example the number of frames in a buffer.
+     *
+     * On Android before API 29 ATrace has no counters, so the value is passed to systrace
+     * in the name of an empty section, for example "frames 192".
+     */
+    static void setCounter(uint32_t nameId, int64_t value) {
+        if (isActive()) {
+            recordEvent(kTypeCounter, nameId, value);
+        }
+    }
+
+    /**
+     * Convert the records in all of the rings to JSON in the Chrome trace event format.
+     * This can be called from any thread while other threads are recording.
+     * It allocates so do not call it from an audio callback.
+     */
+    static std::string exportChromeJson();
+
+    /**
+     * Forget the records that were made so far. This can be called from any thread.
+     */
+    static void clear();
+
+    /**
+     * @return number of events that were not recorded because no ring was free
+     */
+    static int64_t getDroppedEventCount();
+
+private:
+    static constexpr uint8_t kTypeBegin = 0;
+    static constexpr uint8_t kTypeEnd = 1;
+    static constexpr uint8_t kTypeCounter = 2;
+
+    // True if the event is recorded in a ring or may be passed to ATrace.
+    static bool isActive() {
+        return isEnabled() || mIsATraceLoaded.load(std::memory_order_relaxed);
+    }
+
+    static void recordEvent(uint8_t type, uint32_t nameId, int64_t value);
+
+    static std::atomic<bool> mIsEnabled;
+    static std::atomic<bool> mIsATraceLoaded;
+};
+
+/**
+ * Trace a section for the lifetime of this object.
+ */
+class ScopedTraceSection {
+public:
+    explicit ScopedTraceSection(uint32_t nameId) {
+        Tracer::beginSection(nameId);
+    }
+
+    ~ScopedTraceSection() {
+        Tracer::endSection();
+    }
+
+    ScopedTraceSection(const ScopedTraceSection&) = delete;
+    ScopedTraceSection& operator=(const ScopedTraceSection&) = delete;
+};
+
+} // namespace oboe
+
+#endif //OBOE_TRACER_H
@@ -26,6 +26,7 @@ namespace oboe {
 
 /**
  * Convert an array of floats to an array of 16-bit integers.
+ * Values outside the range [-1.0, 1.0) are clipped.
  *
  * @param source the input array.
  * @param destination the output array.
@@ -73,20 +73,11 @@ void resampleData(const ResampleBlock& input, ResampleBlock* output, int numChan
     float *outputBuffer = new float[numOutFramesAllocated];    // multi-channel buffer to be filled
     output->mBuffer = outputBuffer;
 
-    int numOutputSamples = 0;
-    int inputSamplesLeft = input.mNumSamples;
-    while ((inputSamplesLeft > 0) && (numOutputSamples < numOutFramesAllocated)) {
-        if(resampler->isWriteNeeded()) {
-            resampler->writeNextFrame(inputBuffer);
-            inputBuffer += numChannels;
-            inputSamplesLeft -= numChannels;
-        } else {
-            resampler->readNextFrame(outputBuffer);
-            outputBuffer += numChannels;
-            numOutputSamples += numChannels;
-        }
-    }
-    output->mNumSamples = numOutputSamples;
+    // Convert the whole sample in one call.
+    MultiChannelResampler::ProcessResult result = resampler->process(
+            inputBuffer, input.mNumSamples / numChannels,
+            outputBuffer, numOutFramesAllocated / numChannels);
+    output->mNumSamples = result.framesProduced * numChannels;
 
     delete resampler;
 }
@@ -21,10 +21,15 @@
 #include <oboe/AudioStream.h>
 #include "OboeDebug.h"
 #include "AudioClock.h"
+#include "DenormalGuard.h"
+#include <oboe/Tracer.h>
 #include <oboe/Utilities.h>
 
 namespace oboe {
 
+// Interned when the library is loaded so the audio thread does not take the name lock.
+static const uint32_t kDataCallbackTraceName = Tracer::internString("oboe data callback");
+
 /*
  * AudioStream
  */
@@ -61,6 +66,14 @@ DataCallbackResult AudioStream::fireDataCallback(void *audioData, int32_t numFra
 
     beginPerformanceHintInCallback();
 
+    const bool isStatisticsEnabled = isCallbackStatisticsEnabled();
+    const int64_t beginNanos = isStatisticsEnabled ? AudioClock::getNanoseconds() : 0;
+
+    // The floating point mode is restored when this goes out of scope.
+    DenormalGuard denormalGuard(isDenormalProtectionEnabled());
+
+    Tracer::beginSection(kDataCallbackTraceName);
+
     // Call the app to do the work.
     DataCallbackResult result;
     if (mDataCallback) {
@@ -72,8 +85,13 @@ DataCallbackResult AudioStream::fireDataCallback(void *audioData, int32_t numFra
     // So block that here.
     setDataCallbackEnabled(result == DataCallbackResult::Continue);
 
+    Tracer::endSection();
     endPerformanceHintInCallback(numFrames);
 
+    if (isStatisticsEnabled) {
+        mCallbackStatistics.recordCallback(beginNanos, AudioClock::getNanoseconds(),
+                                           numFrames, getSampleRate());
+    }
     return result;
 }
 
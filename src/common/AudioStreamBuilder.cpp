@@ -17,18 +17,29 @@
 #include <sys/types.h>
 
 
+#ifdef __ANDROID__
 #include "aaudio/AAudioExtensions.h"
 #include "aaudio/AudioStreamAAudio.h"
+#endif
 #include "FilterAudioStream.h"
 #include "OboeDebug.h"
 #include "oboe/Oboe.h"
 #include "oboe/AudioStreamBuilder.h"
+#ifdef __ANDROID__
 #include "opensles/AudioInputStreamOpenSLES.h"
 #include "opensles/AudioOutputStreamOpenSLES.h"
 #include "opensles/AudioStreamOpenSLES.h"
+#else
+#include "null/AudioStreamNull.h"
+#endif
 #include "QuirksManager.h"
 
+#ifdef __ANDROID__
 bool oboe::OboeGlobals::mWorkaroundsEnabled = true;
+#else
+// The workarounds are for Android devices so they are not needed by the null backend.
+bool oboe::OboeGlobals::mWorkaroundsEnabled = false;
+#endif
 
 namespace oboe {
 
@@ -53,6 +64,8 @@ constexpr int kBufferSizeInBurstsForLowLatencyStreams = 2;
 #define OBOE_ENABLE_AAUDIO 1
 #endif
 
+#ifdef __ANDROID__
+
 bool AudioStreamBuilder::isAAudioSupported() {
     return AudioStreamAAudio::isSupported() && OBOE_ENABLE_AAUDIO;
 }
@@ -81,6 +94,23 @@ AudioStream *AudioStreamBuilder::build() {
     return stream;
 }
 
+#else // __ANDROID__
+
+// Host builds use a null stream that is driven by a timer thread.
+bool AudioStreamBuilder::isAAudioSupported() {
+    return false;
+}
+
+bool AudioStreamBuilder::isAAudioRecommended() {
+    return false;
+}
+
+AudioStream *AudioStreamBuilder::build() {
+    return new AudioStreamNull(*this);
+}
+
+#endif // __ANDROID__
+
 bool AudioStreamBuilder::isCompatible(AudioStreamBase &other) {
     return (getSampleRate() == oboe::Unspecified || getSampleRate() == other.getSampleRate())
            && (getFormat() == (AudioFormat)oboe::Unspecified || getFormat() == other.getFormat())
@@ -103,6 +133,9 @@ Result AudioStreamBuilder::openStreamInternal(AudioStream **streamPP) {
     LOGI("%s() %s -------- %s --------",
          __func__, getDirection() == Direction::Input ? "INPUT" : "OUTPUT", getVersionText());
 
+    // Pass the trace sections of the stream to systrace.
+    Tracer::initialize();
+
     if (streamPP == nullptr) {
         return Result::ErrorNull;
     }
@@ -163,6 +196,7 @@ Result AudioStreamBuilder::openStreamInternal(AudioStream **streamPP) {
         }
     }
 
+#ifdef __ANDROID__
     // If MMAP has a problem in this case then disable it temporarily.
     bool wasMMapOriginallyEnabled = AAudioExtensions::getInstance().isMMapEnabled();
     bool wasMMapTemporarilyDisabled = false;
@@ -177,6 +211,9 @@ Result AudioStreamBuilder::openStreamInternal(AudioStream **streamPP) {
     if (wasMMapTemporarilyDisabled) {
         AAudioExtensions::getInstance().setMMapEnabled(wasMMapOriginallyEnabled); // restore original
     }
+#else
+    result = streamP->open();
+#endif
     if (result == Result::OK) {
 
         int32_t  optimalBufferSize = -1;
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "oboe/CallbackStatistics.h"
+#include "oboe/Definitions.h"
+
+namespace oboe {
+
+int32_t Histogram::getBucketIndex(int64_t value) {
+    if (value < kSubBucketCount) {
+        return static_cast<int32_t>(std::max<int64_t>(value, 0));
+    }
+    const int32_t exponent = 63 - __builtin_clzll(static_cast<uint64_t>(value));
+    if (exponent > kMaxExponent) {
+        return kNumBuckets - 1;
+    }
+    // The sub-bucket is the bits after the leading one.
+    const int32_t subBucket = static_cast<int32_t>(value >> (exponent - kSubBucketBits))
+            & (kSubBucketCount - 1);
+    return ((exponent - kSubBucketBits + 1) * kSubBucketCount) + subBucket;
+}
+
+int64_t Histogram::getBucketLowerBound(int32_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    const int32_t exponent = (index / kSubBucketCount) + kSubBucketBits - 1;
+    const int64_t subBucket = index % kSubBucketCount;
+    return (kSubBucketCount + subBucket) << (exponent - kSubBucketBits);
+}
+
+int64_t Histogram::getBucketUpperBound(int32_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    if (index >= kNumBuckets - 1) {
+        return INT64_MAX;
+    }
+    return getBucketLowerBound(index + 1) - 1;
+}
+
+void Histogram::record(int64_t value) {
+    value = std::max<int64_t>(value, 0);
+    // Only this thread writes so a load and a store are enough. They cannot have to retry.
+    std::atomic<int64_t> &bucket = mBuckets[getBucketIndex(value)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (value > mMaximum.load(std::memory_order_relaxed)) {
+        mMaximum.store(value, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::reset() {
+    for (std::atomic<int64_t> &bucket : mBuckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    mMaximum.store(0, std::memory_order_relaxed);
+}
+
+int64_t Histogram::getCount() const {
+    int64_t count = 0;
+    for (const std::atomic<int64_t> &bucket : mBuckets) {
+        count += bucket.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+int64_t Histogram::getPercentile(double percent) const {
+    // Copy the counts so the total matches the buckets that are searched.
+    int64_t counts[kNumBuckets];
+    int64_t total = 0;
+    for (int32_t i = 0; i < kNumBuckets; i++) {
+        counts[i] = mBuckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    // The rank of the percentile, from 1 to total.
+    const double clipped = std::min(std::max(percent, 0.0), 100.0);
+    const int64_t rank = std::max<int64_t>(
+            1, static_cast<int64_t>(std::ceil(clipped * 0.01 * static_cast<double>(total))));
+    int64_t cumulative = 0;
+    for (int32_t i = 0; i < kNumBuckets; i++) {
+        cumulative += counts[i];
+        if (cumulative >= rank) {
+            return std::min(getBucketUpperBound(i), getMaximum());
+        }
+    }
+    return getMaximum();
+}
+
+void CallbackStatistics::reset() {
+    mResetRequested.store(true, std::memory_order_release);
+}
+
+void CallbackStatistics::recordCallback(int64_t beginNanos, int64_t endNanos,
+                                        int32_t numFrames, int32_t sampleRate) {
+    // Check with a plain load first so the usual case has no read-modify-write.
+    if (mResetRequested.load(std::memory_order_relaxed)
+            && mResetRequested.exchange(false, std::memory_order_acquire)) {
+        // This is the recording thread so the histograms can be cleared now.
+        mIntervalNanos.reset();
+        mDurationNanos.reset();
+        mFramesPerCallback.reset();
+        mLatenessNanos.reset();
+        mPreviousBeginNanos = -1;
+    }
+    mDurationNanos.record(endNanos - beginNanos);
+    mFramesPerCallback.record(numFrames);
+
+    const int64_t intervalNanos = beginNanos - mPreviousBeginNanos;
+    if (mPreviousBeginNanos < 0 || intervalNanos > kRestartGapNanos) {
+        // The first callback after starting. It is on schedule by definition.
+        mIdealBeginNanos = static_cast<double>(beginNanos);
+    } else {
+        mIntervalNanos.record(intervalNanos);
+        double latenessNanos = static_cast<double>(beginNanos) - mIdealBeginNanos;
+        if (latenessNanos < 0.0) {
+            mIdealBeginNanos = static_cast<double>(beginNanos);
+            latenessNanos = 0.0;
+        } else {
+            mIdealBeginNanos += latenessNanos / (1 << kDriftShift);
+        }
+        mLatenessNanos.record(static_cast<int64_t>(latenessNanos));
+    }
+    mPreviousBeginNanos = beginNanos;
+    if (sampleRate > 0) {
+        mIdealBeginNanos += static_cast<double>(numFrames) * kNanosPerSecond / sampleRate;
+    }
+}
+
+} // namespace oboe
@@ -14,7 +14,10 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <memory>
+#include <numeric>
+#include <vector>
 
 #include "OboeDebug.h"
 #include "DataConversionFlowGraph.h"
@@ -22,11 +25,13 @@
 #include "SourceI16Caller.h"
 #include "SourceI24Caller.h"
 #include "SourceI32Caller.h"
+#include <oboe/Tracer.h>
 
 #include <flowgraph/MonoToMultiConverter.h>
 #include <flowgraph/MultiToMonoConverter.h>
 #include <flowgraph/RampLinear.h>
 #include <flowgraph/SinkFloat.h>
+#include <flowgraph/SinkFused.h>
 #include <flowgraph/SinkI16.h>
 #include <flowgraph/SinkI24.h>
 #include <flowgraph/SinkI32.h>
@@ -40,6 +45,70 @@ using namespace oboe;
 using namespace flowgraph;
 using namespace resampler;
 
+namespace {
+
+// Interned when the library is loaded so the audio thread does not take the name lock.
+const uint32_t kReadTraceName = Tracer::internString("oboe conversion read");
+const uint32_t kWriteTraceName = Tracer::internString("oboe conversion write");
+
+/**
+ * @return a matrix for a ChannelMixer, or an empty vector if the channels should be copied
+ */
+std::vector<float> makeMixerMatrix(ChannelMask sourceChannelMask,
+                                   int32_t sourceChannelCount,
+                                   ChannelMask sinkChannelMask,
+                                   int32_t sinkChannelCount) {
+    if (sourceChannelMask == ChannelMask::Unspecified
+            || sinkChannelMask == ChannelMask::Unspecified
+            || sourceChannelMask == sinkChannelMask
+            || getChannelCountFromChannelMask(sourceChannelMask) != sourceChannelCount
+            || getChannelCountFromChannelMask(sinkChannelMask) != sinkChannelCount) {
+        return {};
+    }
+    return ChannelMixer::makeMatrix(static_cast<uint32_t>(sourceChannelMask),
+                                    static_cast<uint32_t>(sinkChannelMask));
+}
+
+/**
+ * The channel and sample rate converters in a form that can be swapped by a GraphCrossfader.
+ */
+class ConverterSection : public GraphCrossfader::Section {
+public:
+    ConverterSection(int32_t inputChannelCount,
+                     int32_t inputSampleRate,
+                     int32_t outputChannelCount,
+                     int32_t outputSampleRate,
+                     const std::vector<float> &mixerMatrix,
+                     MultiChannelResampler::Quality quality)
+            : Section(inputChannelCount, outputChannelCount) {
+        FlowGraphPortFloatOutput *lastOutput = mConverters.connect(&source.output,
+                                                                   inputChannelCount,
+                                                                   inputSampleRate,
+                                                                   outputChannelCount,
+                                                                   outputSampleRate,
+                                                                   mixerMatrix,
+                                                                   quality);
+        lastOutput->connect(&sink.input);
+        const MultiChannelResampler *resampler = mConverters.getResampler();
+        if (resampler != nullptr) {
+            // Fill the filter before the crossfade. Use whole periods of the rate ratio
+            // so the number of output frames is exact.
+            const int32_t framesPerPeriod = inputSampleRate / std::gcd(inputSampleRate,
+                                                                       outputSampleRate);
+            const int32_t historyFrames = 2 * resampler->getNumTaps();
+            const int32_t preRollFrames = ((historyFrames + framesPerPeriod - 1)
+                    / framesPerPeriod) * framesPerPeriod;
+            setPreRoll(preRollFrames, static_cast<int32_t>(
+                    static_cast<int64_t>(preRollFrames) * outputSampleRate / inputSampleRate));
+        }
+    }
+
+private:
+    ConverterChain mConverters;
+};
+
+} // namespace
+
 void DataConversionFlowGraph::setSource(const void *buffer, int32_t numFrames) {
     mSource->setData(buffer, numFrames);
 }
@@ -136,22 +205,9 @@ Result DataConversionFlowGraph::configure(AudioStream *sourceStream, AudioStream
     } else {
         // IF OUTPUT and NOT using a callback then write to the child stream using a BlockWriter.
         // OR IF INPUT and using a callback then write to the app using a BlockWriter.
-        switch (sourceFormat) {
-            case AudioFormat::Float:
-                mSource = std::make_unique<SourceFloat>(sourceChannelCount);
-                break;
-            case AudioFormat::I16:
-                mSource = std::make_unique<SourceI16>(sourceChannelCount);
-                break;
-            case AudioFormat::I24:
-                mSource = std::make_unique<SourceI24>(sourceChannelCount);
-                break;
-            case AudioFormat::I32:
-                mSource = std::make_unique<SourceI32>(sourceChannelCount);
-                break;
-            default:
-                LOGE("%s() Unsupported source format = %d", __func__, static_cast<int>(sourceFormat));
-                return Result::ErrorIllegalArgument;
+        mSource = makeSource(sourceFormat, sourceChannelCount);
+        if (!mSource) {
+            return Result::ErrorIllegalArgument;
         }
         if (isInput) {
             int32_t actualSinkFramesPerCallback = (sinkFramesPerCallback == kUnspecified)
@@ -159,26 +215,98 @@ Result DataConversionFlowGraph::configure(AudioStream *sourceStream, AudioStream
                     : sinkFramesPerCallback;
             // The BlockWriter is after the Sink so use the SinkStream size.
             mBlockWriter.open(actualSinkFramesPerCallback * sinkStream->getBytesPerFrame());
-            mAppBuffer = std::make_unique<uint8_t[]>(
-                    kDefaultBufferSize * sinkStream->getBytesPerFrame());
         }
         lastOutput = &mSource->output;
     }
 
+    mSourceChannelMask = sourceStream->getChannelMask();
+    mSinkChannelMask = sinkStream->getChannelMask();
+    if (mFilterStream->isLiveReconfigurationEnabled()) {
+        mLiveReconfigurationEnabled = true;
+    }
+    Result result = connectConverters(lastOutput,
+                                      sourceChannelCount, sourceSampleRate,
+                                      sinkFormat, sinkChannelCount, sinkSampleRate,
+                                      sourceStream->getSampleRateConversionQuality());
+    if (result != Result::OK) {
+        return result;
+    }
+
+    // Resize every port in the graph to the block size.
+    AudioStream *childStream = isOutput ? sinkStream : sourceStream;
+    mFramesPerBlock = calculateFramesPerBlock(mFilterStream->getFlowGraphBlockSize(),
+                                              childStream->getFramesPerBurst(),
+                                              std::max(sourceChannelCount, sinkChannelCount));
+    mSink->pullSetFramesPerBuffer(mFramesPerBlock);
+    // The graph does not change after this so sort it once instead of pulling recursively.
+    mSink->buildSchedule();
+    if (mSource && isInput) {
+        mAppBuffer = std::make_unique<uint8_t[]>(
+                mFramesPerBlock * sinkStream->getBytesPerFrame());
+    }
+    LOGD("%s() flowgraph block size = %d frames", __func__, mFramesPerBlock);
+
+    return Result::OK;
+}
+
+Result DataConversionFlowGraph::configure(AudioFormat sourceFormat,
+                                          int32_t sourceChannelCount,
+                                          int32_t sourceSampleRate,
+                                          AudioFormat sinkFormat,
+                                          int32_t sinkChannelCount,
+                                          int32_t sinkSampleRate,
+                                          SampleRateConversionQuality quality,
+                                          int32_t framesPerBlock) {
+    mSource = makeSource(sourceFormat, sourceChannelCount);
+    if (!mSource) {
+        return Result::ErrorIllegalArgument;
+    }
+    Result result = connectConverters(&mSource->output,
+                                      sourceChannelCount, sourceSampleRate,
+                                      sinkFormat, sinkChannelCount, sinkSampleRate,
+                                      quality);
+    if (result != Result::OK) {
+        return result;
+    }
+    mFramesPerBlock = framesPerBlock;
+    mSink->pullSetFramesPerBuffer(mFramesPerBlock);
+    mSink->buildSchedule();
+    return Result::OK;
+}
+
+std::unique_ptr<FlowGraphSourceBuffered> DataConversionFlowGraph::makeSource(
+        AudioFormat format, int32_t channelCount) {
+    switch (format) {
+        case AudioFormat::Float:
+            return std::make_unique<SourceFloat>(channelCount);
+        case AudioFormat::I16:
+            return std::make_unique<SourceI16>(channelCount);
+        case AudioFormat::I24:
+            return std::make_unique<SourceI24>(channelCount);
+        case AudioFormat::I32:
+            return std::make_unique<SourceI32>(channelCount);
+        default:
+            LOGE("%s() Unsupported source format = %d", __func__, static_cast<int>(format));
+            return nullptr;
+    }
+}
+
+FlowGraphPortFloatOutput *ConverterChain::connect(FlowGraphPortFloatOutput *lastOutput,
+                                                  int32_t sourceChannelCount,
+                                                  int32_t sourceSampleRate,
+                                                  int32_t sinkChannelCount,
+                                                  int32_t sinkSampleRate,
+                                                  const std::vector<float> &mixerMatrix,
+                                                  MultiChannelResampler::Quality quality) {
+    const bool isMixed = !mixerMatrix.empty();
+
     // If we are going to reduce the number of channels then do it before the
     // sample rate converter.
-    if (sourceChannelCount > sinkChannelCount) {
-        if (sinkChannelCount == 1) {
-            mMultiToMonoConverter = std::make_unique<MultiToMonoConverter>(sourceChannelCount);
-            lastOutput->connect(&mMultiToMonoConverter->input);
-            lastOutput = &mMultiToMonoConverter->output;
-        } else {
-            mChannelCountConverter = std::make_unique<ChannelCountConverter>(
-                    sourceChannelCount,
-                    sinkChannelCount);
-            lastOutput->connect(&mChannelCountConverter->input);
-            lastOutput = &mChannelCountConverter->output;
-        }
+    if (isMixed && sourceChannelCount >= sinkChannelCount) {
+        lastOutput = connectChannelMixer(lastOutput, sinkChannelCount, mixerMatrix);
+    } else if (!isMixed && sourceChannelCount > sinkChannelCount) {
+        mFusibleInput = lastOutput;
+        lastOutput = connectChannelConverter(lastOutput, sinkChannelCount);
     }
 
     // Sample Rate conversion
@@ -187,54 +315,185 @@ Result DataConversionFlowGraph::configure(AudioStream *sourceStream, AudioStream
         mResampler.reset(MultiChannelResampler::make(lastOutput->getSamplesPerFrame(),
                                                      sourceSampleRate,
                                                      sinkSampleRate,
-                                                     convertOboeSRQualityToMCR(
-                                                             sourceStream->getSampleRateConversionQuality())));
+                                                     quality));
         // Make a flowgraph node that uses the resampler.
         mRateConverter = std::make_unique<SampleRateConverter>(lastOutput->getSamplesPerFrame(),
                                                                *mResampler.get());
         lastOutput->connect(&mRateConverter->input);
         lastOutput = &mRateConverter->output;
+        // The SRC has state so nothing upstream can be fused.
+        mFusibleNodes.clear();
+        mFusibleInput = nullptr;
     }
 
     // Expand the number of channels if required.
-    if (sourceChannelCount < sinkChannelCount) {
-        if (sourceChannelCount == 1) {
-            mMonoToMultiConverter = std::make_unique<MonoToMultiConverter>(sinkChannelCount);
-            lastOutput->connect(&mMonoToMultiConverter->input);
-            lastOutput = &mMonoToMultiConverter->output;
-        } else {
-            mChannelCountConverter = std::make_unique<ChannelCountConverter>(
-                    sourceChannelCount,
-                    sinkChannelCount);
-            lastOutput->connect(&mChannelCountConverter->input);
-            lastOutput = &mChannelCountConverter->output;
+    if (isMixed && sourceChannelCount < sinkChannelCount) {
+        lastOutput = connectChannelMixer(lastOutput, sinkChannelCount, mixerMatrix);
+    } else if (!isMixed && sourceChannelCount < sinkChannelCount) {
+        if (mFusibleNodes.empty()) {
+            mFusibleInput = lastOutput;
         }
+        lastOutput = connectChannelConverter(lastOutput, sinkChannelCount);
     }
+    return lastOutput;
+}
 
-    // Sink
-    switch (sinkFormat) {
-        case AudioFormat::Float:
-            mSink = std::make_unique<SinkFloat>(sinkChannelCount);
-            break;
-        case AudioFormat::I16:
-            mSink = std::make_unique<SinkI16>(sinkChannelCount);
-            break;
-        case AudioFormat::I24:
-            mSink = std::make_unique<SinkI24>(sinkChannelCount);
-            break;
-        case AudioFormat::I32:
-            mSink = std::make_unique<SinkI32>(sinkChannelCount);
-            break;
-        default:
-            LOGE("%s() Unsupported sink format = %d", __func__, static_cast<int>(sinkFormat));
-            return Result::ErrorIllegalArgument;;
+FlowGraphPortFloatOutput *ConverterChain::connectChannelMixer(
+        FlowGraphPortFloatOutput *lastOutput,
+        int32_t sinkChannelCount,
+        const std::vector<float> &mixerMatrix) {
+    mChannelMixer = std::make_unique<ChannelMixer>(lastOutput->getSamplesPerFrame(),
+                                                   sinkChannelCount);
+    mChannelMixer->setMatrix(mixerMatrix);
+    lastOutput->connect(&mChannelMixer->input);
+    return &mChannelMixer->output;
+}
+
+// The channel converters are stateless so they are added to the fusible nodes.
+FlowGraphPortFloatOutput *ConverterChain::connectChannelConverter(
+        FlowGraphPortFloatOutput *lastOutput,
+        int32_t sinkChannelCount) {
+    const int32_t sourceChannelCount = lastOutput->getSamplesPerFrame();
+    if (sinkChannelCount == 1) {
+        mMultiToMonoConverter = std::make_unique<MultiToMonoConverter>(sourceChannelCount);
+        lastOutput->connect(&mMultiToMonoConverter->input);
+        mFusibleNodes.push_back(mMultiToMonoConverter.get());
+        return &mMultiToMonoConverter->output;
+    } else if (sourceChannelCount == 1) {
+        mMonoToMultiConverter = std::make_unique<MonoToMultiConverter>(sinkChannelCount);
+        lastOutput->connect(&mMonoToMultiConverter->input);
+        mFusibleNodes.push_back(mMonoToMultiConverter.get());
+        return &mMonoToMultiConverter->output;
+    }
+    mChannelCountConverter = std::make_unique<ChannelCountConverter>(sourceChannelCount,
+                                                                     sinkChannelCount);
+    lastOutput->connect(&mChannelCountConverter->input);
+    mFusibleNodes.push_back(mChannelCountConverter.get());
+    return &mChannelCountConverter->output;
+}
+
+Result DataConversionFlowGraph::connectConverters(FlowGraphPortFloatOutput *lastOutput,
+                                                  int32_t sourceChannelCount,
+                                                  int32_t sourceSampleRate,
+                                                  AudioFormat sinkFormat,
+                                                  int32_t sinkChannelCount,
+                                                  int32_t sinkSampleRate,
+                                                  SampleRateConversionQuality quality) {
+    if (mLiveReconfigurationEnabled) {
+        mSourceChannelCount = sourceChannelCount;
+        mSourceSampleRate = sourceSampleRate;
+        mSinkChannelCount = sinkChannelCount;
+        mSinkSampleRate = sinkSampleRate;
+        mCrossfader = std::make_unique<GraphCrossfader>(sourceChannelCount, sinkChannelCount);
+        lastOutput->connect(&mCrossfader->input);
+        lastOutput = &mCrossfader->output;
+        // The block size is set on the section by pullSetFramesPerBuffer().
+        Result result = setSampleRateConversionQuality(quality);
+        if (result != Result::OK) {
+            return result;
+        }
+    } else {
+        lastOutput = mConverters.connect(lastOutput,
+                                         sourceChannelCount, sourceSampleRate,
+                                         sinkChannelCount, sinkSampleRate,
+                                         makeMixerMatrix(mSourceChannelMask, sourceChannelCount,
+                                                         mSinkChannelMask, sinkChannelCount),
+                                         convertOboeSRQualityToMCR(quality));
+    }
+    // Stateless nodes at the end of the chain that may be fused into the sink.
+    const std::vector<FlowGraphNode *> &fusibleNodes = mConverters.getFusibleNodes();
+    FlowGraphPortFloatOutput *fusibleInput = mConverters.getFusibleInput();
+
+    // Replace the stateless nodes and the sink with a single fused sink.
+    if (mFusionEnabled && !fusibleNodes.empty()) {
+        std::unique_ptr<SinkFused> fusedSink;
+        switch (sinkFormat) {
+            case AudioFormat::Float:
+                fusedSink = std::make_unique<SinkFused>(fusibleInput->getSamplesPerFrame(),
+                                                        SinkFused::Format::Float);
+                break;
+            case AudioFormat::I16:
+                fusedSink = std::make_unique<SinkFused>(fusibleInput->getSamplesPerFrame(),
+                                                        SinkFused::Format::I16);
+                break;
+            case AudioFormat::I24:
+                fusedSink = std::make_unique<SinkFused>(fusibleInput->getSamplesPerFrame(),
+                                                        SinkFused::Format::I24);
+                break;
+            case AudioFormat::I32:
+                fusedSink = std::make_unique<SinkFused>(fusibleInput->getSamplesPerFrame(),
+                                                        SinkFused::Format::I32);
+                break;
+            default:
+                break; // Not fusible. Handled below.
+        }
+        bool fused = (fusedSink != nullptr);
+        for (FlowGraphNode *node : fusibleNodes) {
+            fused = fused && fusedSink->fuse(*node);
+        }
+        if (fused) {
+            LOGD("%s() fused %d node(s) into the sink", __func__,
+                 static_cast<int>(fusibleNodes.size()));
+            fusibleInput->connect(&fusedSink->input);
+            mSink = std::move(fusedSink);
+        }
     }
-    lastOutput->connect(&mSink->input);
 
+    // Sink
+    if (!mSink) {
+        switch (sinkFormat) {
+            case AudioFormat::Float:
+                mSink = std::make_unique<SinkFloat>(sinkChannelCount);
+                break;
+            case AudioFormat::I16:
+                mSink = std::make_unique<SinkI16>(sinkChannelCount);
+                break;
+            case AudioFormat::I24:
+                mSink = std::make_unique<SinkI24>(sinkChannelCount);
+                break;
+            case AudioFormat::I32:
+                mSink = std::make_unique<SinkI32>(sinkChannelCount);
+                break;
+            default:
+                LOGE("%s() Unsupported sink format = %d", __func__, static_cast<int>(sinkFormat));
+                return Result::ErrorIllegalArgument;;
+        }
+        lastOutput->connect(&mSink->input);
+    }
     return Result::OK;
 }
 
+Result DataConversionFlowGraph::setSampleRateConversionQuality(
+        SampleRateConversionQuality quality) {
+    if (!mCrossfader) {
+        return Result::ErrorInvalidState;
+    }
+    auto section = std::make_unique<ConverterSection>(
+            mSourceChannelCount, mSourceSampleRate,
+            mSinkChannelCount, mSinkSampleRate,
+            makeMixerMatrix(mSourceChannelMask, mSourceChannelCount,
+                            mSinkChannelMask, mSinkChannelCount),
+            convertOboeSRQualityToMCR(quality));
+    return mCrossfader->publish(std::move(section)) ? Result::OK : Result::ErrorInternal;
+}
+
+int32_t DataConversionFlowGraph::calculateFramesPerBlock(int32_t requestedFrames,
+                                                         int32_t framesPerBurst,
+                                                         int32_t maxChannelCount) {
+    if (requestedFrames > 0) {
+        return requestedFrames;
+    }
+    if (framesPerBurst <= kDefaultBufferSize) {
+        return kDefaultBufferSize;
+    }
+    // Process a whole burst in one pass unless the port buffers would not fit in the cache.
+    int32_t maxFrames = kCacheBudgetBytes
+            / (kBuffersInCache * std::max(1, maxChannelCount) * (int32_t) sizeof(float));
+    return std::max(kDefaultBufferSize, std::min(framesPerBurst, maxFrames));
+}
+
 int32_t DataConversionFlowGraph::read(void *buffer, int32_t numFrames, int64_t timeoutNanos) {
+    ScopedTraceSection traceSection(kReadTraceName);
     if (mSourceCaller) {
         mSourceCaller->setTimeoutNanos(timeoutNanos);
     }
@@ -244,11 +503,12 @@ int32_t DataConversionFlowGraph::read(void *buffer, int32_t numFrames, int64_t t
 
 // This is similar to pushing data through the flowgraph.
 int32_t DataConversionFlowGraph::write(void *inputBuffer, int32_t numFrames) {
+    ScopedTraceSection traceSection(kWriteTraceName);
     // Put the data from the input at the head of the flowgraph.
     mSource->setData(inputBuffer, numFrames);
     while (true) {
         // Pull and read some data in app format into a small buffer.
-        int32_t framesRead = mSink->read(mAppBuffer.get(), flowgraph::kDefaultBufferSize);
+        int32_t framesRead = mSink->read(mAppBuffer.get(), mFramesPerBlock);
         if (framesRead <= 0) break;
         // Write to a block adapter, which will call the destination whenever it has enough data.
         int32_t bytesRead = mBlockWriter.write(mAppBuffer.get(),
@@ -20,8 +20,11 @@
 #include <memory>
 #include <stdint.h>
 #include <sys/types.h>
+#include <vector>
 
 #include <flowgraph/ChannelCountConverter.h>
+#include <flowgraph/ChannelMixer.h>
+#include <flowgraph/GraphCrossfader.h>
 #include <flowgraph/MonoToMultiConverter.h>
 #include <flowgraph/MultiToMonoConverter.h>
 #include <flowgraph/SampleRateConverter.h>
@@ -34,6 +37,72 @@ namespace oboe {
 class AudioStream;
 class AudioSourceCaller;
 
+/**
+ * The channel count, channel mixer and sample rate converters between two formats.
+ * This is used by DataConversionFlowGraph and by the sections that it crossfades between.
+ */
+class ConverterChain {
+public:
+    /**
+     * Connect the converters after lastOutput.
+     * Channels are reduced before the sample rate converter and expanded after it.
+     * This should only be called once for each instance.
+     *
+     * @param lastOutput output to convert
+     * @param mixerMatrix matrix for a ChannelMixer, or empty to copy the channels
+     * @param quality of the sample rate converter, if there is one
+     * @return the output of the last converter, or lastOutput if nothing is converted
+     */
+    flowgraph::FlowGraphPortFloatOutput *connect(
+            flowgraph::FlowGraphPortFloatOutput *lastOutput,
+            int32_t sourceChannelCount,
+            int32_t sourceSampleRate,
+            int32_t sinkChannelCount,
+            int32_t sinkSampleRate,
+            const std::vector<float> &mixerMatrix,
+            resampler::MultiChannelResampler::Quality quality);
+
+    /**
+     * @return the sample rate converter, or nullptr if the rate is not converted
+     */
+    resampler::MultiChannelResampler *getResampler() const {
+        return mResampler.get();
+    }
+
+    /**
+     * @return stateless nodes at the end of the chain that may be fused into the sink
+     */
+    const std::vector<flowgraph::FlowGraphNode *> &getFusibleNodes() const {
+        return mFusibleNodes;
+    }
+
+    /**
+     * @return the output that feeds the fusible nodes, or nullptr if there are none
+     */
+    flowgraph::FlowGraphPortFloatOutput *getFusibleInput() const {
+        return mFusibleInput;
+    }
+
+private:
+    flowgraph::FlowGraphPortFloatOutput *connectChannelMixer(
+            flowgraph::FlowGraphPortFloatOutput *lastOutput,
+            int32_t sinkChannelCount,
+            const std::vector<float> &mixerMatrix);
+
+    flowgraph::FlowGraphPortFloatOutput *connectChannelConverter(
+            flowgraph::FlowGraphPortFloatOutput *lastOutput,
+            int32_t sinkChannelCount);
+
+    std::unique_ptr<flowgraph::MonoToMultiConverter>   mMonoToMultiConverter;
+    std::unique_ptr<flowgraph::MultiToMonoConverter>   mMultiToMonoConverter;
+    std::unique_ptr<flowgraph::ChannelCountConverter>  mChannelCountConverter;
+    std::unique_ptr<flowgraph::ChannelMixer>           mChannelMixer;
+    std::unique_ptr<resampler::MultiChannelResampler>  mResampler;
+    std::unique_ptr<flowgraph::SampleRateConverter>    mRateConverter;
+    std::vector<flowgraph::FlowGraphNode *>            mFusibleNodes;
+    flowgraph::FlowGraphPortFloatOutput               *mFusibleInput = nullptr;
+};
+
 /**
  * Convert PCM channels, format and sample rate for optimal latency.
  */
@@ -56,6 +125,23 @@ public:
      */
     oboe::Result configure(oboe::AudioStream *sourceStream, oboe::AudioStream *sinkStream);
 
+    /**
+     * Connect a graph that converts data from a buffer set by setSource() without a stream,
+     * eg. for offline rendering. Data is then pulled with read().
+     * This should only be called once for each instance.
+     *
+     * @param framesPerBlock number of frames processed by each pass through the graph
+     * @return OK or an error if a format is not supported
+     */
+    oboe::Result configure(AudioFormat sourceFormat,
+                           int32_t sourceChannelCount,
+                           int32_t sourceSampleRate,
+                           AudioFormat sinkFormat,
+                           int32_t sinkChannelCount,
+                           int32_t sinkSampleRate,
+                           SampleRateConversionQuality quality,
+                           int32_t framesPerBlock);
+
     int32_t read(void *buffer, int32_t numFrames, int64_t timeoutNanos);
 
     int32_t write(void *buffer, int32_t numFrames);
@@ -66,20 +152,138 @@ public:
         return mCallbackResult;
     }
 
+    /**
+     * Fuse stateless nodes in front of the sink, such as channel converters,
+     * into the sink so they run in a single loop. This is enabled by default.
+     * The output is identical either way.
+     *
+     * This must be called before configure().
+     *
+     * @param enabled true to fuse nodes when possible
+     */
+    void setFusionEnabled(bool enabled) {
+        mFusionEnabled = enabled;
+    }
+
+    bool isFusionEnabled() const {
+        return mFusionEnabled;
+    }
+
+    /**
+     * Set the channel masks for configure() without streams.
+     * configure() with streams uses the channel masks of the streams.
+     *
+     * If both masks are specified and different then the channels are mixed by a ChannelMixer
+     * with a matrix for the masks, eg. a 5.1 downmix. Otherwise the channels are copied.
+     *
+     * This must be called before configure().
+     */
+    void setChannelMasks(ChannelMask sourceChannelMask, ChannelMask sinkChannelMask) {
+        mSourceChannelMask = sourceChannelMask;
+        mSinkChannelMask = sinkChannelMask;
+    }
+
+    /**
+     * Put the channel and sample rate converters in a section that can be replaced
+     * while the graph is running. See setSampleRateConversionQuality().
+     * This costs an extra copy of the data so it is disabled by default.
+     *
+     * This must be called before configure(). configure() with streams also enables it
+     * if AudioStreamBuilder::setLiveReconfigurationEnabled() was set.
+     *
+     * @param enabled true to allow the converters to be replaced
+     */
+    void setLiveReconfigurationEnabled(bool enabled) {
+        mLiveReconfigurationEnabled = enabled;
+    }
+
+    bool isLiveReconfigurationEnabled() const {
+        return mLiveReconfigurationEnabled;
+    }
+
+    /**
+     * Build new converters with a different quality and crossfade to them.
+     * The new converters are built on the calling thread, which should not be the audio thread.
+     * The audio thread switches to them at the start of its next block.
+     * The old converters are deleted by a later call to this method or by the destructor.
+     *
+     * @param quality of the new sample rate converter
+     * @return ErrorInvalidState if live reconfiguration was not enabled before configure()
+     */
+    oboe::Result setSampleRateConversionQuality(SampleRateConversionQuality quality);
+
+    /**
+     * @return the crossfader when live reconfiguration is enabled, otherwise nullptr
+     */
+    flowgraph::GraphCrossfader *getCrossfader() const {
+        return mCrossfader.get();
+    }
+
+    /**
+     * @return number of frames processed by each pass through the graph, set by configure()
+     */
+    int32_t getFramesPerBlock() const {
+        return mFramesPerBlock;
+    }
+
+    /**
+     * @return the sample rate converter, or nullptr if the rate is not converted
+     */
+    const resampler::MultiChannelResampler *getResampler() const {
+        return mConverters.getResampler();
+    }
+
+    /**
+     * Choose the number of frames that the graph processes in each pass.
+     * Larger blocks have less overhead per frame but use more cache.
+     *
+     * @param requestedFrames size set by the app, or kUnspecified
+     * @param framesPerBurst burst size of the child stream
+     * @param maxChannelCount largest channel count in the graph
+     * @return number of frames per block
+     */
+    static int32_t calculateFramesPerBlock(int32_t requestedFrames,
+                                           int32_t framesPerBurst,
+                                           int32_t maxChannelCount);
+
 private:
+    static std::unique_ptr<flowgraph::FlowGraphSourceBuffered> makeSource(AudioFormat format,
+                                                                          int32_t channelCount);
+
+    // Connect the channel and rate converters and the sink after lastOutput.
+    oboe::Result connectConverters(flowgraph::FlowGraphPortFloatOutput *lastOutput,
+                                   int32_t sourceChannelCount,
+                                   int32_t sourceSampleRate,
+                                   AudioFormat sinkFormat,
+                                   int32_t sinkChannelCount,
+                                   int32_t sinkSampleRate,
+                                   SampleRateConversionQuality quality);
+
+    // Approximate cache budget for the port buffers that are in use during one pass.
+    static constexpr int32_t kCacheBudgetBytes = 16 * 1024;
+    // Number of port buffers that are typically touched in one pass.
+    static constexpr int32_t kBuffersInCache = 4;
+
     std::unique_ptr<flowgraph::FlowGraphSourceBuffered>    mSource;
     std::unique_ptr<AudioSourceCaller>                 mSourceCaller;
-    std::unique_ptr<flowgraph::MonoToMultiConverter>   mMonoToMultiConverter;
-    std::unique_ptr<flowgraph::MultiToMonoConverter>   mMultiToMonoConverter;
-    std::unique_ptr<flowgraph::ChannelCountConverter>  mChannelCountConverter;
-    std::unique_ptr<resampler::MultiChannelResampler>  mResampler;
-    std::unique_ptr<flowgraph::SampleRateConverter>    mRateConverter;
+    ConverterChain                                     mConverters;
     std::unique_ptr<flowgraph::FlowGraphSink>              mSink;
+    std::unique_ptr<flowgraph::GraphCrossfader>        mCrossfader;
 
     FixedBlockWriter                                   mBlockWriter;
     DataCallbackResult                                 mCallbackResult = DataCallbackResult::Continue;
     AudioStream                                       *mFilterStream = nullptr;
     std::unique_ptr<uint8_t[]>                         mAppBuffer;
+    bool                                               mFusionEnabled = true;
+    bool                                               mLiveReconfigurationEnabled = false;
+    ChannelMask                                        mSourceChannelMask = ChannelMask::Unspecified;
+    ChannelMask                                        mSinkChannelMask = ChannelMask::Unspecified;
+    // Formats for the converters in the crossfader.
+    int32_t                                            mSourceChannelCount = 0;
+    int32_t                                            mSourceSampleRate = 0;
+    int32_t                                            mSinkChannelCount = 0;
+    int32_t                                            mSinkSampleRate = 0;
+    int32_t                                            mFramesPerBlock = flowgraph::kDefaultBufferSize;
 };
 
 }
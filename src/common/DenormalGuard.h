@@ -0,0 +1,118 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMMON_DENORMAL_GUARD_H
+#define COMMON_DENORMAL_GUARD_H
+
+#include <cstdint>
+
+#if defined(__SSE__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#define DENORMAL_GUARD_SSE 1
+#elif defined(__aarch64__)
+#define DENORMAL_GUARD_AARCH64 1
+#elif defined(__arm__) && defined(__ARM_FP)
+#define DENORMAL_GUARD_ARM 1
+#endif
+
+namespace oboe {
+
+/**
+ * Treat subnormal floats as zero while this object is in scope.
+ * The previous floating point mode of the thread is restored by the destructor.
+ *
+ * Filters with feedback, such as IIR filters, echoes and decaying envelopes,
+ * produce subnormal values as the signal fades to silence. Those can make the
+ * arithmetic 10 to 100 times slower on x86 and ARM.
+ *
+ * On x86 this sets the FTZ and DAZ bits of MXCSR. On ARM it sets the FZ bit of
+ * FPCR or FPSCR, which flushes both the inputs and the outputs.
+ * It does nothing on other CPUs.
+ */
+class DenormalGuard {
+public:
+    /**
+     * @param enabled if false then the mode is not changed
+     */
+    explicit DenormalGuard(bool enabled) : mEnabled(enabled) {
+        if (mEnabled) {
+            mSavedControl = readControl();
+            writeControl(mSavedControl | kFlushToZeroBits);
+        }
+    }
+
+    ~DenormalGuard() {
+        if (mEnabled) {
+            writeControl(mSavedControl);
+        }
+    }
+
+    DenormalGuard(const DenormalGuard&) = delete;
+    DenormalGuard& operator=(const DenormalGuard&) = delete;
+
+    /**
+     * @return true if subnormals can be flushed on this CPU
+     */
+    static constexpr bool isSupported() {
+        return kFlushToZeroBits != 0;
+    }
+
+private:
+#if DENORMAL_GUARD_SSE
+    using Control = uint32_t;
+    static constexpr Control kFlushToZeroBits = 0x8040; // FTZ | DAZ
+
+    static Control readControl() { return _mm_getcsr(); }
+    static void writeControl(Control control) { _mm_setcsr(control); }
+#elif DENORMAL_GUARD_AARCH64
+    using Control = uint64_t;
+    static constexpr Control kFlushToZeroBits = 1 << 24; // FZ
+
+    static Control readControl() {
+        Control control;
+        __asm__ __volatile__("mrs %0, fpcr" : "=r"(control));
+        return control;
+    }
+    static void writeControl(Control control) {
+        __asm__ __volatile__("msr fpcr, %0" : : "r"(control));
+    }
+#elif DENORMAL_GUARD_ARM
+    using Control = uint32_t;
+    static constexpr Control kFlushToZeroBits = 1 << 24; // FZ
+
+    static Control readControl() {
+        Control control;
+        __asm__ __volatile__("vmrs %0, fpscr" : "=r"(control));
+        return control;
+    }
+    static void writeControl(Control control) {
+        __asm__ __volatile__("vmsr fpscr, %0" : : "r"(control));
+    }
+#else
+    using Control = uint32_t;
+    static constexpr Control kFlushToZeroBits = 0;
+
+    static Control readControl() { return 0; }
+    static void writeControl(Control /*control*/) {}
+#endif
+
+    const bool mEnabled;
+    Control    mSavedControl = 0;
+};
+
+} // namespace oboe
+
+#endif //COMMON_DENORMAL_GUARD_H
@@ -53,6 +53,20 @@ Result FilterAudioStream::configureFlowGraph() {
     return mFlowGraph->configure(sourceStream, sinkStream);
 }
 
+Result FilterAudioStream::setSampleRateConversionQuality(SampleRateConversionQuality quality) {
+    if (quality == SampleRateConversionQuality::None) {
+        return Result::ErrorIllegalArgument;
+    }
+    if (!mFlowGraph || getSampleRate() == mChildStream->getSampleRate()) {
+        return Result::ErrorInvalidState;
+    }
+    Result result = mFlowGraph->setSampleRateConversionQuality(quality);
+    if (result == Result::OK) {
+        mSampleRateConversionQuality = quality;
+    }
+    return result;
+}
+
 // Put the data to be written at the source end of the flowgraph.
 // Then read (pull) the data from the flowgraph and write it to the
 // child stream.
@@ -138,6 +138,17 @@ public:
         return mChildStream->getAudioApi();
     }
 
+    Result setSampleRateConversionQuality(SampleRateConversionQuality quality) override;
+
+    // The callbacks come from the child stream.
+    const CallbackStatistics &getCallbackStatistics() const override {
+        return mChildStream->getCallbackStatistics();
+    }
+
+    void resetCallbackStatistics() override {
+        mChildStream->resetCallbackStatistics();
+    }
+
     void updateFramesWritten() override {
         // TODO for output, just count local writes?
         mFramesWritten = static_cast<int64_t>(mChildStream->getFramesWritten() * mRateScaler);
@@ -18,12 +18,14 @@
 #ifndef OBOE_DEBUG_H
 #define OBOE_DEBUG_H
 
-#include <android/log.h>
-
 #ifndef MODULE_NAME
 #define MODULE_NAME  "OboeAudio"
 #endif
 
+#ifdef __ANDROID__
+
+#include <android/log.h>
+
 // Always log INFO and errors.
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, MODULE_NAME, __VA_ARGS__)
 #define LOGW(...) __android_log_print(ANDROID_LOG_WARN, MODULE_NAME, __VA_ARGS__)
@@ -38,4 +40,32 @@
 #define LOGD(...)
 #endif
 
+#else // __ANDROID__
+
+// Host builds have no logcat so print to stderr.
+#include <cstdio>
+
+#define OBOE_HOST_LOG(level, ...) \
+    do { \
+        fprintf(stderr, "%s " MODULE_NAME ": ", level); \
+        fprintf(stderr, __VA_ARGS__); \
+        fputc('\n', stderr); \
+    } while (0)
+
+// Always log INFO and errors.
+#define LOGI(...) OBOE_HOST_LOG("I", __VA_ARGS__)
+#define LOGW(...) OBOE_HOST_LOG("W", __VA_ARGS__)
+#define LOGE(...) OBOE_HOST_LOG("E", __VA_ARGS__)
+#define LOGF(...) OBOE_HOST_LOG("F", __VA_ARGS__)
+
+#if OBOE_ENABLE_LOGGING
+#define LOGV(...) OBOE_HOST_LOG("V", __VA_ARGS__)
+#define LOGD(...) OBOE_HOST_LOG("D", __VA_ARGS__)
+#else
+#define LOGV(...)
+#define LOGD(...)
+#endif
+
+#endif // __ANDROID__
+
 #endif //OBOE_DEBUG_H
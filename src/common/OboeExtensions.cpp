@@ -15,10 +15,14 @@
  */
 
 #include "oboe/OboeExtensions.h"
+#ifdef __ANDROID__
 #include "aaudio/AAudioExtensions.h"
+#endif
 
 using namespace oboe;
 
+#ifdef __ANDROID__
+
 bool OboeExtensions::isMMapSupported(){
     return AAudioExtensions::getInstance().isMMapSupported();
 }
@@ -34,3 +38,24 @@ int32_t OboeExtensions::setMMapEnabled(bool enabled){
 bool OboeExtensions::isMMapUsed(oboe::AudioStream *oboeStream){
     return AAudioExtensions::getInstance().isMMapUsed(oboeStream);
 }
+
+#else // __ANDROID__
+
+// There is no MMAP on the host.
+bool OboeExtensions::isMMapSupported(){
+    return false;
+}
+
+bool OboeExtensions::isMMapEnabled(){
+    return false;
+}
+
+int32_t OboeExtensions::setMMapEnabled(bool /* enabled */){
+    return static_cast<int32_t>(Result::ErrorUnimplemented);
+}
+
+bool OboeExtensions::isMMapUsed(oboe::AudioStream * /* oboeStream */){
+    return false;
+}
+
+#endif // __ANDROID__
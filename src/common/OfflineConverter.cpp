@@ -0,0 +1,267 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "oboe/OfflineConverter.h"
+#include "oboe/Utilities.h"
+#include "common/DataConversionFlowGraph.h"
+#include "common/OboeDebug.h"
+#include "flowgraph/FlowGraphWorkerPool.h"
+
+using namespace oboe;
+using namespace flowgraph;
+
+// A flowgraph source holds an int32_t frame count so large inputs are set in pieces.
+constexpr int64_t kMaxFramesPerSource = 1 << 24;
+
+namespace {
+
+struct ChunkPlan {
+    OfflineConverter *converter;
+    const uint8_t    *input;
+    int64_t           numInputFrames;
+    uint8_t          *output;
+    int64_t           numOutputFrames;
+    int64_t           framesPerChunk;
+    int64_t           preRollFrames;
+    std::vector<Result> results;
+};
+
+} // namespace
+
+int32_t OfflineConverter::Format::getBytesPerFrame() const {
+    return channelCount * convertFormatToSizeInBytes(format);
+}
+
+OfflineConverter::OfflineConverter(const Format &input,
+                                   const Format &output,
+                                   SampleRateConversionQuality quality)
+        : mInput(input)
+        , mOutput(output)
+        , mQuality(quality) {}
+
+int64_t OfflineConverter::getOutputFrameCount(int64_t numInputFrames) const {
+    if (mInput.sampleRate <= 0 || numInputFrames <= 0) {
+        return 0;
+    }
+    return (numInputFrames * mOutput.sampleRate + mInput.sampleRate - 1) / mInput.sampleRate;
+}
+
+ResultWithValue<int64_t> OfflineConverter::convert(const void *input,
+                                                   int64_t numInputFrames,
+                                                   void *output,
+                                                   int64_t outputCapacity) {
+    if (mInput.getBytesPerFrame() <= 0 || mOutput.getBytesPerFrame() <= 0) {
+        return Result::ErrorInvalidFormat;
+    }
+    if (mInput.sampleRate <= 0 || mOutput.sampleRate <= 0) {
+        return Result::ErrorInvalidRate;
+    }
+    if (mFramesPerBlock <= 0 || numInputFrames < 0) {
+        return Result::ErrorIllegalArgument;
+    }
+    const int64_t numOutputFrames = getOutputFrameCount(numInputFrames);
+    if (numOutputFrames == 0) {
+        return ResultWithValue<int64_t>(0);
+    }
+    if (input == nullptr || output == nullptr) {
+        return Result::ErrorNull;
+    }
+    if (outputCapacity < numOutputFrames) {
+        return Result::ErrorOutOfRange;
+    }
+
+    // Build a graph to find out how the resampler has to be aligned.
+    DataConversionFlowGraph probe;
+    probe.setChannelMasks(mInput.channelMask, mOutput.channelMask);
+    Result result = probe.configure(mInput.format, mInput.channelCount, mInput.sampleRate,
+                                    mOutput.format, mOutput.channelCount, mOutput.sampleRate,
+                                    mQuality, mFramesPerBlock);
+    if (result != Result::OK) {
+        return result;
+    }
+    int64_t framesPerCycle = 1;
+    int64_t preRollFrames = 0;
+    const resampler::MultiChannelResampler *resampler = probe.getResampler();
+    if (resampler != nullptr) {
+        // The output frame at the start of every chunk must be an integer.
+        const int64_t inputRate = mInput.sampleRate;
+        framesPerCycle = std::lcm(static_cast<int64_t>(resampler->getInputFramesPerCycle()),
+                                  inputRate / std::gcd(inputRate,
+                                                       static_cast<int64_t>(mOutput.sampleRate)));
+        // Enough input to fill the history of every stage of the resampler.
+        const int64_t historyFrames = 2 * static_cast<int64_t>(resampler->getNumTaps());
+        preRollFrames = ((historyFrames + framesPerCycle - 1) / framesPerCycle) * framesPerCycle;
+    }
+
+    const int32_t threadCount = std::max(1, mThreadCount);
+    int64_t framesPerChunk = (mFramesPerChunk > 0)
+            ? mFramesPerChunk
+            : std::max(kMinFramesPerChunk, (numInputFrames + threadCount - 1) / threadCount);
+    framesPerChunk = ((framesPerChunk + framesPerCycle - 1) / framesPerCycle) * framesPerCycle;
+    const int64_t numChunks = std::max(static_cast<int64_t>(1),
+            (numInputFrames + framesPerChunk - 1) / framesPerChunk);
+    if (numChunks > INT32_MAX) {
+        return Result::ErrorOutOfRange;
+    }
+
+    ChunkPlan plan{this, static_cast<const uint8_t *>(input), numInputFrames,
+                   static_cast<uint8_t *>(output), numOutputFrames,
+                   framesPerChunk, preRollFrames,
+                   std::vector<Result>(static_cast<size_t>(numChunks), Result::OK)};
+    const int32_t numWorkers = static_cast<int32_t>(
+            std::min(static_cast<int64_t>(threadCount), numChunks)) - 1;
+    if (numWorkers > 0) {
+        // Offline work should not compete with real-time audio threads.
+        FlowGraphWorkerPool pool(numWorkers, false /* realTime */);
+        pool.run(convertChunkTask, &plan, static_cast<int32_t>(numChunks));
+    } else {
+        for (int32_t i = 0; i < static_cast<int32_t>(numChunks); i++) {
+            convertChunkTask(&plan, i);
+        }
+    }
+    for (Result chunkResult : plan.results) {
+        if (chunkResult != Result::OK) {
+            return chunkResult;
+        }
+    }
+    return ResultWithValue<int64_t>(numOutputFrames);
+}
+
+void OfflineConverter::convertChunkTask(void *context, int32_t chunkIndex) {
+    ChunkPlan *plan = static_cast<ChunkPlan *>(context);
+    OfflineConverter *converter = plan->converter;
+    const int64_t firstInputFrame = chunkIndex * plan->framesPerChunk;
+    const int64_t endInputFrame = firstInputFrame + plan->framesPerChunk;
+    const int64_t startInputFrame = std::max(static_cast<int64_t>(0),
+                                             firstInputFrame - plan->preRollFrames);
+    // The last chunk also writes the output for the silence after the input.
+    const int64_t endOutputFrame = (endInputFrame >= plan->numInputFrames)
+            ? plan->numOutputFrames
+            : endInputFrame * converter->mOutput.sampleRate / converter->mInput.sampleRate;
+    auto result = converter->convertChunk(plan->input, plan->numInputFrames,
+                                          startInputFrame, firstInputFrame,
+                                          plan->output, endOutputFrame);
+    plan->results[chunkIndex] = result.error();
+}
+
+ResultWithValue<int64_t> OfflineConverter::convertChunk(const uint8_t *input,
+                                                        int64_t numInputFrames,
+                                                        int64_t startInputFrame,
+                                                        int64_t firstInputFrame,
+                                                        uint8_t *output,
+                                                        int64_t endOutputFrame) {
+    DataConversionFlowGraph graph;
+    graph.setChannelMasks(mInput.channelMask, mOutput.channelMask);
+    Result result = graph.configure(mInput.format, mInput.channelCount, mInput.sampleRate,
+                                    mOutput.format, mOutput.channelCount, mOutput.sampleRate,
+                                    mQuality, mFramesPerBlock);
+    if (result != Result::OK) {
+        return result;
+    }
+    const int64_t inputBytesPerFrame = mInput.getBytesPerFrame();
+    const int64_t outputBytesPerFrame = mOutput.getBytesPerFrame();
+    // Both input positions are at the start of a resampler cycle so these are exact.
+    int64_t outputFrame = startInputFrame * mOutput.sampleRate / mInput.sampleRate;
+    const int64_t firstOutputFrame = firstInputFrame * mOutput.sampleRate / mInput.sampleRate;
+
+    // The output of the pre-roll is only needed to fill the history of the resampler.
+    std::vector<uint8_t> discarded(static_cast<size_t>(mFramesPerBlock * outputBytesPerFrame));
+    std::vector<uint8_t> silence;
+    int64_t inputFrame = startInputFrame;
+    while (outputFrame < endOutputFrame) {
+        if (inputFrame < numInputFrames) {
+            const int64_t framesToSet = std::min(numInputFrames - inputFrame, kMaxFramesPerSource);
+            graph.setSource(&input[inputFrame * inputBytesPerFrame],
+                            static_cast<int32_t>(framesToSet));
+            inputFrame += framesToSet;
+        } else {
+            if (silence.empty()) {
+                silence.resize(static_cast<size_t>(mFramesPerBlock * inputBytesPerFrame), 0);
+            }
+            graph.setSource(silence.data(), mFramesPerBlock);
+        }
+        // Pull until the graph runs out of input.
+        while (outputFrame < endOutputFrame) {
+            int32_t framesRead;
+            if (outputFrame < firstOutputFrame) {
+                const int64_t framesLeft = firstOutputFrame - outputFrame;
+                framesRead = graph.read(discarded.data(), static_cast<int32_t>(
+                        std::min(framesLeft, static_cast<int64_t>(mFramesPerBlock))), 0);
+            } else {
+                const int64_t framesLeft = endOutputFrame - outputFrame;
+                framesRead = graph.read(&output[outputFrame * outputBytesPerFrame],
+                                        static_cast<int32_t>(std::min(framesLeft,
+                                                kMaxFramesPerSource)), 0);
+            }
+            if (framesRead <= 0) {
+                break;
+            }
+            outputFrame += framesRead;
+        }
+    }
+    return ResultWithValue<int64_t>(endOutputFrame - firstOutputFrame);
+}
+
+Result OfflineConverter::convertFile(const std::string &inputPath,
+                                     const std::string &outputPath) {
+    const int32_t inputBytesPerFrame = mInput.getBytesPerFrame();
+    const int32_t outputBytesPerFrame = mOutput.getBytesPerFrame();
+    if (inputBytesPerFrame <= 0 || outputBytesPerFrame <= 0) {
+        return Result::ErrorInvalidFormat;
+    }
+    FILE *inputFile = fopen(inputPath.c_str(), "rb");
+    if (inputFile == nullptr) {
+        LOGE("OfflineConverter::%s() could not open %s", __func__, inputPath.c_str());
+        return Result::ErrorIllegalArgument;
+    }
+    std::vector<uint8_t> inputData;
+    uint8_t buffer[64 * 1024];
+    size_t numBytes;
+    while ((numBytes = fread(buffer, 1, sizeof(buffer), inputFile)) > 0) {
+        inputData.insert(inputData.end(), buffer, buffer + numBytes);
+    }
+    fclose(inputFile);
+
+    // A partial frame at the end of the file is ignored.
+    const int64_t numInputFrames = static_cast<int64_t>(inputData.size()) / inputBytesPerFrame;
+    const int64_t numOutputFrames = getOutputFrameCount(numInputFrames);
+    std::vector<uint8_t> outputData(static_cast<size_t>(numOutputFrames * outputBytesPerFrame));
+    ResultWithValue<int64_t> result = convert(inputData.data(), numInputFrames,
+                                              outputData.data(), numOutputFrames);
+    if (!result) {
+        return result.error();
+    }
+
+    FILE *outputFile = fopen(outputPath.c_str(), "wb");
+    if (outputFile == nullptr) {
+        LOGE("OfflineConverter::%s() could not open %s", __func__, outputPath.c_str());
+        return Result::ErrorIllegalArgument;
+    }
+    const size_t bytesWritten = fwrite(outputData.data(), 1, outputData.size(), outputFile);
+    const bool closed = (fclose(outputFile) == 0);
+    if (bytesWritten != outputData.size() || !closed) {
+        LOGE("OfflineConverter::%s() could not write %s", __func__, outputPath.c_str());
+        return Result::ErrorInternal;
+    }
+    return Result::OK;
+}
@@ -19,8 +19,23 @@
 
 #include <memory>
 #include <oboe/AudioStreamBuilder.h>
+#ifdef __ANDROID__
 #include <aaudio/AudioStreamAAudio.h>
+#endif
 
+// Host builds do not have android/api-level.h.
+#ifndef __ANDROID_API_L__
+#define __ANDROID_API_L__ 21
+#endif
+#ifndef __ANDROID_API_M__
+#define __ANDROID_API_M__ 23
+#endif
+#ifndef __ANDROID_API_O__
+#define __ANDROID_API_O__ 26
+#endif
+#ifndef __ANDROID_API_P__
+#define __ANDROID_API_P__ 28
+#endif
 #ifndef __ANDROID_API_R__
 #define __ANDROID_API_R__ 30
 #endif
@@ -60,11 +75,15 @@ public:
 
     static bool isMMapUsed(AudioStream &stream) {
         bool answer = false;
+#ifdef __ANDROID__
         if (stream.getAudioApi() == AudioApi::AAudio) {
             AudioStreamAAudio *streamAAudio =
                     reinterpret_cast<AudioStreamAAudio *>(&stream);
             answer = streamAAudio->isMMapUsed();
         }
+#else
+        (void) stream;
+#endif
         return answer;
     }
 
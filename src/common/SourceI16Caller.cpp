@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <unistd.h>
 #include "flowgraph/FlowGraphNode.h"
+#include "flowgraph/PcmConversion.h"
 #include "SourceI16Caller.h"
 
 #if FLOWGRAPH_ANDROID_INTERNAL
@@ -38,9 +39,7 @@ int32_t SourceI16Caller::onProcess(int32_t numFrames) {
 #if FLOWGRAPH_ANDROID_INTERNAL
     memcpy_to_float_from_i16(floatData, shortData, numSamples);
 #else
-    for (int i = 0; i < numSamples; i++) {
-        *floatData++ = *shortData++ * (1.0f / 32768);
-    }
+    PcmConversion::convertI16ToFloat(shortData, floatData, numSamples);
 #endif
 
     return framesRead;
@@ -32,16 +32,25 @@ class SourceI16Caller : public AudioSourceCaller {
 public:
     SourceI16Caller(int32_t channelCount, int32_t framesPerCallback)
     : AudioSourceCaller(channelCount, framesPerCallback, sizeof(int16_t)) {
-        mConversionBuffer = std::make_unique<int16_t[]>(static_cast<size_t>(channelCount)
-                * static_cast<size_t>(output.getFramesPerBuffer()));
+        allocateConversionBuffer();
     }
 
     int32_t onProcess(int32_t numFrames) override;
 
+    void setFramesPerBuffer(int32_t framesPerBuffer) override {
+        AudioSourceCaller::setFramesPerBuffer(framesPerBuffer);
+        allocateConversionBuffer();
+    }
+
     const char *getName() override {
         return "SourceI16Caller";
     }
 private:
+    void allocateConversionBuffer() {
+        mConversionBuffer = std::make_unique<int16_t[]>(static_cast<size_t>(output.getSamplesPerFrame())
+                * static_cast<size_t>(output.getFramesPerBuffer()));
+    }
+
     std::unique_ptr<int16_t[]>  mConversionBuffer;
 };
 
@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <unistd.h>
 #include "flowgraph/FlowGraphNode.h"
+#include "flowgraph/PcmConversion.h"
 #include "SourceI24Caller.h"
 
 #if FLOWGRAPH_ANDROID_INTERNAL
@@ -38,18 +39,7 @@ int32_t SourceI24Caller::onProcess(int32_t numFrames) {
 #if FLOWGRAPH_ANDROID_INTERNAL
     memcpy_to_float_from_p24(floatData, byteData, numSamples);
 #else
-    static const float scale = 1. / (float)(1UL << 31);
-    for (int i = 0; i < numSamples; i++) {
-        // Assemble the data assuming Little Endian format.
-        int32_t pad = byteData[2];
-        pad <<= 8;
-        pad |= byteData[1];
-        pad <<= 8;
-        pad |= byteData[0];
-        pad <<= 8; // Shift to 32 bit data so the sign is correct.
-        byteData += kBytesPerI24Packed;
-        *floatData++ = pad * scale; // scale to range -1.0 to 1.0
-    }
+    PcmConversion::convertP24ToFloat(byteData, floatData, numSamples);
 #endif
 
     return framesRead;
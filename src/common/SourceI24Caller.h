@@ -33,18 +33,27 @@ class SourceI24Caller : public AudioSourceCaller {
 public:
     SourceI24Caller(int32_t channelCount, int32_t framesPerCallback)
     : AudioSourceCaller(channelCount, framesPerCallback, kBytesPerI24Packed) {
-        mConversionBuffer = std::make_unique<uint8_t[]>(static_cast<size_t>(kBytesPerI24Packed)
-                * static_cast<size_t>(channelCount)
-                * static_cast<size_t>(output.getFramesPerBuffer()));
+        allocateConversionBuffer();
     }
 
     int32_t onProcess(int32_t numFrames) override;
 
+    void setFramesPerBuffer(int32_t framesPerBuffer) override {
+        AudioSourceCaller::setFramesPerBuffer(framesPerBuffer);
+        allocateConversionBuffer();
+    }
+
     const char *getName() override {
         return "SourceI24Caller";
     }
 
 private:
+    void allocateConversionBuffer() {
+        mConversionBuffer = std::make_unique<uint8_t[]>(static_cast<size_t>(kBytesPerI24Packed)
+                * static_cast<size_t>(output.getSamplesPerFrame())
+                * static_cast<size_t>(output.getFramesPerBuffer()));
+    }
+
     std::unique_ptr<uint8_t[]>  mConversionBuffer;
     static constexpr int kBytesPerI24Packed = 3;
 };
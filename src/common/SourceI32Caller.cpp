@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <unistd.h>
 #include "flowgraph/FlowGraphNode.h"
+#include "flowgraph/PcmConversion.h"
 #include "SourceI32Caller.h"
 
 #if FLOWGRAPH_ANDROID_INTERNAL
@@ -36,11 +37,9 @@ int32_t SourceI32Caller::onProcess(int32_t numFrames) {
     int32_t numSamples = framesRead * output.getSamplesPerFrame();
 
 #if FLOWGRAPH_ANDROID_INTERNAL
-    memcpy_to_float_from_i32(floatData, shortData, numSamples);
+    memcpy_to_float_from_i32(floatData, intData, numSamples);
 #else
-    for (int i = 0; i < numSamples; i++) {
-        *floatData++ = *intData++ * kScale;
-    }
+    PcmConversion::convertI32ToFloat(intData, floatData, numSamples);
 #endif
 
     return framesRead;
@@ -34,19 +34,27 @@ class SourceI32Caller : public AudioSourceCaller {
 public:
     SourceI32Caller(int32_t channelCount, int32_t framesPerCallback)
     : AudioSourceCaller(channelCount, framesPerCallback, sizeof(int32_t)) {
-        mConversionBuffer = std::make_unique<int32_t[]>(static_cast<size_t>(channelCount)
-                * static_cast<size_t>(output.getFramesPerBuffer()));
+        allocateConversionBuffer();
     }
 
     int32_t onProcess(int32_t numFrames) override;
 
+    void setFramesPerBuffer(int32_t framesPerBuffer) override {
+        AudioSourceCaller::setFramesPerBuffer(framesPerBuffer);
+        allocateConversionBuffer();
+    }
+
     const char *getName() override {
         return "SourceI32Caller";
     }
 
 private:
+    void allocateConversionBuffer() {
+        mConversionBuffer = std::make_unique<int32_t[]>(static_cast<size_t>(output.getSamplesPerFrame())
+                * static_cast<size_t>(output.getFramesPerBuffer()));
+    }
+
     std::unique_ptr<int32_t[]>  mConversionBuffer;
-    static constexpr float kScale = 1.0 / (1UL << 31);
 };
 
 }
@@ -16,15 +16,20 @@
 
 #include "oboe/StabilizedCallback.h"
 #include "common/AudioClock.h"
-#include "common/Trace.h"
+#include "oboe/Tracer.h"
 
 constexpr int32_t kLoadGenerationStepSizeNanos = 20000;
 constexpr float kPercentageOfCallbackToUse = 0.8;
 
 using namespace oboe;
 
+// Interned when the library is loaded so the audio thread does not take the name lock.
+static const uint32_t kActualLoadName = Tracer::internString("Actual load");
+static const uint32_t kStabilizedLoadName = Tracer::internString("Stabilized load");
+static const uint32_t kStabilizedNanosName = Tracer::internString("Stabilized load nanos");
+
 StabilizedCallback::StabilizedCallback(AudioStreamCallback *callback) : mCallback(callback){
-    Trace::initialize();
+    Tracer::initialize();
 }
 
 /**
@@ -64,16 +69,17 @@ StabilizedCallback::onAudioReady(AudioStream *oboeStream, void *audioData, int32
     int64_t targetDurationNanos = static_cast<int64_t>(
             (numFramesAsNanos * kPercentageOfCallbackToUse) - lateStartNanos);
 
-    Trace::beginSection("Actual load");
+    Tracer::beginSection(kActualLoadName);
     DataCallbackResult result = mCallback->onAudioReady(oboeStream, audioData, numFrames);
-    Trace::endSection();
+    Tracer::endSection();
 
     int64_t executionDurationNanos = AudioClock::getNanoseconds() - startTimeNanos;
     int64_t stabilizingLoadDurationNanos = targetDurationNanos - executionDurationNanos;
 
-    Trace::beginSection("Stabilized load for %lldns", stabilizingLoadDurationNanos);
+    Tracer::setCounter(kStabilizedNanosName, stabilizingLoadDurationNanos);
+    Tracer::beginSection(kStabilizedLoadName);
     generateLoad(stabilizingLoadDurationNanos);
-    Trace::endSection();
+    Tracer::endSection();
 
     // Wraparound: At 48000 frames per second mFrameCount wraparound will occur after 6m years,
     // significantly longer than the average lifetime of an Android phone.
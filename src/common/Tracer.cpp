@@ -0,0 +1,394 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "oboe/Tracer.h"
+#include "common/AudioClock.h"
+#include "common/OboeDebug.h"
+
+using namespace oboe;
+
+namespace {
+
+struct TraceRecord {
+    int64_t  timeNanos;
+    int64_t  value;
+    uint32_t nameId;
+    int32_t  threadId;
+    uint8_t  type;
+};
+
+constexpr uint64_t kRecordIndexMask = Tracer::kRecordsPerThread - 1;
+static_assert((Tracer::kRecordsPerThread & kRecordIndexMask) == 0,
+              "kRecordsPerThread must be a power of two");
+
+/**
+ * Records written by one thread at a time. A ring is released when its thread exits
+ * and can then be used by a new thread. The old records are kept.
+ */
+struct TraceRing {
+    std::atomic<bool>     isOwned{false};
+    // Only used by the owner.
+    int32_t               threadId = 0;
+    // Records before this were cleared.
+    std::atomic<uint64_t> clearCounter{0};
+    // Written by the owner. Read by the exporter.
+    alignas(64) std::atomic<uint64_t> writeCounter{0};
+    TraceRecord           records[Tracer::kRecordsPerThread];
+};
+
+} // namespace
+
+std::atomic<bool> Tracer::mIsEnabled{false};
+std::atomic<bool> Tracer::mIsATraceLoaded{false};
+
+// The rings are never freed so the exporter can always read them.
+static std::atomic<TraceRing *> sRings[Tracer::kMaxThreads] = {};
+static std::atomic<int64_t> sDroppedEventCount{0};
+
+// Names are only added, so they can be read without the lock.
+static std::mutex sNameLock;
+static const char *sNames[Tracer::kMaxNames] = {"unknown"};
+static std::atomic<int32_t> sNumNames{1};
+
+#if defined(__ANDROID__)
+// Forward the events to ATrace. Using dlsym allows us to use tracing on API 21+ without
+// needing android/trace.h which wasn't published until API 23.
+typedef void (*fp_ATrace_beginSection)(const char *sectionName);
+typedef void (*fp_ATrace_endSection)();
+typedef void (*fp_ATrace_setCounter)(const char *counterName, int64_t counterValue); // API 29
+typedef bool (*fp_ATrace_isEnabled)(); // API 23
+
+static std::atomic<fp_ATrace_beginSection> ATrace_beginSection{nullptr};
+static std::atomic<fp_ATrace_endSection> ATrace_endSection{nullptr};
+static std::atomic<fp_ATrace_setCounter> ATrace_setCounter{nullptr};
+static std::atomic<fp_ATrace_isEnabled> ATrace_isEnabled{nullptr};
+
+static bool loadATrace() {
+    void *lib = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+    if (lib == nullptr) {
+        LOGW("Could not open libandroid.so so the trace is not passed to ATrace");
+        return false;
+    }
+    auto beginSection = reinterpret_cast<fp_ATrace_beginSection>(
+            dlsym(lib, "ATrace_beginSection"));
+    auto endSection = reinterpret_cast<fp_ATrace_endSection>(dlsym(lib, "ATrace_endSection"));
+    if (beginSection == nullptr || endSection == nullptr) {
+        return false;
+    }
+    ATrace_isEnabled.store(reinterpret_cast<fp_ATrace_isEnabled>(
+            dlsym(lib, "ATrace_isEnabled")), std::memory_order_release);
+    ATrace_setCounter.store(reinterpret_cast<fp_ATrace_setCounter>(
+            dlsym(lib, "ATrace_setCounter")), std::memory_order_release);
+    ATrace_beginSection.store(beginSection, std::memory_order_release);
+    ATrace_endSection.store(endSection, std::memory_order_release);
+    return true;
+}
+
+// Before API 23 there is no way to ask, so pass everything like the old Trace class did.
+static bool isATraceEnabled() {
+    fp_ATrace_isEnabled isEnabled = ATrace_isEnabled.load(std::memory_order_acquire);
+    return isEnabled == nullptr || isEnabled();
+}
+
+// Which of the open sections on this thread were passed to ATrace, one bit per depth.
+// An end is only passed on if its begin was. Otherwise a systrace that starts in the
+// middle of a section would end a section that belongs to the app.
+// This is trivial so it does not need a thread_local destructor. See issue 360.
+struct ATraceSectionStack {
+    uint64_t passedMask;
+    int32_t  depth;
+};
+static constexpr int32_t kMaxATraceDepth = 64;
+static thread_local ATraceSectionStack tATraceSections{0, 0};
+
+#endif // __ANDROID__
+
+static void releaseRing(void *ring) {
+    static_cast<TraceRing *>(ring)->isOwned.store(false, std::memory_order_release);
+}
+
+static pthread_key_t createRingKey() {
+    pthread_key_t key;
+    pthread_key_create(&key, releaseRing);
+    return key;
+}
+
+// A pthread key instead of thread_local so that the destructor does not depend
+// on the C++ runtime. See issue 360. It is created when the library is loaded.
+static const pthread_key_t sRingKey = createRingKey();
+
+// Called by the recording thread. This never allocates. See Tracer::reserveRings().
+static TraceRing *claimRing() {
+    for (std::atomic<TraceRing *> &slot : sRings) {
+        TraceRing *ring = slot.load(std::memory_order_acquire);
+        if (ring == nullptr) {
+            continue;
+        }
+        bool isOwned = false;
+        if (ring->isOwned.compare_exchange_strong(isOwned, true, std::memory_order_acquire)) {
+            return ring;
+        }
+    }
+    return nullptr;
+}
+
+void Tracer::initialize() {
+#if defined(__ANDROID__)
+    static const bool isATraceLoaded = loadATrace();
+    mIsATraceLoaded.store(isATraceLoaded, std::memory_order_release);
+#endif
+    if (isEnabled()) {
+        // For the callback thread of the stream that is being opened.
+        reserveRings(kDefaultReservedRings);
+    }
+}
+
+void Tracer::setEnabled(bool enabled) {
+    if (enabled) {
+        reserveRings(kDefaultReservedRings);
+    }
+    mIsEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Tracer::reserveRings(int32_t numThreads) {
+    int32_t numFree = 0;
+    for (std::atomic<TraceRing *> &slot : sRings) {
+        TraceRing *ring = slot.load(std::memory_order_acquire);
+        if (ring != nullptr) {
+            if (!ring->isOwned.load(std::memory_order_acquire)) {
+                numFree++;
+            }
+        } else if (numFree < numThreads) {
+            TraceRing *newRing = new TraceRing();
+            if (slot.compare_exchange_strong(ring, newRing, std::memory_order_acq_rel)) {
+                numFree++;
+            } else {
+                // Another thread filled this slot first.
+                delete newRing;
+            }
+        }
+        if (numFree >= numThreads) {
+            return;
+        }
+    }
+}
+
+uint32_t Tracer::internString(const char *name) {
+    std::lock_guard<std::mutex> lock(sNameLock);
+    const int32_t numNames = sNumNames.load(std::memory_order_relaxed);
+    for (int32_t i = 1; i < numNames; i++) {
+        if (strcmp(sNames[i], name) == 0) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    if (numNames >= kMaxNames) {
+        LOGW("Tracer::%s() too many names, %s is traced as unknown", __func__, name);
+        return 0;
+    }
+    // Interned names are kept for the life of the process.
+    sNames[numNames] = strdup(name);
+    sNumNames.store(numNames + 1, std::memory_order_release);
+    return static_cast<uint32_t>(numNames);
+}
+
+const char *Tracer::getString(uint32_t nameId) {
+    if (nameId >= static_cast<uint32_t>(sNumNames.load(std::memory_order_acquire))) {
+        return sNames[0];
+    }
+    return sNames[nameId];
+}
+
+void Tracer::recordEvent(uint8_t type, uint32_t nameId, int64_t value) {
+#if defined(__ANDROID__)
+    if (mIsATraceLoaded.load(std::memory_order_acquire)) {
+        ATraceSectionStack &stack = tATraceSections;
+        if (type == kTypeBegin) {
+            // Decide once for the whole section.
+            if (stack.depth < kMaxATraceDepth) {
+                const uint64_t bit = 1ull << stack.depth;
+                if (isATraceEnabled()) {
+                    ATrace_beginSection.load(std::memory_order_relaxed)(getString(nameId));
+                    stack.passedMask |= bit;
+                } else {
+                    stack.passedMask &= ~bit;
+                }
+            }
+            stack.depth++;
+        } else if (type == kTypeEnd) {
+            if (stack.depth > 0) {
+                stack.depth--;
+                if (stack.depth < kMaxATraceDepth
+                        && (stack.passedMask & (1ull << stack.depth)) != 0) {
+                    ATrace_endSection.load(std::memory_order_relaxed)();
+                }
+            }
+        } else if (isATraceEnabled()) {
+            fp_ATrace_setCounter setCounter = ATrace_setCounter.load(std::memory_order_relaxed);
+            if (setCounter != nullptr) {
+                setCounter(getString(nameId), value);
+            } else {
+                // Before API 29 put the value in the name of an empty section,
+                // so it still shows up in a systrace like it did with the old Trace class.
+                char sectionName[128];
+                snprintf(sectionName, sizeof(sectionName), "%s %" PRId64,
+                         getString(nameId), value);
+                ATrace_beginSection.load(std::memory_order_relaxed)(sectionName);
+                ATrace_endSection.load(std::memory_order_relaxed)();
+            }
+        }
+    }
+#endif
+    if (!isEnabled()) {
+        return;
+    }
+
+    TraceRing *ring = static_cast<TraceRing *>(pthread_getspecific(sRingKey));
+    if (ring == nullptr) {
+        ring = claimRing();
+        if (ring == nullptr) {
+            sDroppedEventCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring->threadId = static_cast<int32_t>(syscall(SYS_gettid));
+        pthread_setspecific(sRingKey, ring);
+    }
+
+    // Only this thread writes to the ring so there is nothing to wait for.
+    const uint64_t counter = ring->writeCounter.load(std::memory_order_relaxed);
+    TraceRecord &record = ring->records[counter & kRecordIndexMask];
+    record.timeNanos = AudioClock::getNanoseconds();
+    record.value = value;
+    record.nameId = nameId;
+    record.threadId = ring->threadId;
+    record.type = type;
+    ring->writeCounter.store(counter + 1, std::memory_order_release);
+}
+
+static void appendJsonString(std::string &json, const char *text) {
+    json += '"';
+    for (const char *c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            json += '\\';
+            json += *c;
+        } else if (static_cast<unsigned char>(*c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(*c));
+            json += escaped;
+        } else {
+            json += *c;
+        }
+    }
+    json += '"';
+}
+
+std::string Tracer::exportChromeJson() {
+    std::vector<TraceRecord> records;
+    for (std::atomic<TraceRing *> &slot : sRings) {
+        TraceRing *ring = slot.load(std::memory_order_acquire);
+        if (ring == nullptr) {
+            continue;
+        }
+        const uint64_t end = ring->writeCounter.load(std::memory_order_acquire);
+        const uint64_t oldest = (end > kRecordsPerThread) ? end - kRecordsPerThread : 0;
+        const uint64_t begin = std::max(oldest,
+                                        ring->clearCounter.load(std::memory_order_acquire));
+        const size_t firstIndex = records.size();
+        for (uint64_t counter = begin; counter < end; counter++) {
+            records.push_back(ring->records[counter & kRecordIndexMask]);
+        }
+        // The owner may have overwritten the oldest records while they were copied.
+        // Drop those, like a seqlock reader. The record at newEnd may be half written.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t newEnd = ring->writeCounter.load(std::memory_order_relaxed);
+        if (newEnd + 1 > begin + kRecordsPerThread) {
+            const uint64_t numOverwritten = std::min(newEnd + 1 - kRecordsPerThread - begin,
+                                                     end - begin);
+            records.erase(records.begin() + firstIndex,
+                          records.begin() + firstIndex + numOverwritten);
+        }
+    }
+    std::stable_sort(records.begin(), records.end(),
+                     [](const TraceRecord &a, const TraceRecord &b) {
+                         return a.timeNanos < b.timeNanos;
+                     });
+
+    const int pid = getpid();
+    // Open sections on each thread. An end is dropped if its begin was overwritten.
+    std::map<int32_t, int32_t> depths;
+    std::string json = "{\"traceEvents\":[";
+    bool isFirst = true;
+    char buffer[128];
+    for (const TraceRecord &record : records) {
+        int32_t &depth = depths[record.threadId];
+        if (record.type == kTypeEnd) {
+            if (depth == 0) continue;
+            depth--;
+        } else if (record.type == kTypeBegin) {
+            depth++;
+        }
+        json += isFirst ? "\n{" : ",\n{";
+        isFirst = false;
+        if (record.type != kTypeEnd) {
+            json += "\"name\":";
+            appendJsonString(json, getString(record.nameId));
+            json += ',';
+        }
+        const char *phase = (record.type == kTypeBegin) ? "B"
+                : ((record.type == kTypeEnd) ? "E" : "C");
+        // The timestamps are in microseconds.
+        snprintf(buffer, sizeof(buffer),
+                 "\"cat\":\"oboe\",\"ph\":\"%s\",\"ts\":%" PRId64 ".%03" PRId64
+                 ",\"pid\":%d,\"tid\":%d",
+                 phase, record.timeNanos / 1000, record.timeNanos % 1000, pid,
+                 static_cast<int>(record.threadId));
+        json += buffer;
+        if (record.type == kTypeCounter) {
+            snprintf(buffer, sizeof(buffer), ",\"args\":{\"value\":%" PRId64 "}", record.value);
+            json += buffer;
+        }
+        json += '}';
+    }
+    json += "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return json;
+}
+
+void Tracer::clear() {
+    for (std::atomic<TraceRing *> &slot : sRings) {
+        TraceRing *ring = slot.load(std::memory_order_acquire);
+        if (ring != nullptr) {
+            ring->clearCounter.store(ring->writeCounter.load(std::memory_order_acquire),
+                                     std::memory_order_release);
+        }
+    }
+    sDroppedEventCount.store(0, std::memory_order_relaxed);
+}
+
+int64_t Tracer::getDroppedEventCount() {
+    return sDroppedEventCount.load(std::memory_order_relaxed);
+}
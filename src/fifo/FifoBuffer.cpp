@@ -21,17 +21,40 @@
 #include "oboe/FifoControllerBase.h"
 #include "fifo/FifoController.h"
 #include "fifo/FifoControllerIndirect.h"
+#include "fifo/FifoControllerSpsc.h"
 #include "oboe/FifoBuffer.h"
 
 namespace oboe {
 
-FifoBuffer::FifoBuffer(uint32_t bytesPerFrame, uint32_t capacityInFrames)
+// The SPSC controller only reloads the other side's counter if it needs more frames.
+static uint32_t getFramesToRead(FifoControllerBase &fifo, uint32_t /* framesWanted */) {
+    return fifo.getFullFramesAvailable();
+}
+
+static uint32_t getFramesToRead(FifoControllerSpsc &fifo, uint32_t framesWanted) {
+    return fifo.getFullFramesAvailableToReader(framesWanted);
+}
+
+static uint32_t getFramesToWrite(FifoControllerBase &fifo, uint32_t /* framesWanted */) {
+    return fifo.getEmptyFramesAvailable();
+}
+
+static uint32_t getFramesToWrite(FifoControllerSpsc &fifo, uint32_t framesWanted) {
+    return fifo.getEmptyFramesAvailableToWriter(framesWanted);
+}
+
+FifoBuffer::FifoBuffer(uint32_t bytesPerFrame, uint32_t capacityInFrames,
+                       bool singleProducerSingleConsumer)
         : mBytesPerFrame(bytesPerFrame)
         , mStorage(nullptr)
         , mFramesReadCount(0)
         , mFramesUnderrunCount(0)
 {
-    mFifo = std::make_unique<FifoController>(capacityInFrames);
+    if (singleProducerSingleConsumer) {
+        mFifoSpsc = std::make_unique<FifoControllerSpsc>(capacityInFrames);
+    } else {
+        mFifo = std::make_unique<FifoController>(capacityInFrames);
+    }
     // allocate buffer
     int32_t bytesPerBuffer = bytesPerFrame * capacityInFrames;
     mStorage = new uint8_t[bytesPerBuffer];
@@ -66,89 +89,105 @@ int32_t FifoBuffer::convertFramesToBytes(int32_t frames) {
     return frames * mBytesPerFrame;
 }
 
-int32_t FifoBuffer::read(void *buffer, int32_t numFrames) {
+FifoBuffer::Regions FifoBuffer::makeRegions(uint32_t index, uint32_t numFrames,
+                                            uint32_t capacity) {
+    Regions regions;
+    regions.data[0] = &mStorage[convertFramesToBytes(index)];
+    if ((index + numFrames) > capacity) {
+        // The first part is at the end of mStorage and the second part at the beginning.
+        regions.numFrames[0] = static_cast<int32_t>(capacity - index);
+        regions.data[1] = &mStorage[0];
+        regions.numFrames[1] = static_cast<int32_t>(numFrames) - regions.numFrames[0];
+    } else {
+        regions.numFrames[0] = static_cast<int32_t>(numFrames);
+    }
+    return regions;
+}
+
+FifoBuffer::Regions FifoBuffer::acquireReadRegions(int32_t numFrames) {
+    return mFifoSpsc ? acquireReadRegionsInternal(*mFifoSpsc, numFrames)
+                     : acquireReadRegionsInternal(*mFifo, numFrames);
+}
+
+template <typename Controller>
+FifoBuffer::Regions FifoBuffer::acquireReadRegionsInternal(Controller &fifo, int32_t numFrames) {
     if (numFrames <= 0) {
-        return 0;
+        return Regions();
     }
     // safe because numFrames is guaranteed positive
     uint32_t framesToRead = static_cast<uint32_t>(numFrames);
-    uint32_t framesAvailable = mFifo->getFullFramesAvailable();
+    uint32_t framesAvailable = getFramesToRead(fifo, framesToRead);
     framesToRead = std::min(framesToRead, framesAvailable);
+    return makeRegions(fifo.getReadIndex(), framesToRead, fifo.getFrameCapacity());
+}
 
-    uint32_t readIndex = mFifo->getReadIndex(); // ranges 0 to capacity
-    uint8_t *destination = reinterpret_cast<uint8_t *>(buffer);
-    uint8_t *source = &mStorage[convertFramesToBytes(readIndex)];
-    if ((readIndex + framesToRead) > mFifo->getFrameCapacity()) {
-        // read in two parts, first part here is at the end of the mStorage buffer
-        int32_t frames1 = static_cast<int32_t>(mFifo->getFrameCapacity() - readIndex);
-        int32_t numBytes = convertFramesToBytes(frames1);
-        if (numBytes < 0) {
-            return static_cast<int32_t>(Result::ErrorOutOfRange);
-        }
-        memcpy(destination, source, static_cast<size_t>(numBytes));
-        destination += numBytes;
-        // read second part, which is at the beginning of mStorage
-        source = &mStorage[0];
-        int32_t frames2 = static_cast<uint32_t>(framesToRead - frames1);
-        numBytes = convertFramesToBytes(frames2);
-        if (numBytes < 0) {
-            return static_cast<int32_t>(Result::ErrorOutOfRange);
-        }
-        memcpy(destination, source, static_cast<size_t>(numBytes));
+void FifoBuffer::commitRead(int32_t numFrames) {
+    if (numFrames <= 0) {
+        return;
+    }
+    if (mFifoSpsc) {
+        mFifoSpsc->advanceReadIndex(static_cast<uint32_t>(numFrames));
     } else {
-        // just read in one shot
-        int32_t numBytes = convertFramesToBytes(framesToRead);
-        if (numBytes < 0) {
-            return static_cast<int32_t>(Result::ErrorOutOfRange);
-        }
-        memcpy(destination, source, static_cast<size_t>(numBytes));
+        mFifo->advanceReadIndex(static_cast<uint32_t>(numFrames));
     }
-    mFifo->advanceReadIndex(framesToRead);
+}
 
-    return framesToRead;
+FifoBuffer::Regions FifoBuffer::acquireWriteRegions(int32_t numFrames) {
+    return mFifoSpsc ? acquireWriteRegionsInternal(*mFifoSpsc, numFrames)
+                     : acquireWriteRegionsInternal(*mFifo, numFrames);
 }
 
-int32_t FifoBuffer::write(const void *buffer, int32_t numFrames) {
+template <typename Controller>
+FifoBuffer::Regions FifoBuffer::acquireWriteRegionsInternal(Controller &fifo, int32_t numFrames) {
     if (numFrames <= 0) {
-        return 0;
+        return Regions();
     }
     // Guaranteed positive.
     uint32_t framesToWrite = static_cast<uint32_t>(numFrames);
-    uint32_t framesAvailable = mFifo->getEmptyFramesAvailable();
+    uint32_t framesAvailable = getFramesToWrite(fifo, framesToWrite);
     framesToWrite = std::min(framesToWrite, framesAvailable);
+    return makeRegions(fifo.getWriteIndex(), framesToWrite, fifo.getFrameCapacity());
+}
 
-    uint32_t writeIndex = mFifo->getWriteIndex();
-    int byteIndex = convertFramesToBytes(writeIndex);
-    const uint8_t *source = reinterpret_cast<const uint8_t *>(buffer);
-    uint8_t *destination = &mStorage[byteIndex];
-    if ((writeIndex + framesToWrite) > mFifo->getFrameCapacity()) {
-        // write in two parts, first part here
-        int32_t frames1 = static_cast<uint32_t>(mFifo->getFrameCapacity() - writeIndex);
-        int32_t numBytes = convertFramesToBytes(frames1);
-        if (numBytes < 0) {
-            return static_cast<int32_t>(Result::ErrorOutOfRange);
-        }
-        memcpy(destination, source, static_cast<size_t>(numBytes));
-        // read second part
-        source += convertFramesToBytes(frames1);
-        destination = &mStorage[0];
-        int frames2 = static_cast<uint32_t>(framesToWrite - frames1);
-        numBytes = convertFramesToBytes(frames2);
-        if (numBytes < 0) {
-            return static_cast<int32_t>(Result::ErrorOutOfRange);
-        }
-        memcpy(destination, source, static_cast<size_t>(numBytes));
+void FifoBuffer::commitWrite(int32_t numFrames) {
+    if (numFrames <= 0) {
+        return;
+    }
+    if (mFifoSpsc) {
+        mFifoSpsc->advanceWriteIndex(static_cast<uint32_t>(numFrames));
     } else {
-        // just write in one shot
-        int32_t numBytes = convertFramesToBytes(framesToWrite);
-        if (numBytes < 0) {
-            return static_cast<int32_t>(Result::ErrorOutOfRange);
+        mFifo->advanceWriteIndex(static_cast<uint32_t>(numFrames));
+    }
+}
+
+int32_t FifoBuffer::read(void *buffer, int32_t numFrames) {
+    Regions regions = acquireReadRegions(numFrames);
+    uint8_t *destination = reinterpret_cast<uint8_t *>(buffer);
+    for (int i = 0; i < 2; i++) {
+        size_t numBytes = static_cast<size_t>(convertFramesToBytes(regions.numFrames[i]));
+        if (numBytes > 0) {
+            memcpy(destination, regions.data[i], numBytes);
+            destination += numBytes;
         }
-        memcpy(destination, source, static_cast<size_t>(numBytes));
     }
-    mFifo->advanceWriteIndex(framesToWrite);
+    int32_t framesRead = regions.getNumFrames();
+    commitRead(framesRead);
+    return framesRead;
+}
 
-    return framesToWrite;
+int32_t FifoBuffer::write(const void *buffer, int32_t numFrames) {
+    Regions regions = acquireWriteRegions(numFrames);
+    const uint8_t *source = reinterpret_cast<const uint8_t *>(buffer);
+    for (int i = 0; i < 2; i++) {
+        size_t numBytes = static_cast<size_t>(convertFramesToBytes(regions.numFrames[i]));
+        if (numBytes > 0) {
+            memcpy(regions.data[i], source, numBytes);
+            source += numBytes;
+        }
+    }
+    int32_t framesWritten = regions.getNumFrames();
+    commitWrite(framesWritten);
+    return framesWritten;
 }
 
 int32_t FifoBuffer::readNow(void *buffer, int32_t numFrames) {
@@ -172,7 +211,35 @@ int32_t FifoBuffer::readNow(void *buffer, int32_t numFrames) {
 
 
 uint32_t FifoBuffer::getBufferCapacityInFrames() const {
-    return mFifo->getFrameCapacity();
+    return mFifoSpsc ? mFifoSpsc->getFrameCapacity() : mFifo->getFrameCapacity();
+}
+
+uint32_t FifoBuffer::getFullFramesAvailable() {
+    return mFifoSpsc ? mFifoSpsc->getFullFramesAvailable() : mFifo->getFullFramesAvailable();
+}
+
+uint64_t FifoBuffer::getReadCounter() const {
+    return mFifoSpsc ? mFifoSpsc->getReadCounter() : mFifo->getReadCounter();
+}
+
+void FifoBuffer::setReadCounter(uint64_t n) {
+    if (mFifoSpsc) {
+        mFifoSpsc->setReadCounter(n);
+    } else {
+        mFifo->setReadCounter(n);
+    }
+}
+
+uint64_t FifoBuffer::getWriteCounter() {
+    return mFifoSpsc ? mFifoSpsc->getWriteCounter() : mFifo->getWriteCounter();
+}
+
+void FifoBuffer::setWriteCounter(uint64_t n) {
+    if (mFifoSpsc) {
+        mFifoSpsc->setWriteCounter(n);
+    } else {
+        mFifo->setWriteCounter(n);
+    }
 }
 
 } // namespace oboe
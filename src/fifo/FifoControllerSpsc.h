@@ -0,0 +1,183 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NATIVEOBOE_FIFOCONTROLLERSPSC_H
+#define NATIVEOBOE_FIFOCONTROLLERSPSC_H
+
+#include <atomic>
+#include <cassert>
+#include <stdint.h>
+
+namespace oboe {
+
+/**
+ * Manage the read/write indices of a circular buffer that has exactly one
+ * reader thread and one writer thread.
+ *
+ * This has the same role as FifoController but it is optimized for that case:
+ * - there are no virtual calls
+ * - the indices are calculated with a mask when the capacity is a power of two
+ * - the read and write counters are on separate cache lines
+ * - each side caches the other side's counter and only reloads it when
+ *   the cached value does not show enough frames
+ * - the counters are advanced with a release store instead of a fetch_add
+ *
+ * The methods ending in "ToReader" or "ToWriter", and the advance methods,
+ * must only be called by that side. The other methods can be called from any thread.
+ */
+class FifoControllerSpsc {
+public:
+    // Assume a common cache line size. Too big would only waste a little memory.
+    static constexpr size_t kCacheLineSizeBytes = 64;
+
+    explicit FifoControllerSpsc(uint32_t capacityInFrames)
+            : mTotalFrames(capacityInFrames)
+            , mIndexMask(isPowerOfTwo(capacityInFrames) ? capacityInFrames - 1 : 0) {
+        // Avoid ridiculously large buffers and the arithmetic wraparound issues that can follow.
+        assert(capacityInFrames <= (UINT32_MAX / 4));
+    }
+
+    uint32_t getFrameCapacity() const { return mTotalFrames; }
+
+    /**
+     * @return true if the indices are calculated with a mask instead of a modulo
+     */
+    bool isMasked() const { return mIndexMask != 0; }
+
+    // Reader side.
+
+    /**
+     * Only reload the write counter if the cached value has less than framesWanted.
+     *
+     * @param framesWanted number of frames the reader would like to read
+     * @return number of valid frames available to read
+     */
+    uint32_t getFullFramesAvailableToReader(uint32_t framesWanted) {
+        const uint64_t readCounter = mReadCounter.load(std::memory_order_relaxed);
+        uint32_t available = clipFullFrames(mCachedWriteCounter, readCounter);
+        if (available < framesWanted) {
+            mCachedWriteCounter = mWriteCounter.load(std::memory_order_acquire);
+            available = clipFullFrames(mCachedWriteCounter, readCounter);
+        }
+        return available;
+    }
+
+    uint32_t getReadIndex() const {
+        return convertCounterToIndex(mReadCounter.load(std::memory_order_relaxed));
+    }
+
+    void advanceReadIndex(uint32_t numFrames) {
+        const uint64_t readCounter = mReadCounter.load(std::memory_order_relaxed);
+        mReadCounter.store(readCounter + numFrames, std::memory_order_release);
+    }
+
+    // Writer side.
+
+    /**
+     * Only reload the read counter if the cached value has less than framesWanted.
+     *
+     * @param framesWanted number of frames the writer would like to write
+     * @return number of frames that can be written
+     */
+    uint32_t getEmptyFramesAvailableToWriter(uint32_t framesWanted) {
+        const uint64_t writeCounter = mWriteCounter.load(std::memory_order_relaxed);
+        uint32_t available = mTotalFrames - clipFullFrames(writeCounter, mCachedReadCounter);
+        if (available < framesWanted) {
+            mCachedReadCounter = mReadCounter.load(std::memory_order_acquire);
+            available = mTotalFrames - clipFullFrames(writeCounter, mCachedReadCounter);
+        }
+        return available;
+    }
+
+    uint32_t getWriteIndex() const {
+        return convertCounterToIndex(mWriteCounter.load(std::memory_order_relaxed));
+    }
+
+    void advanceWriteIndex(uint32_t numFrames) {
+        const uint64_t writeCounter = mWriteCounter.load(std::memory_order_relaxed);
+        mWriteCounter.store(writeCounter + numFrames, std::memory_order_release);
+    }
+
+    // Either side or another thread.
+
+    uint32_t getFullFramesAvailable() const {
+        const uint64_t writeCounter = getWriteCounter();
+        return clipFullFrames(writeCounter, getReadCounter());
+    }
+
+    uint64_t getReadCounter() const {
+        return mReadCounter.load(std::memory_order_acquire);
+    }
+
+    uint64_t getWriteCounter() const {
+        return mWriteCounter.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Do not call this while the reader or the writer is running.
+     */
+    void setReadCounter(uint64_t n) {
+        mReadCounter.store(n, std::memory_order_release);
+        mCachedReadCounter = n;
+    }
+
+    /**
+     * Do not call this while the reader or the writer is running.
+     */
+    void setWriteCounter(uint64_t n) {
+        mWriteCounter.store(n, std::memory_order_release);
+        mCachedWriteCounter = n;
+    }
+
+private:
+    static bool isPowerOfTwo(uint32_t n) {
+        return n > 1 && (n & (n - 1)) == 0;
+    }
+
+    uint32_t convertCounterToIndex(uint64_t counter) const {
+        return static_cast<uint32_t>((mIndexMask != 0) ? (counter & mIndexMask)
+                                                       : (counter % mTotalFrames));
+    }
+
+    // Same rules as FifoControllerBase::getFullFramesAvailable().
+    uint32_t clipFullFrames(uint64_t writeCounter, uint64_t readCounter) const {
+        if (readCounter > writeCounter) {
+            return 0;
+        }
+        uint64_t delta = writeCounter - readCounter;
+        if (delta >= mTotalFrames) {
+            return mTotalFrames;
+        }
+        return static_cast<uint32_t>(delta);
+    }
+
+    // Read-only after construction so these can share a cache line.
+    const uint32_t mTotalFrames;
+    const uint64_t mIndexMask;
+
+    // Owned by the writer.
+    alignas(kCacheLineSizeBytes) std::atomic<uint64_t> mWriteCounter{0};
+    uint64_t mCachedReadCounter = 0;
+
+    // Owned by the reader.
+    alignas(kCacheLineSizeBytes) std::atomic<uint64_t> mReadCounter{0};
+    uint64_t mCachedWriteCounter = 0;
+    // The size is rounded up to the alignment so nothing else can share the reader's line.
+};
+
+} // namespace oboe
+
+#endif //NATIVEOBOE_FIFOCONTROLLERSPSC_H
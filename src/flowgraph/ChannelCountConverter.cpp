@@ -16,6 +16,7 @@
 
 #include <unistd.h>
 #include "FlowGraphNode.h"
+#include "FusedStage.h"
 #include "ChannelCountConverter.h"
 
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
@@ -41,7 +42,7 @@ int32_t ChannelCountConverter::onProcess(int32_t numFrames) {
             // Wrap if we run out of inputs.
             // Discard if we run out of outputs.
             outputBuffer[outputChannel] = inputBuffer[inputChannel];
-            inputChannel = (inputChannel == inputChannelCount)
+            inputChannel = (inputChannel + 1 == inputChannelCount)
                     ? 0 : inputChannel + 1;
         }
         inputBuffer += inputChannelCount;
@@ -50,3 +51,14 @@ int32_t ChannelCountConverter::onProcess(int32_t numFrames) {
     return numFrames;
 }
 
+
+bool ChannelCountConverter::describeFusedStage(FusedStage *stage) {
+    stage->type = FusedStage::Type::ChannelMap;
+    stage->inputChannelCount = input.getSamplesPerFrame();
+    stage->outputChannelCount = output.getSamplesPerFrame();
+    stage->channelMap.resize(stage->outputChannelCount);
+    for (int outputChannel = 0; outputChannel < stage->outputChannelCount; outputChannel++) {
+        stage->channelMap[outputChannel] = outputChannel % stage->inputChannelCount;
+    }
+    return true;
+}
@@ -39,6 +39,8 @@ namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
 
         int32_t onProcess(int32_t numFrames) override;
 
+    bool describeFusedStage(FusedStage *stage) override;
+
         const char *getName() override {
             return "ChannelCountConverter";
         }
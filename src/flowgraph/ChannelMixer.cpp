@@ -0,0 +1,378 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unistd.h>
+
+#include "ChannelMixer.h"
+#include "LayoutConverter.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CHANNEL_MIXER_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define CHANNEL_MIXER_NEON 1
+#endif
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+
+namespace {
+
+/***************************************************************************/
+// Kernels that process one planar channel.
+
+// destination = gain * source
+void scaleChannel(const float *source, float gain, float *destination, int32_t numFrames) {
+    if (gain == 1.0f) {
+        memcpy(destination, source, numFrames * sizeof(float));
+        return;
+    }
+    int32_t i = 0;
+#if CHANNEL_MIXER_SSE2
+    const __m128 gains = _mm_set1_ps(gain);
+    for (; i + 4 <= numFrames; i += 4) {
+        _mm_storeu_ps(&destination[i], _mm_mul_ps(gains, _mm_loadu_ps(&source[i])));
+    }
+#elif CHANNEL_MIXER_NEON
+    for (; i + 4 <= numFrames; i += 4) {
+        vst1q_f32(&destination[i], vmulq_n_f32(vld1q_f32(&source[i]), gain));
+    }
+#endif
+    for (; i < numFrames; i++) {
+        destination[i] = gain * source[i];
+    }
+}
+
+// destination += gain * source
+void mixChannel(const float *source, float gain, float *destination, int32_t numFrames) {
+    int32_t i = 0;
+#if CHANNEL_MIXER_SSE2
+    const __m128 gains = _mm_set1_ps(gain);
+    for (; i + 4 <= numFrames; i += 4) {
+        const __m128 product = _mm_mul_ps(gains, _mm_loadu_ps(&source[i]));
+        _mm_storeu_ps(&destination[i], _mm_add_ps(_mm_loadu_ps(&destination[i]), product));
+    }
+#elif CHANNEL_MIXER_NEON
+    for (; i + 4 <= numFrames; i += 4) {
+        vst1q_f32(&destination[i],
+                  vmlaq_n_f32(vld1q_f32(&destination[i]), vld1q_f32(&source[i]), gain));
+    }
+#endif
+    for (; i < numFrames; i++) {
+        destination[i] += gain * source[i];
+    }
+}
+
+/***************************************************************************/
+// Positions of the channels in a channel mask.
+
+enum class Side {
+    Left,
+    Right,
+    Center,
+    LowFrequency,
+};
+
+struct Position {
+    Side  side;
+    float gain; // relative to the front left and right channels
+};
+
+constexpr float kMinus3dB = 0.70710678f;
+
+constexpr int32_t kFrontLeftBit = 0;
+constexpr int32_t kFrontRightBit = 1;
+constexpr int32_t kFrontCenterBit = 2;
+constexpr int32_t kLowFrequencyBit = 3;
+
+// Indexed by the bit in the channel mask.
+constexpr Position kPositions[] = {
+        {Side::Left, 1.0f},                 // FrontLeft
+        {Side::Right, 1.0f},                // FrontRight
+        {Side::Center, 1.0f},               // FrontCenter
+        {Side::LowFrequency, kMinus3dB},    // LowFrequency
+        {Side::Left, kMinus3dB},            // BackLeft
+        {Side::Right, kMinus3dB},           // BackRight
+        {Side::Left, 1.0f},                 // FrontLeftOfCenter
+        {Side::Right, 1.0f},                // FrontRightOfCenter
+        {Side::Center, kMinus3dB},          // BackCenter
+        {Side::Left, kMinus3dB},            // SideLeft
+        {Side::Right, kMinus3dB},           // SideRight
+        {Side::Center, kMinus3dB},          // TopCenter
+        {Side::Left, kMinus3dB},            // TopFrontLeft
+        {Side::Center, kMinus3dB},          // TopFrontCenter
+        {Side::Right, kMinus3dB},           // TopFrontRight
+        {Side::Left, kMinus3dB},            // TopBackLeft
+        {Side::Center, kMinus3dB},          // TopBackCenter
+        {Side::Right, kMinus3dB},           // TopBackRight
+        {Side::Left, kMinus3dB},            // TopSideLeft
+        {Side::Right, kMinus3dB},           // TopSideRight
+        {Side::Left, kMinus3dB},            // BottomFrontLeft
+        {Side::Center, kMinus3dB},          // BottomFrontCenter
+        {Side::Right, kMinus3dB},           // BottomFrontRight
+        {Side::LowFrequency, kMinus3dB},    // LowFrequency2
+        {Side::Left, 1.0f},                 // FrontWideLeft
+        {Side::Right, 1.0f},                // FrontWideRight
+};
+constexpr int32_t kNumPositions = sizeof(kPositions) / sizeof(kPositions[0]);
+
+Position getPosition(int32_t bit) {
+    // Treat unknown channels like the centre surround channels.
+    return (bit < kNumPositions) ? kPositions[bit] : Position{Side::Center, kMinus3dB};
+}
+
+// A matrix that is being built from two channel masks.
+class MatrixBuilder {
+public:
+    MatrixBuilder(uint32_t inputMask, uint32_t outputMask)
+            : mInputBits(getBits(inputMask))
+            , mOutputBits(getBits(outputMask))
+            , mGains(mInputBits.size() * mOutputBits.size(), 0.0f) {}
+
+    std::vector<float> build() {
+        if (mGains.empty()) {
+            return mGains;
+        }
+        const int32_t inputChannelCount = static_cast<int32_t>(mInputBits.size());
+        const int32_t outputChannelCount = static_cast<int32_t>(mOutputBits.size());
+        for (int32_t i = 0; i < inputChannelCount; i++) {
+            mixInput(i);
+        }
+        for (int32_t o = 0; o < outputChannelCount; o++) {
+            float *row = &mGains[o * inputChannelCount];
+            if (std::all_of(row, row + inputChannelCount, [](float g) { return g == 0.0f; })) {
+                fillOutput(o);
+            }
+            // Scale down a mix that could clip.
+            float sum = 0.0f;
+            for (int32_t i = 0; i < inputChannelCount; i++) {
+                sum += row[i];
+            }
+            if (sum > 1.0f) {
+                for (int32_t i = 0; i < inputChannelCount; i++) {
+                    row[i] /= sum;
+                }
+            }
+        }
+        return mGains;
+    }
+
+private:
+    static std::vector<int32_t> getBits(uint32_t mask) {
+        std::vector<int32_t> bits;
+        for (int32_t bit = 0; bit < 32; bit++) {
+            if ((mask & (1u << bit)) != 0) {
+                bits.push_back(bit);
+            }
+        }
+        return bits;
+    }
+
+    static int32_t findChannel(const std::vector<int32_t> &bits, int32_t bit) {
+        auto it = std::find(bits.begin(), bits.end(), bit);
+        return (it == bits.end()) ? -1 : static_cast<int32_t>(it - bits.begin());
+    }
+
+    static bool hasChannel(const std::vector<int32_t> &bits, int32_t bit) {
+        return findChannel(bits, bit) >= 0;
+    }
+
+    bool add(int32_t outputBit, int32_t inputBit, float gain) {
+        const int32_t outputChannel = findChannel(mOutputBits, outputBit);
+        const int32_t inputChannel = findChannel(mInputBits, inputBit);
+        if (outputChannel < 0 || inputChannel < 0) {
+            return false;
+        }
+        mGains[outputChannel * mInputBits.size() + inputChannel] += gain;
+        return true;
+    }
+
+    // Mix an input channel into the output channels on the same side.
+    void mixInput(int32_t inputChannel) {
+        const int32_t bit = mInputBits[inputChannel];
+        if (add(bit, bit, 1.0f)) {
+            return;
+        }
+        const Position position = getPosition(bit);
+        const float gain = position.gain;
+        bool mixed = false;
+        switch (position.side) {
+            case Side::Left:
+                mixed = add(kFrontLeftBit, bit, gain)
+                        || add(kFrontCenterBit, bit, gain)
+                        || add(kFrontRightBit, bit, gain);
+                break;
+            case Side::Right:
+                mixed = add(kFrontRightBit, bit, gain)
+                        || add(kFrontCenterBit, bit, gain)
+                        || add(kFrontLeftBit, bit, gain);
+                break;
+            case Side::LowFrequency:
+                mixed = add(kLowFrequencyBit, bit, 1.0f);
+                [[fallthrough]];
+            case Side::Center:
+                mixed = mixed || mixCenter(bit, gain);
+                break;
+        }
+        if (!mixed) {
+            // There are no front channels so use the first output channel.
+            add(mOutputBits[0], bit, gain);
+        }
+    }
+
+    bool mixCenter(int32_t inputBit, float gain) {
+        if (add(kFrontCenterBit, inputBit, gain)) {
+            return true;
+        }
+        if (hasChannel(mOutputBits, kFrontLeftBit) && hasChannel(mOutputBits, kFrontRightBit)) {
+            add(kFrontLeftBit, inputBit, gain * kMinus3dB);
+            add(kFrontRightBit, inputBit, gain * kMinus3dB);
+            return true;
+        }
+        return add(kFrontLeftBit, inputBit, gain) || add(kFrontRightBit, inputBit, gain);
+    }
+
+    // Copy a front input channel to an output channel that nothing was mixed into.
+    void fillOutput(int32_t outputChannel) {
+        const int32_t bit = mOutputBits[outputChannel];
+        const Position position = getPosition(bit);
+        const float gain = position.gain;
+        switch (position.side) {
+            case Side::Left:
+                (void) (add(bit, kFrontLeftBit, gain)
+                        || add(bit, kFrontCenterBit, gain)
+                        || add(bit, kFrontRightBit, gain));
+                break;
+            case Side::Right:
+                (void) (add(bit, kFrontRightBit, gain)
+                        || add(bit, kFrontCenterBit, gain)
+                        || add(bit, kFrontLeftBit, gain));
+                break;
+            case Side::Center:
+                if (add(bit, kFrontCenterBit, gain)) {
+                    break;
+                }
+                if (hasChannel(mInputBits, kFrontLeftBit)
+                        && hasChannel(mInputBits, kFrontRightBit)) {
+                    add(bit, kFrontLeftBit, gain * kMinus3dB);
+                    add(bit, kFrontRightBit, gain * kMinus3dB);
+                    break;
+                }
+                (void) (add(bit, kFrontLeftBit, gain) || add(bit, kFrontRightBit, gain));
+                break;
+            case Side::LowFrequency:
+                break; // Do not make up bass.
+        }
+    }
+
+    const std::vector<int32_t> mInputBits;
+    const std::vector<int32_t> mOutputBits;
+    std::vector<float>         mGains;
+};
+
+} // namespace
+
+ChannelMixer::ChannelMixer(int32_t inputChannelCount, int32_t outputChannelCount)
+        : input(*this, inputChannelCount)
+        , output(*this, outputChannelCount) {
+    std::vector<float> gains(inputChannelCount * outputChannelCount, 0.0f);
+    for (int32_t i = 0; i < std::min(inputChannelCount, outputChannelCount); i++) {
+        gains[i * inputChannelCount + i] = 1.0f;
+    }
+    setMatrix(gains);
+}
+
+bool ChannelMixer::setMatrix(const std::vector<float> &gains) {
+    const int32_t inputChannelCount = input.getSamplesPerFrame();
+    const int32_t outputChannelCount = output.getSamplesPerFrame();
+    if (gains.size() != static_cast<size_t>(inputChannelCount * outputChannelCount)) {
+        return false;
+    }
+    mGains = gains;
+    mTerms.clear();
+    for (int32_t o = 0; o < outputChannelCount; o++) {
+        for (int32_t i = 0; i < inputChannelCount; i++) {
+            const float gain = mGains[o * inputChannelCount + i];
+            if (gain != 0.0f) {
+                mTerms.push_back({o, i, gain});
+            }
+        }
+    }
+    return true;
+}
+
+void ChannelMixer::setFramesPerBuffer(int32_t framesPerBuffer) {
+    FlowGraphNode::setFramesPerBuffer(framesPerBuffer);
+    mPlanarInput.resize(static_cast<size_t>(framesPerBuffer) * input.getSamplesPerFrame());
+    mPlanarOutput.resize(static_cast<size_t>(framesPerBuffer) * output.getSamplesPerFrame());
+}
+
+int32_t ChannelMixer::onProcess(int32_t numFrames) {
+    const int32_t inputChannelCount = input.getSamplesPerFrame();
+    const int32_t outputChannelCount = output.getSamplesPerFrame();
+
+    const float *inputBuffer = input.getBuffer();
+    int32_t inputStride = input.getChannelStride();
+    if (!input.isPlanar()) {
+        LayoutConverter::deinterleave(inputBuffer, mPlanarInput.data(),
+                                      inputChannelCount, numFrames, numFrames);
+        inputBuffer = mPlanarInput.data();
+        inputStride = numFrames;
+    }
+    float *outputBuffer = output.isPlanar() ? output.getBuffer() : mPlanarOutput.data();
+    const int32_t outputStride = output.isPlanar() ? output.getChannelStride() : numFrames;
+
+    auto term = mTerms.begin();
+    for (int32_t o = 0; o < outputChannelCount; o++) {
+        float *channelOutput = outputBuffer + o * outputStride;
+        bool isWritten = false;
+        for (; term != mTerms.end() && term->outputChannel == o; ++term) {
+            const float *channelInput = inputBuffer + term->inputChannel * inputStride;
+            if (isWritten) {
+                mixChannel(channelInput, term->gain, channelOutput, numFrames);
+            } else {
+                scaleChannel(channelInput, term->gain, channelOutput, numFrames);
+                isWritten = true;
+            }
+        }
+        if (!isWritten) {
+            std::fill(channelOutput, channelOutput + numFrames, 0.0f);
+        }
+    }
+
+    if (!output.isPlanar()) {
+        LayoutConverter::interleave(mPlanarOutput.data(), numFrames, output.getBuffer(),
+                                    outputChannelCount, numFrames);
+    }
+    return numFrames;
+}
+
+std::vector<float> ChannelMixer::makeMatrix(uint32_t inputMask, uint32_t outputMask) {
+    return MatrixBuilder(inputMask, outputMask).build();
+}
+
+const char *ChannelMixer::getImplementationName() {
+#if CHANNEL_MIXER_SSE2
+    return "SSE2";
+#elif CHANNEL_MIXER_NEON
+    return "NEON";
+#else
+    return "Scalar";
+#endif
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOWGRAPH_CHANNEL_MIXER_H
+#define FLOWGRAPH_CHANNEL_MIXER_H
+
+#include <sys/types.h>
+#include <unistd.h>
+#include <vector>
+
+#include "FlowGraphNode.h"
+
+namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
+
+/**
+ * Mix M input channels into N output channels with a matrix of gains.
+ * This can be used to downmix 5.1 to stereo, upmix stereo to quad, or swap channels.
+ *
+ * The channels are mixed in a planar layout, one output channel at a time, with SIMD kernels.
+ * Interleaved ports are converted with LayoutConverter. Zero gains are skipped.
+ */
+class ChannelMixer : public FlowGraphNode {
+public:
+    /**
+     * The initial matrix copies input channel i to output channel i.
+     */
+    ChannelMixer(int32_t inputChannelCount, int32_t outputChannelCount);
+
+    virtual ~ChannelMixer() = default;
+
+    int32_t onProcess(int32_t numFrames) override;
+
+    void setFramesPerBuffer(int32_t framesPerBuffer) override;
+
+    bool isPlanarSupported() const override {
+        return true;
+    }
+
+    const char *getName() override {
+        return "ChannelMixer";
+    }
+
+    /**
+     * Set all of the gains. This is not thread safe.
+     *
+     * @param gains outputChannelCount rows of inputChannelCount gains
+     * @return false if the number of gains is wrong
+     */
+    bool setMatrix(const std::vector<float> &gains);
+
+    /**
+     * @return gain from an input channel to an output channel
+     */
+    float getGain(int32_t outputChannel, int32_t inputChannel) const {
+        return mGains[outputChannel * input.getSamplesPerFrame() + inputChannel];
+    }
+
+    /**
+     * Make a matrix that converts between two channel masks. The bits of the masks are the same
+     * as the AAudio channel masks and the channels are interleaved in the order of the bits.
+     *
+     * Channels that are in both masks are copied. Other input channels are mixed into the
+     * output channels on the same side, with -3 dB for centre, surround, height and LFE channels.
+     * An output row that adds up to more than one is scaled down so the mix cannot clip.
+     * Output channels that no input is mixed into copy the front channel on the same side,
+     * except LFE, which is silent.
+     *
+     * @param inputMask channel mask of the input
+     * @param outputMask channel mask of the output
+     * @return matrix for setMatrix(), or an empty vector if either mask is zero
+     */
+    static std::vector<float> makeMatrix(uint32_t inputMask, uint32_t outputMask);
+
+    /**
+     * @return name of the SIMD instructions used by the kernels, or "Scalar"
+     */
+    static const char *getImplementationName();
+
+    FlowGraphPortFloatInput input;
+    FlowGraphPortFloatOutput output;
+
+private:
+    // One non-zero gain of the matrix.
+    struct Term {
+        int32_t outputChannel;
+        int32_t inputChannel;
+        float   gain;
+    };
+
+    std::vector<float> mGains;
+    std::vector<Term>  mTerms; // sorted by output channel
+    std::vector<float> mPlanarInput; // used when the input is interleaved
+    std::vector<float> mPlanarOutput; // used when the output is interleaved
+};
+
+} /* namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph */
+
+#endif //FLOWGRAPH_CHANNEL_MIXER_H
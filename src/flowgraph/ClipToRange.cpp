@@ -17,8 +17,17 @@
 #include <algorithm>
 #include <unistd.h>
 #include "FlowGraphNode.h"
+#include "FusedStage.h"
 #include "ClipToRange.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CLIP_TO_RANGE_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define CLIP_TO_RANGE_NEON 1
+#endif
+
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
 
 ClipToRange::ClipToRange(int32_t channelCount)
@@ -26,13 +35,66 @@ ClipToRange::ClipToRange(int32_t channelCount)
 }
 
 int32_t ClipToRange::onProcess(int32_t numFrames) {
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
+    if (input.isPlanar()) {
+        // Clip each channel as a separate mono block.
+        for (int32_t channel = 0; channel < output.getSamplesPerFrame(); channel++) {
+            clip(input.getBuffer() + channel * input.getChannelStride(),
+                 output.getBuffer() + channel * output.getChannelStride(), numFrames,
+                 mMinimum, mMaximum);
+        }
+    } else {
+        clip(input.getBuffer(), output.getBuffer(), numFrames * output.getSamplesPerFrame(),
+             mMinimum, mMaximum);
+    }
+    return numFrames;
+}
 
-    int32_t numSamples = numFrames * output.getSamplesPerFrame();
-    for (int32_t i = 0; i < numSamples; i++) {
-        *outputBuffer++ = std::min(mMaximum, std::max(mMinimum, *inputBuffer++));
+// std::max(minimum, x) is (minimum < x) ? x : minimum, so a NaN input becomes the minimum.
+// The vector code uses the same comparisons so the output is identical.
+void ClipToRange::clip(const float *inputBuffer, float *outputBuffer, int32_t numSamples,
+                       float minimum, float maximum) {
+    int32_t i = 0;
+#if CLIP_TO_RANGE_SSE2
+    // maxps and minps return the second operand if the comparison is false.
+    const __m128 low = _mm_set1_ps(minimum);
+    const __m128 high = _mm_set1_ps(maximum);
+    for (; i + 4 <= numSamples; i += 4) {
+        const __m128 in = _mm_loadu_ps(&inputBuffer[i]);
+        _mm_storeu_ps(&outputBuffer[i], _mm_min_ps(_mm_max_ps(in, low), high));
+    }
+#elif CLIP_TO_RANGE_NEON
+    // vmaxq_f32() returns NaN for a NaN input so select with the comparisons instead.
+    const float32x4_t low = vdupq_n_f32(minimum);
+    const float32x4_t high = vdupq_n_f32(maximum);
+    for (; i + 4 <= numSamples; i += 4) {
+        const float32x4_t in = vld1q_f32(&inputBuffer[i]);
+        const float32x4_t raised = vbslq_f32(vcltq_f32(low, in), in, low);
+        vst1q_f32(&outputBuffer[i], vbslq_f32(vcltq_f32(raised, high), raised, high));
+    }
+#endif
+    for (; i < numSamples; i++) {
+        outputBuffer[i] = std::min(maximum, std::max(minimum, inputBuffer[i]));
     }
+}
 
-    return numFrames;
+const char *ClipToRange::getImplementationName() {
+#if CLIP_TO_RANGE_SSE2
+    return "SSE2";
+#elif CLIP_TO_RANGE_NEON
+    return "NEON";
+#else
+    return "Scalar";
+#endif
+}
+
+bool ClipToRange::describeFusedStage(FusedStage *stage) {
+    if (input.isPlanar()) {
+        return false; // SinkFused reads interleaved frames
+    }
+    stage->type = FusedStage::Type::Clip;
+    stage->inputChannelCount = input.getSamplesPerFrame();
+    stage->outputChannelCount = output.getSamplesPerFrame();
+    stage->minimum = mMinimum;
+    stage->maximum = mMaximum;
+    return true;
 }
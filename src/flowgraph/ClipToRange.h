@@ -38,6 +38,12 @@ public:
 
     int32_t onProcess(int32_t numFrames) override;
 
+    bool describeFusedStage(FusedStage *stage) override;
+
+    bool isPlanarSupported() const override {
+        return true;
+    }
+
     void setMinimum(float min) {
         mMinimum = min;
     }
@@ -58,7 +64,21 @@ public:
         return "ClipToRange";
     }
 
+    /**
+     * Clip a block of samples with SIMD, if available.
+     * The result is the same as std::min(maximum, std::max(minimum, input)),
+     * so a NaN input becomes the minimum.
+     */
+    static void clip(const float *inputBuffer, float *outputBuffer, int32_t numSamples,
+                     float minimum, float maximum);
+
+    /**
+     * @return name of the instruction set used by clip()
+     */
+    static const char *getImplementationName();
+
 private:
+
     float mMinimum = kDefaultMinHeadroom;
     float mMaximum = kDefaultMaxHeadroom;
 };
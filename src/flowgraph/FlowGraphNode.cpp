@@ -18,6 +18,8 @@
 #include <algorithm>
 #include <sys/types.h>
 #include "FlowGraphNode.h"
+#include "FlowGraphSchedule.h"
+#include "ParameterAutomation.h"
 
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
 
@@ -44,6 +46,13 @@ int32_t FlowGraphNode::pullData(int32_t numFrames, int64_t callCount) {
     return frameCount;
 }
 
+int32_t FlowGraphNode::pullAutomatedInputPorts(int32_t numFrames, int64_t callCount) {
+    for (auto &port : mAutomatedInputPorts) {
+        numFrames = port.get().pullData(callCount, numFrames);
+    }
+    return numFrames;
+}
+
 void FlowGraphNode::pullReset() {
     if (!mBlockRecursion) {
         mBlockRecursion = true; // for cyclic graphs
@@ -56,6 +65,26 @@ void FlowGraphNode::pullReset() {
     }
 }
 
+void FlowGraphNode::pullSetFramesPerBuffer(int32_t framesPerBuffer) {
+    if (!mBlockRecursion) {
+        mBlockRecursion = true; // for cyclic graphs
+        for (auto &port : mInputPorts) {
+            port.get().pullSetFramesPerBuffer(framesPerBuffer);
+        }
+        mBlockRecursion = false;
+        setFramesPerBuffer(framesPerBuffer);
+    }
+}
+
+void FlowGraphNode::setFramesPerBuffer(int32_t framesPerBuffer) {
+    for (auto &port : mInputPorts) {
+        port.get().setFramesPerBuffer(framesPerBuffer);
+    }
+    for (auto &port : mOutputPorts) {
+        port.get().setFramesPerBuffer(framesPerBuffer);
+    }
+}
+
 void FlowGraphNode::reset() {
     mLastFrameCount = 0;
     mLastCallCount = kInitialCallCount;
@@ -72,6 +101,24 @@ FlowGraphPortFloat::FlowGraphPortFloat(FlowGraphNode &parent,
     mBuffer = std::make_unique<float[]>(numFloats);
 }
 
+void FlowGraphPortFloat::setFramesPerBuffer(int32_t framesPerBuffer) {
+    if (framesPerBuffer == mFramesPerBuffer) return;
+    const int32_t samplesPerFrame = getSamplesPerFrame();
+    size_t numFloats = static_cast<size_t>(framesPerBuffer) * samplesPerFrame;
+    std::unique_ptr<float[]> buffer = std::make_unique<float[]>(numFloats);
+    // Keep the old contents and repeat the last frame so that a value set
+    // by FlowGraphPortFloatInput::setValue() survives the resize.
+    const float *lastFrame = &mBuffer[(mFramesPerBuffer - 1) * samplesPerFrame];
+    for (int32_t frame = 0; frame < framesPerBuffer; frame++) {
+        const float *source = (frame < mFramesPerBuffer)
+                ? &mBuffer[frame * samplesPerFrame]
+                : lastFrame;
+        std::copy(source, source + samplesPerFrame, &buffer[frame * samplesPerFrame]);
+    }
+    mBuffer = std::move(buffer);
+    mFramesPerBuffer = framesPerBuffer;
+}
+
 /***************************************************************************/
 int32_t FlowGraphPortFloatOutput::pullData(int64_t callCount, int32_t numFrames) {
     numFrames = std::min(getFramesPerBuffer(), numFrames);
@@ -82,6 +129,10 @@ void FlowGraphPortFloatOutput::pullReset() {
     mContainingNode.pullReset();
 }
 
+void FlowGraphPortFloatOutput::pullSetFramesPerBuffer(int32_t framesPerBuffer) {
+    mContainingNode.pullSetFramesPerBuffer(framesPerBuffer);
+}
+
 // These need to be in the .cpp file because of forward cross references.
 void FlowGraphPortFloatOutput::connect(FlowGraphPortFloatInput *port) {
     port->connect(this);
@@ -93,14 +144,53 @@ void FlowGraphPortFloatOutput::disconnect(FlowGraphPortFloatInput *port) {
 
 /***************************************************************************/
 int32_t FlowGraphPortFloatInput::pullData(int64_t callCount, int32_t numFrames) {
-    return (mConnected == nullptr)
-            ? std::min(getFramesPerBuffer(), numFrames)
-            : mConnected->pullData(callCount, numFrames);
+    if (mConnected != nullptr) {
+        return mConnected->pullData(callCount, numFrames);
+    }
+    numFrames = std::min(getFramesPerBuffer(), numFrames);
+    if (mAutomation != nullptr) {
+        renderAutomation(numFrames);
+    }
+    return numFrames;
+}
+
+void FlowGraphPortFloatInput::setAutomation(ParameterAutomation *automation) {
+    mAutomation = automation;
+    if (automation != nullptr && !mIsAutomationAdded) {
+        mContainingNode.addAutomatedInputPort(*this);
+        mIsAutomationAdded = true;
+    }
+}
+
+void FlowGraphPortFloatInput::renderAutomation(int32_t numFrames) {
+    float *buffer = FlowGraphPortFloat::getBuffer();
+    mAutomation->render(buffer, numFrames);
+    const int32_t samplesPerFrame = getSamplesPerFrame();
+    if (samplesPerFrame == 1) {
+        return;
+    }
+    if (isPlanar()) {
+        const int32_t channelStride = FlowGraphPortFloat::getChannelStride();
+        for (int32_t channel = 1; channel < samplesPerFrame; channel++) {
+            std::copy(buffer, buffer + numFrames, &buffer[channel * channelStride]);
+        }
+    } else {
+        // Spread the values from the end so none are overwritten before they are read.
+        for (int32_t frame = numFrames - 1; frame >= 0; frame--) {
+            const float value = buffer[frame];
+            std::fill(&buffer[frame * samplesPerFrame], &buffer[(frame + 1) * samplesPerFrame],
+                      value);
+        }
+    }
 }
 void FlowGraphPortFloatInput::pullReset() {
     if (mConnected != nullptr) mConnected->pullReset();
 }
 
+void FlowGraphPortFloatInput::pullSetFramesPerBuffer(int32_t framesPerBuffer) {
+    if (mConnected != nullptr) mConnected->pullSetFramesPerBuffer(framesPerBuffer);
+}
+
 float *FlowGraphPortFloatInput::getBuffer() {
     if (mConnected == nullptr) {
         return FlowGraphPortFloat::getBuffer(); // loaded using setValue()
@@ -109,6 +199,26 @@ float *FlowGraphPortFloatInput::getBuffer() {
     }
 }
 
+FlowGraphSink::FlowGraphSink(int32_t channelCount)
+        : input(*this, channelCount) {
+}
+
+FlowGraphSink::~FlowGraphSink() = default;
+
+void FlowGraphSink::buildSchedule() {
+    if (!mSchedule) {
+        mSchedule = std::make_unique<FlowGraphSchedule>();
+    }
+    mSchedule->build(*this);
+}
+
+void FlowGraphSink::clearSchedule() {
+    mSchedule.reset();
+}
+
 int32_t FlowGraphSink::pullData(int32_t numFrames) {
+    if (mSchedule) {
+        return mSchedule->process(numFrames);
+    }
     return FlowGraphNode::pullData(numFrames, getLastCallCount() + 1);
 }
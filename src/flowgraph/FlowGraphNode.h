@@ -26,7 +26,9 @@
 #define FLOWGRAPH_FLOW_GRAPH_NODE_H
 
 #include <cassert>
+#include <cstdint>
 #include <cstring>
+#include <functional>
 #include <math.h>
 #include <memory>
 #include <sys/types.h>
@@ -59,13 +61,17 @@
 
 namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
 
-// Default block size that can be overridden when the FlowGraphPortFloat is created.
+// Default block size that can be overridden when the FlowGraphPortFloat is created
+// or later by FlowGraphNode::pullSetFramesPerBuffer().
 // If it is too small then we will have too much overhead from switching between nodes.
 // If it is too high then we will thrash the caches.
 constexpr int kDefaultBufferSize = 8; // arbitrary
 
 class FlowGraphPort;
 class FlowGraphPortFloatInput;
+class FlowGraphSchedule;
+class ParameterAutomation;
+struct FusedStage;
 
 /***************************************************************************/
 /**
@@ -98,6 +104,25 @@ public:
      */
     int32_t pullData(int32_t numFrames, int64_t callCount);
 
+    /**
+     * Call onProcess() without pulling from the upstream nodes.
+     * This is used by FlowGraphSchedule, which has already run the upstream nodes.
+     * The call count is updated the same way as pullData() so the two can be mixed.
+     *
+     * @param numFrames number of frames available from the upstream nodes
+     * @param callCount
+     * @return number of frames actually processed
+     */
+    int32_t processScheduled(int32_t numFrames, int64_t callCount) {
+        if (mDataPulledAutomatically && !mAutomatedInputPorts.empty()) {
+            // Unconnected ports are not in the schedule so render their automation here.
+            numFrames = pullAutomatedInputPorts(numFrames, callCount);
+        }
+        mLastCallCount = callCount;
+        mLastFrameCount = (numFrames > 0) ? onProcess(numFrames) : 0;
+        return mLastFrameCount;
+    }
+
     /**
      * Recursively reset all the nodes in the graph, starting from a Sink.
      *
@@ -110,10 +135,49 @@ public:
      */
     virtual void reset();
 
+    /**
+     * Recursively set the number of frames in the port buffers of all the nodes
+     * in the graph, starting from a Sink.
+     *
+     * This must not be called at the same time as pullData!
+     *
+     * @param framesPerBuffer maximum number of frames processed per pass
+     */
+    void pullSetFramesPerBuffer(int32_t framesPerBuffer);
+
+    /**
+     * Reallocate the buffers of all the ports of this node.
+     * Override this if the node has other buffers that depend on the block size.
+     *
+     * This must not be called at the same time as pullData!
+     *
+     * @param framesPerBuffer maximum number of frames processed per pass
+     */
+    virtual void setFramesPerBuffer(int32_t framesPerBuffer);
+
     void addInputPort(FlowGraphPort &port) {
         mInputPorts.emplace_back(port);
     }
 
+    void addOutputPort(FlowGraphPort &port) {
+        mOutputPorts.emplace_back(port);
+    }
+
+    /**
+     * Called by FlowGraphPortFloatInput::setAutomation().
+     */
+    void addAutomatedInputPort(FlowGraphPort &port) {
+        mAutomatedInputPorts.emplace_back(port);
+    }
+
+    const std::vector<std::reference_wrapper<FlowGraphPort>> &getInputPorts() const {
+        return mInputPorts;
+    }
+
+    const std::vector<std::reference_wrapper<FlowGraphPort>> &getOutputPorts() const {
+        return mOutputPorts;
+    }
+
     bool isDataPulledAutomatically() const {
         return mDataPulledAutomatically;
     }
@@ -135,18 +199,44 @@ public:
         return "FlowGraph";
     }
 
+    /**
+     * Nodes that map each input frame to exactly one output frame, with no delay,
+     * can describe their processing so it can be fused with adjacent nodes into a single loop.
+     * See SinkFused.
+     *
+     * @param stage filled in if the node can be fused
+     * @return true if the node can be fused
+     */
+    virtual bool describeFusedStage(FusedStage *stage) {
+        (void) stage;
+        return false;
+    }
+
     int64_t getLastCallCount() {
         return mLastCallCount;
     }
 
+    /**
+     * Override this to return true if onProcess() handles ports with a planar layout.
+     * See FlowGraphPortFloat::setLayout().
+     */
+    virtual bool isPlanarSupported() const {
+        return false;
+    }
+
 protected:
 
     static constexpr int64_t  kInitialCallCount = -1;
     int64_t  mLastCallCount = kInitialCallCount;
 
     std::vector<std::reference_wrapper<FlowGraphPort>> mInputPorts;
+    std::vector<std::reference_wrapper<FlowGraphPort>> mOutputPorts;
+    // Input ports that have a ParameterAutomation. This is usually empty.
+    std::vector<std::reference_wrapper<FlowGraphPort>> mAutomatedInputPorts;
 
 private:
+    int32_t pullAutomatedInputPorts(int32_t numFrames, int64_t callCount);
+
     bool     mDataPulledAutomatically = true;
     bool     mBlockRecursion = false;
     int32_t  mLastFrameCount = 0;
@@ -174,14 +264,62 @@ public:
     FlowGraphPort(const FlowGraphPort&) = delete;
     FlowGraphPort& operator=(const FlowGraphPort&) = delete;
 
+    /**
+     * How the samples of a multi-channel buffer are arranged.
+     *
+     * Interleaved puts the samples of each frame together: L0 R0 L1 R1 ...
+     * Planar puts all of the frames of each channel together: L0 L1 ... R0 R1 ...
+     * Each channel of a planar buffer starts getFramesPerBuffer() samples after the previous one.
+     * Mono buffers are the same in either layout.
+     */
+    enum class Layout {
+        Interleaved,
+        Planar,
+    };
+
     int32_t getSamplesPerFrame() const {
         return mSamplesPerFrame;
     }
 
+    FlowGraphNode &getContainingNode() const {
+        return mContainingNode;
+    }
+
+    /**
+     * This is used by FlowGraphSchedule to find the upstream nodes without pulling data.
+     * @return the node connected to this input port, or nullptr
+     */
+    virtual FlowGraphNode *getConnectedNode() const {
+        return nullptr;
+    }
+
+    /**
+     * This is used by FlowGraphSchedule to limit the number of frames processed per pass.
+     * @return maximum number of frames that fit in the buffer of this port
+     */
+    virtual int32_t getFrameCapacity() const {
+        return INT32_MAX;
+    }
+
     virtual int32_t pullData(int64_t framePosition, int32_t numFrames) = 0;
 
     virtual void pullReset() {}
 
+    virtual void pullSetFramesPerBuffer(int32_t framesPerBuffer) {
+        (void) framesPerBuffer;
+    }
+
+    /**
+     * Reallocate the buffer, if any.
+     * A port with a buffer keeps the frames that still fit. If the buffer grows,
+     * the new frames are copies of the last old frame, so a value set by
+     * FlowGraphPortFloatInput::setValue() is kept.
+     * @param framesPerBuffer maximum number of frames in the buffer
+     */
+    virtual void setFramesPerBuffer(int32_t framesPerBuffer) {
+        (void) framesPerBuffer;
+    }
+
 protected:
     FlowGraphNode &mContainingNode;
 
@@ -209,6 +347,48 @@ public:
         return mFramesPerBuffer;
     }
 
+    void setFramesPerBuffer(int32_t framesPerBuffer) override;
+
+    int32_t getFrameCapacity() const override {
+        return mFramesPerBuffer;
+    }
+
+    Layout getLayout() const {
+        return mLayout;
+    }
+
+    /**
+     * Set the layout before connecting the port.
+     * Connected ports must have the same layout, so a LayoutConverter is needed
+     * between a planar and an interleaved node.
+     * Only nodes that return true from isPlanarSupported() can use the planar layout.
+     */
+    void setLayout(Layout layout) {
+        assert(layout == Layout::Interleaved || mContainingNode.isPlanarSupported());
+        mLayout = layout;
+    }
+
+    /**
+     * @return true if the buffer is planar and has more than one channel
+     */
+    bool isPlanar() const {
+        return mLayout == Layout::Planar && getSamplesPerFrame() > 1;
+    }
+
+    /**
+     * @return distance between the same frame of adjacent channels, in samples
+     */
+    int32_t getChannelStride() const {
+        return isPlanar() ? mFramesPerBuffer : 1;
+    }
+
+    /**
+     * @return distance between adjacent frames of the same channel, in samples
+     */
+    int32_t getFrameStride() const {
+        return isPlanar() ? 1 : getSamplesPerFrame();
+    }
+
 protected:
 
     /**
@@ -219,7 +399,8 @@ protected:
     }
 
 private:
-    const int32_t    mFramesPerBuffer = 1;
+    int32_t          mFramesPerBuffer = 1;
+    Layout           mLayout = Layout::Interleaved;
     std::unique_ptr<float[]> mBuffer; // allocated in constructor
 };
 
@@ -231,6 +412,8 @@ class FlowGraphPortFloatOutput : public FlowGraphPortFloat {
 public:
     FlowGraphPortFloatOutput(FlowGraphNode &parent, int32_t samplesPerFrame)
             : FlowGraphPortFloat(parent, samplesPerFrame) {
+        // Add to parent so the buffer can be resized with setFramesPerBuffer().
+        parent.addOutputPort(*this);
     }
 
     virtual ~FlowGraphPortFloatOutput() = default;
@@ -266,6 +449,8 @@ public:
 
     void pullReset() override;
 
+    void pullSetFramesPerBuffer(int32_t framesPerBuffer) override;
+
 };
 
 /***************************************************************************/
@@ -299,7 +484,7 @@ public:
      * to this port.
      */
     void setValue(float value) {
-        int numFloats = kDefaultBufferSize * getSamplesPerFrame();
+        int numFloats = getFramesPerBuffer() * getSamplesPerFrame();
         float *buffer = getBuffer();
         for (int i = 0; i < numFloats; i++) {
             *buffer++ = value;
@@ -314,6 +499,7 @@ public:
      */
     void connect(FlowGraphPortFloatOutput *port) {
         assert(getSamplesPerFrame() == port->getSamplesPerFrame());
+        assert(isPlanar() == port->isPlanar());
         mConnected = port;
     }
 
@@ -327,6 +513,32 @@ public:
         mConnected = nullptr;
     }
 
+    /**
+     * Render the values of this port from a ParameterAutomation when it is pulled.
+     * Every channel gets the same value. This is ignored while an output port is connected.
+     *
+     * The automation is not owned by the port. Pass nullptr to stop using it.
+     * This not thread safe. Set it before running the graph.
+     */
+    void setAutomation(ParameterAutomation *automation);
+
+    ParameterAutomation *getAutomation() const {
+        return mAutomation;
+    }
+
+    /**
+     * The buffer of a connected port is used, so use its size for the stride.
+     * @return distance between the same frame of adjacent channels, in samples
+     */
+    int32_t getChannelStride() const {
+        return (mConnected == nullptr) ? FlowGraphPortFloat::getChannelStride()
+                                       : mConnected->getChannelStride();
+    }
+
+    FlowGraphNode *getConnectedNode() const override {
+        return (mConnected == nullptr) ? nullptr : &mConnected->getContainingNode();
+    }
+
     /**
      * Pull data from any output port that is connected.
      */
@@ -334,8 +546,14 @@ public:
 
     void pullReset() override;
 
+    void pullSetFramesPerBuffer(int32_t framesPerBuffer) override;
+
 private:
+    void renderAutomation(int32_t numFrames);
+
     FlowGraphPortFloatOutput *mConnected = nullptr;
+    ParameterAutomation      *mAutomation = nullptr;
+    bool                      mIsAutomationAdded = false;
 };
 
 /***************************************************************************/
@@ -397,14 +615,31 @@ protected:
  */
 class FlowGraphSink : public FlowGraphNode {
 public:
-    explicit FlowGraphSink(int32_t channelCount)
-            : input(*this, channelCount) {
-    }
+    // These are in the .cpp file because FlowGraphSchedule is not defined here.
+    explicit FlowGraphSink(int32_t channelCount);
 
-    virtual ~FlowGraphSink() = default;
+    virtual ~FlowGraphSink();
 
     FlowGraphPortFloatInput input;
 
+    /**
+     * Sort the upstream nodes once so that read() runs them from a flat list
+     * instead of recursively pulling the data. See FlowGraphSchedule.
+     *
+     * Call this again after changing the connections or the block size.
+     * This must not be called at the same time as read()!
+     */
+    void buildSchedule();
+
+    /**
+     * Go back to pulling the data recursively.
+     */
+    void clearSchedule();
+
+    FlowGraphSchedule *getSchedule() const {
+        return mSchedule.get();
+    }
+
     /**
      * Do nothing. The work happens in the read() method.
      *
@@ -420,10 +655,14 @@ public:
 protected:
     /**
      * Pull data through the graph using this nodes last callCount.
+     * If a schedule was built then the nodes are run from that instead.
      * @param numFrames
      * @return
      */
     int32_t pullData(int32_t numFrames);
+
+private:
+    std::unique_ptr<FlowGraphSchedule> mSchedule;
 };
 
 /***************************************************************************/
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "FlowGraphSchedule.h"
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+
+void FlowGraphSchedule::build(FlowGraphNode &lastNode) {
+    mSteps.clear();
+    mUpstreamSteps.clear();
+    std::unordered_map<FlowGraphNode *, int32_t> indices;
+    addNode(&lastNode, indices);
+    mFrameCounts.assign(mSteps.size(), 0);
+    findBranches();
+}
+
+// Depth first so that each node is added after all of its upstream nodes.
+int32_t FlowGraphSchedule::addNode(FlowGraphNode *node,
+                                   std::unordered_map<FlowGraphNode *, int32_t> &indices) {
+    indices[node] = kVisiting;
+    int32_t maxFrames = INT32_MAX;
+    for (FlowGraphPort &port : node->getOutputPorts()) {
+        maxFrames = std::min(maxFrames, port.getFrameCapacity());
+    }
+
+    std::vector<int32_t> upstreamSteps;
+    if (node->isDataPulledAutomatically()) {
+        for (FlowGraphPort &port : node->getInputPorts()) {
+            FlowGraphNode *upstream = port.getConnectedNode();
+            if (upstream == nullptr) {
+                maxFrames = std::min(maxFrames, port.getFrameCapacity()); // uses setValue()
+                continue;
+            }
+            auto found = indices.find(upstream);
+            int32_t upstreamIndex = (found == indices.end())
+                    ? addNode(upstream, indices)
+                    : found->second;
+            // A node that is still being visited is on a cycle. Use its previous output.
+            if (upstreamIndex != kVisiting) {
+                upstreamSteps.push_back(upstreamIndex);
+            }
+        }
+    }
+
+    const int32_t index = static_cast<int32_t>(mSteps.size());
+    const int32_t firstUpstream = static_cast<int32_t>(mUpstreamSteps.size());
+    mUpstreamSteps.insert(mUpstreamSteps.end(), upstreamSteps.begin(), upstreamSteps.end());
+    mSteps.push_back({node, maxFrames, firstUpstream,
+                      static_cast<int32_t>(mUpstreamSteps.size())});
+    indices[node] = index;
+    return index;
+}
+
+void FlowGraphSchedule::findBranches() {
+    const int32_t numSteps = static_cast<int32_t>(mSteps.size());
+    const int32_t numEdges = static_cast<int32_t>(mUpstreamSteps.size());
+    mPlan.clear();
+    mGroups.clear();
+    mBranches.clear();
+    mBranchSteps.clear();
+
+    // Find the steps that feed exactly one input of one other step.
+    std::vector<int32_t> consumerCounts(numSteps, 0);
+    std::vector<int32_t> consumerEdges(numSteps, 0); // index into mUpstreamSteps
+    for (int32_t index = 0; index < numSteps; index++) {
+        const Step &step = mSteps[index];
+        for (int32_t edge = step.firstUpstream; edge < step.endUpstream; edge++) {
+            consumerCounts[mUpstreamSteps[edge]]++;
+            consumerEdges[mUpstreamSteps[edge]] = edge;
+        }
+    }
+    std::vector<int32_t> edgeConsumers(numEdges);
+    for (int32_t index = 0; index < numSteps; index++) {
+        for (int32_t edge = mSteps[index].firstUpstream; edge < mSteps[index].endUpstream; edge++) {
+            edgeConsumers[edge] = index;
+        }
+    }
+
+    // A branch is identified by the input edge of the merge node that it feeds.
+    // Go from downstream to upstream so that the branch of the consumer is already known.
+    // Merges inside a branch are part of that branch.
+    std::vector<int32_t> branchEdges(numSteps, kNoBranch);
+    for (int32_t index = numSteps - 1; index >= 0; index--) {
+        if (consumerCounts[index] != 1) {
+            continue; // feeds several steps, or none
+        }
+        const int32_t edge = consumerEdges[index];
+        const int32_t consumer = edgeConsumers[edge];
+        const Step &consumerStep = mSteps[consumer];
+        if (branchEdges[consumer] != kNoBranch) {
+            branchEdges[index] = branchEdges[consumer];
+        } else if (consumerStep.endUpstream - consumerStep.firstUpstream > 1) {
+            branchEdges[index] = edge;
+        }
+    }
+    std::vector<std::vector<int32_t>> stepsByEdge(numEdges);
+    for (int32_t index = 0; index < numSteps; index++) {
+        if (branchEdges[index] != kNoBranch) {
+            stepsByEdge[branchEdges[index]].push_back(index);
+        }
+    }
+
+    // Run the branches just before the node that merges them.
+    for (int32_t index = 0; index < numSteps; index++) {
+        if (branchEdges[index] != kNoBranch) {
+            continue;
+        }
+        const Step &step = mSteps[index];
+        int32_t numBranches = 0;
+        for (int32_t edge = step.firstUpstream; edge < step.endUpstream; edge++) {
+            numBranches += stepsByEdge[edge].empty() ? 0 : 1;
+        }
+        if (numBranches == 1) {
+            // Nothing to run in parallel.
+            for (int32_t edge = step.firstUpstream; edge < step.endUpstream; edge++) {
+                mPlan.insert(mPlan.end(), stepsByEdge[edge].begin(), stepsByEdge[edge].end());
+            }
+        } else if (numBranches > 1) {
+            Group group{{static_cast<int32_t>(mBranches.size()), 0}, 0};
+            for (int32_t edge = step.firstUpstream; edge < step.endUpstream; edge++) {
+                const std::vector<int32_t> &branchSteps = stepsByEdge[edge];
+                if (branchSteps.empty()) {
+                    continue;
+                }
+                const int32_t first = static_cast<int32_t>(mBranchSteps.size());
+                mBranchSteps.insert(mBranchSteps.end(), branchSteps.begin(), branchSteps.end());
+                mBranches.push_back({first, static_cast<int32_t>(mBranchSteps.size())});
+                group.numSteps += static_cast<int32_t>(branchSteps.size());
+            }
+            group.branches.end = static_cast<int32_t>(mBranches.size());
+            mPlan.push_back(-1 - static_cast<int32_t>(mGroups.size()));
+            mGroups.push_back(group);
+        }
+        mPlan.push_back(index);
+    }
+}
+
+int32_t FlowGraphSchedule::process(int32_t numFrames) {
+    if (mSteps.empty()) {
+        return 0;
+    }
+    mNumFrames = numFrames;
+    mCallCount = mSteps.back().node->getLastCallCount() + 1;
+    for (int32_t entry : mPlan) {
+        if (entry >= 0) {
+            runStep(entry);
+        } else {
+            runGroup(mGroups[-1 - entry]);
+        }
+    }
+    return mFrameCounts.back();
+}
+
+void FlowGraphSchedule::runBranch(int32_t branchIndex) {
+    const Range &branch = mBranches[branchIndex];
+    for (int32_t i = branch.first; i < branch.end; i++) {
+        runStep(mBranchSteps[i]);
+    }
+}
+
+void FlowGraphSchedule::runGroup(const Group &group) {
+    const int64_t work = static_cast<int64_t>(mNumFrames) * group.numSteps;
+    if (mWorkerPool != nullptr && work >= mMinParallelWork) {
+        mRunningGroup = &group;
+        mWorkerPool->run(runBranchTask, this, group.branches.end - group.branches.first);
+    } else {
+        for (int32_t branch = group.branches.first; branch < group.branches.end; branch++) {
+            runBranch(branch);
+        }
+    }
+}
+
+void FlowGraphSchedule::runBranchTask(void *context, int32_t taskIndex) {
+    FlowGraphSchedule *schedule = static_cast<FlowGraphSchedule *>(context);
+    schedule->runBranch(schedule->mRunningGroup->branches.first + taskIndex);
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOWGRAPH_FLOW_GRAPH_SCHEDULE_H
+#define FLOWGRAPH_FLOW_GRAPH_SCHEDULE_H
+
+#include <algorithm>
+#include <sys/types.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include "FlowGraphNode.h"
+#include "FlowGraphWorkerPool.h"
+
+namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
+
+/**
+ * A flat list of the nodes upstream of a sink, sorted so that every node comes after
+ * the nodes that it reads from.
+ *
+ * The graph is sorted once by build(). Then process() runs each node once per pass
+ * by calling onProcess() directly. That avoids the recursion of FlowGraphNode::pullData(),
+ * and its per node call count checks and virtual port calls.
+ *
+ * Nodes that pull their own inputs, see FlowGraphNode::setDataPulledAutomatically(),
+ * are scheduled like a source. They still pull their upstream nodes recursively.
+ * Cycles are broken the same way as pullData(): a node on a cycle reads the
+ * previous output of the node that feeds it.
+ *
+ * A node with several upstream nodes, such as ManyToMultiConverter, merges branches.
+ * Each branch is the set of nodes whose output only reaches the rest of the graph
+ * through one input of the merge node. Branches do not share nodes so they can run
+ * at the same time on a FlowGraphWorkerPool, see setWorkerPool().
+ * Nodes that feed more than one branch are run before the branches.
+ *
+ * FlowGraphSink::buildSchedule() makes the sink use a schedule for read().
+ */
+class FlowGraphSchedule {
+public:
+    /**
+     * Sort the nodes that are upstream of the last node.
+     * Call this again after changing the connections or the block size.
+     *
+     * @param lastNode the node that is run last, usually a sink
+     */
+    void build(FlowGraphNode &lastNode);
+
+    /**
+     * Run every node once.
+     * The number of frames processed by each node is limited by the frames processed
+     * by its upstream nodes and by the size of its port buffers.
+     *
+     * @param numFrames maximum number of frames requested for processing
+     * @return number of frames processed by the last node
+     */
+    int32_t process(int32_t numFrames);
+
+    /**
+     * Run independent branches on a pool of threads.
+     * Small blocks are run on the calling thread because waking the workers would cost more.
+     *
+     * This must not be called at the same time as process()!
+     *
+     * @param pool pool to use or nullptr to run everything on the calling thread
+     * @param minParallelWork only use the pool if the number of frames times the number
+     *                        of nodes in the branches is at least this
+     */
+    void setWorkerPool(FlowGraphWorkerPool *pool,
+                       int32_t minParallelWork = kDefaultMinParallelWork) {
+        mWorkerPool = pool;
+        mMinParallelWork = minParallelWork;
+    }
+
+    /**
+     * @return number of branches that can run in parallel, summed over all the merge nodes
+     */
+    int32_t getBranchCount() const {
+        return static_cast<int32_t>(mBranches.size());
+    }
+
+    // Roughly the work needed to pay for waking the workers, in frames times nodes.
+    static constexpr int32_t kDefaultMinParallelWork = 2048;
+
+    int32_t getNodeCount() const {
+        return static_cast<int32_t>(mSteps.size());
+    }
+
+    /**
+     * @param index position in the schedule, 0 is run first
+     */
+    FlowGraphNode *getNode(int32_t index) const {
+        return mSteps[index].node;
+    }
+
+private:
+    struct Step {
+        FlowGraphNode *node;
+        int32_t maxFrames; // smallest port buffer
+        // The upstream steps are mUpstreamSteps[firstUpstream] to mUpstreamSteps[endUpstream - 1].
+        int32_t firstUpstream;
+        int32_t endUpstream;
+    };
+
+    // The steps of a branch are mBranchSteps[first] to mBranchSteps[end - 1].
+    struct Range {
+        int32_t first;
+        int32_t end;
+    };
+
+    // The branches that are merged by one node.
+    struct Group {
+        Range   branches; // index into mBranches
+        int32_t numSteps; // in all the branches
+    };
+
+    static constexpr int32_t kVisiting = -1;
+    static constexpr int32_t kNoBranch = -1;
+
+    int32_t addNode(FlowGraphNode *node, std::unordered_map<FlowGraphNode *, int32_t> &indices);
+    void findBranches();
+
+    void runStep(int32_t index) {
+        const Step &step = mSteps[index];
+        int32_t frameCount = std::min(mNumFrames, step.maxFrames);
+        for (int32_t i = step.firstUpstream; i < step.endUpstream; i++) {
+            frameCount = std::min(frameCount, mFrameCounts[mUpstreamSteps[i]]);
+        }
+        mFrameCounts[index] = step.node->processScheduled(frameCount, mCallCount);
+    }
+
+    void runBranch(int32_t branchIndex);
+    void runGroup(const Group &group);
+    static void runBranchTask(void *context, int32_t taskIndex);
+
+    std::vector<Step>    mSteps;
+    std::vector<int32_t> mUpstreamSteps;
+    std::vector<int32_t> mFrameCounts; // frames processed by each step in the current pass
+
+    // Steps are run in this order. A negative entry, -1 - groupIndex, runs a group of branches.
+    std::vector<int32_t> mPlan;
+    std::vector<Group>   mGroups;
+    std::vector<Range>   mBranches;
+    std::vector<int32_t> mBranchSteps;
+
+    FlowGraphWorkerPool *mWorkerPool = nullptr;
+    int32_t              mMinParallelWork = kDefaultMinParallelWork;
+
+    // The current pass, for the worker threads.
+    int32_t              mNumFrames = 0;
+    int64_t              mCallCount = 0;
+    const Group         *mRunningGroup = nullptr;
+};
+
+} /* namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph */
+
+#endif //FLOWGRAPH_FLOW_GRAPH_SCHEDULE_H
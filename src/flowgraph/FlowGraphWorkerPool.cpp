@@ -0,0 +1,118 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "FlowGraphWorkerPool.h"
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+
+FlowGraphWorkerPool::FlowGraphWorkerPool(int32_t numWorkers, bool realTime) {
+    sem_init(&mWakeUp, 0, 0);
+    for (int32_t i = 0; i < numWorkers; i++) {
+        mThreads.emplace_back([this, realTime]() { runWorker(realTime); });
+    }
+}
+
+FlowGraphWorkerPool::~FlowGraphWorkerPool() {
+    mExiting.store(true, std::memory_order_release);
+    wakeWorkers();
+    for (std::thread &thread : mThreads) {
+        thread.join();
+    }
+    sem_destroy(&mWakeUp);
+}
+
+void FlowGraphWorkerPool::wakeWorkers() {
+    for (size_t i = 0; i < mThreads.size(); i++) {
+        sem_post(&mWakeUp);
+    }
+}
+
+void FlowGraphWorkerPool::run(TaskFunction function, void *context, int32_t numTasks) {
+    if (numTasks <= 0) {
+        return;
+    }
+    if (mThreads.empty() || numTasks == 1) {
+        for (int32_t i = 0; i < numTasks; i++) {
+            function(context, i);
+        }
+        return;
+    }
+
+    const Batch batch = {function, context, numTasks, ++mGeneration};
+    BatchSlot &slot = mBatches[batch.generation & 1];
+    // A worker that woke up late may still be reading this slot for the batch before last.
+    // This fence pairs with the one in runWorker() so that it then sees a newer generation
+    // and cannot claim a task.
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.function.store(function, std::memory_order_relaxed);
+    slot.context.store(context, std::memory_order_relaxed);
+    slot.numTasks.store(numTasks, std::memory_order_relaxed);
+    mTasksLeft.store(numTasks, std::memory_order_relaxed);
+    mNextTask.store(static_cast<uint64_t>(batch.generation) << 32, std::memory_order_release);
+    wakeWorkers();
+
+    runTasks(batch);
+    // Wait for the tasks that the workers claimed.
+    while (mTasksLeft.load(std::memory_order_acquire) > 0) {
+        std::this_thread::yield();
+    }
+}
+
+void FlowGraphWorkerPool::runTasks(const Batch &batch) {
+    const uint64_t first = static_cast<uint64_t>(batch.generation) << 32;
+    uint64_t next = mNextTask.load();
+    while (true) {
+        if ((next & ~0xFFFFFFFFull) != first || (next - first) >= (uint64_t) batch.numTasks) {
+            return; // finished or a newer batch
+        }
+        if (mNextTask.compare_exchange_weak(next, next + 1)) {
+            batch.function(batch.context, static_cast<int32_t>(next - first));
+            mTasksLeft.fetch_sub(1, std::memory_order_release);
+            next = mNextTask.load();
+        }
+    }
+}
+
+void FlowGraphWorkerPool::runWorker(bool realTime) {
+    if (realTime) {
+        sched_param param{};
+        param.sched_priority = kRealTimePriority;
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0) {
+            mRealTimeWorkerCount++;
+        }
+    }
+    while (true) {
+        while (sem_wait(&mWakeUp) != 0) {} // retry if interrupted
+        if (mExiting.load(std::memory_order_acquire)) {
+            return;
+        }
+        const uint32_t generation = static_cast<uint32_t>(
+                mNextTask.load(std::memory_order_acquire) >> 32);
+        const BatchSlot &slot = mBatches[generation & 1];
+        const Batch batch = {slot.function.load(std::memory_order_relaxed),
+                             slot.context.load(std::memory_order_relaxed),
+                             slot.numTasks.load(std::memory_order_relaxed),
+                             generation};
+        // If run() rewrote the slot while it was read then the claims in runTasks()
+        // see the newer generation and fail, like a seqlock reader.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // This may be a batch that has already finished. Then no tasks can be claimed.
+        runTasks(batch);
+    }
+}
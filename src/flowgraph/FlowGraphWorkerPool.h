@@ -0,0 +1,116 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOWGRAPH_FLOW_GRAPH_WORKER_POOL_H
+#define FLOWGRAPH_FLOW_GRAPH_WORKER_POOL_H
+
+#include <atomic>
+#include <semaphore.h>
+#include <sys/types.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "FlowGraphNode.h"
+
+namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
+
+/**
+ * A small pool of threads that helps the calling thread run a batch of independent tasks.
+ * FlowGraphSchedule uses it to run independent branches of a graph at the same time.
+ *
+ * The calling thread runs tasks too, so a batch finishes even if the workers are slow to wake.
+ * Every thread claims the next task from a shared counter until there are none left.
+ * That balances the load like work stealing without a queue per thread, which is enough
+ * because each batch is a single fork and join.
+ *
+ * run() does not allocate memory or take a lock, so a worker that is preempted,
+ * for example because it could not get SCHED_FIFO, cannot block the calling thread.
+ * The batch is published in one of two slots, selected by its generation.
+ */
+class FlowGraphWorkerPool {
+public:
+    using TaskFunction = void (*)(void *context, int32_t taskIndex);
+
+    // Same as the priority usually given to audio callback threads.
+    static constexpr int kRealTimePriority = 2;
+
+    /**
+     * @param numWorkers number of threads in addition to the thread that calls run()
+     * @param realTime if true then try to run the workers with SCHED_FIFO,
+     *                 which may not be permitted
+     */
+    explicit FlowGraphWorkerPool(int32_t numWorkers, bool realTime = true);
+
+    ~FlowGraphWorkerPool();
+
+    FlowGraphWorkerPool(const FlowGraphWorkerPool&) = delete;
+    FlowGraphWorkerPool& operator=(const FlowGraphWorkerPool&) = delete;
+
+    int32_t getWorkerCount() const {
+        return static_cast<int32_t>(mThreads.size());
+    }
+
+    /**
+     * @return number of workers that are running with SCHED_FIFO
+     */
+    int32_t getRealTimeWorkerCount() const {
+        return mRealTimeWorkerCount.load();
+    }
+
+    /**
+     * Call function(context, taskIndex) once for every taskIndex from 0 to numTasks - 1,
+     * and return when they have all finished.
+     * Only one thread may call this at a time.
+     */
+    void run(TaskFunction function, void *context, int32_t numTasks);
+
+private:
+    struct Batch {
+        TaskFunction function;
+        void        *context;
+        int32_t      numTasks;
+        uint32_t     generation;
+    };
+
+    // A slot is only rewritten two batches later, after the generation has moved on.
+    struct BatchSlot {
+        std::atomic<TaskFunction> function{nullptr};
+        std::atomic<void *>       context{nullptr};
+        std::atomic<int32_t>      numTasks{0};
+    };
+
+    void wakeWorkers();
+    void runWorker(bool realTime);
+    void runTasks(const Batch &batch);
+
+    std::vector<std::thread> mThreads;
+    std::atomic<int32_t>     mRealTimeWorkerCount{0};
+
+    sem_t                    mWakeUp; // posted once per worker for every batch
+    BatchSlot                mBatches[2]; // indexed by the low bit of the generation
+    uint32_t                 mGeneration = 0; // only used by run()
+    std::atomic<bool>        mExiting{false};
+
+    // The generation of the batch is in the upper 32 bits and the next task in the lower bits.
+    // A worker that wakes up late cannot claim a task from the next batch.
+    std::atomic<uint64_t>    mNextTask{0};
+    std::atomic<int32_t>     mTasksLeft{0};
+};
+
+} /* namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph */
+
+#endif //FLOWGRAPH_FLOW_GRAPH_WORKER_POOL_H
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FLOWGRAPH_FUSED_STAGE_H
+#define FLOWGRAPH_FUSED_STAGE_H
+
+#include <sys/types.h>
+#include <vector>
+
+#include "FlowGraphNode.h"
+
+namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
+
+class RampLinear;
+
+/**
+ * Description of a node that maps each input frame to one output frame
+ * so that it can be fused with its neighbors into a single loop.
+ * See FlowGraphNode::describeFusedStage() and SinkFused.
+ */
+struct FusedStage {
+    enum class Type {
+        ChannelMap, // output channel i is copied from input channel channelMap[i]
+        Gain,       // multiply by the level from a RampLinear
+        Limit,      // Limiter soft clipping, a NaN repeats the last output of its channel
+        Clip,       // clamp to [minimum, maximum]
+    };
+
+    Type                 type = Type::ChannelMap;
+    int32_t              inputChannelCount = 0;
+    int32_t              outputChannelCount = 0;
+    std::vector<int32_t> channelMap;       // for ChannelMap
+    RampLinear          *ramp = nullptr;   // for Gain, owned by the caller
+    float                minimum = 0.0f;   // for Clip
+    float                maximum = 0.0f;   // for Clip
+};
+
+} /* namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph */
+
+#endif //FLOWGRAPH_FUSED_STAGE_H
@@ -0,0 +1,243 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "FlowGraphNode.h"
+#include "GraphCrossfader.h"
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+
+int32_t GraphCrossfader::SectionSource::onProcess(int32_t numFrames) {
+    if (mCrossfader == nullptr) {
+        return 0;
+    }
+    return mCrossfader->readInput(*this, output.getBuffer(), numFrames);
+}
+
+GraphCrossfader::GraphCrossfader(int32_t inputChannelCount, int32_t outputChannelCount)
+        : input(*this, inputChannelCount)
+        , output(*this, outputChannelCount) {
+    // The sections pull the input when they need it.
+    setDataPulledAutomatically(false);
+}
+
+GraphCrossfader::~GraphCrossfader() {
+    reclaim();
+    delete mPending.exchange(nullptr);
+    delete mIncoming;
+    delete mCurrent;
+}
+
+void GraphCrossfader::setFramesPerBuffer(int32_t framesPerBuffer) {
+    FlowGraphNode::setFramesPerBuffer(framesPerBuffer);
+    mHistory.resize(static_cast<size_t>(kHistoryBlocks) * framesPerBuffer
+                    * input.getSamplesPerFrame());
+    mHistoryStart = mHistoryEnd;
+    mIncomingBuffer.resize(static_cast<size_t>(framesPerBuffer) * output.getSamplesPerFrame());
+    // This is not called while the graph is running so the sections can be changed here.
+    for (Section *section : {mCurrent, mIncoming, mPending.load()}) {
+        if (section != nullptr) {
+            section->sink.pullSetFramesPerBuffer(framesPerBuffer);
+            section->sink.buildSchedule();
+        }
+    }
+}
+
+bool GraphCrossfader::publish(std::unique_ptr<Section> section) {
+    reclaim();
+    if (section->source.output.getSamplesPerFrame() != input.getSamplesPerFrame()
+            || section->sink.input.getSamplesPerFrame() != output.getSamplesPerFrame()) {
+        return false;
+    }
+    section->source.mCrossfader = this;
+    section->sink.pullSetFramesPerBuffer(output.getFramesPerBuffer());
+    section->sink.buildSchedule();
+    // If the audio thread has not picked up the previous one then it never will.
+    delete mPending.exchange(section.release(), std::memory_order_acq_rel);
+    return true;
+}
+
+void GraphCrossfader::reclaim() {
+    // Take the whole list so there is no ABA problem with the audio thread pushing.
+    Section *section = mRetired.exchange(nullptr, std::memory_order_acquire);
+    while (section != nullptr) {
+        Section *next = section->mNextRetired;
+        delete section;
+        section = next;
+    }
+}
+
+void GraphCrossfader::retire(Section *section) {
+    Section *head = mRetired.load(std::memory_order_relaxed);
+    do {
+        section->mNextRetired = head;
+    } while (!mRetired.compare_exchange_weak(head, section, std::memory_order_release,
+                                             std::memory_order_relaxed));
+}
+
+int32_t GraphCrossfader::readInput(SectionSource &source, float *buffer, int32_t numFrames) {
+    const int32_t channelCount = input.getSamplesPerFrame();
+    while (mHistoryEnd < source.mPosition + numFrames && pullInput()) {}
+    // A section that fell too far behind skips the frames that were dropped.
+    source.mPosition = std::max(source.mPosition, mHistoryStart);
+    const int32_t framesRead = static_cast<int32_t>(std::max(static_cast<int64_t>(0),
+            std::min(static_cast<int64_t>(numFrames), mHistoryEnd - source.mPosition)));
+    memcpy(buffer, &mHistory[(source.mPosition - mHistoryStart) * channelCount],
+           framesRead * channelCount * sizeof(float));
+    source.mPosition += framesRead;
+    return framesRead;
+}
+
+bool GraphCrossfader::pullInput() {
+    const int32_t channelCount = input.getSamplesPerFrame();
+    const int32_t framesPerBuffer = input.getFramesPerBuffer();
+    const int64_t capacity = static_cast<int64_t>(mHistory.size()) / channelCount;
+    if (mHistoryEnd - mHistoryStart + framesPerBuffer > capacity) {
+        // Keep half of the history for the pre-roll of the next section,
+        // or more if a section has not read it yet.
+        int64_t oldestNeeded = mHistoryEnd - capacity / 2;
+        for (Section *section : {mCurrent, mIncoming}) {
+            if (section != nullptr) {
+                oldestNeeded = std::min(oldestNeeded, section->source.mPosition);
+            }
+        }
+        oldestNeeded = std::max(oldestNeeded, mHistoryEnd + framesPerBuffer - capacity);
+        const int64_t framesKept = std::max(static_cast<int64_t>(0), mHistoryEnd - oldestNeeded);
+        const int64_t firstKept = mHistoryEnd - framesKept - mHistoryStart;
+        memmove(mHistory.data(), &mHistory[firstKept * channelCount],
+                framesKept * channelCount * sizeof(float));
+        mHistoryStart = mHistoryEnd - framesKept;
+    }
+    mInputCallCount++;
+    const int32_t framesRead = input.pullData(mInputCallCount, framesPerBuffer);
+    if (framesRead <= 0) {
+        return false;
+    }
+    memcpy(&mHistory[(mHistoryEnd - mHistoryStart) * channelCount], input.getBuffer(),
+           framesRead * channelCount * sizeof(float));
+    mHistoryEnd += framesRead;
+    return true;
+}
+
+int32_t GraphCrossfader::pullSection(Section *section, float *buffer, int32_t numFrames) {
+    const int32_t framesRead = section->sink.read(buffer, numFrames);
+    const int32_t channelCount = output.getSamplesPerFrame();
+    // The other section may still have output so fill the gap with silence.
+    std::fill(buffer + std::max(0, framesRead) * channelCount,
+              buffer + numFrames * channelCount, 0.0f);
+    return std::max(0, framesRead);
+}
+
+int64_t GraphCrossfader::getInputPosition(const Section &section, int64_t startFrame,
+                                          int64_t outputFrames) {
+    if (section.mPreRollOutputFrames > 0) {
+        return startFrame + outputFrames * section.mPreRollInputFrames
+                / section.mPreRollOutputFrames;
+    }
+    return startFrame + outputFrames;
+}
+
+void GraphCrossfader::startCrossfade(Section *next) {
+    if (mCurrent == nullptr) {
+        // Nothing to fade from.
+        next->source.mPosition = mHistoryEnd;
+        mCurrent = next;
+        mCurrentStartFrame = mHistoryEnd;
+        mCurrentOutputFrames = 0;
+        mSwapCount.fetch_add(1, std::memory_order_release);
+        return;
+    }
+    // The current section may have read ahead of its output so line up by the output.
+    const int64_t position = std::max(mHistoryStart, getInputPosition(
+            *mCurrent, mCurrentStartFrame, mCurrentOutputFrames));
+    const int64_t startPosition = std::max(mHistoryStart,
+                                           position - next->mPreRollInputFrames);
+    next->source.mPosition = startPosition;
+    mIncoming = next;
+    mIncomingStartFrame = position;
+    mIncomingOutputFrames = 0;
+    mFadeLength = std::max(1, mCrossfadeFrames.load());
+    mFadePosition = 0;
+
+    // Fill the filters of the new section from the history.
+    if (next->mPreRollInputFrames > 0) {
+        int64_t framesToDiscard = (position - startPosition) * next->mPreRollOutputFrames
+                / next->mPreRollInputFrames;
+        const int32_t framesPerBuffer = output.getFramesPerBuffer();
+        while (framesToDiscard > 0) {
+            const int32_t framesRead = next->sink.read(mIncomingBuffer.data(),
+                    static_cast<int32_t>(std::min(framesToDiscard,
+                                                  static_cast<int64_t>(framesPerBuffer))));
+            if (framesRead <= 0) {
+                break;
+            }
+            framesToDiscard -= framesRead;
+        }
+    }
+}
+
+int32_t GraphCrossfader::onProcess(int32_t numFrames) {
+    // The audio thread never frees a section. Faded out sections are put on the
+    // retired list, so a new one can be picked up before the old ones are reclaimed.
+    if (mIncoming == nullptr) {
+        Section *next = mPending.exchange(nullptr, std::memory_order_acq_rel);
+        if (next != nullptr) {
+            startCrossfade(next);
+        }
+    }
+
+    float *outputBuffer = output.getBuffer();
+    const int32_t channelCount = output.getSamplesPerFrame();
+    if (mCurrent == nullptr) {
+        std::fill(outputBuffer, outputBuffer + numFrames * channelCount, 0.0f);
+        return numFrames;
+    }
+    int32_t framesRead = pullSection(mCurrent, outputBuffer, numFrames);
+    mCurrentOutputFrames += framesRead;
+    if (mIncoming == nullptr) {
+        return framesRead;
+    }
+
+    const float *incomingBuffer = mIncomingBuffer.data();
+    const int32_t incomingFramesRead = pullSection(mIncoming, mIncomingBuffer.data(), numFrames);
+    mIncomingOutputFrames += incomingFramesRead;
+    framesRead = std::max(framesRead, incomingFramesRead);
+    const float scaler = 1.0f / mFadeLength;
+    for (int32_t i = 0; i < framesRead; i++) {
+        if (mFadePosition < mFadeLength) {
+            const float gain = mFadePosition++ * scaler;
+            for (int32_t ch = 0; ch < channelCount; ch++) {
+                *outputBuffer += gain * (*incomingBuffer++ - *outputBuffer);
+                outputBuffer++;
+            }
+        } else {
+            memcpy(outputBuffer, incomingBuffer, channelCount * sizeof(float));
+            outputBuffer += channelCount;
+            incomingBuffer += channelCount;
+        }
+    }
+    if (mFadePosition >= mFadeLength) {
+        retire(mCurrent);
+        mCurrent = mIncoming;
+        mCurrentStartFrame = mIncomingStartFrame;
+        mCurrentOutputFrames = mIncomingOutputFrames;
+        mIncoming = nullptr;
+        mSwapCount.fetch_add(1, std::memory_order_release);
+    }
+    return framesRead;
+}
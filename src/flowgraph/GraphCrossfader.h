@@ -0,0 +1,206 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOWGRAPH_GRAPH_CROSSFADER_H
+#define FLOWGRAPH_GRAPH_CROSSFADER_H
+
+#include <atomic>
+#include <memory>
+#include <sys/types.h>
+#include <unistd.h>
+#include <vector>
+
+#include "FlowGraphNode.h"
+#include "SinkFloat.h"
+
+namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
+
+/**
+ * Run a part of a graph, called a Section, that can be replaced while the graph is running.
+ *
+ * The connections of a running graph must not be changed from another thread.
+ * So a control thread builds a complete new Section and publishes it with publish().
+ * The audio thread picks it up with an atomic exchange at the start of the next block,
+ * runs the old and new sections side by side, and crossfades from one to the other.
+ * When the crossfade is done the old section is put on a retired list and deleted by
+ * the next call to reclaim() or publish(), so nothing is allocated or freed on the
+ * audio thread. A new section is picked up even if older ones have not been reclaimed.
+ *
+ * Both sections read the same input, which is pulled once into a small history buffer.
+ * A new section is first run over some of the input that the current section has already
+ * read, so that its filters are full, and the output for that is discarded.
+ * The sections may have different latencies or sample rate converters.
+ * The crossfade is linear because the two outputs are usually highly correlated.
+ */
+class GraphCrossfader : public FlowGraphNode {
+public:
+    static constexpr int32_t kDefaultCrossfadeFrames = 256;
+
+    /**
+     * The input end of a Section. It reads the frames that were pulled by the crossfader.
+     */
+    class SectionSource : public FlowGraphSource {
+    public:
+        explicit SectionSource(int32_t channelCount)
+                : FlowGraphSource(channelCount) {}
+
+        int32_t onProcess(int32_t numFrames) override;
+
+        const char *getName() override {
+            return "SectionSource";
+        }
+
+    private:
+        friend class GraphCrossfader;
+
+        GraphCrossfader *mCrossfader = nullptr;
+        int64_t          mPosition = 0; // next input frame to read
+    };
+
+    /**
+     * A part of a graph that can be replaced.
+     * Subclass this, own the nodes in the subclass,
+     * and connect them from source.output to sink.input.
+     */
+    class Section {
+    public:
+        Section(int32_t inputChannelCount, int32_t outputChannelCount)
+                : source(inputChannelCount)
+                , sink(outputChannelCount) {}
+
+        virtual ~Section() = default;
+
+        /**
+         * Set how much earlier input is run through this section before it is faded in.
+         * The ratio of the two values must match the sample rate ratio of the section.
+         * It is also used to start the section at the same time as the current one.
+         * Without a pre-roll the section must have one output frame per input frame.
+         * The pre-roll is limited by the input history of the crossfader,
+         * which is a few blocks.
+         *
+         * @param inputFrames number of input frames to run before the crossfade
+         * @param outputFrames number of output frames to discard for that input
+         */
+        void setPreRoll(int32_t inputFrames, int32_t outputFrames) {
+            mPreRollInputFrames = inputFrames;
+            mPreRollOutputFrames = outputFrames;
+        }
+
+        SectionSource source;
+        SinkFloat     sink;
+
+    private:
+        friend class GraphCrossfader;
+
+        int32_t mPreRollInputFrames = 0;
+        int32_t mPreRollOutputFrames = 0;
+        Section *mNextRetired = nullptr; // link in the retired list
+    };
+
+    GraphCrossfader(int32_t inputChannelCount, int32_t outputChannelCount);
+
+    ~GraphCrossfader() override;
+
+    int32_t onProcess(int32_t numFrames) override;
+
+    void setFramesPerBuffer(int32_t framesPerBuffer) override;
+
+    const char *getName() override {
+        return "GraphCrossfader";
+    }
+
+    /**
+     * Replace the running section. The first section is used without a crossfade.
+     * A later one is crossfaded in when the audio thread starts its next block,
+     * after any crossfade that is already in progress.
+     * If a section was published but not yet picked up then it is replaced.
+     *
+     * This allocates memory so call it from a control thread, after the block size is set.
+     * Only one thread may call publish() and reclaim().
+     *
+     * @param section with the same channel counts as this node
+     * @return false if the channel counts do not match
+     */
+    bool publish(std::unique_ptr<Section> section);
+
+    /**
+     * Delete the sections that were faded out, if any.
+     * Call this from a control thread. It is also called by publish().
+     */
+    void reclaim();
+
+    /**
+     * Set the length of the following crossfades. This may be called from any thread.
+     *
+     * @param numFrames length in output frames
+     */
+    void setCrossfadeLengthInFrames(int32_t numFrames) {
+        mCrossfadeFrames.store(numFrames);
+    }
+
+    int32_t getCrossfadeLengthInFrames() const {
+        return mCrossfadeFrames.load();
+    }
+
+    /**
+     * @return number of sections that have completely replaced the previous one
+     */
+    int64_t getSwapCount() const {
+        return mSwapCount.load(std::memory_order_acquire);
+    }
+
+    FlowGraphPortFloatInput  input;
+    FlowGraphPortFloatOutput output;
+
+private:
+    // The sections may drift apart by a few blocks of input.
+    static constexpr int32_t kHistoryBlocks = 4;
+
+    // Called by a SectionSource on the audio thread.
+    int32_t readInput(SectionSource &source, float *buffer, int32_t numFrames);
+    bool pullInput();
+    int32_t pullSection(Section *section, float *buffer, int32_t numFrames);
+    void startCrossfade(Section *next);
+    // Push a section on the retired list. Called by the audio thread.
+    void retire(Section *section);
+
+    // Input frame that lines up with the next output frame of a section.
+    static int64_t getInputPosition(const Section &section, int64_t startFrame,
+                                    int64_t outputFrames);
+
+    std::atomic<Section *> mPending{nullptr}; // published but not picked up
+    std::atomic<Section *> mRetired{nullptr}; // list of sections faded out but not deleted
+    Section               *mCurrent = nullptr; // only used by the audio thread after publish
+    Section               *mIncoming = nullptr; // only used by the audio thread
+    std::atomic<int32_t>   mCrossfadeFrames{kDefaultCrossfadeFrames};
+    int32_t                mFadeLength = 0;
+    int32_t                mFadePosition = 0;
+    int64_t                mCurrentStartFrame = 0; // input frame at the first output frame
+    int64_t                mCurrentOutputFrames = 0;
+    int64_t                mIncomingStartFrame = 0;
+    int64_t                mIncomingOutputFrames = 0;
+    std::atomic<int64_t>   mSwapCount{0};
+
+    std::vector<float>     mHistory; // input frames from mHistoryStart to mHistoryEnd
+    int64_t                mHistoryStart = 0;
+    int64_t                mHistoryEnd = 0;
+    int64_t                mInputCallCount = kInitialCallCount;
+    std::vector<float>     mIncomingBuffer; // output of mIncoming during a crossfade
+};
+
+} /* namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph */
+
+#endif //FLOWGRAPH_GRAPH_CROSSFADER_H
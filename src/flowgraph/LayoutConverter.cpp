@@ -0,0 +1,231 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <unistd.h>
+
+#include "LayoutConverter.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define LAYOUT_CONVERTER_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define LAYOUT_CONVERTER_NEON 1
+#endif
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+
+namespace {
+
+/***************************************************************************/
+// Blocks of a transpose. Row r of the source becomes column r of the destination.
+// The strides are the distance between rows.
+
+#if LAYOUT_CONVERTER_SSE2
+
+inline void transpose4x4(const float *source, int32_t sourceStride,
+                         float *destination, int32_t destinationStride) {
+    __m128 row0 = _mm_loadu_ps(source);
+    __m128 row1 = _mm_loadu_ps(source + sourceStride);
+    __m128 row2 = _mm_loadu_ps(source + 2 * sourceStride);
+    __m128 row3 = _mm_loadu_ps(source + 3 * sourceStride);
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+    _mm_storeu_ps(destination, row0);
+    _mm_storeu_ps(destination + destinationStride, row1);
+    _mm_storeu_ps(destination + 2 * destinationStride, row2);
+    _mm_storeu_ps(destination + 3 * destinationStride, row3);
+}
+
+// Four rows of two samples become two rows of four.
+inline void transpose4x2(const float *source, int32_t sourceStride,
+                         float *destination, int32_t destinationStride) {
+    __m128 rows01 = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) source);
+    rows01 = _mm_loadh_pi(rows01, (const __m64 *) (source + sourceStride));
+    __m128 rows23 = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) (source + 2 * sourceStride));
+    rows23 = _mm_loadh_pi(rows23, (const __m64 *) (source + 3 * sourceStride));
+    _mm_storeu_ps(destination, _mm_shuffle_ps(rows01, rows23, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(destination + destinationStride,
+                  _mm_shuffle_ps(rows01, rows23, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+// Two rows of four samples become four rows of two.
+inline void transpose2x4(const float *source, int32_t sourceStride,
+                         float *destination, int32_t destinationStride) {
+    __m128 row0 = _mm_loadu_ps(source);
+    __m128 row1 = _mm_loadu_ps(source + sourceStride);
+    __m128 low = _mm_unpacklo_ps(row0, row1);
+    __m128 high = _mm_unpackhi_ps(row0, row1);
+    _mm_storel_pi((__m64 *) destination, low);
+    _mm_storeh_pi((__m64 *) (destination + destinationStride), low);
+    _mm_storel_pi((__m64 *) (destination + 2 * destinationStride), high);
+    _mm_storeh_pi((__m64 *) (destination + 3 * destinationStride), high);
+}
+
+#elif LAYOUT_CONVERTER_NEON
+
+inline void transpose4x4(const float *source, int32_t sourceStride,
+                         float *destination, int32_t destinationStride) {
+    float32x4x2_t rows01 = vtrnq_f32(vld1q_f32(source), vld1q_f32(source + sourceStride));
+    float32x4x2_t rows23 = vtrnq_f32(vld1q_f32(source + 2 * sourceStride),
+                                     vld1q_f32(source + 3 * sourceStride));
+    vst1q_f32(destination, vcombine_f32(vget_low_f32(rows01.val[0]),
+                                        vget_low_f32(rows23.val[0])));
+    vst1q_f32(destination + destinationStride, vcombine_f32(vget_low_f32(rows01.val[1]),
+                                                            vget_low_f32(rows23.val[1])));
+    vst1q_f32(destination + 2 * destinationStride, vcombine_f32(vget_high_f32(rows01.val[0]),
+                                                                vget_high_f32(rows23.val[0])));
+    vst1q_f32(destination + 3 * destinationStride, vcombine_f32(vget_high_f32(rows01.val[1]),
+                                                                vget_high_f32(rows23.val[1])));
+}
+
+// Four rows of two samples become two rows of four.
+inline void transpose4x2(const float *source, int32_t sourceStride,
+                         float *destination, int32_t destinationStride) {
+    float32x4_t rows01 = vcombine_f32(vld1_f32(source), vld1_f32(source + sourceStride));
+    float32x4_t rows23 = vcombine_f32(vld1_f32(source + 2 * sourceStride),
+                                      vld1_f32(source + 3 * sourceStride));
+    float32x4x2_t columns = vuzpq_f32(rows01, rows23);
+    vst1q_f32(destination, columns.val[0]);
+    vst1q_f32(destination + destinationStride, columns.val[1]);
+}
+
+// Two rows of four samples become four rows of two.
+inline void transpose2x4(const float *source, int32_t sourceStride,
+                         float *destination, int32_t destinationStride) {
+    float32x4x2_t zipped = vzipq_f32(vld1q_f32(source), vld1q_f32(source + sourceStride));
+    vst1_f32(destination, vget_low_f32(zipped.val[0]));
+    vst1_f32(destination + destinationStride, vget_high_f32(zipped.val[0]));
+    vst1_f32(destination + 2 * destinationStride, vget_low_f32(zipped.val[1]));
+    vst1_f32(destination + 3 * destinationStride, vget_high_f32(zipped.val[1]));
+}
+
+#endif
+
+/**
+ * Transpose a matrix of numRows by numColumns samples.
+ * Interleaving and deinterleaving are both transposes, with frames or channels as the rows.
+ */
+void transpose(const float *source, int32_t sourceStride,
+               float *destination, int32_t destinationStride,
+               int32_t numRows, int32_t numColumns) {
+    int32_t row = 0;
+#if LAYOUT_CONVERTER_SSE2 || LAYOUT_CONVERTER_NEON
+    for (; row + 4 <= numRows; row += 4) {
+        int32_t column = 0;
+        for (; column + 4 <= numColumns; column += 4) {
+            transpose4x4(&source[row * sourceStride + column], sourceStride,
+                         &destination[column * destinationStride + row], destinationStride);
+        }
+        for (; column + 2 <= numColumns; column += 2) {
+            transpose4x2(&source[row * sourceStride + column], sourceStride,
+                         &destination[column * destinationStride + row], destinationStride);
+        }
+        for (; column < numColumns; column++) {
+            for (int32_t i = 0; i < 4; i++) {
+                destination[column * destinationStride + row + i] =
+                        source[(row + i) * sourceStride + column];
+            }
+        }
+    }
+    for (; row + 2 <= numRows; row += 2) {
+        int32_t column = 0;
+        for (; column + 4 <= numColumns; column += 4) {
+            transpose2x4(&source[row * sourceStride + column], sourceStride,
+                         &destination[column * destinationStride + row], destinationStride);
+        }
+        for (; column < numColumns; column++) {
+            destination[column * destinationStride + row] = source[row * sourceStride + column];
+            destination[column * destinationStride + row + 1] =
+                    source[(row + 1) * sourceStride + column];
+        }
+    }
+#endif
+    for (; row < numRows; row++) {
+        const float *sourceRow = &source[row * sourceStride];
+        for (int32_t column = 0; column < numColumns; column++) {
+            destination[column * destinationStride + row] = sourceRow[column];
+        }
+    }
+}
+
+} // namespace
+
+/***************************************************************************/
+LayoutConverter::LayoutConverter(int32_t channelCount,
+                                 FlowGraphPort::Layout inputLayout,
+                                 FlowGraphPort::Layout outputLayout)
+        : FlowGraphFilter(channelCount) {
+    input.setLayout(inputLayout);
+    output.setLayout(outputLayout);
+}
+
+int32_t LayoutConverter::onProcess(int32_t numFrames) {
+    const float *inputBuffer = input.getBuffer();
+    float *outputBuffer = output.getBuffer();
+    const int32_t channelCount = output.getSamplesPerFrame();
+
+    if (input.isPlanar() && !output.isPlanar()) {
+        interleave(inputBuffer, input.getChannelStride(), outputBuffer, channelCount, numFrames);
+    } else if (!input.isPlanar() && output.isPlanar()) {
+        deinterleave(inputBuffer, outputBuffer, channelCount, numFrames,
+                     output.getChannelStride());
+    } else if (input.isPlanar()) {
+        for (int32_t channel = 0; channel < channelCount; channel++) {
+            memcpy(&outputBuffer[channel * output.getChannelStride()],
+                   &inputBuffer[channel * input.getChannelStride()],
+                   numFrames * sizeof(float));
+        }
+    } else {
+        memcpy(outputBuffer, inputBuffer, numFrames * channelCount * sizeof(float));
+    }
+    return numFrames;
+}
+
+std::unique_ptr<LayoutConverter> LayoutConverter::connect(FlowGraphPortFloatOutput &output,
+                                                          FlowGraphPortFloatInput &input) {
+    std::unique_ptr<LayoutConverter> converter;
+    if (output.isPlanar() == input.isPlanar()) {
+        output.connect(&input);
+    } else {
+        converter = std::make_unique<LayoutConverter>(output.getSamplesPerFrame(),
+                                                      output.getLayout(), input.getLayout());
+        output.connect(&converter->input);
+        converter->output.connect(&input);
+    }
+    return converter;
+}
+
+void LayoutConverter::deinterleave(const float *source, float *destination,
+                                   int32_t channelCount, int32_t numFrames,
+                                   int32_t channelStride) {
+    transpose(source, channelCount, destination, channelStride, numFrames, channelCount);
+}
+
+void LayoutConverter::interleave(const float *source, int32_t channelStride,
+                                 float *destination, int32_t channelCount, int32_t numFrames) {
+    transpose(source, channelStride, destination, channelCount, channelCount, numFrames);
+}
+
+const char *LayoutConverter::getImplementationName() {
+#if LAYOUT_CONVERTER_SSE2
+    return "SSE2";
+#elif LAYOUT_CONVERTER_NEON
+    return "NEON";
+#else
+    return "Scalar";
+#endif
+}
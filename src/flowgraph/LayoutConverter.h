@@ -0,0 +1,95 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOWGRAPH_LAYOUT_CONVERTER_H
+#define FLOWGRAPH_LAYOUT_CONVERTER_H
+
+#include <memory>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "FlowGraphNode.h"
+
+namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
+
+/**
+ * Convert between the interleaved and the planar layouts.
+ *
+ * Nodes that process each channel separately can run faster on planar buffers
+ * because they read each channel contiguously. Place one of these at each boundary
+ * between the planar part of a graph and the interleaved part.
+ * See FlowGraphPort::Layout.
+ */
+class LayoutConverter : public FlowGraphFilter {
+public:
+    LayoutConverter(int32_t channelCount,
+                    FlowGraphPort::Layout inputLayout,
+                    FlowGraphPort::Layout outputLayout);
+
+    virtual ~LayoutConverter() = default;
+
+    int32_t onProcess(int32_t numFrames) override;
+
+    bool isPlanarSupported() const override {
+        return true;
+    }
+
+    const char *getName() override {
+        return "LayoutConverter";
+    }
+
+    /**
+     * Connect an output port to an input port.
+     * If the layouts are different then a LayoutConverter is connected between them.
+     *
+     * @return the converter, which must live as long as the graph, or nullptr if not needed
+     */
+    static std::unique_ptr<LayoutConverter> connect(FlowGraphPortFloatOutput &output,
+                                                    FlowGraphPortFloatInput &input);
+
+    /**
+     * Convert interleaved frames to planar.
+     *
+     * @param source interleaved frames
+     * @param destination first sample of channel 0
+     * @param channelCount samples per frame
+     * @param numFrames number of frames to convert
+     * @param channelStride distance between the channels in the destination
+     */
+    static void deinterleave(const float *source, float *destination,
+                             int32_t channelCount, int32_t numFrames, int32_t channelStride);
+
+    /**
+     * Convert planar frames to interleaved.
+     *
+     * @param source first sample of channel 0
+     * @param channelStride distance between the channels in the source
+     * @param destination interleaved frames
+     * @param channelCount samples per frame
+     * @param numFrames number of frames to convert
+     */
+    static void interleave(const float *source, int32_t channelStride, float *destination,
+                           int32_t channelCount, int32_t numFrames);
+
+    /**
+     * @return name of the SIMD instructions used by the kernels, or "Scalar"
+     */
+    static const char *getImplementationName();
+};
+
+} /* namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph */
+
+#endif //FLOWGRAPH_LAYOUT_CONVERTER_H
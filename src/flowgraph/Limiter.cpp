@@ -18,24 +18,144 @@
 #include <math.h>
 #include <unistd.h>
 #include "FlowGraphNode.h"
+#include "FusedStage.h"
 #include "Limiter.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define LIMITER_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define LIMITER_NEON 1
+#endif
+
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
 
 Limiter::Limiter(int32_t channelCount)
-        : FlowGraphFilter(channelCount) {
+        : FlowGraphFilter(channelCount)
+        , mLastValidOutputs(channelCount, 0.0f) {
 }
 
 int32_t Limiter::onProcess(int32_t numFrames) {
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
-
-    int32_t numSamples = numFrames * output.getSamplesPerFrame();
+    const int32_t channelCount = output.getSamplesPerFrame();
+    if (!input.isPlanar()) {
+        limitInterleaved(input.getBuffer(), output.getBuffer(), numFrames, channelCount,
+                         mLastValidOutputs.data());
+        return numFrames;
+    }
 
-    // Cache the last valid output to reduce memory read/write
-    float lastValidOutput = mLastValidOutput;
+    for (int32_t channel = 0; channel < channelCount; channel++) {
+        mLastValidOutputs[channel] = limit(
+                input.getBuffer() + channel * input.getChannelStride(),
+                output.getBuffer() + channel * output.getChannelStride(),
+                numFrames, mLastValidOutputs[channel]);
+    }
+    return numFrames;
+}
 
+// limit() holds a NaN across adjacent samples, which are different channels here.
+// The valid outputs do not depend on the hold so only the NaN samples are fixed afterwards.
+void Limiter::limitInterleaved(const float *inputBuffer, float *outputBuffer,
+                               int32_t numFrames, int32_t channelCount,
+                               float *lastValidOutputs) {
+    const int32_t numSamples = numFrames * channelCount;
+    if (channelCount == 1) {
+        lastValidOutputs[0] = limit(inputBuffer, outputBuffer, numSamples, lastValidOutputs[0]);
+        return;
+    }
+    if (numFrames <= 0) {
+        return;
+    }
+    limit(inputBuffer, outputBuffer, numSamples, 0.0f);
     for (int32_t i = 0; i < numSamples; i++) {
+        if (isnan(inputBuffer[i])) {
+            outputBuffer[i] = (i < channelCount) ? lastValidOutputs[i]
+                                                 : outputBuffer[i - channelCount];
+        }
+    }
+    std::copy(&outputBuffer[numSamples - channelCount], &outputBuffer[numSamples],
+              lastValidOutputs);
+}
+
+// The vector code computes every branch of processFloat() and selects the result with masks.
+// The arithmetic is the same so the output is identical to processFloat().
+// A NaN is replaced by the output before it, with a shift and select for each power of two.
+float Limiter::limit(const float *inputBuffer, float *outputBuffer, int32_t numSamples,
+                     float lastValidOutput) {
+    int32_t i = 0;
+#if LIMITER_SSE2
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 knee = _mm_set1_ps(kXWhenYis3Decibels);
+    const __m128 splineA = _mm_set1_ps(kPolynomialSplineA);
+    const __m128 splineB = _mm_set1_ps(kPolynomialSplineB);
+    const __m128 splineC = _mm_set1_ps(kPolynomialSplineC);
+    const __m128 maxOutput = _mm_set1_ps(static_cast<float>(M_SQRT2));
+    for (; i + 4 <= numSamples; i += 4) {
+        const __m128 in = _mm_loadu_ps(&inputBuffer[i]);
+        const __m128 inAbs = _mm_andnot_ps(signMask, in);
+        const __m128 spline = _mm_add_ps(
+                _mm_mul_ps(_mm_add_ps(_mm_mul_ps(splineA, inAbs), splineB), inAbs), splineC);
+        const __m128 isSpline = _mm_cmplt_ps(inAbs, knee);
+        __m128 out = _mm_or_ps(_mm_and_ps(isSpline, spline), _mm_andnot_ps(isSpline, maxOutput));
+        out = _mm_or_ps(out, _mm_and_ps(signMask, in));
+        const __m128 isLinear = _mm_cmple_ps(inAbs, one);
+        out = _mm_or_ps(_mm_and_ps(isLinear, in), _mm_andnot_ps(isLinear, out));
+
+        __m128 isNan = _mm_cmpunord_ps(in, in);
+        if (_mm_movemask_ps(isNan) != 0) {
+            const __m128 last = _mm_set1_ps(lastValidOutput);
+            // Shift in one sample: last, out0, out1, out2
+            __m128 shifted = _mm_move_ss(
+                    _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(out), 4)), last);
+            out = _mm_or_ps(_mm_and_ps(isNan, shifted), _mm_andnot_ps(isNan, out));
+            isNan = _mm_and_ps(isNan, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(isNan), 4)));
+            // Shift in two samples: last, last, out0, out1
+            shifted = _mm_movelh_ps(last, out);
+            out = _mm_or_ps(_mm_and_ps(isNan, shifted), _mm_andnot_ps(isNan, out));
+            // Only a NaN with NaNs in all the samples before it is left.
+            isNan = _mm_and_ps(isNan, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(isNan), 8)));
+            out = _mm_or_ps(_mm_and_ps(isNan, last), _mm_andnot_ps(isNan, out));
+        }
+        _mm_storeu_ps(&outputBuffer[i], out);
+        lastValidOutput = _mm_cvtss_f32(_mm_shuffle_ps(out, out, _MM_SHUFFLE(3, 3, 3, 3)));
+    }
+#elif LIMITER_NEON
+    const uint32x4_t signMask = vdupq_n_u32(0x80000000u);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t knee = vdupq_n_f32(kXWhenYis3Decibels);
+    const float32x4_t splineA = vdupq_n_f32(kPolynomialSplineA);
+    const float32x4_t splineB = vdupq_n_f32(kPolynomialSplineB);
+    const float32x4_t splineC = vdupq_n_f32(kPolynomialSplineC);
+    const float32x4_t maxOutput = vdupq_n_f32(static_cast<float>(M_SQRT2));
+    const uint32x4_t noLanes = vdupq_n_u32(0);
+    for (; i + 4 <= numSamples; i += 4) {
+        const float32x4_t in = vld1q_f32(&inputBuffer[i]);
+        const float32x4_t inAbs = vabsq_f32(in);
+        // Clang fuses the multiply and add of the scalar spline on arm64, so fuse them here too.
+        const float32x4_t spline = vfmaq_f32(splineC, vfmaq_f32(splineB, splineA, inAbs), inAbs);
+        float32x4_t out = vbslq_f32(vcltq_f32(inAbs, knee), spline, maxOutput);
+        out = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(out),
+                                              vandq_u32(signMask, vreinterpretq_u32_f32(in))));
+        out = vbslq_f32(vcleq_f32(inAbs, one), in, out);
+
+        uint32x4_t isNan = vmvnq_u32(vceqq_f32(in, in));
+        if (vmaxvq_u32(isNan) != 0) {
+            const float32x4_t last = vdupq_n_f32(lastValidOutput);
+            out = vbslq_f32(isNan, vextq_f32(last, out, 3), out);
+            isNan = vandq_u32(isNan, vextq_u32(noLanes, isNan, 3));
+            out = vbslq_f32(isNan, vextq_f32(last, out, 2), out);
+            // Only a NaN with NaNs in all the samples before it is left.
+            isNan = vandq_u32(isNan, vextq_u32(noLanes, isNan, 2));
+            out = vbslq_f32(isNan, last, out);
+        }
+        vst1q_f32(&outputBuffer[i], out);
+        lastValidOutput = vgetq_lane_f32(out, 3);
+    }
+#endif
+    inputBuffer += i;
+    outputBuffer += i;
+    for (; i < numSamples; i++) {
         // Use the previous output if the input is NaN
         if (!isnan(*inputBuffer)) {
             lastValidOutput = processFloat(*inputBuffer);
@@ -43,9 +163,7 @@ int32_t Limiter::onProcess(int32_t numFrames) {
         inputBuffer++;
         *outputBuffer++ = lastValidOutput;
     }
-    mLastValidOutput = lastValidOutput;
-
-    return numFrames;
+    return lastValidOutput;
 }
 
 float Limiter::processFloat(float in)
@@ -65,3 +183,23 @@ float Limiter::processFloat(float in)
     }
     return out;
 }
+
+const char *Limiter::getImplementationName() {
+#if LIMITER_SSE2
+    return "SSE2";
+#elif LIMITER_NEON
+    return "NEON";
+#else
+    return "Scalar";
+#endif
+}
+
+bool Limiter::describeFusedStage(FusedStage *stage) {
+    if (input.isPlanar()) {
+        return false; // SinkFused reads interleaved frames
+    }
+    stage->type = FusedStage::Type::Limit;
+    stage->inputChannelCount = input.getSamplesPerFrame();
+    stage->outputChannelCount = output.getSamplesPerFrame();
+    return true;
+}
@@ -20,6 +20,7 @@
 #include <atomic>
 #include <unistd.h>
 #include <sys/types.h>
+#include <vector>
 
 #include "FlowGraphNode.h"
 
@@ -31,18 +32,16 @@ public:
 
     int32_t onProcess(int32_t numFrames) override;
 
+    bool describeFusedStage(FusedStage *stage) override;
+
+    bool isPlanarSupported() const override {
+        return true;
+    }
+
     const char *getName() override {
         return "Limiter";
     }
 
-private:
-    // These numbers are based on a polynomial spline for a quadratic solution Ax^2 + Bx + C
-    // The range is up to 3 dB, (10^(3/20)), to match AudioTrack for float data.
-    static constexpr float kPolynomialSplineA = -0.6035533905; // -(1+sqrt(2))/4
-    static constexpr float kPolynomialSplineB = 2.2071067811; // (3+sqrt(2))/2
-    static constexpr float kPolynomialSplineC = -0.6035533905; // -(1+sqrt(2))/4
-    static constexpr float kXWhenYis3Decibels = 1.8284271247; // -1+2sqrt(2)
-
     /**
      * Process an input based on the following:
      * If between -1 and 1, return the input value.
@@ -53,10 +52,45 @@ private:
      * The derivative of the spline is 1 at 1 and 0 at kXWhenYis3Decibels.
      * This way, the graph is both continuous and differentiable.
      */
-    float processFloat(float in);
+    static float processFloat(float in);
+
+    /**
+     * Apply processFloat() to a block of samples with SIMD, if available.
+     * A NaN input is replaced by the previous output.
+     *
+     * @param lastValidOutput output used if the first input is NaN
+     * @return the last valid output, which replaces any NaN inputs
+     */
+    static float limit(const float *inputBuffer, float *outputBuffer, int32_t numSamples,
+                       float lastValidOutput);
+
+    /**
+     * Apply limit() to interleaved frames.
+     * A NaN input is replaced by the previous output of the same channel.
+     *
+     * @param lastValidOutputs one per channel, used if the first input of the channel is NaN,
+     *                         then updated with the last valid output of each channel
+     */
+    static void limitInterleaved(const float *inputBuffer, float *outputBuffer,
+                                 int32_t numFrames, int32_t channelCount,
+                                 float *lastValidOutputs);
+
+    /**
+     * @return name of the instruction set used by limit()
+     */
+    static const char *getImplementationName();
+
+private:
+
+    // These numbers are based on a polynomial spline for a quadratic solution Ax^2 + Bx + C
+    // The range is up to 3 dB, (10^(3/20)), to match AudioTrack for float data.
+    static constexpr float kPolynomialSplineA = -0.6035533905; // -(1+sqrt(2))/4
+    static constexpr float kPolynomialSplineB = 2.2071067811; // (3+sqrt(2))/2
+    static constexpr float kPolynomialSplineC = -0.6035533905; // -(1+sqrt(2))/4
+    static constexpr float kXWhenYis3Decibels = 1.8284271247; // -1+2sqrt(2)
 
-    // Use the previous valid output for NaN inputs
-    float mLastValidOutput = 0.0f;
+    // Use the previous valid output of the same channel for NaN inputs
+    std::vector<float> mLastValidOutputs;
 };
 
 } /* namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph */
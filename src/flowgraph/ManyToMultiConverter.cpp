@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <cstring>
 #include <unistd.h>
 
 #include "ManyToMultiConverter.h"
@@ -31,6 +32,14 @@ ManyToMultiConverter::ManyToMultiConverter(int32_t channelCount)
 int32_t ManyToMultiConverter::onProcess(int32_t numFrames) {
     int32_t channelCount = output.getSamplesPerFrame();
 
+    if (output.isPlanar()) {
+        for (int ch = 0; ch < channelCount; ch++) {
+            memcpy(output.getBuffer() + ch * output.getChannelStride(), inputs[ch]->getBuffer(),
+                   numFrames * sizeof(float));
+        }
+        return numFrames;
+    }
+
     for (int ch = 0; ch < channelCount; ch++) {
         const float *inputBuffer = inputs[ch]->getBuffer();
         float *outputBuffer = output.getBuffer() + ch;
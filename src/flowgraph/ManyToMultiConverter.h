@@ -36,6 +36,10 @@ public:
 
     int32_t onProcess(int numFrames) override;
 
+    bool isPlanarSupported() const override {
+        return true;
+    }
+
     void setEnabled(bool /*enabled*/) {}
 
     std::vector<std::unique_ptr<flowgraph::FlowGraphPortFloatInput>> inputs;
@@ -31,13 +31,13 @@ int32_t MonoBlend::onProcess(int32_t numFrames) {
     const float *inputBuffer = input.getBuffer();
     float *outputBuffer = output.getBuffer();
 
-    for (size_t i = 0; i < numFrames; ++i) {
+    for (int32_t i = 0; i < numFrames; ++i) {
         float accum = 0;
-        for (size_t j = 0; j < channelCount; ++j) {
+        for (int32_t j = 0; j < channelCount; ++j) {
             accum += *inputBuffer++;
         }
         accum *= mInvChannelCount;
-        for (size_t j = 0; j < channelCount; ++j) {
+        for (int32_t j = 0; j < channelCount; ++j) {
             *outputBuffer++ = accum;
         }
     }
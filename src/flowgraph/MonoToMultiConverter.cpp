@@ -16,6 +16,7 @@
 
 #include <unistd.h>
 #include "FlowGraphNode.h"
+#include "FusedStage.h"
 #include "MonoToMultiConverter.h"
 
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
@@ -39,3 +40,11 @@ int32_t MonoToMultiConverter::onProcess(int32_t numFrames) {
     return numFrames;
 }
 
+
+bool MonoToMultiConverter::describeFusedStage(FusedStage *stage) {
+    stage->type = FusedStage::Type::ChannelMap;
+    stage->inputChannelCount = 1;
+    stage->outputChannelCount = output.getSamplesPerFrame();
+    stage->channelMap.assign(stage->outputChannelCount, 0);
+    return true;
+}
@@ -36,6 +36,8 @@ public:
 
     int32_t onProcess(int32_t numFrames) override;
 
+    bool describeFusedStage(FusedStage *stage) override;
+
     const char *getName() override {
         return "MonoToMultiConverter";
     }
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <cstring>
 #include <unistd.h>
 #include "FlowGraphNode.h"
 #include "MultiToManyConverter.h"
@@ -33,6 +34,15 @@ MultiToManyConverter::~MultiToManyConverter() = default;
 int32_t MultiToManyConverter::onProcess(int32_t numFrames) {
     int32_t channelCount = input.getSamplesPerFrame();
 
+    if (input.isPlanar()) {
+        // Each channel is already contiguous.
+        for (int ch = 0; ch < channelCount; ch++) {
+            memcpy(outputs[ch]->getBuffer(), input.getBuffer() + ch * input.getChannelStride(),
+                   numFrames * sizeof(float));
+        }
+        return numFrames;
+    }
+
     for (int ch = 0; ch < channelCount; ch++) {
         const float *inputBuffer = input.getBuffer() + ch;
         float *outputBuffer = outputs[ch]->getBuffer();
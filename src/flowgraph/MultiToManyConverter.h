@@ -36,6 +36,10 @@ namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
 
         int32_t onProcess(int32_t numFrames) override;
 
+        bool isPlanarSupported() const override {
+            return true;
+        }
+
         const char *getName() override {
             return "MultiToManyConverter";
         }
@@ -16,6 +16,7 @@
 
 #include <unistd.h>
 #include "FlowGraphNode.h"
+#include "FusedStage.h"
 #include "MultiToMonoConverter.h"
 
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
@@ -39,3 +40,11 @@ int32_t MultiToMonoConverter::onProcess(int32_t numFrames) {
     return numFrames;
 }
 
+
+bool MultiToMonoConverter::describeFusedStage(FusedStage *stage) {
+    stage->type = FusedStage::Type::ChannelMap;
+    stage->inputChannelCount = input.getSamplesPerFrame();
+    stage->outputChannelCount = 1;
+    stage->channelMap.assign(1, 0); // first channel
+    return true;
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "ParameterAutomation.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define PARAMETER_AUTOMATION_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define PARAMETER_AUTOMATION_NEON 1
+#endif
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+
+namespace {
+
+// values[i] = first + slope * i
+// The index is converted to float so the error does not build up over the block.
+void fillLinear(float *values, int32_t numFrames, float first, float slope) {
+    int32_t i = 0;
+#if PARAMETER_AUTOMATION_SSE2
+    const __m128 base = _mm_set1_ps(first);
+    const __m128 step = _mm_set1_ps(slope);
+    const __m128 four = _mm_set1_ps(4.0f);
+    __m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    for (; i + 4 <= numFrames; i += 4) {
+        _mm_storeu_ps(&values[i], _mm_add_ps(base, _mm_mul_ps(step, index)));
+        index = _mm_add_ps(index, four);
+    }
+#elif PARAMETER_AUTOMATION_NEON
+    const float32x4_t base = vdupq_n_f32(first);
+    const float32x4_t step = vdupq_n_f32(slope);
+    const float32x4_t four = vdupq_n_f32(4.0f);
+    const float lanes[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    float32x4_t index = vld1q_f32(lanes);
+    for (; i + 4 <= numFrames; i += 4) {
+        vst1q_f32(&values[i], vaddq_f32(base, vmulq_f32(step, index)));
+        index = vaddq_f32(index, four);
+    }
+#endif
+    for (; i < numFrames; i++) {
+        values[i] = first + slope * static_cast<float>(i);
+    }
+}
+
+// values[i] = first * ratio^i
+void fillExponential(float *values, int32_t numFrames, float first, float ratio) {
+    int32_t i = 0;
+    float value = first;
+#if PARAMETER_AUTOMATION_SSE2 || PARAMETER_AUTOMATION_NEON
+    if (numFrames >= 4) {
+        const float ratio2 = ratio * ratio;
+        const float lanes[4] = {first, first * ratio, first * ratio2, first * ratio2 * ratio};
+        const float ratio4 = ratio2 * ratio2;
+#if PARAMETER_AUTOMATION_SSE2
+        const __m128 step = _mm_set1_ps(ratio4);
+        __m128 current = _mm_loadu_ps(lanes);
+        for (; i + 4 <= numFrames; i += 4) {
+            _mm_storeu_ps(&values[i], current);
+            current = _mm_mul_ps(current, step);
+        }
+#else
+        const float32x4_t step = vdupq_n_f32(ratio4);
+        float32x4_t current = vld1q_f32(lanes);
+        for (; i + 4 <= numFrames; i += 4) {
+            vst1q_f32(&values[i], current);
+            current = vmulq_f32(current, step);
+        }
+#endif
+        value = values[i - 1] * ratio;
+    }
+#endif
+    for (; i < numFrames; i++) {
+        values[i] = value;
+        value *= ratio;
+    }
+}
+
+} // namespace
+
+ParameterAutomation::ParameterAutomation(float initialValue, int32_t capacity)
+        : mCapacity(static_cast<uint32_t>(capacity))
+        , mEvents(static_cast<size_t>(capacity))
+        , mValue(initialValue) {
+    assert(capacity > 0);
+}
+
+bool ParameterAutomation::schedule(int64_t frame, float value, Curve curve) {
+    if (frame < mLastScheduledFrame) {
+        return false;
+    }
+    const uint32_t writeCounter = mWriteCounter.load(std::memory_order_relaxed);
+    if (writeCounter - mReadCounter.load(std::memory_order_acquire) >= mCapacity) {
+        return false; // full
+    }
+    Event &event = mEvents[writeCounter % mCapacity];
+    event.frame = frame;
+    event.value = value;
+    event.curve = curve;
+    mWriteCounter.store(writeCounter + 1, std::memory_order_release);
+    mLastScheduledFrame = frame;
+    return true;
+}
+
+bool ParameterAutomation::popEvent(Event *event) {
+    const uint32_t readCounter = mReadCounter.load(std::memory_order_relaxed);
+    if (readCounter == mWriteCounter.load(std::memory_order_acquire)) {
+        return false; // empty
+    }
+    *event = mEvents[readCounter % mCapacity];
+    mReadCounter.store(readCounter + 1, std::memory_order_release);
+    return true;
+}
+
+void ParameterAutomation::render(float *values, int32_t numFrames) {
+    int64_t position = mFramePosition.load(std::memory_order_relaxed);
+    int32_t framesDone = 0;
+    while (framesDone < numFrames) {
+        if (!mHasTarget) {
+            if (!popEvent(&mTarget)) {
+                std::fill(&values[framesDone], &values[numFrames], mValue);
+                position += numFrames - framesDone;
+                break;
+            }
+            mHasTarget = true;
+            mSegmentStartFrame = position;
+            mSegmentStartValue = mValue;
+        }
+
+        // Render up to the frame of the target. That frame gets the target value.
+        const int32_t framesToRender = static_cast<int32_t>(std::clamp<int64_t>(
+                mTarget.frame - position, 0, numFrames - framesDone));
+        if (framesToRender > 0) {
+            float *output = &values[framesDone];
+            const double length = static_cast<double>(mTarget.frame - mSegmentStartFrame);
+            const double offset = static_cast<double>(position - mSegmentStartFrame);
+            const double start = mSegmentStartValue;
+            const double target = mTarget.value;
+            Curve curve = mTarget.curve;
+            if (curve == Curve::Exponential && !(start * target > 0.0)) {
+                curve = Curve::Linear;
+            }
+            switch (curve) {
+                case Curve::Step:
+                    std::fill(output, output + framesToRender, mValue);
+                    break;
+                case Curve::Linear: {
+                    const double slope = (target - start) / length;
+                    fillLinear(output, framesToRender,
+                               static_cast<float>(start + slope * offset),
+                               static_cast<float>(slope));
+                    break;
+                }
+                case Curve::Exponential: {
+                    // Start each block from the exact value so the products do not drift.
+                    const double ratio = std::pow(target / start, 1.0 / length);
+                    fillExponential(output, framesToRender,
+                                    static_cast<float>(start * std::pow(ratio, offset)),
+                                    static_cast<float>(ratio));
+                    break;
+                }
+            }
+            mValue = output[framesToRender - 1];
+            position += framesToRender;
+            framesDone += framesToRender;
+        }
+        if (position >= mTarget.frame) {
+            mValue = mTarget.value;
+            mHasTarget = false;
+        }
+    }
+    mFramePosition.store(position, std::memory_order_release);
+}
+
+const char *ParameterAutomation::getImplementationName() {
+#if PARAMETER_AUTOMATION_SSE2
+    return "SSE2";
+#elif PARAMETER_AUTOMATION_NEON
+    return "NEON";
+#else
+    return "Scalar";
+#endif
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOWGRAPH_PARAMETER_AUTOMATION_H
+#define FLOWGRAPH_PARAMETER_AUTOMATION_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "FlowGraphNode.h"
+
+namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
+
+/**
+ * A queue of timed parameter changes that renders one value per frame.
+ *
+ * A control thread schedules events with a frame position. The audio thread renders the
+ * values in blocks, so a parameter can change on any frame without a virtual call or
+ * an atomic load per sample. The events are passed through a lock-free queue
+ * that has one writer and one reader.
+ *
+ * Attach it to an unconnected input port with FlowGraphPortFloatInput::setAutomation().
+ * The frame positions then count the frames processed by the node of that port.
+ *
+ * Each event sets the value at its frame. The curve says how the value gets there:
+ * - Step holds the previous value then jumps at the frame.
+ * - Linear ramps from the previous value.
+ * - Exponential ramps with a constant ratio per frame. That sounds even for a frequency
+ *   or a gain. Both values must have the same sign and not be zero, otherwise it is linear.
+ *
+ * A ramp starts at the previous event, or when it is rendered if the queue was idle.
+ * An event with a frame that has already been rendered takes effect immediately.
+ */
+class ParameterAutomation {
+public:
+    enum class Curve : int32_t {
+        Step,
+        Linear,
+        Exponential,
+    };
+
+    static constexpr int32_t kDefaultCapacity = 64;
+
+    /**
+     * @param initialValue value until the first event
+     * @param capacity maximum number of events that are waiting to be rendered
+     */
+    explicit ParameterAutomation(float initialValue = 0.0f, int32_t capacity = kDefaultCapacity);
+
+    // These are called by the control thread.
+
+    /**
+     * Queue an event. Events must be scheduled in order of their frames.
+     *
+     * @param frame frame position where the parameter reaches the value
+     * @return false if the queue is full or the frame is before the previous event
+     */
+    bool schedule(int64_t frame, float value, Curve curve);
+
+    bool setValueAtFrame(int64_t frame, float value) {
+        return schedule(frame, value, Curve::Step);
+    }
+
+    bool linearRampToValueAtFrame(int64_t frame, float value) {
+        return schedule(frame, value, Curve::Linear);
+    }
+
+    bool exponentialRampToValueAtFrame(int64_t frame, float value) {
+        return schedule(frame, value, Curve::Exponential);
+    }
+
+    /**
+     * This can be called from any thread.
+     * @return number of frames rendered so far
+     */
+    int64_t getFramePosition() const {
+        return mFramePosition.load(std::memory_order_acquire);
+    }
+
+    // These are called by the audio thread.
+
+    /**
+     * Write the values of the next frames and consume the events that they reach.
+     */
+    void render(float *values, int32_t numFrames);
+
+    /**
+     * @return the last value rendered
+     */
+    float getValue() const {
+        return mValue;
+    }
+
+    /**
+     * @return name of the instruction set used to render the ramps
+     */
+    static const char *getImplementationName();
+
+private:
+    struct Event {
+        int64_t frame = 0;
+        float   value = 0.0f;
+        Curve   curve = Curve::Step;
+    };
+
+    bool popEvent(Event *event);
+
+    // Assume a common cache line size, like FifoControllerSpsc.
+    static constexpr size_t kCacheLineSizeBytes = 64;
+
+    const uint32_t     mCapacity;
+    std::vector<Event> mEvents;
+
+    // Owned by the control thread.
+    alignas(kCacheLineSizeBytes) std::atomic<uint32_t> mWriteCounter{0};
+    int64_t mLastScheduledFrame = INT64_MIN;
+
+    // Owned by the audio thread.
+    alignas(kCacheLineSizeBytes) std::atomic<uint32_t> mReadCounter{0};
+    std::atomic<int64_t> mFramePosition{0};
+    float   mValue;
+    Event   mTarget;
+    bool    mHasTarget = false;
+    int64_t mSegmentStartFrame = 0;
+    float   mSegmentStartValue = 0.0f;
+};
+
+} /* namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph */
+
+#endif //FLOWGRAPH_PARAMETER_AUTOMATION_H
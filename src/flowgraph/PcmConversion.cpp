@@ -0,0 +1,487 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PcmConversion.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define PCM_CONVERSION_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define PCM_CONVERSION_NEON 1
+#endif
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+
+namespace {
+
+constexpr float kScaleI16ToFloat = 1.0f / 32768.0f;
+constexpr float kScaleI32ToFloat = 1.0f / (1UL << 31);
+constexpr float kScaleQ8_23ToFloat = 1.0f / (1UL << 23);
+#if PCM_CONVERSION_SSE2 || PCM_CONVERSION_NEON
+constexpr float kScaleFloatToI32 = (float) (1UL << 31);
+constexpr float kScaleFloatToQ8_23 = (float) (1UL << 23);
+#endif
+
+// Dither is generated into a small buffer on the stack, which is then converted.
+constexpr int32_t kDitherBlockSize = 64;
+
+/**
+ * Add dither to blocks of the source and pass them to the converter.
+ * Both the SIMD and the scalar conversions use this so they produce the same noise.
+ */
+template <typename T, typename Converter>
+void convertWithDither(const float *source, T *destination, int32_t numSamples,
+                       int32_t destinationStride, float lsb, PcmDither &dither,
+                       Converter convert) {
+    float buffer[kDitherBlockSize];
+    while (numSamples > 0) {
+        int32_t numToConvert = std::min(numSamples, kDitherBlockSize);
+        for (int i = 0; i < numToConvert; i++) {
+            buffer[i] = source[i] + (dither.nextTriangular() * lsb);
+        }
+        convert(buffer, destination, numToConvert);
+        source += numToConvert;
+        destination += numToConvert * destinationStride;
+        numSamples -= numToConvert;
+    }
+}
+
+constexpr float kLsbI16 = 1.0f / 32768.0f;
+constexpr float kLsbI24 = 1.0f / (1 << 23);
+
+} // namespace
+
+/***************************************************************************/
+// Scalar reference.
+
+void PcmConversion::Scalar::convertFloatToI16(const float *source, int16_t *destination,
+                                              int32_t numSamples, PcmDither *dither) {
+    if (dither != nullptr) {
+        convertWithDither(source, destination, numSamples, 1, kLsbI16, *dither,
+                          [](const float *s, int16_t *d, int32_t n) {
+                              Scalar::convertFloatToI16(s, d, n);
+                          });
+        return;
+    }
+    for (int i = 0; i < numSamples; i++) {
+        destination[i] = floatToI16(source[i]);
+    }
+}
+
+void PcmConversion::Scalar::convertI16ToFloat(const int16_t *source, float *destination,
+                                              int32_t numSamples) {
+    for (int i = 0; i < numSamples; i++) {
+        destination[i] = source[i] * kScaleI16ToFloat;
+    }
+}
+
+void PcmConversion::Scalar::convertFloatToP24(const float *source, uint8_t *destination,
+                                              int32_t numSamples, PcmDither *dither) {
+    if (dither != nullptr) {
+        convertWithDither(source, destination, numSamples, kBytesPerI24Packed, kLsbI24,
+                          *dither,
+                          [](const float *s, uint8_t *d, int32_t n) {
+                              Scalar::convertFloatToP24(s, d, n);
+                          });
+        return;
+    }
+    for (int i = 0; i < numSamples; i++) {
+        destination = writeP24(floatToI24(source[i]), destination);
+    }
+}
+
+void PcmConversion::Scalar::convertP24ToFloat(const uint8_t *source, float *destination,
+                                              int32_t numSamples) {
+    for (int i = 0; i < numSamples; i++) {
+        destination[i] = readP24(source) * kScaleI32ToFloat;
+        source += kBytesPerI24Packed;
+    }
+}
+
+void PcmConversion::Scalar::convertFloatToI32(const float *source, int32_t *destination,
+                                              int32_t numSamples) {
+    for (int i = 0; i < numSamples; i++) {
+        destination[i] = floatToI32(source[i]);
+    }
+}
+
+void PcmConversion::Scalar::convertI32ToFloat(const int32_t *source, float *destination,
+                                              int32_t numSamples) {
+    for (int i = 0; i < numSamples; i++) {
+        destination[i] = source[i] * kScaleI32ToFloat;
+    }
+}
+
+void PcmConversion::Scalar::convertFloatToQ8_23(const float *source, int32_t *destination,
+                                                int32_t numSamples) {
+    for (int i = 0; i < numSamples; i++) {
+        destination[i] = floatToQ8_23(source[i]);
+    }
+}
+
+void PcmConversion::Scalar::convertQ8_23ToFloat(const int32_t *source, float *destination,
+                                                int32_t numSamples) {
+    for (int i = 0; i < numSamples; i++) {
+        destination[i] = source[i] * kScaleQ8_23ToFloat;
+    }
+}
+
+/***************************************************************************/
+// SIMD. Each function converts whole vectors then finishes with the scalar code.
+
+#if PCM_CONVERSION_SSE2
+namespace {
+
+// Round to nearest, ties away from zero, to match lroundf().
+// SSE2 has no rounding instruction so adjust the truncated value using the exact fraction.
+inline __m128i roundTiesAway(__m128 scaled) {
+    __m128i truncated = _mm_cvttps_epi32(scaled);
+    __m128 fraction = _mm_sub_ps(scaled, _mm_cvtepi32_ps(truncated));
+    // The comparison masks are -1 where true.
+    __m128i roundUp = _mm_castps_si128(_mm_cmpge_ps(fraction, _mm_set1_ps(0.5f)));
+    __m128i roundDown = _mm_castps_si128(_mm_cmple_ps(fraction, _mm_set1_ps(-0.5f)));
+    return _mm_add_epi32(_mm_sub_epi32(truncated, roundUp), roundDown);
+}
+
+// The clip is done in float so the conversion cannot overflow.
+// _mm_max_ps() returns the second operand for NaN, which matches std::max() in floatToI16().
+inline __m128i floatToI24x4(__m128 samples) {
+    __m128 scaled = _mm_mul_ps(samples, _mm_set1_ps((float) (1 << 23)));
+    scaled = _mm_min_ps(_mm_max_ps(scaled, _mm_set1_ps(-(float) (1 << 23))),
+                        _mm_set1_ps((float) ((1 << 23) - 1)));
+    return _mm_cvttps_epi32(scaled);
+}
+
+} // namespace
+
+void PcmConversion::convertFloatToI16(const float *source, int16_t *destination,
+                                      int32_t numSamples, PcmDither *dither) {
+    if (dither != nullptr) {
+        convertWithDither(source, destination, numSamples, 1, kLsbI16, *dither,
+                          [](const float *s, int16_t *d, int32_t n) {
+                              convertFloatToI16(s, d, n);
+                          });
+        return;
+    }
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 minimum = _mm_set1_ps(-32768.0f);
+    const __m128 maximum = _mm_set1_ps(32767.0f);
+    int i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        __m128 low = _mm_mul_ps(_mm_loadu_ps(&source[i]), scale);
+        __m128 high = _mm_mul_ps(_mm_loadu_ps(&source[i + 4]), scale);
+        low = _mm_min_ps(_mm_max_ps(low, minimum), maximum);
+        high = _mm_min_ps(_mm_max_ps(high, minimum), maximum);
+        __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(low), _mm_cvttps_epi32(high));
+        _mm_storeu_si128((__m128i *) &destination[i], packed);
+    }
+    Scalar::convertFloatToI16(&source[i], &destination[i], numSamples - i);
+}
+
+void PcmConversion::convertI16ToFloat(const int16_t *source, float *destination,
+                                      int32_t numSamples) {
+    const __m128 scale = _mm_set1_ps(kScaleI16ToFloat);
+    int i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        __m128i shorts = _mm_loadu_si128((const __m128i *) &source[i]);
+        // Sign extend by putting each short in the top half then shifting down.
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(shorts, shorts), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(shorts, shorts), 16);
+        _mm_storeu_ps(&destination[i], _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(&destination[i + 4], _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+    Scalar::convertI16ToFloat(&source[i], &destination[i], numSamples - i);
+}
+
+void PcmConversion::convertFloatToP24(const float *source, uint8_t *destination,
+                                      int32_t numSamples, PcmDither *dither) {
+    if (dither != nullptr) {
+        convertWithDither(source, destination, numSamples, kBytesPerI24Packed, kLsbI24,
+                          *dither,
+                          [](const float *s, uint8_t *d, int32_t n) {
+                              convertFloatToP24(s, d, n);
+                          });
+        return;
+    }
+    int i = 0;
+    alignas(16) int32_t ints[4];
+    for (; i + 4 <= numSamples; i += 4) {
+        _mm_store_si128((__m128i *) ints, floatToI24x4(_mm_loadu_ps(&source[i])));
+        for (int32_t sample : ints) {
+            destination = writeP24(sample, destination);
+        }
+    }
+    Scalar::convertFloatToP24(&source[i], destination, numSamples - i);
+}
+
+void PcmConversion::convertP24ToFloat(const uint8_t *source, float *destination,
+                                      int32_t numSamples) {
+    const __m128 scale = _mm_set1_ps(kScaleI32ToFloat);
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        __m128i ints = _mm_setr_epi32(readP24(&source[0]),
+                                      readP24(&source[kBytesPerI24Packed]),
+                                      readP24(&source[2 * kBytesPerI24Packed]),
+                                      readP24(&source[3 * kBytesPerI24Packed]));
+        _mm_storeu_ps(&destination[i], _mm_mul_ps(_mm_cvtepi32_ps(ints), scale));
+        source += 4 * kBytesPerI24Packed;
+    }
+    Scalar::convertP24ToFloat(source, &destination[i], numSamples - i);
+}
+
+void PcmConversion::convertFloatToI32(const float *source, int32_t *destination,
+                                      int32_t numSamples) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 scale = _mm_set1_ps(kScaleFloatToI32);
+    const __m128i maximum = _mm_set1_epi32(INT32_MAX);
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        __m128 samples = _mm_loadu_ps(&source[i]);
+        __m128 scaled = _mm_mul_ps(_mm_min_ps(_mm_max_ps(samples, minusOne), one), scale);
+        __m128i ints = roundTiesAway(scaled);
+        // 1.0 scales to 2^31, which does not fit, so select INT32_MAX.
+        __m128i isMaximum = _mm_castps_si128(_mm_cmpge_ps(samples, one));
+        ints = _mm_or_si128(_mm_andnot_si128(isMaximum, ints),
+                            _mm_and_si128(isMaximum, maximum));
+        _mm_storeu_si128((__m128i *) &destination[i], ints);
+    }
+    Scalar::convertFloatToI32(&source[i], &destination[i], numSamples - i);
+}
+
+void PcmConversion::convertI32ToFloat(const int32_t *source, float *destination,
+                                      int32_t numSamples) {
+    const __m128 scale = _mm_set1_ps(kScaleI32ToFloat);
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        __m128i ints = _mm_loadu_si128((const __m128i *) &source[i]);
+        _mm_storeu_ps(&destination[i], _mm_mul_ps(_mm_cvtepi32_ps(ints), scale));
+    }
+    Scalar::convertI32ToFloat(&source[i], &destination[i], numSamples - i);
+}
+
+void PcmConversion::convertFloatToQ8_23(const float *source, int32_t *destination,
+                                        int32_t numSamples) {
+    const __m128 scale = _mm_set1_ps(kScaleFloatToQ8_23);
+    const __m128 minimum = _mm_set1_ps(-kScaleFloatToQ8_23);
+    const __m128 maximum = _mm_set1_ps(kScaleFloatToQ8_23 - 1.0f);
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        __m128 scaled = _mm_mul_ps(_mm_loadu_ps(&source[i]), scale);
+        // Clip in the same order as clamp24FromFloat() so NaN gives the maximum.
+        scaled = _mm_max_ps(_mm_min_ps(scaled, maximum), minimum);
+        _mm_storeu_si128((__m128i *) &destination[i], roundTiesAway(scaled));
+    }
+    Scalar::convertFloatToQ8_23(&source[i], &destination[i], numSamples - i);
+}
+
+void PcmConversion::convertQ8_23ToFloat(const int32_t *source, float *destination,
+                                        int32_t numSamples) {
+    const __m128 scale = _mm_set1_ps(kScaleQ8_23ToFloat);
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        __m128i ints = _mm_loadu_si128((const __m128i *) &source[i]);
+        _mm_storeu_ps(&destination[i], _mm_mul_ps(_mm_cvtepi32_ps(ints), scale));
+    }
+    Scalar::convertQ8_23ToFloat(&source[i], &destination[i], numSamples - i);
+}
+
+const char *PcmConversion::getImplementationName() {
+    return "SSE2";
+}
+
+#elif PCM_CONVERSION_NEON
+
+namespace {
+
+inline int32x4_t floatToI24x4(float32x4_t samples) {
+    float32x4_t scaled = vmulq_f32(samples, vdupq_n_f32((float) (1 << 23)));
+    scaled = vminq_f32(vmaxq_f32(scaled, vdupq_n_f32(-(float) (1 << 23))),
+                       vdupq_n_f32((float) ((1 << 23) - 1)));
+    return vcvtq_s32_f32(scaled); // truncate
+}
+
+} // namespace
+
+void PcmConversion::convertFloatToI16(const float *source, int16_t *destination,
+                                      int32_t numSamples, PcmDither *dither) {
+    if (dither != nullptr) {
+        convertWithDither(source, destination, numSamples, 1, kLsbI16, *dither,
+                          [](const float *s, int16_t *d, int32_t n) {
+                              convertFloatToI16(s, d, n);
+                          });
+        return;
+    }
+    const float32x4_t scale = vdupq_n_f32(32768.0f);
+    int i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        // vcvtq_s32_f32() truncates and saturates, then vqmovn_s32() clips to 16 bits.
+        int32x4_t low = vcvtq_s32_f32(vmulq_f32(vld1q_f32(&source[i]), scale));
+        int32x4_t high = vcvtq_s32_f32(vmulq_f32(vld1q_f32(&source[i + 4]), scale));
+        vst1q_s16(&destination[i], vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+    }
+    Scalar::convertFloatToI16(&source[i], &destination[i], numSamples - i);
+}
+
+void PcmConversion::convertI16ToFloat(const int16_t *source, float *destination,
+                                      int32_t numSamples) {
+    const float32x4_t scale = vdupq_n_f32(kScaleI16ToFloat);
+    int i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        int16x8_t shorts = vld1q_s16(&source[i]);
+        int32x4_t low = vmovl_s16(vget_low_s16(shorts));
+        int32x4_t high = vmovl_s16(vget_high_s16(shorts));
+        vst1q_f32(&destination[i], vmulq_f32(vcvtq_f32_s32(low), scale));
+        vst1q_f32(&destination[i + 4], vmulq_f32(vcvtq_f32_s32(high), scale));
+    }
+    Scalar::convertI16ToFloat(&source[i], &destination[i], numSamples - i);
+}
+
+void PcmConversion::convertFloatToP24(const float *source, uint8_t *destination,
+                                      int32_t numSamples, PcmDither *dither) {
+    if (dither != nullptr) {
+        convertWithDither(source, destination, numSamples, kBytesPerI24Packed, kLsbI24,
+                          *dither,
+                          [](const float *s, uint8_t *d, int32_t n) {
+                              convertFloatToP24(s, d, n);
+                          });
+        return;
+    }
+    int i = 0;
+    int32_t ints[4];
+    for (; i + 4 <= numSamples; i += 4) {
+        vst1q_s32(ints, floatToI24x4(vld1q_f32(&source[i])));
+        for (int32_t sample : ints) {
+            destination = writeP24(sample, destination);
+        }
+    }
+    Scalar::convertFloatToP24(&source[i], destination, numSamples - i);
+}
+
+void PcmConversion::convertP24ToFloat(const uint8_t *source, float *destination,
+                                      int32_t numSamples) {
+    const float32x4_t scale = vdupq_n_f32(kScaleI32ToFloat);
+    int i = 0;
+    int32_t ints[4];
+    for (; i + 4 <= numSamples; i += 4) {
+        for (int32_t &sample : ints) {
+            sample = readP24(source);
+            source += kBytesPerI24Packed;
+        }
+        vst1q_f32(&destination[i], vmulq_f32(vcvtq_f32_s32(vld1q_s32(ints)), scale));
+    }
+    Scalar::convertP24ToFloat(source, &destination[i], numSamples - i);
+}
+
+void PcmConversion::convertFloatToI32(const float *source, int32_t *destination,
+                                      int32_t numSamples) {
+    const float32x4_t scale = vdupq_n_f32(kScaleFloatToI32);
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        // vcvtaq_s32_f32() rounds ties away from zero and saturates, like clamp32FromFloat().
+        float32x4_t scaled = vmulq_f32(vld1q_f32(&source[i]), scale);
+        vst1q_s32(&destination[i], vcvtaq_s32_f32(scaled));
+    }
+    Scalar::convertFloatToI32(&source[i], &destination[i], numSamples - i);
+}
+
+void PcmConversion::convertI32ToFloat(const int32_t *source, float *destination,
+                                      int32_t numSamples) {
+    const float32x4_t scale = vdupq_n_f32(kScaleI32ToFloat);
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        vst1q_f32(&destination[i], vmulq_f32(vcvtq_f32_s32(vld1q_s32(&source[i])), scale));
+    }
+    Scalar::convertI32ToFloat(&source[i], &destination[i], numSamples - i);
+}
+
+void PcmConversion::convertFloatToQ8_23(const float *source, int32_t *destination,
+                                        int32_t numSamples) {
+    const float32x4_t scale = vdupq_n_f32(kScaleFloatToQ8_23);
+    const float32x4_t minimum = vdupq_n_f32(-kScaleFloatToQ8_23);
+    const float32x4_t maximum = vdupq_n_f32(kScaleFloatToQ8_23 - 1.0f);
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        float32x4_t scaled = vmulq_f32(vld1q_f32(&source[i]), scale);
+        // vminnmq_f32() returns the number for NaN, like fminf() in clamp24FromFloat().
+        scaled = vmaxnmq_f32(vminnmq_f32(scaled, maximum), minimum);
+        vst1q_s32(&destination[i], vcvtaq_s32_f32(scaled));
+    }
+    Scalar::convertFloatToQ8_23(&source[i], &destination[i], numSamples - i);
+}
+
+void PcmConversion::convertQ8_23ToFloat(const int32_t *source, float *destination,
+                                        int32_t numSamples) {
+    const float32x4_t scale = vdupq_n_f32(kScaleQ8_23ToFloat);
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        vst1q_f32(&destination[i], vmulq_f32(vcvtq_f32_s32(vld1q_s32(&source[i])), scale));
+    }
+    Scalar::convertQ8_23ToFloat(&source[i], &destination[i], numSamples - i);
+}
+
+const char *PcmConversion::getImplementationName() {
+    return "NEON";
+}
+
+#else // no SIMD
+
+void PcmConversion::convertFloatToI16(const float *source, int16_t *destination,
+                                      int32_t numSamples, PcmDither *dither) {
+    Scalar::convertFloatToI16(source, destination, numSamples, dither);
+}
+
+void PcmConversion::convertI16ToFloat(const int16_t *source, float *destination,
+                                      int32_t numSamples) {
+    Scalar::convertI16ToFloat(source, destination, numSamples);
+}
+
+void PcmConversion::convertFloatToP24(const float *source, uint8_t *destination,
+                                      int32_t numSamples, PcmDither *dither) {
+    Scalar::convertFloatToP24(source, destination, numSamples, dither);
+}
+
+void PcmConversion::convertP24ToFloat(const uint8_t *source, float *destination,
+                                      int32_t numSamples) {
+    Scalar::convertP24ToFloat(source, destination, numSamples);
+}
+
+void PcmConversion::convertFloatToI32(const float *source, int32_t *destination,
+                                      int32_t numSamples) {
+    Scalar::convertFloatToI32(source, destination, numSamples);
+}
+
+void PcmConversion::convertI32ToFloat(const int32_t *source, float *destination,
+                                      int32_t numSamples) {
+    Scalar::convertI32ToFloat(source, destination, numSamples);
+}
+
+void PcmConversion::convertFloatToQ8_23(const float *source, int32_t *destination,
+                                        int32_t numSamples) {
+    Scalar::convertFloatToQ8_23(source, destination, numSamples);
+}
+
+void PcmConversion::convertQ8_23ToFloat(const int32_t *source, float *destination,
+                                        int32_t numSamples) {
+    Scalar::convertQ8_23ToFloat(source, destination, numSamples);
+}
+
+const char *PcmConversion::getImplementationName() {
+    return "Scalar";
+}
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOWGRAPH_PCM_CONVERSION_H
+#define FLOWGRAPH_PCM_CONVERSION_H
+
+#include <algorithm>
+#include <sys/types.h>
+
+#include "FlowGraphNode.h"
+#include "FlowgraphUtilities.h"
+
+namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
+
+/**
+ * Generator of triangular (TPDF) dither noise.
+ * This is a cheap LCG so it is safe to use in a real-time callback.
+ */
+class PcmDither {
+public:
+    explicit PcmDither(uint32_t seed = 12345) : mSeed(seed) {}
+
+    /**
+     * @return noise with a triangular distribution in the range (-1.0, 1.0)
+     */
+    float nextTriangular() {
+        return nextUniform() - nextUniform();
+    }
+
+private:
+    float nextUniform() {
+        mSeed = (mSeed * 1664525u) + 1013904223u;
+        return (mSeed >> 8) * (1.0f / (1 << 24)); // [0.0, 1.0)
+    }
+
+    uint32_t mSeed;
+};
+
+/**
+ * Conversion between float and the integer PCM formats.
+ *
+ * The bulk conversions use SSE2 or AArch64 NEON when they are available.
+ * They give bit-identical results to the scalar versions in PcmConversion::Scalar
+ * for all inputs except NaN, which is undefined.
+ *
+ * Float samples are nominally in the range [-1.0, 1.0). Samples outside that range are clipped.
+ *
+ * The float to integer conversions can optionally add one LSB of triangular dither.
+ * The dither is added before the sample is quantized.
+ */
+class PcmConversion {
+public:
+    // Single sample conversions. These define the behavior of the bulk conversions.
+
+    /**
+     * Convert a float to a 16-bit integer by truncation, with clipping.
+     */
+    static inline int16_t floatToI16(float sample) {
+        float scaled = sample * 32768.0f;
+        scaled = std::min(32767.0f, std::max(-32768.0f, scaled)); // clip
+        return static_cast<int16_t>(scaled);
+    }
+
+    /**
+     * Convert a float to a 24-bit integer by truncation, with clipping.
+     * The result is in the low 24 bits of an int32_t.
+     */
+    static inline int32_t floatToI24(float sample) {
+        float scaled = sample * static_cast<float>(1 << 23);
+        scaled = std::min(static_cast<float>((1 << 23) - 1),
+                          std::max(-static_cast<float>(1 << 23), scaled)); // clip
+        return static_cast<int32_t>(scaled);
+    }
+
+    /**
+     * Write a 24-bit integer as a packed 24-bit integer in Little Endian format.
+     * @return pointer to the next sample
+     */
+    static inline uint8_t *writeP24(int32_t sample, uint8_t *destination) {
+        *destination++ = (uint8_t) sample;
+        *destination++ = (uint8_t) (sample >> 8);
+        *destination++ = (uint8_t) (sample >> 16);
+        return destination;
+    }
+
+    /**
+     * Read a packed 24-bit integer in Little Endian format.
+     * @return sample shifted to the top of an int32_t so the sign is correct
+     */
+    static inline int32_t readP24(const uint8_t *source) {
+        int32_t pad = source[2];
+        pad <<= 8;
+        pad |= source[1];
+        pad <<= 8;
+        pad |= source[0];
+        pad <<= 8;
+        return pad;
+    }
+
+    /**
+     * Convert a float to a Q0.31 integer. Rounds to nearest, ties away from 0.
+     */
+    static inline int32_t floatToI32(float sample) {
+        return FlowgraphUtilities::clamp32FromFloat(sample);
+    }
+
+    /**
+     * Convert a float to a Q8.23 integer clamped to the Q0.23 range.
+     * Rounds to nearest, ties away from 0.
+     */
+    static inline int32_t floatToQ8_23(float sample) {
+        return FlowgraphUtilities::clamp24FromFloat(sample);
+    }
+
+    static constexpr int kBytesPerI24Packed = 3;
+
+    static void convertFloatToI16(const float *source, int16_t *destination,
+                                  int32_t numSamples, PcmDither *dither = nullptr);
+    static void convertI16ToFloat(const int16_t *source, float *destination,
+                                  int32_t numSamples);
+
+    static void convertFloatToP24(const float *source, uint8_t *destination,
+                                  int32_t numSamples, PcmDither *dither = nullptr);
+    static void convertP24ToFloat(const uint8_t *source, float *destination,
+                                  int32_t numSamples);
+
+    static void convertFloatToI32(const float *source, int32_t *destination,
+                                  int32_t numSamples);
+    static void convertI32ToFloat(const int32_t *source, float *destination,
+                                  int32_t numSamples);
+
+    static void convertFloatToQ8_23(const float *source, int32_t *destination,
+                                    int32_t numSamples);
+    static void convertQ8_23ToFloat(const int32_t *source, float *destination,
+                                    int32_t numSamples);
+
+    /**
+     * @return name of the instruction set used by the bulk conversions, eg. "SSE2"
+     */
+    static const char *getImplementationName();
+
+    /**
+     * Reference implementation of the bulk conversions using the single sample functions.
+     */
+    struct Scalar {
+        static void convertFloatToI16(const float *source, int16_t *destination,
+                                      int32_t numSamples, PcmDither *dither = nullptr);
+        static void convertI16ToFloat(const int16_t *source, float *destination,
+                                      int32_t numSamples);
+
+        static void convertFloatToP24(const float *source, uint8_t *destination,
+                                      int32_t numSamples, PcmDither *dither = nullptr);
+        static void convertP24ToFloat(const uint8_t *source, float *destination,
+                                      int32_t numSamples);
+
+        static void convertFloatToI32(const float *source, int32_t *destination,
+                                      int32_t numSamples);
+        static void convertI32ToFloat(const int32_t *source, float *destination,
+                                      int32_t numSamples);
+
+        static void convertFloatToQ8_23(const float *source, int32_t *destination,
+                                        int32_t numSamples);
+        static void convertQ8_23ToFloat(const int32_t *source, float *destination,
+                                        int32_t numSamples);
+    };
+};
+
+} /* namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph */
+
+#endif //FLOWGRAPH_PCM_CONVERSION_H
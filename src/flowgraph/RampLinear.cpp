@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <unistd.h>
 #include "FlowGraphNode.h"
+#include "FusedStage.h"
 #include "RampLinear.h"
 
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
@@ -42,11 +43,7 @@ float RampLinear::interpolateCurrent() {
     return mLevelTo - (mRemaining * mScaler);
 }
 
-int32_t RampLinear::onProcess(int32_t numFrames) {
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
-    int32_t channelCount = output.getSamplesPerFrame();
-
+void RampLinear::updateTarget() {
     float target = getTarget();
     if (target != mLevelTo) {
         // Start new ramp. Continue from previous level.
@@ -55,6 +52,33 @@ int32_t RampLinear::onProcess(int32_t numFrames) {
         mRemaining = mLengthInFrames;
         mScaler = (mLevelTo - mLevelFrom) / mLengthInFrames; // for interpolation
     }
+}
+
+int32_t RampLinear::onProcess(int32_t numFrames) {
+    const float *inputBuffer = input.getBuffer();
+    float *outputBuffer = output.getBuffer();
+    int32_t channelCount = output.getSamplesPerFrame();
+
+    updateTarget();
+
+    if (input.isPlanar()) {
+        // Every channel follows the same part of the ramp.
+        int32_t framesToRamp = std::min(numFrames, mRemaining);
+        for (int ch = 0; ch < channelCount; ch++) {
+            const float *channelInput = inputBuffer + ch * input.getChannelStride();
+            float *channelOutput = outputBuffer + ch * output.getChannelStride();
+            int32_t remaining = mRemaining;
+            int32_t i = 0;
+            for (; i < framesToRamp; i++) {
+                channelOutput[i] = channelInput[i] * (mLevelTo - (remaining-- * mScaler));
+            }
+            for (; i < numFrames; i++) {
+                channelOutput[i] = channelInput[i] * mLevelTo;
+            }
+        }
+        mRemaining -= framesToRamp;
+        return numFrames;
+    }
 
     int32_t framesLeft = numFrames;
 
@@ -79,3 +103,30 @@ int32_t RampLinear::onProcess(int32_t numFrames) {
 
     return numFrames;
 }
+
+void RampLinear::fillLevels(float *levels, int32_t numFrames) {
+    // Mark the ramp as used so that setTarget() will ramp instead of jumping.
+    if (mLastCallCount == kInitialCallCount) {
+        mLastCallCount = 0;
+    }
+    updateTarget();
+    for (int i = 0; i < numFrames; i++) {
+        if (mRemaining > 0) {
+            *levels++ = interpolateCurrent();
+            mRemaining--;
+        } else {
+            *levels++ = mLevelTo;
+        }
+    }
+}
+
+bool RampLinear::describeFusedStage(FusedStage *stage) {
+    if (input.isPlanar()) {
+        return false; // SinkFused reads interleaved frames
+    }
+    stage->type = FusedStage::Type::Gain;
+    stage->inputChannelCount = input.getSamplesPerFrame();
+    stage->outputChannelCount = output.getSamplesPerFrame();
+    stage->ramp = this;
+    return true;
+}
@@ -41,6 +41,12 @@ public:
 
     int32_t onProcess(int32_t numFrames) override;
 
+    bool describeFusedStage(FusedStage *stage) override;
+
+    bool isPlanarSupported() const override {
+        return true;
+    }
+
     /**
      * This is used for the next ramp.
      * Calling this does not affect a ramp that is in progress.
@@ -78,8 +84,20 @@ public:
         return "RampLinear";
     }
 
+    /**
+     * Calculate the level for each of the next numFrames frames.
+     * This advances the ramp exactly like onProcess().
+     * It is used when this node has been fused into another node.
+     *
+     * @param levels array to receive one level per frame
+     * @param numFrames number of frames
+     */
+    void fillLevels(float *levels, int32_t numFrames);
+
 private:
 
+    void updateTarget();
+
     float interpolateCurrent();
 
     std::atomic<float>  mTarget;
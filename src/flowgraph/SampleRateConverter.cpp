@@ -42,30 +42,25 @@ bool SampleRateConverter::isInputAvailable() {
     return (mInputCursor < mNumValidInputFrames);
 }
 
-const float *SampleRateConverter::getNextInputFrame() {
-    const float *inputBuffer = input.getBuffer();
-    return &inputBuffer[mInputCursor++ * input.getSamplesPerFrame()];
-}
-
 int32_t SampleRateConverter::onProcess(int32_t numFrames) {
     float *outputBuffer = output.getBuffer();
-    int32_t channelCount = output.getSamplesPerFrame();
+    const int32_t channelCount = output.getSamplesPerFrame();
     int framesLeft = numFrames;
     while (framesLeft > 0) {
         // Gather input samples as needed.
-        if(mResampler.isWriteNeeded()) {
-            if (isInputAvailable()) {
-                const float *frame = getNextInputFrame();
-                mResampler.writeNextFrame(frame);
-            } else {
-                break;
-            }
-        } else {
-            // Output frame is interpolated from input samples.
-            mResampler.readNextFrame(outputBuffer);
-            outputBuffer += channelCount;
-            framesLeft--;
+        if (mResampler.isWriteNeeded() && !isInputAvailable()) {
+            break;
         }
+        // Convert as many frames as we can from the input port buffer.
+        const float *inputBuffer = input.getBuffer();
+        const MultiChannelResampler::ProcessResult result = mResampler.process(
+                &inputBuffer[mInputCursor * input.getSamplesPerFrame()],
+                mNumValidInputFrames - mInputCursor,
+                outputBuffer,
+                framesLeft);
+        mInputCursor += result.framesConsumed;
+        outputBuffer += result.framesProduced * channelCount;
+        framesLeft -= result.framesProduced;
     }
     return numFrames - framesLeft;
 }
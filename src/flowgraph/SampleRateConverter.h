@@ -45,9 +45,6 @@ private:
     // Return true if there is a sample available.
     bool isInputAvailable();
 
-    // This assumes data is available. Only call after calling isInputAvailable().
-    const float *getNextInputFrame();
-
     resampler::MultiChannelResampler &mResampler;
 
     int32_t mInputCursor = 0;         // offset into the input port buffer
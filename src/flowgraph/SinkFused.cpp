@@ -0,0 +1,187 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <math.h>
+#include <unistd.h>
+
+#include "FlowGraphNode.h"
+#include "Limiter.h"
+#include "PcmConversion.h"
+#include "RampLinear.h"
+#include "SinkFused.h"
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+
+SinkFused::SinkFused(int32_t inputChannelCount, Format format)
+        : FlowGraphSink(inputChannelCount)
+        , mFormat(format)
+        , mChannelMap(inputChannelCount) {
+    for (int channel = 0; channel < inputChannelCount; channel++) {
+        mChannelMap[channel] = channel;
+    }
+}
+
+bool SinkFused::fuse(FlowGraphNode &node) {
+    FusedStage stage;
+    if (!node.describeFusedStage(&stage)
+            || stage.inputChannelCount != getOutputChannelCount()) {
+        return false;
+    }
+    if (stage.type == FusedStage::Type::ChannelMap) {
+        // Compose the maps. The other operations are the same for every channel
+        // so they can be applied after the complete map.
+        std::vector<int32_t> channelMap(stage.outputChannelCount);
+        for (int channel = 0; channel < stage.outputChannelCount; channel++) {
+            channelMap[channel] = mChannelMap[stage.channelMap[channel]];
+        }
+        mChannelMap = std::move(channelMap);
+        allocateLastValidOutputs();
+        return true;
+    }
+    Operation operation;
+    operation.type = stage.type;
+    operation.ramp = stage.ramp;
+    operation.minimum = stage.minimum;
+    operation.maximum = stage.maximum;
+    mOperations.push_back(operation);
+    allocateLevels();
+    allocateLastValidOutputs();
+    return true;
+}
+
+void SinkFused::allocateLastValidOutputs() {
+    // The operations are applied after the channel map so keep one per output channel.
+    for (Operation &operation : mOperations) {
+        if (operation.type == FusedStage::Type::Limit) {
+            operation.lastValidOutputs.resize(getOutputChannelCount(), 0.0f);
+        }
+    }
+}
+
+void SinkFused::setFramesPerBuffer(int32_t framesPerBuffer) {
+    FlowGraphSink::setFramesPerBuffer(framesPerBuffer);
+    allocateLevels();
+}
+
+void SinkFused::allocateLevels() {
+    // Reassign the level arrays because the storage may have moved.
+    const int32_t framesPerBuffer = input.getFramesPerBuffer();
+    mLevels.resize(mOperations.size() * framesPerBuffer);
+    for (size_t i = 0; i < mOperations.size(); i++) {
+        mOperations[i].levels = &mLevels[i * framesPerBuffer];
+    }
+}
+
+float SinkFused::applyOperations(float sample, int32_t frameIndex, int32_t channel) {
+    for (Operation &operation : mOperations) {
+        switch (operation.type) {
+            case FusedStage::Type::Gain:
+                sample *= operation.levels[frameIndex];
+                break;
+            case FusedStage::Type::Limit:
+                // Use the previous output of the channel if the input is NaN
+                if (!isnan(sample)) {
+                    operation.lastValidOutputs[channel] = Limiter::processFloat(sample);
+                }
+                sample = operation.lastValidOutputs[channel];
+                break;
+            case FusedStage::Type::Clip:
+                sample = std::min(operation.maximum, std::max(operation.minimum, sample));
+                break;
+            case FusedStage::Type::ChannelMap:
+                break; // already applied
+        }
+    }
+    return sample;
+}
+
+template <typename T, typename Encoder>
+T *SinkFused::convertFrames(const float *inputBuffer, T *outputBuffer,
+                            int32_t numFrames, Encoder encode) {
+    const int32_t inputChannelCount = input.getSamplesPerFrame();
+    const int32_t outputChannelCount = getOutputChannelCount();
+    const int32_t *channelMap = mChannelMap.data();
+    for (int frame = 0; frame < numFrames; frame++) {
+        for (int channel = 0; channel < outputChannelCount; channel++) {
+            float sample = inputBuffer[channelMap[channel]];
+            if (!mOperations.empty()) {
+                sample = applyOperations(sample, frame, channel);
+            }
+            outputBuffer = encode(sample, outputBuffer);
+        }
+        inputBuffer += inputChannelCount;
+    }
+    return outputBuffer;
+}
+
+// The encoders use the same single sample conversions as SinkI16, SinkI24, SinkI32 and SinkI8_24.
+int32_t SinkFused::read(void *data, int32_t numFrames) {
+    int32_t framesLeft = numFrames;
+    while (framesLeft > 0) {
+        // Run the graph and pull data through the input port.
+        int32_t framesRead = pullData(framesLeft);
+        if (framesRead <= 0) {
+            break;
+        }
+        for (Operation &operation : mOperations) {
+            if (operation.type == FusedStage::Type::Gain) {
+                operation.ramp->fillLevels(operation.levels, framesRead);
+            }
+        }
+        const float *signal = input.getBuffer();
+        switch (mFormat) {
+            case Format::Float:
+                data = convertFrames(signal, static_cast<float *>(data), framesRead,
+                        [](float sample, float *output) {
+                            *output = sample;
+                            return output + 1;
+                        });
+                break;
+            case Format::I16:
+                data = convertFrames(signal, static_cast<int16_t *>(data), framesRead,
+                        [](float sample, int16_t *output) {
+                            *output = PcmConversion::floatToI16(sample);
+                            return output + 1;
+                        });
+                break;
+            case Format::I24:
+                data = convertFrames(signal, static_cast<uint8_t *>(data), framesRead,
+                        [](float sample, uint8_t *output) {
+                            return PcmConversion::writeP24(PcmConversion::floatToI24(sample),
+                                                           output);
+                        });
+                break;
+            case Format::I32:
+                data = convertFrames(signal, static_cast<int32_t *>(data), framesRead,
+                        [](float sample, int32_t *output) {
+                            *output = PcmConversion::floatToI32(sample);
+                            return output + 1;
+                        });
+                break;
+            case Format::I8_24:
+                data = convertFrames(signal, static_cast<int32_t *>(data), framesRead,
+                        [](float sample, int32_t *output) {
+                            *output = PcmConversion::floatToQ8_23(sample);
+                            return output + 1;
+                        });
+                break;
+        }
+        framesLeft -= framesRead;
+    }
+    return numFrames - framesLeft;
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FLOWGRAPH_SINK_FUSED_H
+#define FLOWGRAPH_SINK_FUSED_H
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <vector>
+
+#include "FlowGraphNode.h"
+#include "FusedStage.h"
+
+namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
+
+/**
+ * AudioSink that performs the work of several stateless nodes
+ * and the final format conversion in a single loop.
+ *
+ * Nodes such as channel converters, RampLinear, Limiter and ClipToRange
+ * that would normally sit in front of a sink are described by
+ * FlowGraphNode::describeFusedStage() and then passed to fuse().
+ * The fused nodes are not connected to the graph. Their ports are not used.
+ * This avoids a port buffer and a pullData() call per fused node.
+ */
+class SinkFused : public FlowGraphSink {
+public:
+    enum class Format {
+        Float,
+        I16,
+        I24,   // packed 24-bit
+        I32,
+        I8_24, // Q8.23 in a 32-bit integer
+    };
+
+    /**
+     * @param inputChannelCount channel count of the input port
+     * @param format format of the data returned by read()
+     */
+    SinkFused(int32_t inputChannelCount, Format format);
+
+    /**
+     * Append the processing of a node that would be connected in front of this sink.
+     * Nodes must be fused in order from upstream to downstream.
+     * The input of the node must have the same channel count as the current output.
+     *
+     * Call this before data is read.
+     *
+     * @param node node to fuse, which must stay allocated if it is a RampLinear
+     * @return true if fused, false if the node does not support fusion
+     */
+    bool fuse(FlowGraphNode &node);
+
+    /**
+     * @return channel count of the data returned by read()
+     */
+    int32_t getOutputChannelCount() const {
+        return static_cast<int32_t>(mChannelMap.size());
+    }
+
+    int32_t read(void *data, int32_t numFrames) override;
+
+    void setFramesPerBuffer(int32_t framesPerBuffer) override;
+
+    const char *getName() override {
+        return "SinkFused";
+    }
+
+private:
+    struct Operation {
+        FusedStage::Type type;
+        RampLinear *ramp = nullptr;
+        float       minimum = 0.0f;
+        float       maximum = 0.0f;
+        std::vector<float> lastValidOutputs; // one per output channel, for Limit
+        float      *levels = nullptr;       // one per frame, for Gain
+    };
+
+    template <typename T, typename Encoder>
+    T *convertFrames(const float *input, T *output, int32_t numFrames, Encoder encode);
+
+    inline float applyOperations(float sample, int32_t frameIndex, int32_t channel);
+
+    void allocateLevels();
+
+    void allocateLastValidOutputs();
+
+    const Format           mFormat;
+    std::vector<int32_t>   mChannelMap; // input channel for each output channel
+    std::vector<Operation> mOperations;
+    std::vector<float>     mLevels;     // storage for Gain levels
+};
+
+} /* namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph */
+
+#endif //FLOWGRAPH_SINK_FUSED_H
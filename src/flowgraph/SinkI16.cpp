@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <unistd.h>
 
+#include "PcmConversion.h"
 #include "SinkI16.h"
 
 #if FLOWGRAPH_ANDROID_INTERNAL
@@ -46,10 +47,8 @@ int32_t SinkI16::read(void *data, int32_t numFrames) {
         shortData += numSamples;
         signal += numSamples;
 #else
-        for (int i = 0; i < numSamples; i++) {
-            int32_t n = (int32_t) (*signal++ * 32768.0f);
-            *shortData++ = std::min(INT16_MAX, std::max(INT16_MIN, n)); // clip
-        }
+        PcmConversion::convertFloatToI16(signal, shortData, numSamples);
+        shortData += numSamples;
 #endif
         framesLeft -= framesRead;
     }
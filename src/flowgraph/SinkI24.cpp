@@ -19,6 +19,7 @@
 
 
 #include "FlowGraphNode.h"
+#include "PcmConversion.h"
 #include "SinkI24.h"
 
 #if FLOWGRAPH_ANDROID_INTERNAL
@@ -49,16 +50,8 @@ int32_t SinkI24::read(void *data, int32_t numFrames) {
         byteData += numSamples * kBytesPerI24Packed;
         floatData += numSamples;
 #else
-        const int32_t kI24PackedMax = 0x007FFFFF;
-        const int32_t kI24PackedMin = 0xFF800000;
-        for (int i = 0; i < numSamples; i++) {
-            int32_t n = (int32_t) (*floatData++ * 0x00800000);
-            n = std::min(kI24PackedMax, std::max(kI24PackedMin, n)); // clip
-            // Write as a packed 24-bit integer in Little Endian format.
-            *byteData++ = (uint8_t) n;
-            *byteData++ = (uint8_t) (n >> 8);
-            *byteData++ = (uint8_t) (n >> 16);
-        }
+        PcmConversion::convertFloatToP24(floatData, byteData, numSamples);
+        byteData += numSamples * PcmConversion::kBytesPerI24Packed;
 #endif
         framesLeft -= framesRead;
     }
@@ -15,7 +15,7 @@
  */
 
 #include "FlowGraphNode.h"
-#include "FlowgraphUtilities.h"
+#include "PcmConversion.h"
 #include "SinkI8_24.h"
 
 #if FLOWGRAPH_ANDROID_INTERNAL
@@ -45,9 +45,8 @@ int32_t SinkI8_24::read(void *data, int32_t numFrames) {
         intData += numSamples;
         signal += numSamples;
 #else
-        for (int i = 0; i < numSamples; i++) {
-            *intData++ = FlowgraphUtilities::clamp24FromFloat(*signal++);
-        }
+        PcmConversion::convertFloatToQ8_23(signal, intData, numSamples);
+        intData += numSamples;
 #endif
         framesLeft -= framesRead;
     }
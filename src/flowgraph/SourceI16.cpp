@@ -18,6 +18,7 @@
 #include <unistd.h>
 
 #include "FlowGraphNode.h"
+#include "PcmConversion.h"
 #include "SourceI16.h"
 
 #if FLOWGRAPH_ANDROID_INTERNAL
@@ -44,9 +45,7 @@ int32_t SourceI16::onProcess(int32_t numFrames) {
 #if FLOWGRAPH_ANDROID_INTERNAL
     memcpy_to_float_from_i16(floatData, shortData, numSamples);
 #else
-    for (int i = 0; i < numSamples; i++) {
-        *floatData++ = *shortData++ * (1.0f / 32768);
-    }
+    PcmConversion::convertI16ToFloat(shortData, floatData, numSamples);
 #endif
 
     mFrameIndex += framesToProcess;
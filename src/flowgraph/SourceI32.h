@@ -33,8 +33,6 @@ public:
     const char *getName() override {
         return "SourceI32";
     }
-private:
-    static constexpr float kScale = 1.0 / (1UL << 31);
 };
 
 } /* namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph */
@@ -18,6 +18,7 @@
 #include <unistd.h>
 
 #include "FlowGraphNode.h"
+#include "PcmConversion.h"
 #include "SourceI8_24.h"
 
 #if FLOWGRAPH_ANDROID_INTERNAL
@@ -44,9 +45,7 @@ int32_t SourceI8_24::onProcess(int32_t numFrames) {
 #if FLOWGRAPH_ANDROID_INTERNAL
     memcpy_to_float_from_q8_23(floatData, intData, numSamples);
 #else
-    for (int i = 0; i < numSamples; i++) {
-        *floatData++ = *intData++ * kScale;
-    }
+    PcmConversion::convertQ8_23ToFloat(intData, floatData, numSamples);
 #endif
 
     mFrameIndex += framesToProcess;
@@ -0,0 +1,231 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>   // Do NOT delete. Needed for LLVM. See #1746
+#include <cassert>
+#include <cstring>
+#include <numeric>
+
+#include "CascadedResampler.h"
+#include "IntegerInterpolator.h"
+#include "IntegerRatio.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+CascadedResampler::CascadedResampler(const MultiChannelResampler::Builder &builder)
+        : MultiChannelResampler(builder) {
+    const std::vector<int32_t> rates = planStages(builder);
+    assert(rates.size() >= 3);
+    const size_t samplesPerBlock = static_cast<size_t>(kFramesPerStageBlock)
+            * static_cast<size_t>(getChannelCount());
+    mStages.resize(rates.size() - 1);
+    for (size_t i = 0; i < mStages.size(); i++) {
+        MultiChannelResampler::Builder stageBuilder = builder;
+        stageBuilder.setInputRate(rates[i])->setOutputRate(rates[i + 1]);
+        if ((rates[i + 1] % rates[i]) == 0) {
+            mStages[i].resampler = std::make_unique<IntegerInterpolator>(stageBuilder);
+        } else {
+            mStages[i].resampler.reset(stageBuilder.buildSingleStage());
+        }
+        mStages[i].output.resize(samplesPerBlock);
+
+        // The stage input at frame n of the cascade is at n * rates[i] / rates[0].
+        // That has to be a multiple of the stage cycle.
+        const int64_t stageCycle = static_cast<int64_t>(rates[0])
+                * mStages[i].resampler->getInputFramesPerCycle();
+        const int64_t framesPerCycle = stageCycle / std::gcd(stageCycle,
+                                                             static_cast<int64_t>(rates[i]));
+        mInputFramesPerCycle = static_cast<int32_t>(std::lcm(
+                static_cast<int64_t>(mInputFramesPerCycle), framesPerCycle));
+    }
+
+    // Each stage can hold back up to a block of frames so the queue has to cover
+    // that delay plus the frames that can be written between two reads.
+    const int32_t framesPerRead = (mNumerator + mDenominator - 1) / mDenominator;
+    const int32_t capacityFrames = (framesPerRead + 1) * kFramesPerStageBlock
+            * static_cast<int32_t>(mStages.size());
+    mInputQueue.resize(static_cast<size_t>(capacityFrames)
+                       * static_cast<size_t>(getChannelCount()));
+}
+
+bool CascadedResampler::isPolyphaseSupported(int32_t numTaps, int32_t inputRate,
+                                             int32_t outputRate) {
+    IntegerRatio ratio(inputRate, outputRate);
+    ratio.reduce();
+    return (numTaps * ratio.getDenominator()) <= kMaxCoefficients;
+}
+
+std::vector<int32_t> CascadedResampler::planStages(const MultiChannelResampler::Builder &builder) {
+    std::vector<int32_t> rates;
+    const int32_t inputRate = builder.getInputRate();
+    const int32_t outputRate = builder.getOutputRate();
+    // The linear resampler is already cheap and does not filter.
+    // If a single polyphase stage is possible then it uses the least CPU.
+    if (builder.getNumTaps() <= 2
+            || isPolyphaseSupported(builder.getNumTaps(), inputRate, outputRate)) {
+        return rates;
+    }
+
+    // Dividing the input rate can only make the reduced output side larger,
+    // so the cascade does not help when downsampling.
+    if (outputRate <= inputRate) {
+        return rates;
+    }
+
+    // Use the largest integer factor that leaves a fractional stage that fits in
+    // a polyphase table. That runs the fractional stage at the lowest rate.
+    const int32_t maxFactor = std::min(outputRate / inputRate, kMaxIntegerFactor);
+    for (int32_t factor = maxFactor; factor >= 2; factor--) {
+        const int32_t middleRate = outputRate / factor;
+        if ((outputRate % factor) == 0
+                && isPolyphaseSupported(builder.getNumTaps(), inputRate, middleRate)) {
+            // The middle rate is not the input rate because then a single
+            // polyphase stage would have been used above.
+            rates = {inputRate, middleRate, outputRate};
+            break;
+        }
+    }
+    return rates;
+}
+
+void CascadedResampler::writeFrames(const float *frames, int32_t numFrames) {
+    const int32_t channelCount = getChannelCount();
+    int32_t capacityFrames = static_cast<int32_t>(mInputQueue.size()) / channelCount;
+    if (mInputCursor >= mNumInputFrames) {
+        mInputCursor = mNumInputFrames = 0; // empty
+    } else if (mNumInputFrames + numFrames > capacityFrames) {
+        // Move the unread frames to the front.
+        const int32_t framesLeft = mNumInputFrames - mInputCursor;
+        memmove(mInputQueue.data(), &mInputQueue[mInputCursor * channelCount],
+                framesLeft * channelCount * sizeof(float));
+        mInputCursor = 0;
+        mNumInputFrames = framesLeft;
+    }
+    while (mNumInputFrames + numFrames > capacityFrames) {
+        mInputQueue.resize(mInputQueue.size() * 2); // should not happen
+        capacityFrames *= 2;
+    }
+    memcpy(&mInputQueue[mNumInputFrames * channelCount], frames,
+           numFrames * channelCount * sizeof(float));
+    mNumInputFrames += numFrames;
+}
+
+int32_t CascadedResampler::getInputFramesPerCycle() const {
+    return mInputFramesPerCycle;
+}
+
+void CascadedResampler::writeFrame(const float *frame) {
+    writeFrames(frame, 1);
+}
+
+bool CascadedResampler::pullStage(int32_t index) {
+    const int32_t channelCount = getChannelCount();
+    Stage &stage = mStages[index];
+    while (stage.outputCursor >= stage.numOutputFrames) {
+        const float *input;
+        int32_t *inputCursor;
+        int32_t numInputFrames;
+        if (index == 0) {
+            input = mInputQueue.data();
+            inputCursor = &mInputCursor;
+            numInputFrames = mNumInputFrames;
+        } else {
+            Stage &previous = mStages[index - 1];
+            input = previous.output.data();
+            inputCursor = &previous.outputCursor;
+            numInputFrames = previous.numOutputFrames;
+        }
+        ProcessResult result = stage.resampler->process(&input[*inputCursor * channelCount],
+                                                        numInputFrames - *inputCursor,
+                                                        stage.output.data(),
+                                                        kFramesPerStageBlock);
+        *inputCursor += result.framesConsumed;
+        stage.outputCursor = 0;
+        stage.numOutputFrames = result.framesProduced;
+        if (result.framesProduced == 0) {
+            // The stage has used all of its input so get more from upstream.
+            if (index == 0 || !pullStage(index - 1)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void CascadedResampler::readFrames(float *frames, int32_t numFrames) {
+    const int32_t lastIndex = getNumStages() - 1;
+    const int32_t channelCount = getChannelCount();
+    Stage &stage = mStages[lastIndex];
+    while (numFrames > 0) {
+        // The ratio of each stage is exact so the overall phase only asks for a frame
+        // after enough input has been written to produce it.
+        bool isAvailable = pullStage(lastIndex);
+        assert(isAvailable);
+        if (!isAvailable) {
+            // Output silence rather than spin on the audio thread.
+            memset(frames, 0, numFrames * channelCount * sizeof(float));
+            break;
+        }
+        const int32_t framesToCopy = std::min(numFrames,
+                                              stage.numOutputFrames - stage.outputCursor);
+        memcpy(frames, &stage.output[stage.outputCursor * channelCount],
+               framesToCopy * channelCount * sizeof(float));
+        stage.outputCursor += framesToCopy;
+        frames += framesToCopy * channelCount;
+        numFrames -= framesToCopy;
+    }
+}
+
+void CascadedResampler::readFrame(float *frame) {
+    readFrames(frame, 1);
+}
+
+MultiChannelResampler::ProcessResult CascadedResampler::process(const float *input,
+        int32_t numInputFrames, float *output, int32_t outputCapacity) {
+    const int32_t channelCount = getChannelCount();
+    // Limit the frames queued at once so the queue does not have to grow.
+    const int32_t maxFramesPerChunk = kFramesPerStageBlock;
+    ProcessResult result;
+    while (true) {
+        // Step the phase with the same rules as processFrames() so the result is the same
+        // as the frame API. Then move the frames in blocks.
+        int32_t framesToWrite = 0;
+        int32_t framesToRead = 0;
+        const int32_t writeLimit = std::min(numInputFrames - result.framesConsumed,
+                                            maxFramesPerChunk);
+        const int32_t readLimit = outputCapacity - result.framesProduced;
+        while (true) {
+            if (isWriteNeeded()) {
+                if (framesToWrite >= writeLimit) break;
+                advanceWrite();
+                framesToWrite++;
+            } else {
+                if (framesToRead >= readLimit) break;
+                advanceRead();
+                framesToRead++;
+            }
+        }
+        if (framesToWrite == 0 && framesToRead == 0) {
+            break;
+        }
+        // All of the frames are written before any are read. That is safe because
+        // each output frame only depends on input that was written before it.
+        writeFrames(&input[result.framesConsumed * channelCount], framesToWrite);
+        readFrames(&output[result.framesProduced * channelCount], framesToRead);
+        result.framesConsumed += framesToWrite;
+        result.framesProduced += framesToRead;
+    }
+    return result;
+}
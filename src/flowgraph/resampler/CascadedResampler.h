@@ -0,0 +1,122 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef RESAMPLER_CASCADED_RESAMPLER_H
+#define RESAMPLER_CASCADED_RESAMPLER_H
+
+#include <memory>
+#include <vector>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "MultiChannelResampler.h"
+#include "ResamplerDefinitions.h"
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+
+/**
+ * Resampler that converts in two stages.
+ *
+ * Some ratios, like 11025 => 48000, need too many coefficients for a PolyphaseResampler
+ * so a single stage would use the slower SincResampler.
+ * This splits the ratio into one fractional stage that is small enough for a
+ * PolyphaseResampler, and one stage that changes the rate by an integer factor.
+ * For example 11025 => 48000 becomes 11025 => 12000 => 48000.
+ *
+ * The fractional stage runs first, at the lowest rate, and an IntegerInterpolator
+ * then multiplies the rate. This is only used for upsampling because dividing the
+ * input rate cannot make the fractional stage smaller.
+ * The delay is a little longer than a single stage because it is the sum of both filters.
+ *
+ * Builder::build() selects this automatically.
+ */
+class CascadedResampler : public MultiChannelResampler {
+public:
+    explicit CascadedResampler(const MultiChannelResampler::Builder &builder);
+
+    virtual ~CascadedResampler() = default;
+
+    /**
+     * Decide whether to use a CascadedResampler.
+     *
+     * @return the rates at the input and output of each stage, starting with the input rate
+     *         and ending with the output rate, or empty if a single stage should be used
+     */
+    static std::vector<int32_t> planStages(const MultiChannelResampler::Builder &builder);
+
+    int32_t getNumStages() const {
+        return static_cast<int32_t>(mStages.size());
+    }
+
+    /**
+     * @param index of a stage, starting at the input
+     * @return the resampler for that stage
+     */
+    MultiChannelResampler *getStage(int32_t index) const {
+        return mStages[index].resampler.get();
+    }
+
+    /**
+     * Every stage has to be at the start of its cycle.
+     */
+    int32_t getInputFramesPerCycle() const override;
+
+    void writeFrame(const float *frame) override;
+
+    void readFrame(float *frame) override;
+
+    ProcessResult process(const float *input, int32_t numInputFrames,
+                          float *output, int32_t outputCapacity) override;
+
+private:
+
+    struct Stage {
+        std::unique_ptr<MultiChannelResampler> resampler;
+        std::vector<float> output;
+        int32_t            outputCursor = 0;
+        int32_t            numOutputFrames = 0;
+    };
+
+    static bool isPolyphaseSupported(int32_t numTaps, int32_t inputRate, int32_t outputRate);
+
+    // Append frames to the input of the first stage.
+    void writeFrames(const float *frames, int32_t numFrames);
+
+    // Copy frames from the output of the last stage.
+    void readFrames(float *frames, int32_t numFrames);
+
+    // Make sure that the output of a stage has at least one frame.
+    // Each stage processes a block at a time so the virtual calls are not made per frame.
+    // @return false if there is not enough input
+    bool pullStage(int32_t index);
+
+    // Frames per stage output buffer.
+    static constexpr int32_t kFramesPerStageBlock = 64;
+
+    // The largest integer factor that is tried when planning the stages.
+    static constexpr int32_t kMaxIntegerFactor = 16;
+
+    std::vector<Stage> mStages;
+
+    // Frames that were written but not yet consumed by the first stage.
+    std::vector<float> mInputQueue;
+    int32_t            mInputCursor = 0;
+    int32_t            mNumInputFrames = 0;
+    int32_t            mInputFramesPerCycle = 1;
+};
+
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
+
+#endif //RESAMPLER_CASCADED_RESAMPLER_H
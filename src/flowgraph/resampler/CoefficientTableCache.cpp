@@ -0,0 +1,59 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CoefficientTableCache.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+CoefficientTableCache &CoefficientTableCache::getInstance() {
+    static CoefficientTableCache sInstance;
+    return sInstance;
+}
+
+std::shared_ptr<const CoefficientTableCache::Table> CoefficientTableCache::getTable(
+        const CoefficientTableKey &key,
+        const Generator &generator) {
+    std::lock_guard<std::mutex> lock(mLock);
+    auto it = mTables.find(key);
+    if (it != mTables.end()) {
+        std::shared_ptr<const Table> table = it->second.lock();
+        if (table) {
+            return table;
+        }
+    }
+    // Generate while holding the lock so that two threads do not build the same table.
+    auto table = std::make_shared<Table>();
+    generator(*table);
+    removeExpiredTables();
+    mTables[key] = table;
+    return table;
+}
+
+int32_t CoefficientTableCache::getNumTables() {
+    std::lock_guard<std::mutex> lock(mLock);
+    removeExpiredTables();
+    return static_cast<int32_t>(mTables.size());
+}
+
+void CoefficientTableCache::removeExpiredTables() {
+    for (auto it = mTables.begin(); it != mTables.end(); ) {
+        if (it->second.expired()) {
+            it = mTables.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
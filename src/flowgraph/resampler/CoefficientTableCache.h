@@ -0,0 +1,93 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESAMPLER_COEFFICIENT_TABLE_CACHE_H
+#define RESAMPLER_COEFFICIENT_TABLE_CACHE_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sys/types.h>
+#include <tuple>
+#include <vector>
+
+#include "ResamplerDefinitions.h"
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+
+/**
+ * Parameters that completely determine the contents of a coefficient table.
+ */
+struct CoefficientTableKey {
+    int32_t numTaps = 0;
+    int32_t numRows = 0;
+    int32_t inputRate = 0;  // reduced, eg. 147 for 44100 => 48000
+    int32_t outputRate = 0; // reduced, eg. 160 for 44100 => 48000
+    double  phaseIncrement = 0.0;
+    float   normalizedCutoff = 0.0f;
+    int32_t window = 0;     // which window function was used
+
+    bool operator<(const CoefficientTableKey &other) const {
+        return std::tie(numTaps, numRows, inputRate, outputRate,
+                        phaseIncrement, normalizedCutoff, window)
+                < std::tie(other.numTaps, other.numRows, other.inputRate, other.outputRate,
+                           other.phaseIncrement, other.normalizedCutoff, other.window);
+    }
+};
+
+/**
+ * Process-wide cache of immutable filter coefficient tables.
+ *
+ * Resamplers with the same parameters share one table.
+ * The cache only holds weak references so a table is freed
+ * when the last resampler using it is deleted.
+ *
+ * This is thread safe. But it locks a mutex so do not call it from an audio callback.
+ */
+class CoefficientTableCache {
+public:
+    using Table = std::vector<float>;
+    using Generator = std::function<void(Table &table)>;
+
+    static CoefficientTableCache &getInstance();
+
+    /**
+     * Return a table matching the key. If there is no live table then
+     * a new one is filled in by calling the generator.
+     *
+     * @param key parameters of the table
+     * @param generator called with an empty table if the table is not in the cache
+     * @return shared table
+     */
+    std::shared_ptr<const Table> getTable(const CoefficientTableKey &key,
+                                          const Generator &generator);
+
+    /**
+     * @return number of tables currently in use
+     */
+    int32_t getNumTables();
+
+private:
+    void removeExpiredTables();
+
+    std::mutex mLock;
+    std::map<CoefficientTableKey, std::weak_ptr<const Table>> mTables;
+};
+
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
+
+#endif //RESAMPLER_COEFFICIENT_TABLE_CACHE_H
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESAMPLER_FIXED_CHANNEL_KERNELS_H
+#define RESAMPLER_FIXED_CHANNEL_KERNELS_H
+
+#include <cstring>
+#include <sys/types.h>
+
+#include "ResamplerDefinitions.h"
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+
+/**
+ * FIR loops for a channel count that is known at compile time.
+ *
+ * The sums for a frame are held in 4 and 2 lane vectors so the compiler can keep them
+ * in registers and vectorize across channels in a single pass over the taps.
+ * This uses the GCC/Clang vector extensions so it works with SSE and NEON.
+ * Each channel is summed in tap order, like the scalar ResamplerKernels.
+ */
+template <int32_t kChannelCount>
+struct FixedChannelKernels {
+
+    /**
+     * Move the cursor back and write the frame twice so the FIR never has to wrap.
+     */
+    static inline void writeFrame(float *x, int32_t numTaps, int32_t *cursor,
+                                  const float *frame) {
+        if (--*cursor < 0) {
+            *cursor = numTaps - 1;
+        }
+        float *dest = &x[*cursor * kChannelCount];
+        float *destCopy = dest + (numTaps * kChannelCount);
+        for (int32_t channel = 0; channel < kChannelCount; channel++) {
+            dest[channel] = destCopy[channel] = frame[channel];
+        }
+    }
+
+    static inline void dot(const float *x, const float *coefficients, int32_t numTaps,
+                           float *output) {
+        Accumulator sum;
+        for (int32_t tap = 0; tap < numTaps; tap++) {
+            sum.add(&x[tap * kChannelCount], coefficients[tap]);
+        }
+        sum.store(output);
+    }
+
+    /**
+     * Apply two rows of coefficients and interpolate between the results.
+     */
+    static inline void dotInterpolated(const float *x, const float *coefficients1,
+                                       const float *coefficients2, int32_t numTaps,
+                                       float fraction, float *output) {
+        Accumulator sum1;
+        Accumulator sum2;
+        for (int32_t tap = 0; tap < numTaps; tap++) {
+            const float *xFrame = &x[tap * kChannelCount];
+            sum1.add(xFrame, coefficients1[tap]);
+            sum2.add(xFrame, coefficients2[tap]);
+        }
+        float low[kChannelCount];
+        float high[kChannelCount];
+        sum1.store(low);
+        sum2.store(high);
+        for (int32_t channel = 0; channel < kChannelCount; channel++) {
+            output[channel] = low[channel] + (fraction * (high[channel] - low[channel]));
+        }
+    }
+
+private:
+    typedef float Float4 __attribute__((vector_size(16)));
+    typedef float Float2 __attribute__((vector_size(8)));
+
+    static constexpr int32_t kNumVectors = kChannelCount / 4;
+    static constexpr bool kHasPair = (kChannelCount % 4) >= 2;
+    static constexpr bool kHasSingle = (kChannelCount % 2) == 1;
+
+    // Sums for one frame, held in vector registers.
+    struct Accumulator {
+        Float4 vectors[kNumVectors > 0 ? kNumVectors : 1] = {};
+        Float2 pair = {};
+        float  single = 0.0f;
+
+        inline void add(const float *xFrame, float coefficient) {
+            for (int32_t i = 0; i < kNumVectors; i++) {
+                Float4 samples;
+                memcpy(&samples, &xFrame[i * 4], sizeof(samples)); // unaligned load
+                vectors[i] += samples * coefficient;
+            }
+            if constexpr (kHasPair) {
+                Float2 samples;
+                memcpy(&samples, &xFrame[kNumVectors * 4], sizeof(samples));
+                pair += samples * coefficient;
+            }
+            if constexpr (kHasSingle) {
+                single += xFrame[kChannelCount - 1] * coefficient;
+            }
+        }
+
+        inline void store(float *output) const {
+            for (int32_t i = 0; i < kNumVectors; i++) {
+                memcpy(&output[i * 4], &vectors[i], sizeof(Float4));
+            }
+            if constexpr (kHasPair) {
+                memcpy(&output[kNumVectors * 4], &pair, sizeof(Float2));
+            }
+            if constexpr (kHasSingle) {
+                output[kChannelCount - 1] = single;
+            }
+        }
+    };
+};
+
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
+
+#endif //RESAMPLER_FIXED_CHANNEL_KERNELS_H
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cassert>
+#include "FixedChannelKernels.h"
+#include "IntegerInterpolator.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+IntegerInterpolator::IntegerInterpolator(const MultiChannelResampler::Builder &builder)
+        : PolyphaseResampler(builder) {
+    assert(mNumerator == 1); // the ratio is reduced so the input rate divides the output rate
+}
+
+void IntegerInterpolator::readFrame(float *frame) {
+    const int32_t channelCount = getChannelCount();
+    const float *xFrame = &mX[static_cast<size_t>(mCursor) * static_cast<size_t>(channelCount)];
+    if (mCoefficientCursor == 0) {
+        // The center tap is the only non-zero coefficient.
+        const float *center = &xFrame[(mNumTaps / 2) * channelCount];
+        for (int channel = 0; channel < channelCount; channel++) {
+            frame[channel] = center[channel];
+        }
+    } else {
+        const float *coefficients = &mCoefficients[mCoefficientCursor];
+        // Use the same kernels as the single stage resamplers for each channel count.
+        const bool isScalar = (mKernels.type == ResamplerKernels::Type::Scalar);
+        if (channelCount == 1) {
+            frame[0] = mKernels.dotMono(xFrame, coefficients, mNumTaps);
+        } else if (channelCount == 2) {
+            mKernels.dotStereo(xFrame, coefficients, mNumTaps, frame);
+        } else if (channelCount == 4 && !isScalar) {
+            FixedChannelKernels<4>::dot(xFrame, coefficients, mNumTaps, frame);
+        } else if (channelCount == 6 && !isScalar) {
+            FixedChannelKernels<6>::dot(xFrame, coefficients, mNumTaps, frame);
+        } else if (channelCount == 8 && !isScalar) {
+            FixedChannelKernels<8>::dot(xFrame, coefficients, mNumTaps, frame);
+        } else {
+            mKernels.dotMulti(xFrame, coefficients, mNumTaps, channelCount, frame);
+        }
+    }
+
+    // Advance and wrap through coefficients.
+    mCoefficientCursor += mNumTaps;
+    if (mCoefficientCursor >= mNumCoefficients) {
+        mCoefficientCursor = 0;
+    }
+}
+
+MultiChannelResampler::ProcessResult IntegerInterpolator::process(const float *input,
+        int32_t numInputFrames, float *output, int32_t outputCapacity) {
+    return processFrames(this, input, numInputFrames, output, outputCapacity);
+}
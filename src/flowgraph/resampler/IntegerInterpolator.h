@@ -0,0 +1,51 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESAMPLER_INTEGER_INTERPOLATOR_H
+#define RESAMPLER_INTEGER_INTERPOLATOR_H
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "PolyphaseResampler.h"
+#include "ResamplerDefinitions.h"
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+
+/**
+ * PolyphaseResampler for an output rate that is an integer multiple of the input rate.
+ *
+ * The first row of coefficients is an impulse because the sinc is not stretched when
+ * upsampling. So every Nth output frame is just a delayed copy of an input frame
+ * and the FIR is only run for the other frames.
+ *
+ * This is used as a stage of a CascadedResampler.
+ */
+class IntegerInterpolator : public PolyphaseResampler {
+public:
+    explicit IntegerInterpolator(const MultiChannelResampler::Builder &builder);
+
+    virtual ~IntegerInterpolator() = default;
+
+    void readFrame(float *frame) override;
+
+    ProcessResult process(const float *input, int32_t numInputFrames,
+                          float *output, int32_t outputCapacity) override;
+};
+
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
+
+#endif //RESAMPLER_INTEGER_INTERPOLATOR_H
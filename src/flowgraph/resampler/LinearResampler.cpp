@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <cstring>
+
 #include "LinearResampler.h"
 
 using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
@@ -40,3 +42,8 @@ void LinearResampler::readFrame(float *frame) {
         *frame++ = f0 + (phase * (f1 - f0));
     }
 }
+
+MultiChannelResampler::ProcessResult LinearResampler::process(const float *input,
+        int32_t numInputFrames, float *output, int32_t outputCapacity) {
+    return processFrames(this, input, numInputFrames, output, outputCapacity);
+}
@@ -16,13 +16,16 @@
 
 #include <math.h>
 
+#include "CascadedResampler.h"
 #include "IntegerRatio.h"
 #include "LinearResampler.h"
 #include "MultiChannelResampler.h"
 #include "PolyphaseResampler.h"
+#include "PolyphaseResamplerChannels.h"
 #include "PolyphaseResamplerMono.h"
 #include "PolyphaseResamplerStereo.h"
 #include "SincResampler.h"
+#include "SincResamplerChannels.h"
 #include "SincResamplerStereo.h"
 
 using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
@@ -32,6 +35,7 @@ MultiChannelResampler::MultiChannelResampler(const MultiChannelResampler::Builde
         , mX(static_cast<size_t>(builder.getChannelCount())
                 * static_cast<size_t>(builder.getNumTaps()) * 2)
         , mSingleFrame(builder.getChannelCount())
+        , mKernels(ResamplerKernels::select(builder.isSimdEnabled()))
         , mChannelCount(builder.getChannelCount())
         {
     // Reduce sample rates to the smallest ratio.
@@ -80,6 +84,14 @@ MultiChannelResampler *MultiChannelResampler::make(int32_t channelCount,
 }
 
 MultiChannelResampler *MultiChannelResampler::Builder::build() {
+    // Use several stages if a single stage would need the slower sinc resampler.
+    if (!CascadedResampler::planStages(*this).empty()) {
+        return new CascadedResampler(*this);
+    }
+    return buildSingleStage();
+}
+
+MultiChannelResampler *MultiChannelResampler::Builder::buildSingleStage() {
     if (getNumTaps() == 2) {
         // Note that this does not do low pass filteringh.
         return new LinearResampler(*this);
@@ -87,21 +99,25 @@ MultiChannelResampler *MultiChannelResampler::Builder::build() {
     IntegerRatio ratio(getInputRate(), getOutputRate());
     ratio.reduce();
     bool usePolyphase = (getNumTaps() * ratio.getDenominator()) <= kMaxCoefficients;
+    // Common channel counts have a resampler with the channel loops unrolled.
     if (usePolyphase) {
-        if (getChannelCount() == 1) {
-            return new PolyphaseResamplerMono(*this);
-        } else if (getChannelCount() == 2) {
-            return new PolyphaseResamplerStereo(*this);
-        } else {
-            return new PolyphaseResampler(*this);
+        switch (getChannelCount()) {
+            case 1: return new PolyphaseResamplerMono(*this);
+            case 2: return new PolyphaseResamplerStereo(*this);
+            case 4: return new PolyphaseResamplerChannels<4>(*this);
+            case 6: return new PolyphaseResamplerChannels<6>(*this);
+            case 8: return new PolyphaseResamplerChannels<8>(*this);
+            default: return new PolyphaseResampler(*this);
         }
     } else {
         // Use less optimized resampler that uses a float phaseIncrement.
-        // TODO mono resampler
-        if (getChannelCount() == 2) {
-            return new SincResamplerStereo(*this);
-        } else {
-            return new SincResampler(*this);
+        switch (getChannelCount()) {
+            case 1: return new SincResamplerChannels<1>(*this);
+            case 2: return new SincResamplerStereo(*this);
+            case 4: return new SincResamplerChannels<4>(*this);
+            case 6: return new SincResamplerChannels<6>(*this);
+            case 8: return new SincResamplerChannels<8>(*this);
+            default: return new SincResampler(*this);
         }
     }
 }
@@ -119,19 +135,66 @@ void MultiChannelResampler::writeFrame(const float *frame) {
     }
 }
 
+// Generic version that uses virtual calls per frame.
+// The built-in resamplers override this with processFrames().
+MultiChannelResampler::ProcessResult MultiChannelResampler::process(const float *input,
+        int32_t numInputFrames, float *output, int32_t outputCapacity) {
+    ProcessResult result;
+    while (true) {
+        if (isWriteNeeded()) {
+            if (result.framesConsumed >= numInputFrames) break;
+            writeNextFrame(input);
+            input += getChannelCount();
+            result.framesConsumed++;
+        } else {
+            if (result.framesProduced >= outputCapacity) break;
+            readNextFrame(output);
+            output += getChannelCount();
+            result.framesProduced++;
+        }
+    }
+    return result;
+}
+
 float MultiChannelResampler::sinc(float radians) {
     if (fabsf(radians) < 1.0e-9f) return 1.0f;   // avoid divide by zero
     return sinf(radians) / radians;   // Sinc function
 }
 
-// Generate coefficients in the order they will be used by readFrame().
-// This is more complicated but readFrame() is called repeatedly and should be optimized.
 void MultiChannelResampler::generateCoefficients(int32_t inputRate,
                                               int32_t outputRate,
                                               int32_t numRows,
                                               double phaseIncrement,
                                               float normalizedCutoff) {
-    mCoefficients.resize(static_cast<size_t>(getNumTaps()) * static_cast<size_t>(numRows));
+    // The table only depends on the ratio so 44100 => 48000 can share with 88200 => 96000.
+    IntegerRatio ratio(inputRate, outputRate);
+    ratio.reduce();
+    CoefficientTableKey key;
+    key.numTaps = getNumTaps();
+    key.numRows = numRows;
+    key.inputRate = ratio.getNumerator();
+    key.outputRate = ratio.getDenominator();
+    key.phaseIncrement = phaseIncrement;
+    key.normalizedCutoff = (key.outputRate < key.inputRate) ? normalizedCutoff : 0.0f;
+    key.window = MCR_USE_KAISER;
+    mCoefficientTable = CoefficientTableCache::getInstance().getTable(key,
+            [&](std::vector<float> &coefficients) {
+                calculateCoefficients(coefficients, key.inputRate, key.outputRate,
+                                      numRows, phaseIncrement, normalizedCutoff);
+            });
+    mCoefficients = mCoefficientTable->data();
+    mNumCoefficients = static_cast<int32_t>(mCoefficientTable->size());
+}
+
+// Generate coefficients in the order they will be used by readFrame().
+// This is more complicated but readFrame() is called repeatedly and should be optimized.
+void MultiChannelResampler::calculateCoefficients(std::vector<float> &coefficients,
+                                                  int32_t inputRate,
+                                                  int32_t outputRate,
+                                                  int32_t numRows,
+                                                  double phaseIncrement,
+                                                  float normalizedCutoff) {
+    coefficients.resize(static_cast<size_t>(getNumTaps()) * static_cast<size_t>(numRows));
     int coefficientIndex = 0;
     double phase = 0.0; // ranges from 0.0 to 1.0, fraction between samples
     // Stretch the sinc function for low pass filtering.
@@ -153,7 +216,7 @@ void MultiChannelResampler::generateCoefficients(int32_t inputRate,
             float window = mCoshWindow(static_cast<double>(tapPhase) * numTapsHalfInverse);
 #endif
             float coefficient = sinc(radians * cutoffScaler) * window;
-            mCoefficients.at(coefficientIndex++) = coefficient;
+            coefficients.at(coefficientIndex++) = coefficient;
             gain += coefficient;
             tapPhase += 1.0;
         }
@@ -165,7 +228,7 @@ void MultiChannelResampler::generateCoefficients(int32_t inputRate,
         // Correct for gain variations.
         float gainCorrection = 1.0 / gain; // normalize the gain
         for (int tap = 0; tap < getNumTaps(); tap++) {
-            mCoefficients.at(gainCursor + tap) *= gainCorrection;
+            coefficients.at(gainCursor + tap) *= gainCorrection;
         }
     }
 }
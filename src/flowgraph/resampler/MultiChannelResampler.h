@@ -34,7 +34,9 @@
 #include "HyperbolicCosineWindow.h"
 #endif
 
+#include "CoefficientTableCache.h"
 #include "ResamplerDefinitions.h"
+#include "ResamplerKernels.h"
 
 namespace RESAMPLER_OUTER_NAMESPACE::resampler {
 
@@ -58,6 +60,12 @@ public:
          */
         MultiChannelResampler *build();
 
+        /**
+         * Like build() but never splits the conversion into a CascadedResampler.
+         * @return address of a resampler
+         */
+        MultiChannelResampler *buildSingleStage();
+
         /**
          * The number of taps in the resampling filter.
          * More taps gives better quality but uses more CPU time.
@@ -122,6 +130,20 @@ public:
             return this;
         }
 
+        /**
+         * Use SIMD kernels for the FIR when the CPU supports them. Default is true.
+         *
+         * Set false to use the scalar kernels, which give bit-exact results
+         * across all CPUs.
+         *
+         * @param enabled true to allow SIMD kernels
+         * @return address of this builder for chaining calls
+         */
+        Builder *setSimdEnabled(bool enabled) {
+            mSimdEnabled = enabled;
+            return this;
+        }
+
         int32_t getNumTaps() const {
             return mNumTaps;
         }
@@ -142,12 +164,25 @@ public:
             return mNormalizedCutoff;
         }
 
+        bool isSimdEnabled() const {
+            return mSimdEnabled;
+        }
+
     protected:
         int32_t mChannelCount = 1;
         int32_t mNumTaps = 16;
         int32_t mInputRate = 48000;
         int32_t mOutputRate = 48000;
         float   mNormalizedCutoff = kDefaultNormalizedCutoff;
+        bool    mSimdEnabled = true;
+    };
+
+    /**
+     * Result of a call to process().
+     */
+    struct ProcessResult {
+        int32_t framesConsumed = 0; // number of input frames written to the resampler
+        int32_t framesProduced = 0; // number of output frames read from the resampler
     };
 
     virtual ~MultiChannelResampler() = default;
@@ -190,14 +225,51 @@ public:
         advanceRead();
     }
 
+    /**
+     * Convert a block of interleaved frames.
+     *
+     * This is equivalent to calling writeNextFrame() and readNextFrame() in a loop
+     * controlled by isWriteNeeded(). But it avoids a virtual call per frame.
+     * It stops when it needs to write a frame but the input is used up,
+     * or when it needs to read a frame but the output is full.
+     * The phase is preserved between calls so a stream can be converted
+     * using any sequence of block sizes.
+     *
+     * @param input interleaved input frames
+     * @param numInputFrames number of frames available in input
+     * @param output buffer for the interleaved output frames
+     * @param outputCapacity maximum number of frames that can be written to output
+     * @return number of frames consumed and produced
+     */
+    virtual ProcessResult process(const float *input, int32_t numInputFrames,
+                                  float *output, int32_t outputCapacity);
+
     int getNumTaps() const {
         return mNumTaps;
     }
 
+    /**
+     * The phase of the resampler repeats after this many input frames.
+     * A new resampler that starts at a multiple of this position produces the same output
+     * as one that started at zero, once its history holds the same input frames.
+     *
+     * @return period in input frames
+     */
+    virtual int32_t getInputFramesPerCycle() const {
+        return mNumerator;
+    }
+
     int getChannelCount() const {
         return mChannelCount;
     }
 
+    /**
+     * @return the type of FIR kernels selected when this resampler was built
+     */
+    ResamplerKernels::Type getKernelType() const {
+        return mKernels.type;
+    }
+
     static float hammingWindow(float radians, float spread);
 
     static float sinc(float radians);
@@ -220,6 +292,37 @@ protected:
      */
     virtual void readFrame(float *frame) = 0;
 
+    /**
+     * Block loop shared by the implementations of process().
+     *
+     * The frame methods are called through the static type Resampler so they can be inlined
+     * when the loop is instantiated in the same file as the frame methods.
+     * So a subclass that overrides writeFrame() or readFrame() must also override process().
+     */
+    template <class Resampler>
+    static ProcessResult processFrames(Resampler *resampler,
+                                       const float *input, int32_t numInputFrames,
+                                       float *output, int32_t outputCapacity) {
+        const int32_t channelCount = resampler->getChannelCount();
+        ProcessResult result;
+        while (true) {
+            if (resampler->isWriteNeeded()) {
+                if (result.framesConsumed >= numInputFrames) break;
+                resampler->Resampler::writeFrame(input);
+                resampler->advanceWrite();
+                input += channelCount;
+                result.framesConsumed++;
+            } else {
+                if (result.framesProduced >= outputCapacity) break;
+                resampler->Resampler::readFrame(output);
+                resampler->advanceRead();
+                output += channelCount;
+                result.framesProduced++;
+            }
+        }
+        return result;
+    }
+
     void advanceWrite() {
         mIntegerPhase -= mDenominator;
     }
@@ -230,6 +333,7 @@ protected:
 
     /**
      * Generate the filter coefficients in optimal order.
+     * Identical tables are shared with other resamplers through the CoefficientTableCache.
      *
      * Note that normalizedCutoff is ignored when upsampling, which is when
      * the outputRate is higher than the inputRate.
@@ -252,7 +356,8 @@ protected:
     }
 
     static constexpr int kMaxCoefficients = 8 * 1024;
-    std::vector<float>   mCoefficients;
+    const float         *mCoefficients = nullptr; // points into mCoefficientTable
+    int32_t              mNumCoefficients = 0;
 
     const int            mNumTaps;
     int                  mCursor = 0;
@@ -261,10 +366,19 @@ protected:
     int32_t              mIntegerPhase = 0;
     int32_t              mNumerator = 0;
     int32_t              mDenominator = 0;
-
+    const ResamplerKernels &mKernels;   // FIR kernels selected by the Builder
 
 private:
 
+    void calculateCoefficients(std::vector<float> &coefficients,
+                               int32_t inputRate,
+                               int32_t outputRate,
+                               int32_t numRows,
+                               double phaseIncrement,
+                               float normalizedCutoff);
+
+    std::shared_ptr<const std::vector<float>> mCoefficientTable;
+
 #if MCR_USE_KAISER
     KaiserWindow           mKaiserWindow;
 #else
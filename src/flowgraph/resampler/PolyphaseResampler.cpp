@@ -38,24 +38,17 @@ PolyphaseResampler::PolyphaseResampler(const MultiChannelResampler::Builder &bui
 }
 
 void PolyphaseResampler::readFrame(float *frame) {
-    // Clear accumulator for mixing.
-    std::fill(mSingleFrame.begin(), mSingleFrame.end(), 0.0);
-
     // Multiply input times windowed sinc function.
-    float *coefficients = &mCoefficients[mCoefficientCursor];
-    float *xFrame = &mX[static_cast<size_t>(mCursor) * static_cast<size_t>(getChannelCount())];
-    for (int i = 0; i < mNumTaps; i++) {
-        float coefficient = *coefficients++;
-        for (int channel = 0; channel < getChannelCount(); channel++) {
-            mSingleFrame[channel] += *xFrame++ * coefficient;
-        }
-    }
+    const float *coefficients = &mCoefficients[mCoefficientCursor];
+    const float *xFrame = &mX[static_cast<size_t>(mCursor)
+                              * static_cast<size_t>(getChannelCount())];
+    mKernels.dotMulti(xFrame, coefficients, mNumTaps, getChannelCount(), frame);
 
     // Advance and wrap through coefficients.
-    mCoefficientCursor = (mCoefficientCursor + mNumTaps) % mCoefficients.size();
+    mCoefficientCursor = (mCoefficientCursor + mNumTaps) % mNumCoefficients;
+}
 
-    // Copy accumulator to output.
-    for (int channel = 0; channel < getChannelCount(); channel++) {
-        frame[channel] = mSingleFrame[channel];
-    }
+MultiChannelResampler::ProcessResult PolyphaseResampler::process(const float *input,
+        int32_t numInputFrames, float *output, int32_t outputCapacity) {
+    return processFrames(this, input, numInputFrames, output, outputCapacity);
 }
@@ -42,6 +42,9 @@ public:
 
     void readFrame(float *frame) override;
 
+    ProcessResult process(const float *input, int32_t numInputFrames,
+                          float *output, int32_t outputCapacity) override;
+
 protected:
 
     int32_t                mCoefficientCursor = 0;
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cassert>
+#include "FixedChannelKernels.h"
+#include "PolyphaseResamplerChannels.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+template <int32_t kChannelCount>
+PolyphaseResamplerChannels<kChannelCount>::PolyphaseResamplerChannels(
+        const MultiChannelResampler::Builder &builder)
+        : PolyphaseResampler(builder) {
+    assert(builder.getChannelCount() == kChannelCount);
+}
+
+template <int32_t kChannelCount>
+void PolyphaseResamplerChannels<kChannelCount>::writeFrame(const float *frame) {
+    FixedChannelKernels<kChannelCount>::writeFrame(mX.data(), mNumTaps, &mCursor, frame);
+}
+
+template <int32_t kChannelCount>
+void PolyphaseResamplerChannels<kChannelCount>::readFrame(float *frame) {
+    // Multiply input times precomputed windowed sinc function.
+    const float *coefficients = &mCoefficients[mCoefficientCursor];
+    const float *xFrame = &mX[static_cast<size_t>(mCursor) * kChannelCount];
+    if (mKernels.type == ResamplerKernels::Type::Scalar) {
+        // Keep the results bit-exact when SIMD is disabled.
+        mKernels.dotMulti(xFrame, coefficients, mNumTaps, kChannelCount, frame);
+    } else {
+        FixedChannelKernels<kChannelCount>::dot(xFrame, coefficients, mNumTaps, frame);
+    }
+
+    mCoefficientCursor = (mCoefficientCursor + mNumTaps) % mNumCoefficients;
+}
+
+template <int32_t kChannelCount>
+MultiChannelResampler::ProcessResult PolyphaseResamplerChannels<kChannelCount>::process(
+        const float *input, int32_t numInputFrames, float *output, int32_t outputCapacity) {
+    return processFrames(this, input, numInputFrames, output, outputCapacity);
+}
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+template class PolyphaseResamplerChannels<4>;
+template class PolyphaseResamplerChannels<6>;
+template class PolyphaseResamplerChannels<8>;
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
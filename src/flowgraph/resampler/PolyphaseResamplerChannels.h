@@ -0,0 +1,56 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESAMPLER_POLYPHASE_RESAMPLER_CHANNELS_H
+#define RESAMPLER_POLYPHASE_RESAMPLER_CHANNELS_H
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "PolyphaseResampler.h"
+#include "ResamplerDefinitions.h"
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+
+/**
+ * PolyphaseResampler for a channel count that is known at compile time.
+ *
+ * It is instantiated for 4, 6 and 8 channels.
+ * Mono and stereo use PolyphaseResamplerMono and PolyphaseResamplerStereo, which run the FIR
+ * across the taps with the SIMD ResamplerKernels.
+ */
+template <int32_t kChannelCount>
+class PolyphaseResamplerChannels : public PolyphaseResampler {
+public:
+    explicit PolyphaseResamplerChannels(const MultiChannelResampler::Builder &builder);
+
+    virtual ~PolyphaseResamplerChannels() = default;
+
+    void writeFrame(const float *frame) override;
+
+    void readFrame(float *frame) override;
+
+    ProcessResult process(const float *input, int32_t numInputFrames,
+                          float *output, int32_t outputCapacity) override;
+};
+
+extern template class PolyphaseResamplerChannels<4>;
+extern template class PolyphaseResamplerChannels<6>;
+extern template class PolyphaseResamplerChannels<8>;
+
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
+
+#endif //RESAMPLER_POLYPHASE_RESAMPLER_CHANNELS_H
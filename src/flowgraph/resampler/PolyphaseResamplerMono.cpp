@@ -41,23 +41,15 @@ void PolyphaseResamplerMono::writeFrame(const float *frame) {
 }
 
 void PolyphaseResamplerMono::readFrame(float *frame) {
-    // Clear accumulator.
-    float sum = 0.0;
-
     // Multiply input times precomputed windowed sinc function.
     const float *coefficients = &mCoefficients[mCoefficientCursor];
-    float *xFrame = &mX[mCursor * MONO];
-    const int numLoops = mNumTaps >> 2; // n/4
-    for (int i = 0; i < numLoops; i++) {
-        // Manual loop unrolling, might get converted to SIMD.
-        sum += *xFrame++ * *coefficients++;
-        sum += *xFrame++ * *coefficients++;
-        sum += *xFrame++ * *coefficients++;
-        sum += *xFrame++ * *coefficients++;
-    }
+    const float *xFrame = &mX[mCursor * MONO];
+    frame[0] = mKernels.dotMono(xFrame, coefficients, mNumTaps);
 
-    mCoefficientCursor = (mCoefficientCursor + mNumTaps) % mCoefficients.size();
+    mCoefficientCursor = (mCoefficientCursor + mNumTaps) % mNumCoefficients;
+}
 
-    // Copy accumulator to output.
-    frame[0] = sum;
+MultiChannelResampler::ProcessResult PolyphaseResamplerMono::process(const float *input,
+        int32_t numInputFrames, float *output, int32_t outputCapacity) {
+    return processFrames(this, input, numInputFrames, output, outputCapacity);
 }
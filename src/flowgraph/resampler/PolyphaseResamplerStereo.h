@@ -34,6 +34,9 @@ public:
     void writeFrame(const float *frame) override;
 
     void readFrame(float *frame) override;
+
+    ProcessResult process(const float *input, int32_t numInputFrames,
+                          float *output, int32_t outputCapacity) override;
 };
 
 } /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
@@ -0,0 +1,588 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ResamplerKernels.h"
+
+#if defined(__SSE__)
+#define RESAMPLER_HAVE_SSE 1
+#include <immintrin.h>
+#else
+#define RESAMPLER_HAVE_SSE 0
+#endif
+
+// AVX2 is not part of any Android x86 ABI baseline so it is compiled with a
+// function level target attribute and only selected after checking the CPU.
+#if RESAMPLER_HAVE_SSE && (defined(__x86_64__) || defined(__i386__)) \
+        && (defined(__clang__) || defined(__GNUC__))
+#define RESAMPLER_HAVE_AVX2 1
+#define RESAMPLER_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define RESAMPLER_HAVE_AVX2 0
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RESAMPLER_HAVE_NEON 1
+#include <arm_neon.h>
+#else
+#define RESAMPLER_HAVE_NEON 0
+#endif
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+namespace {
+
+/***************************************************************************/
+// Scalar reference kernels.
+// These must accumulate in the same order as the original resampler loops.
+
+float dotMonoScalar(const float *x, const float *coefficients, int32_t numTaps) {
+    float sum = 0.0;
+    for (int i = 0; i < numTaps; i++) {
+        sum += *x++ * *coefficients++;
+    }
+    return sum;
+}
+
+void dotStereoScalar(const float *x, const float *coefficients, int32_t numTaps,
+                     float *output) {
+    float left = 0.0;
+    float right = 0.0;
+    for (int i = 0; i < numTaps; i++) {
+        const float coefficient = *coefficients++;
+        left += *x++ * coefficient;
+        right += *x++ * coefficient;
+    }
+    output[0] = left;
+    output[1] = right;
+}
+
+// Process channels starting at firstChannel. Used for the remainder of SIMD loops.
+void dotMultiChannelsScalar(const float *x, const float *coefficients, int32_t numTaps,
+                            int32_t channelCount, int32_t firstChannel, float *output) {
+    for (int channel = firstChannel; channel < channelCount; channel++) {
+        output[channel] = 0.0;
+    }
+    for (int tap = 0; tap < numTaps; tap++) {
+        const float coefficient = coefficients[tap];
+        const float *xFrame = &x[tap * channelCount];
+        for (int channel = firstChannel; channel < channelCount; channel++) {
+            output[channel] += xFrame[channel] * coefficient;
+        }
+    }
+}
+
+void dotMultiScalar(const float *x, const float *coefficients, int32_t numTaps,
+                    int32_t channelCount, float *output) {
+    dotMultiChannelsScalar(x, coefficients, numTaps, channelCount, 0, output);
+}
+
+void dotMonoDualScalar(const float *x, const float *coefficients1,
+                       const float *coefficients2, int32_t numTaps,
+                       float *output1, float *output2) {
+    float sum1 = 0.0;
+    float sum2 = 0.0;
+    for (int i = 0; i < numTaps; i++) {
+        const float sample = *x++;
+        sum1 += sample * *coefficients1++;
+        sum2 += sample * *coefficients2++;
+    }
+    *output1 = sum1;
+    *output2 = sum2;
+}
+
+void dotMultiDualChannelsScalar(const float *x, const float *coefficients1,
+                                const float *coefficients2, int32_t numTaps,
+                                int32_t channelCount, int32_t firstChannel,
+                                float *output1, float *output2) {
+    for (int channel = firstChannel; channel < channelCount; channel++) {
+        output1[channel] = 0.0;
+        output2[channel] = 0.0;
+    }
+    for (int tap = 0; tap < numTaps; tap++) {
+        const float coefficient1 = coefficients1[tap];
+        const float coefficient2 = coefficients2[tap];
+        const float *xFrame = &x[tap * channelCount];
+        for (int channel = firstChannel; channel < channelCount; channel++) {
+            const float sample = xFrame[channel];
+            output1[channel] += sample * coefficient1;
+            output2[channel] += sample * coefficient2;
+        }
+    }
+}
+
+void dotMultiDualScalar(const float *x, const float *coefficients1,
+                        const float *coefficients2, int32_t numTaps,
+                        int32_t channelCount, float *output1, float *output2) {
+    dotMultiDualChannelsScalar(x, coefficients1, coefficients2, numTaps,
+                               channelCount, 0, output1, output2);
+}
+
+void dotStereoDualScalar(const float *x, const float *coefficients1,
+                         const float *coefficients2, int32_t numTaps,
+                         float *output1, float *output2) {
+    dotMultiDualScalar(x, coefficients1, coefficients2, numTaps, 2, output1, output2);
+}
+
+const ResamplerKernels sScalarKernels = {
+        dotMonoScalar,
+        dotStereoScalar,
+        dotMultiScalar,
+        dotMonoDualScalar,
+        dotStereoDualScalar,
+        dotMultiDualScalar,
+        ResamplerKernels::Type::Scalar,
+};
+
+/***************************************************************************/
+#if RESAMPLER_HAVE_SSE
+
+inline float horizontalSumSse(__m128 v) {
+    __m128 shuffled = _mm_movehl_ps(v, v);
+    __m128 sums = _mm_add_ps(v, shuffled);
+    shuffled = _mm_shuffle_ps(sums, sums, 1);
+    sums = _mm_add_ss(sums, shuffled);
+    return _mm_cvtss_f32(sums);
+}
+
+// Fold [L R L R] into output[0] = L + L, output[1] = R + R.
+inline void storeStereoSse(__m128 v, float *output) {
+    const __m128 sums = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    _mm_storel_pi(reinterpret_cast<__m64 *>(output), sums);
+}
+
+float dotMonoSse(const float *x, const float *coefficients, int32_t numTaps) {
+    __m128 sum = _mm_setzero_ps();
+    for (int i = 0; i < numTaps; i += 4) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(coefficients + i)));
+    }
+    return horizontalSumSse(sum);
+}
+
+void dotStereoSse(const float *x, const float *coefficients, int32_t numTaps,
+                  float *output) {
+    __m128 sum = _mm_setzero_ps();
+    for (int i = 0; i < numTaps; i += 4) {
+        // Duplicate each coefficient so it lines up with the LRLR input.
+        const __m128 c = _mm_loadu_ps(coefficients + i);
+        const __m128 cLow = _mm_unpacklo_ps(c, c);
+        const __m128 cHigh = _mm_unpackhi_ps(c, c);
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(x + 2 * i), cLow));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(x + 2 * i + 4), cHigh));
+    }
+    storeStereoSse(sum, output);
+}
+
+// Vectorize across channels, four channels at a time.
+int32_t dotMultiChannelsSse(const float *x, const float *coefficients, int32_t numTaps,
+                            int32_t channelCount, int32_t firstChannel, float *output) {
+    int32_t channel = firstChannel;
+    for (; channel + 4 <= channelCount; channel += 4) {
+        __m128 sum = _mm_setzero_ps();
+        const float *xFrame = &x[channel];
+        for (int tap = 0; tap < numTaps; tap++) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(xFrame),
+                                             _mm_set1_ps(coefficients[tap])));
+            xFrame += channelCount;
+        }
+        _mm_storeu_ps(&output[channel], sum);
+    }
+    return channel;
+}
+
+void dotMultiSse(const float *x, const float *coefficients, int32_t numTaps,
+                 int32_t channelCount, float *output) {
+    const int32_t channel = dotMultiChannelsSse(x, coefficients, numTaps,
+                                                channelCount, 0, output);
+    dotMultiChannelsScalar(x, coefficients, numTaps, channelCount, channel, output);
+}
+
+void dotMonoDualSse(const float *x, const float *coefficients1,
+                    const float *coefficients2, int32_t numTaps,
+                    float *output1, float *output2) {
+    __m128 sum1 = _mm_setzero_ps();
+    __m128 sum2 = _mm_setzero_ps();
+    for (int i = 0; i < numTaps; i += 4) {
+        const __m128 samples = _mm_loadu_ps(x + i);
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(samples, _mm_loadu_ps(coefficients1 + i)));
+        sum2 = _mm_add_ps(sum2, _mm_mul_ps(samples, _mm_loadu_ps(coefficients2 + i)));
+    }
+    *output1 = horizontalSumSse(sum1);
+    *output2 = horizontalSumSse(sum2);
+}
+
+void dotStereoDualSse(const float *x, const float *coefficients1,
+                      const float *coefficients2, int32_t numTaps,
+                      float *output1, float *output2) {
+    __m128 sum1 = _mm_setzero_ps();
+    __m128 sum2 = _mm_setzero_ps();
+    for (int i = 0; i < numTaps; i += 4) {
+        const __m128 samplesLow = _mm_loadu_ps(x + 2 * i);
+        const __m128 samplesHigh = _mm_loadu_ps(x + 2 * i + 4);
+        const __m128 c1 = _mm_loadu_ps(coefficients1 + i);
+        const __m128 c2 = _mm_loadu_ps(coefficients2 + i);
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(samplesLow, _mm_unpacklo_ps(c1, c1)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(samplesHigh, _mm_unpackhi_ps(c1, c1)));
+        sum2 = _mm_add_ps(sum2, _mm_mul_ps(samplesLow, _mm_unpacklo_ps(c2, c2)));
+        sum2 = _mm_add_ps(sum2, _mm_mul_ps(samplesHigh, _mm_unpackhi_ps(c2, c2)));
+    }
+    storeStereoSse(sum1, output1);
+    storeStereoSse(sum2, output2);
+}
+
+int32_t dotMultiDualChannelsSse(const float *x, const float *coefficients1,
+                                const float *coefficients2, int32_t numTaps,
+                                int32_t channelCount, int32_t firstChannel,
+                                float *output1, float *output2) {
+    int32_t channel = firstChannel;
+    for (; channel + 4 <= channelCount; channel += 4) {
+        __m128 sum1 = _mm_setzero_ps();
+        __m128 sum2 = _mm_setzero_ps();
+        const float *xFrame = &x[channel];
+        for (int tap = 0; tap < numTaps; tap++) {
+            const __m128 samples = _mm_loadu_ps(xFrame);
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(samples, _mm_set1_ps(coefficients1[tap])));
+            sum2 = _mm_add_ps(sum2, _mm_mul_ps(samples, _mm_set1_ps(coefficients2[tap])));
+            xFrame += channelCount;
+        }
+        _mm_storeu_ps(&output1[channel], sum1);
+        _mm_storeu_ps(&output2[channel], sum2);
+    }
+    return channel;
+}
+
+void dotMultiDualSse(const float *x, const float *coefficients1,
+                     const float *coefficients2, int32_t numTaps,
+                     int32_t channelCount, float *output1, float *output2) {
+    const int32_t channel = dotMultiDualChannelsSse(x, coefficients1, coefficients2, numTaps,
+                                                    channelCount, 0, output1, output2);
+    dotMultiDualChannelsScalar(x, coefficients1, coefficients2, numTaps,
+                               channelCount, channel, output1, output2);
+}
+
+const ResamplerKernels sSseKernels = {
+        dotMonoSse,
+        dotStereoSse,
+        dotMultiSse,
+        dotMonoDualSse,
+        dotStereoDualSse,
+        dotMultiDualSse,
+        ResamplerKernels::Type::Sse,
+};
+
+#endif // RESAMPLER_HAVE_SSE
+
+/***************************************************************************/
+#if RESAMPLER_HAVE_AVX2
+
+RESAMPLER_TARGET_AVX2
+inline __m128 foldAvx2(__m256 v) {
+    return _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+}
+
+// Load 4 coefficients and duplicate each one to line up with 4 stereo frames.
+RESAMPLER_TARGET_AVX2
+inline __m256 loadStereoCoefficientsAvx2(const float *coefficients) {
+    const __m128 c = _mm_loadu_ps(coefficients);
+    return _mm256_set_m128(_mm_unpackhi_ps(c, c), _mm_unpacklo_ps(c, c));
+}
+
+RESAMPLER_TARGET_AVX2
+float dotMonoAvx2(const float *x, const float *coefficients, int32_t numTaps) {
+    __m256 sum = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= numTaps; i += 8) {
+        sum = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(coefficients + i), sum);
+    }
+    __m128 sum128 = foldAvx2(sum);
+    if (i < numTaps) { // numTaps is a multiple of 4
+        sum128 = _mm_fmadd_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(coefficients + i), sum128);
+    }
+    return horizontalSumSse(sum128);
+}
+
+RESAMPLER_TARGET_AVX2
+void dotStereoAvx2(const float *x, const float *coefficients, int32_t numTaps,
+                   float *output) {
+    __m256 sum = _mm256_setzero_ps();
+    for (int i = 0; i < numTaps; i += 4) {
+        sum = _mm256_fmadd_ps(_mm256_loadu_ps(x + 2 * i),
+                              loadStereoCoefficientsAvx2(coefficients + i), sum);
+    }
+    storeStereoSse(foldAvx2(sum), output);
+}
+
+// Vectorize across channels, eight channels at a time.
+RESAMPLER_TARGET_AVX2
+void dotMultiAvx2(const float *x, const float *coefficients, int32_t numTaps,
+                  int32_t channelCount, float *output) {
+    int32_t channel = 0;
+    for (; channel + 8 <= channelCount; channel += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        const float *xFrame = &x[channel];
+        for (int tap = 0; tap < numTaps; tap++) {
+            sum = _mm256_fmadd_ps(_mm256_loadu_ps(xFrame),
+                                  _mm256_set1_ps(coefficients[tap]), sum);
+            xFrame += channelCount;
+        }
+        _mm256_storeu_ps(&output[channel], sum);
+    }
+    channel = dotMultiChannelsSse(x, coefficients, numTaps, channelCount, channel, output);
+    dotMultiChannelsScalar(x, coefficients, numTaps, channelCount, channel, output);
+}
+
+RESAMPLER_TARGET_AVX2
+void dotMonoDualAvx2(const float *x, const float *coefficients1,
+                     const float *coefficients2, int32_t numTaps,
+                     float *output1, float *output2) {
+    __m256 sum1 = _mm256_setzero_ps();
+    __m256 sum2 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= numTaps; i += 8) {
+        const __m256 samples = _mm256_loadu_ps(x + i);
+        sum1 = _mm256_fmadd_ps(samples, _mm256_loadu_ps(coefficients1 + i), sum1);
+        sum2 = _mm256_fmadd_ps(samples, _mm256_loadu_ps(coefficients2 + i), sum2);
+    }
+    __m128 sum1x4 = foldAvx2(sum1);
+    __m128 sum2x4 = foldAvx2(sum2);
+    if (i < numTaps) { // numTaps is a multiple of 4
+        const __m128 samples = _mm_loadu_ps(x + i);
+        sum1x4 = _mm_fmadd_ps(samples, _mm_loadu_ps(coefficients1 + i), sum1x4);
+        sum2x4 = _mm_fmadd_ps(samples, _mm_loadu_ps(coefficients2 + i), sum2x4);
+    }
+    *output1 = horizontalSumSse(sum1x4);
+    *output2 = horizontalSumSse(sum2x4);
+}
+
+RESAMPLER_TARGET_AVX2
+void dotStereoDualAvx2(const float *x, const float *coefficients1,
+                       const float *coefficients2, int32_t numTaps,
+                       float *output1, float *output2) {
+    __m256 sum1 = _mm256_setzero_ps();
+    __m256 sum2 = _mm256_setzero_ps();
+    for (int i = 0; i < numTaps; i += 4) {
+        const __m256 samples = _mm256_loadu_ps(x + 2 * i);
+        sum1 = _mm256_fmadd_ps(samples, loadStereoCoefficientsAvx2(coefficients1 + i), sum1);
+        sum2 = _mm256_fmadd_ps(samples, loadStereoCoefficientsAvx2(coefficients2 + i), sum2);
+    }
+    storeStereoSse(foldAvx2(sum1), output1);
+    storeStereoSse(foldAvx2(sum2), output2);
+}
+
+RESAMPLER_TARGET_AVX2
+void dotMultiDualAvx2(const float *x, const float *coefficients1,
+                      const float *coefficients2, int32_t numTaps,
+                      int32_t channelCount, float *output1, float *output2) {
+    int32_t channel = 0;
+    for (; channel + 8 <= channelCount; channel += 8) {
+        __m256 sum1 = _mm256_setzero_ps();
+        __m256 sum2 = _mm256_setzero_ps();
+        const float *xFrame = &x[channel];
+        for (int tap = 0; tap < numTaps; tap++) {
+            const __m256 samples = _mm256_loadu_ps(xFrame);
+            sum1 = _mm256_fmadd_ps(samples, _mm256_set1_ps(coefficients1[tap]), sum1);
+            sum2 = _mm256_fmadd_ps(samples, _mm256_set1_ps(coefficients2[tap]), sum2);
+            xFrame += channelCount;
+        }
+        _mm256_storeu_ps(&output1[channel], sum1);
+        _mm256_storeu_ps(&output2[channel], sum2);
+    }
+    channel = dotMultiDualChannelsSse(x, coefficients1, coefficients2, numTaps,
+                                      channelCount, channel, output1, output2);
+    dotMultiDualChannelsScalar(x, coefficients1, coefficients2, numTaps,
+                               channelCount, channel, output1, output2);
+}
+
+const ResamplerKernels sAvx2Kernels = {
+        dotMonoAvx2,
+        dotStereoAvx2,
+        dotMultiAvx2,
+        dotMonoDualAvx2,
+        dotStereoDualAvx2,
+        dotMultiDualAvx2,
+        ResamplerKernels::Type::Avx2,
+};
+
+bool isAvx2Supported() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+#endif // RESAMPLER_HAVE_AVX2
+
+/***************************************************************************/
+#if RESAMPLER_HAVE_NEON
+
+inline float horizontalSumNeon(float32x4_t v) {
+#if defined(__aarch64__)
+    return vaddvq_f32(v);
+#else
+    const float32x2_t sum = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#endif
+}
+
+// Fold [L R L R] into output[0] = L + L, output[1] = R + R.
+inline void storeStereoNeon(float32x4_t v, float *output) {
+    vst1_f32(output, vadd_f32(vget_low_f32(v), vget_high_f32(v)));
+}
+
+float dotMonoNeon(const float *x, const float *coefficients, int32_t numTaps) {
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (int i = 0; i < numTaps; i += 4) {
+        sum = vmlaq_f32(sum, vld1q_f32(x + i), vld1q_f32(coefficients + i));
+    }
+    return horizontalSumNeon(sum);
+}
+
+void dotStereoNeon(const float *x, const float *coefficients, int32_t numTaps,
+                   float *output) {
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (int i = 0; i < numTaps; i += 4) {
+        // Duplicate each coefficient so it lines up with the LRLR input.
+        const float32x4x2_t c = vzipq_f32(vld1q_f32(coefficients + i),
+                                          vld1q_f32(coefficients + i));
+        sum = vmlaq_f32(sum, vld1q_f32(x + 2 * i), c.val[0]);
+        sum = vmlaq_f32(sum, vld1q_f32(x + 2 * i + 4), c.val[1]);
+    }
+    storeStereoNeon(sum, output);
+}
+
+void dotMultiNeon(const float *x, const float *coefficients, int32_t numTaps,
+                  int32_t channelCount, float *output) {
+    int32_t channel = 0;
+    for (; channel + 4 <= channelCount; channel += 4) {
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        const float *xFrame = &x[channel];
+        for (int tap = 0; tap < numTaps; tap++) {
+            sum = vmlaq_n_f32(sum, vld1q_f32(xFrame), coefficients[tap]);
+            xFrame += channelCount;
+        }
+        vst1q_f32(&output[channel], sum);
+    }
+    dotMultiChannelsScalar(x, coefficients, numTaps, channelCount, channel, output);
+}
+
+void dotMonoDualNeon(const float *x, const float *coefficients1,
+                     const float *coefficients2, int32_t numTaps,
+                     float *output1, float *output2) {
+    float32x4_t sum1 = vdupq_n_f32(0.0f);
+    float32x4_t sum2 = vdupq_n_f32(0.0f);
+    for (int i = 0; i < numTaps; i += 4) {
+        const float32x4_t samples = vld1q_f32(x + i);
+        sum1 = vmlaq_f32(sum1, samples, vld1q_f32(coefficients1 + i));
+        sum2 = vmlaq_f32(sum2, samples, vld1q_f32(coefficients2 + i));
+    }
+    *output1 = horizontalSumNeon(sum1);
+    *output2 = horizontalSumNeon(sum2);
+}
+
+void dotStereoDualNeon(const float *x, const float *coefficients1,
+                       const float *coefficients2, int32_t numTaps,
+                       float *output1, float *output2) {
+    float32x4_t sum1 = vdupq_n_f32(0.0f);
+    float32x4_t sum2 = vdupq_n_f32(0.0f);
+    for (int i = 0; i < numTaps; i += 4) {
+        const float32x4_t samplesLow = vld1q_f32(x + 2 * i);
+        const float32x4_t samplesHigh = vld1q_f32(x + 2 * i + 4);
+        const float32x4x2_t c1 = vzipq_f32(vld1q_f32(coefficients1 + i),
+                                           vld1q_f32(coefficients1 + i));
+        const float32x4x2_t c2 = vzipq_f32(vld1q_f32(coefficients2 + i),
+                                           vld1q_f32(coefficients2 + i));
+        sum1 = vmlaq_f32(sum1, samplesLow, c1.val[0]);
+        sum1 = vmlaq_f32(sum1, samplesHigh, c1.val[1]);
+        sum2 = vmlaq_f32(sum2, samplesLow, c2.val[0]);
+        sum2 = vmlaq_f32(sum2, samplesHigh, c2.val[1]);
+    }
+    storeStereoNeon(sum1, output1);
+    storeStereoNeon(sum2, output2);
+}
+
+void dotMultiDualNeon(const float *x, const float *coefficients1,
+                      const float *coefficients2, int32_t numTaps,
+                      int32_t channelCount, float *output1, float *output2) {
+    int32_t channel = 0;
+    for (; channel + 4 <= channelCount; channel += 4) {
+        float32x4_t sum1 = vdupq_n_f32(0.0f);
+        float32x4_t sum2 = vdupq_n_f32(0.0f);
+        const float *xFrame = &x[channel];
+        for (int tap = 0; tap < numTaps; tap++) {
+            const float32x4_t samples = vld1q_f32(xFrame);
+            sum1 = vmlaq_n_f32(sum1, samples, coefficients1[tap]);
+            sum2 = vmlaq_n_f32(sum2, samples, coefficients2[tap]);
+            xFrame += channelCount;
+        }
+        vst1q_f32(&output1[channel], sum1);
+        vst1q_f32(&output2[channel], sum2);
+    }
+    dotMultiDualChannelsScalar(x, coefficients1, coefficients2, numTaps,
+                               channelCount, channel, output1, output2);
+}
+
+const ResamplerKernels sNeonKernels = {
+        dotMonoNeon,
+        dotStereoNeon,
+        dotMultiNeon,
+        dotMonoDualNeon,
+        dotStereoDualNeon,
+        dotMultiDualNeon,
+        ResamplerKernels::Type::Neon,
+};
+
+#endif // RESAMPLER_HAVE_NEON
+
+const ResamplerKernels &detectKernels() {
+#if RESAMPLER_HAVE_AVX2
+    if (isAvx2Supported()) {
+        return sAvx2Kernels;
+    }
+#endif
+#if RESAMPLER_HAVE_SSE
+    return sSseKernels;
+#elif RESAMPLER_HAVE_NEON
+    return sNeonKernels;
+#else
+    return sScalarKernels;
+#endif
+}
+
+} // namespace
+
+const ResamplerKernels &ResamplerKernels::getScalar() {
+    return sScalarKernels;
+}
+
+const ResamplerKernels &ResamplerKernels::select(bool simdEnabled) {
+    if (!simdEnabled) {
+        return sScalarKernels;
+    }
+    // Thread-safe one-time detection.
+    static const ResamplerKernels &sDetected = detectKernels();
+    return sDetected;
+}
+
+const char *ResamplerKernels::getTypeName(Type type) {
+    switch (type) {
+        case Type::Scalar:
+            return "Scalar";
+        case Type::Sse:
+            return "SSE";
+        case Type::Avx2:
+            return "AVX2";
+        case Type::Neon:
+            return "NEON";
+    }
+    return "Unknown";
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESAMPLER_RESAMPLER_KERNELS_H
+#define RESAMPLER_RESAMPLER_KERNELS_H
+
+#include <sys/types.h>
+
+#include "ResamplerDefinitions.h"
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+
+/**
+ * Table of FIR tap dot-product kernels used by the polyphase and sinc resamplers.
+ *
+ * The input history "x" is frame interleaved, so x[tap * channelCount + channel].
+ * The coefficients are one row of the filter table, so coefficients[tap].
+ * numTaps must be a multiple of four.
+ *
+ * The scalar table accumulates in exactly the same order as the original
+ * resampler loops so it produces bit-identical results.
+ * The SIMD tables reorder the summation so results may differ in the last bits.
+ */
+struct ResamplerKernels {
+
+    enum class Type : int32_t {
+        Scalar,
+        Sse,
+        Avx2,
+        Neon,
+    };
+
+    float (*dotMono)(const float *x, const float *coefficients, int32_t numTaps);
+
+    void (*dotStereo)(const float *x, const float *coefficients, int32_t numTaps,
+                      float *output);
+
+    void (*dotMulti)(const float *x, const float *coefficients, int32_t numTaps,
+                     int32_t channelCount, float *output);
+
+    /**
+     * Apply two rows of coefficients to the same input.
+     * This is used by the sinc resamplers, which interpolate between two rows.
+     */
+    void (*dotMonoDual)(const float *x, const float *coefficients1,
+                        const float *coefficients2, int32_t numTaps,
+                        float *output1, float *output2);
+
+    void (*dotStereoDual)(const float *x, const float *coefficients1,
+                          const float *coefficients2, int32_t numTaps,
+                          float *output1, float *output2);
+
+    void (*dotMultiDual)(const float *x, const float *coefficients1,
+                         const float *coefficients2, int32_t numTaps,
+                         int32_t channelCount, float *output1, float *output2);
+
+    Type type;
+
+    /**
+     * @return the scalar reference kernels
+     */
+    static const ResamplerKernels &getScalar();
+
+    /**
+     * Select the fastest kernels supported by the CPU we are running on.
+     * The CPU features are only detected on the first call.
+     *
+     * @param simdEnabled if false then return the scalar kernels
+     * @return kernels, which are valid for the life of the process
+     */
+    static const ResamplerKernels &select(bool simdEnabled = true);
+
+    static const char *getTypeName(Type type);
+};
+
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
+
+#endif //RESAMPLER_RESAMPLER_KERNELS_H
@@ -38,6 +38,9 @@ public:
 
     void readFrame(float *frame) override;
 
+    ProcessResult process(const float *input, int32_t numInputFrames,
+                          float *output, int32_t outputCapacity) override;
+
 protected:
 
     std::vector<float> mSingleFrame2; // for interpolation
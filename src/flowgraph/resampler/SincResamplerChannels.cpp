@@ -0,0 +1,81 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>   // Do NOT delete. Needed for LLVM. See #1746
+#include <cassert>
+#include <math.h>
+
+#include "FixedChannelKernels.h"
+#include "SincResamplerChannels.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+template <int32_t kChannelCount>
+SincResamplerChannels<kChannelCount>::SincResamplerChannels(
+        const MultiChannelResampler::Builder &builder)
+        : SincResampler(builder) {
+    assert(builder.getChannelCount() == kChannelCount);
+}
+
+template <int32_t kChannelCount>
+void SincResamplerChannels<kChannelCount>::writeFrame(const float *frame) {
+    FixedChannelKernels<kChannelCount>::writeFrame(mX.data(), mNumTaps, &mCursor, frame);
+}
+
+// Multiply input times windowed sinc function.
+template <int32_t kChannelCount>
+void SincResamplerChannels<kChannelCount>::readFrame(float *frame) {
+    // Determine indices into coefficients table.
+    const double tablePhase = getIntegerPhase() * mPhaseScaler;
+    const int index1 = static_cast<int>(floor(tablePhase));
+    const float *coefficients1 = &mCoefficients[static_cast<size_t>(index1)
+            * static_cast<size_t>(getNumTaps())];
+    const float *coefficients2 = coefficients1 + getNumTaps(); // OK because using a guard row.
+    const float *xFrame = &mX[static_cast<size_t>(mCursor) * kChannelCount];
+    const float fraction = tablePhase - index1;
+
+    if constexpr (kChannelCount == 1) {
+        float low;
+        float high;
+        mKernels.dotMonoDual(xFrame, coefficients1, coefficients2, mNumTaps, &low, &high);
+        frame[0] = low + (fraction * (high - low));
+    } else if (mKernels.type == ResamplerKernels::Type::Scalar) {
+        // Keep the results bit-exact when SIMD is disabled.
+        float low[kChannelCount];
+        float high[kChannelCount];
+        mKernels.dotMultiDual(xFrame, coefficients1, coefficients2, mNumTaps, kChannelCount,
+                              low, high);
+        for (int channel = 0; channel < kChannelCount; channel++) {
+            frame[channel] = low[channel] + (fraction * (high[channel] - low[channel]));
+        }
+    } else {
+        FixedChannelKernels<kChannelCount>::dotInterpolated(xFrame, coefficients1,
+                coefficients2, mNumTaps, fraction, frame);
+    }
+}
+
+template <int32_t kChannelCount>
+MultiChannelResampler::ProcessResult SincResamplerChannels<kChannelCount>::process(
+        const float *input, int32_t numInputFrames, float *output, int32_t outputCapacity) {
+    return processFrames(this, input, numInputFrames, output, outputCapacity);
+}
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+template class SincResamplerChannels<1>;
+template class SincResamplerChannels<4>;
+template class SincResamplerChannels<6>;
+template class SincResamplerChannels<8>;
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESAMPLER_SINC_RESAMPLER_CHANNELS_H
+#define RESAMPLER_SINC_RESAMPLER_CHANNELS_H
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "SincResampler.h"
+#include "ResamplerDefinitions.h"
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+
+/**
+ * SincResampler for a channel count that is known at compile time.
+ *
+ * It is instantiated for mono and for 4, 6 and 8 channels.
+ * Mono runs the FIR across the taps with the SIMD ResamplerKernels.
+ * Stereo uses SincResamplerStereo.
+ */
+template <int32_t kChannelCount>
+class SincResamplerChannels : public SincResampler {
+public:
+    explicit SincResamplerChannels(const MultiChannelResampler::Builder &builder);
+
+    virtual ~SincResamplerChannels() = default;
+
+    void writeFrame(const float *frame) override;
+
+    void readFrame(float *frame) override;
+
+    ProcessResult process(const float *input, int32_t numInputFrames,
+                          float *output, int32_t outputCapacity) override;
+};
+
+extern template class SincResamplerChannels<1>;
+extern template class SincResamplerChannels<4>;
+extern template class SincResamplerChannels<6>;
+extern template class SincResamplerChannels<8>;
+
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
+
+#endif //RESAMPLER_SINC_RESAMPLER_CHANNELS_H
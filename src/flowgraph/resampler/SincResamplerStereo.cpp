@@ -48,34 +48,26 @@ void SincResamplerStereo::writeFrame(const float *frame) {
 
 // Multiply input times windowed sinc function.
 void SincResamplerStereo::readFrame(float *frame) {
-    // Clear accumulator for mixing.
-    std::fill(mSingleFrame.begin(), mSingleFrame.end(), 0.0);
-    std::fill(mSingleFrame2.begin(), mSingleFrame2.end(), 0.0);
-
     // Determine indices into coefficients table.
     double tablePhase = getIntegerPhase() * mPhaseScaler;
     int index1 = static_cast<int>(floor(tablePhase));
-    float *coefficients1 = &mCoefficients[static_cast<size_t>(index1)
+    const float *coefficients1 = &mCoefficients[static_cast<size_t>(index1)
             * static_cast<size_t>(getNumTaps())];
     int index2 = (index1 + 1);
-    float *coefficients2 = &mCoefficients[static_cast<size_t>(index2)
+    const float *coefficients2 = &mCoefficients[static_cast<size_t>(index2)
             * static_cast<size_t>(getNumTaps())];
-    float *xFrame = &mX[static_cast<size_t>(mCursor) * static_cast<size_t>(getChannelCount())];
-    for (int i = 0; i < mNumTaps; i++) {
-        float coefficient1 = *coefficients1++;
-        float coefficient2 = *coefficients2++;
-        for (int channel = 0; channel < getChannelCount(); channel++) {
-            float sample = *xFrame++;
-            mSingleFrame[channel] +=  sample * coefficient1;
-            mSingleFrame2[channel] += sample * coefficient2;
-        }
-    }
+    const float *xFrame = &mX[static_cast<size_t>(mCursor) * STEREO];
+    float low[STEREO];
+    float high[STEREO];
+    mKernels.dotStereoDual(xFrame, coefficients1, coefficients2, mNumTaps, low, high);
 
     // Interpolate and copy to output.
     float fraction = tablePhase - index1;
-    for (int channel = 0; channel < getChannelCount(); channel++) {
-        float low = mSingleFrame[channel];
-        float high = mSingleFrame2[channel];
-        frame[channel] = low + (fraction * (high - low));
-    }
+    frame[0] = low[0] + (fraction * (high[0] - low[0]));
+    frame[1] = low[1] + (fraction * (high[1] - low[1]));
+}
+
+MultiChannelResampler::ProcessResult SincResamplerStereo::process(const float *input,
+        int32_t numInputFrames, float *output, int32_t outputCapacity) {
+    return processFrames(this, input, numInputFrames, output, outputCapacity);
 }
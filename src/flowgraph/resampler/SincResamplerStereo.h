@@ -35,6 +35,9 @@ public:
 
     void readFrame(float *frame) override;
 
+    ProcessResult process(const float *input, int32_t numInputFrames,
+                          float *output, int32_t outputCapacity) override;
+
 };
 
 } /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>   // Do NOT delete. Needed for LLVM. See #1746
+#include <math.h>
+#include "VariableRatioResampler.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+VariableRatioResampler::VariableRatioResampler(const MultiChannelResampler::Builder &builder,
+                                               double maxRatio)
+        : SincResampler(makeFilterBuilder(builder, maxRatio)) {
+    // Replace the reduced ratio from the builder with a fixed denominator
+    // so the ratio can be changed by just changing the numerator.
+    mDenominator = kPhaseDenominator;
+    mIntegerPhase = mDenominator; // so we start with a write needed
+    mPhaseScaler = (double) (mNumRows - 1) / mDenominator;
+    setRatio((double) builder.getInputRate() / builder.getOutputRate());
+}
+
+// The cutoff of the filter is lowered for the highest ratio.
+MultiChannelResampler::Builder VariableRatioResampler::makeFilterBuilder(
+        const MultiChannelResampler::Builder &builder, double maxRatio) {
+    MultiChannelResampler::Builder filterBuilder = builder;
+    const double initialRatio = (double) builder.getInputRate() / builder.getOutputRate();
+    if (maxRatio > initialRatio) {
+        maxRatio = std::min(maxRatio, kMaxRatio);
+        filterBuilder.setInputRate(static_cast<int32_t>(lround(builder.getOutputRate()
+                                                               * maxRatio)));
+    }
+    return filterBuilder;
+}
+
+void VariableRatioResampler::setRatio(double ratio) {
+    mRampFramesLeft = 0;
+    mRatio = mTargetRatio = std::max(kMinRatio, std::min(kMaxRatio, ratio));
+    updateNumerator();
+}
+
+void VariableRatioResampler::rampRatio(double ratio, int32_t numOutputFrames) {
+    if (numOutputFrames <= 0) {
+        setRatio(ratio);
+        return;
+    }
+    mTargetRatio = std::max(kMinRatio, std::min(kMaxRatio, ratio));
+    mRatioIncrement = (mTargetRatio - mRatio) / numOutputFrames;
+    mRampFramesLeft = numOutputFrames;
+}
+
+void VariableRatioResampler::updateNumerator() {
+    mNumerator = static_cast<int32_t>(lround(mRatio * kPhaseDenominator));
+}
+
+void VariableRatioResampler::readFrame(float *frame) {
+    SincResampler::readFrame(frame);
+    // Step the ramp before advanceRead() so each output frame moves the phase by the new ratio.
+    if (mRampFramesLeft > 0) {
+        mRatio = (--mRampFramesLeft == 0) ? mTargetRatio : (mRatio + mRatioIncrement);
+        updateNumerator();
+    }
+}
+
+MultiChannelResampler::ProcessResult VariableRatioResampler::process(const float *input,
+        int32_t numInputFrames, float *output, int32_t outputCapacity) {
+    return processFrames(this, input, numInputFrames, output, outputCapacity);
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESAMPLER_VARIABLE_RATIO_RESAMPLER_H
+#define RESAMPLER_VARIABLE_RATIO_RESAMPLER_H
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "SincResampler.h"
+#include "ResamplerDefinitions.h"
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+
+/**
+ * Sinc resampler whose ratio can be changed while it is running.
+ *
+ * The ratio is the number of input frames consumed per output frame.
+ * So 2.0 plays twice as fast and 0.5 plays at half speed.
+ * It can be used for playback speed control, vari-speed effects or to track
+ * the drift between two clocks.
+ *
+ * The coefficient table is generated once, for the widest ratio, so changing the
+ * ratio is cheap. The phase is a fixed point fraction of an input frame and the
+ * coefficients are interpolated between the rows of the table, like SincResampler.
+ */
+class VariableRatioResampler : public SincResampler {
+public:
+    /**
+     * The initial ratio is inputRate / outputRate from the builder.
+     *
+     * The anti-aliasing filter is designed for maxRatio. The ratio can be set higher
+     * than that but then frequencies above the output Nyquist rate will alias.
+     *
+     * @param builder the number of taps must be a multiple of four
+     * @param maxRatio highest ratio that will be used, ignored if below the initial ratio
+     */
+    explicit VariableRatioResampler(const MultiChannelResampler::Builder &builder,
+                                    double maxRatio = 1.0);
+
+    virtual ~VariableRatioResampler() = default;
+
+    /**
+     * Change the ratio starting with the next output frame.
+     * This also cancels a ramp.
+     *
+     * @param ratio input frames per output frame, clipped to kMinRatio to kMaxRatio
+     */
+    void setRatio(double ratio);
+
+    /**
+     * Change the ratio linearly over the next numOutputFrames.
+     * This avoids the discontinuity in pitch of a sudden change.
+     *
+     * @param ratio input frames per output frame at the end of the ramp
+     * @param numOutputFrames length of the ramp, if <= 0 then same as setRatio()
+     */
+    void rampRatio(double ratio, int32_t numOutputFrames);
+
+    /**
+     * @return input frames per output frame that will be used for the next output frame
+     */
+    double getRatio() const {
+        return mRatio;
+    }
+
+    bool isRamping() const {
+        return mRampFramesLeft > 0;
+    }
+
+    void readFrame(float *frame) override;
+
+    ProcessResult process(const float *input, int32_t numInputFrames,
+                          float *output, int32_t outputCapacity) override;
+
+    static constexpr double kMinRatio = 1.0 / 16;
+    static constexpr double kMaxRatio = 16.0;
+
+private:
+    static MultiChannelResampler::Builder makeFilterBuilder(
+            const MultiChannelResampler::Builder &builder, double maxRatio);
+
+    void updateNumerator();
+
+    // Phase resolution in fractions of an input frame. So the ratio is accurate to about 1e-6.
+    static constexpr int32_t kPhaseDenominator = 1 << 20;
+
+    double  mRatio = 1.0;
+    double  mTargetRatio = 1.0;
+    double  mRatioIncrement = 0.0;
+    int32_t mRampFramesLeft = 0;
+};
+
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
+
+#endif //RESAMPLER_VARIABLE_RATIO_RESAMPLER_H
@@ -0,0 +1,429 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+#include "oboe/NullAudioBackend.h"
+#include "common/AudioClock.h"
+#include "common/OboeDebug.h"
+#include "null/AudioStreamNull.h"
+
+namespace oboe {
+
+// Settings shared by all null streams.
+static std::mutex  sSettingsLock;
+static double      sSpeed = 1.0;
+static std::string sOutputFile;
+static std::string sInputFile;
+
+void NullAudioBackend::setSpeed(double speed) {
+    std::lock_guard<std::mutex> lock(sSettingsLock);
+    sSpeed = std::max(0.0, speed);
+}
+
+double NullAudioBackend::getSpeed() {
+    std::lock_guard<std::mutex> lock(sSettingsLock);
+    return sSpeed;
+}
+
+void NullAudioBackend::setOutputFile(const std::string &path) {
+    std::lock_guard<std::mutex> lock(sSettingsLock);
+    sOutputFile = path;
+}
+
+std::string NullAudioBackend::getOutputFile() {
+    std::lock_guard<std::mutex> lock(sSettingsLock);
+    return sOutputFile;
+}
+
+void NullAudioBackend::setInputFile(const std::string &path) {
+    std::lock_guard<std::mutex> lock(sSettingsLock);
+    sInputFile = path;
+}
+
+std::string NullAudioBackend::getInputFile() {
+    std::lock_guard<std::mutex> lock(sSettingsLock);
+    return sInputFile;
+}
+
+void NullAudioBackend::reset() {
+    std::lock_guard<std::mutex> lock(sSettingsLock);
+    sSpeed = 1.0;
+    sOutputFile.clear();
+    sInputFile.clear();
+}
+
+/*
+ * AudioStreamNull
+ */
+AudioStreamNull::AudioStreamNull(const AudioStreamBuilder &builder)
+        : AudioStreamBuffered(builder) {
+}
+
+AudioStreamNull::~AudioStreamNull() {
+    // The thread must not outlive the stream even if the app forgot to close it.
+    std::lock_guard<std::mutex> lock(mLock);
+    stopThread_l();
+    if (mFile != nullptr) {
+        fclose(mFile);
+        mFile = nullptr;
+    }
+}
+
+Result AudioStreamNull::open() {
+    if (getState() != StreamState::Uninitialized) {
+        return Result::ErrorInvalidState;
+    }
+    Result result = AudioStreamBuffered::open();
+    if (result != Result::OK) {
+        return result;
+    }
+
+    // There is no device so pick the values a typical device would use.
+    if (mSampleRate == kUnspecified) {
+        mSampleRate = DefaultStreamValues::SampleRate;
+    }
+    if (mChannelCount == kUnspecified) {
+        mChannelCount = DefaultStreamValues::ChannelCount;
+    }
+    if (mFormat == AudioFormat::Unspecified) {
+        mFormat = AudioFormat::Float;
+    }
+    if (mFormat == AudioFormat::IEC61937) {
+        LOGE("AudioStreamNull::%s() IEC61937 is not supported", __func__);
+        return Result::ErrorInvalidFormat;
+    }
+    mFramesPerBurst = DefaultStreamValues::FramesPerBurst;
+    // Like OpenSL ES, a specified callback size is used as the burst size.
+    mFramesPerTimerCallback = (mFramesPerCallback > 0) ? mFramesPerCallback : mFramesPerBurst;
+
+    if (usingFIFO()) {
+        allocateFifo();
+    } else {
+        if (mBufferCapacityInFrames == kUnspecified) {
+            mBufferCapacityInFrames = mFramesPerTimerCallback * kDefaultBurstsPerBuffer;
+        }
+        mBufferSizeInFrames = mBufferCapacityInFrames;
+    }
+    mCallbackBuffer = std::make_unique<uint8_t[]>(
+            static_cast<size_t>(mFramesPerTimerCallback) * getBytesPerFrame());
+
+    mSpeed = NullAudioBackend::getSpeed();
+    std::string path = (getDirection() == Direction::Output)
+            ? NullAudioBackend::getOutputFile()
+            : NullAudioBackend::getInputFile();
+    if (!path.empty()) {
+        mFile = fopen(path.c_str(), (getDirection() == Direction::Output) ? "wb" : "rb");
+        if (mFile == nullptr) {
+            LOGE("AudioStreamNull::%s() could not open %s, errno = %d, %s",
+                 __func__, path.c_str(), errno, strerror(errno));
+            return Result::ErrorInternal;
+        }
+    }
+
+    calculateDefaultDelayBeforeCloseMillis();
+    setState(StreamState::Open);
+    return Result::OK;
+}
+
+Result AudioStreamNull::close() {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (getState() == StreamState::Closed) {
+        return Result::ErrorClosed;
+    }
+    stopThread_l();
+    if (mFile != nullptr) {
+        fclose(mFile);
+        mFile = nullptr;
+    }
+    AudioStreamBuffered::close();
+    setState(StreamState::Closed);
+    return Result::OK;
+}
+
+Result AudioStreamNull::requestStart() {
+    std::lock_guard<std::mutex> lock(mLock);
+    switch (getState()) {
+        case StreamState::Starting:
+        case StreamState::Started:
+            return Result::OK;
+        case StreamState::Uninitialized:
+        case StreamState::Closed:
+            return Result::ErrorClosed;
+        default:
+            break;
+    }
+    // The thread may have stopped itself because the callback returned Stop.
+    stopThread_l();
+    // We use a callback if the user requests one
+    // OR if we have an internal callback to read the blocking IO buffer.
+    setDataCallbackEnabled(true);
+    setState(StreamState::Started);
+    startThread_l();
+    return Result::OK;
+}
+
+Result AudioStreamNull::requestPause() {
+    if (getDirection() == Direction::Input) {
+        return Result::ErrorUnimplemented; // Same as AAudio.
+    }
+    std::lock_guard<std::mutex> lock(mLock);
+    return requestStopOrPause_l(StreamState::Pausing, StreamState::Paused);
+}
+
+Result AudioStreamNull::requestFlush() {
+    std::lock_guard<std::mutex> lock(mLock);
+    switch (getState()) {
+        case StreamState::Closed:
+            return Result::ErrorClosed;
+        case StreamState::Paused:
+        case StreamState::Flushed:
+            break;
+        default:
+            return Result::ErrorInvalidState;
+    }
+    setState(StreamState::Flushed);
+    return Result::OK;
+}
+
+Result AudioStreamNull::requestStop() {
+    if (std::this_thread::get_id() == mTimerThreadId.load()) {
+        // Called from the data callback so we cannot join the thread or take the lock.
+        mThreadEnabled.store(false);
+        setState(StreamState::Stopped);
+        return Result::OK;
+    }
+    std::lock_guard<std::mutex> lock(mLock);
+    return requestStopOrPause_l(StreamState::Stopping, StreamState::Stopped);
+}
+
+Result AudioStreamNull::requestStopOrPause_l(StreamState transientState,
+                                             StreamState finalState) {
+    StreamState initialState = getState();
+    if (initialState == StreamState::Uninitialized || initialState == StreamState::Closed) {
+        return Result::ErrorClosed;
+    } else if (initialState == finalState) {
+        return Result::OK;
+    }
+    setState(transientState);
+    stopThread_l();
+    setState(finalState);
+    return Result::OK;
+}
+
+Result AudioStreamNull::waitForStateChange(StreamState currentState,
+                                           StreamState *nextState,
+                                           int64_t timeoutNanoseconds) {
+    Result oboeResult = Result::ErrorTimeout;
+    int64_t sleepTimeNanos = kNanosPerMillisecond; // arbitrary
+    int64_t timeLeftNanos = timeoutNanoseconds;
+
+    while (true) {
+        const StreamState state = getState(); // this does not require a lock
+        if (nextState != nullptr) {
+            *nextState = state;
+        }
+        if (currentState != state) { // state changed?
+            oboeResult = Result::OK;
+            break;
+        }
+
+        // Did we timeout or did user ask for non-blocking?
+        if (timeLeftNanos <= 0) {
+            break;
+        }
+
+        if (sleepTimeNanos > timeLeftNanos){
+            sleepTimeNanos = timeLeftNanos;
+        }
+        AudioClock::sleepForNanos(sleepTimeNanos);
+        timeLeftNanos -= sleepTimeNanos;
+    }
+
+    return oboeResult;
+}
+
+ResultWithValue<int32_t> AudioStreamNull::setBufferSizeInFrames(int32_t requestedFrames) {
+    if (usingFIFO()) {
+        return AudioStreamBuffered::setBufferSizeInFrames(requestedFrames);
+    }
+    if (getState() == StreamState::Closed) {
+        return ResultWithValue<int32_t>(Result::ErrorClosed);
+    }
+    // There is no real buffer when using a callback. Just remember the size.
+    mBufferSizeInFrames = std::max(getFramesPerBurst(),
+                                   std::min(requestedFrames, getBufferCapacityInFrames()));
+    return ResultWithValue<int32_t>(mBufferSizeInFrames);
+}
+
+Result AudioStreamNull::getTimestamp(clockid_t clockId,
+                                     int64_t *framePosition,
+                                     int64_t *timeNanoseconds) {
+    if (getState() != StreamState::Started) {
+        return Result::ErrorInvalidState;
+    }
+    if (clockId != CLOCK_MONOTONIC) {
+        return Result::ErrorUnimplemented;
+    }
+    int64_t position = mFramesProcessedByServer.load();
+    if (position == 0) {
+        return Result::ErrorUnavailable;
+    }
+    // Calculate the time from the position so it does not jitter.
+    *framePosition = position;
+    *timeNanoseconds = mStartTimeNanos.load() + framesToNanos(position - mStartPosition.load());
+    return Result::OK;
+}
+
+void AudioStreamNull::updateFramesRead() {
+    if (usingFIFO()) {
+        AudioStreamBuffered::updateFramesRead();
+    } else if (getDirection() == Direction::Output) {
+        mFramesRead = mFramesProcessedByServer.load();
+    } // or else it will get updated by runTimerThread()
+}
+
+void AudioStreamNull::updateFramesWritten() {
+    if (usingFIFO()) {
+        AudioStreamBuffered::updateFramesWritten();
+    } else if (getDirection() == Direction::Input) {
+        mFramesWritten = mFramesProcessedByServer.load();
+    } // or else it will get updated by runTimerThread()
+}
+
+void AudioStreamNull::startThread_l() {
+    mStartPosition.store(mFramesProcessedByServer.load());
+    mStartTimeNanos.store(AudioClock::getNanoseconds());
+    mThreadEnabled.store(true);
+    mThread = std::thread([this]() { runTimerThread(); });
+}
+
+void AudioStreamNull::stopThread_l() {
+    mThreadEnabled.store(false);
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+}
+
+int64_t AudioStreamNull::framesToNanos(int64_t frames) const {
+    double nanos = static_cast<double>(frames) * kNanosPerSecond / getSampleRate();
+    if (mSpeed > 0.0) {
+        nanos /= mSpeed;
+    }
+    return static_cast<int64_t>(nanos);
+}
+
+void AudioStreamNull::readInputFile(uint8_t *buffer, int32_t numFrames) {
+    const int32_t numBytes = numFrames * getBytesPerFrame();
+    int32_t bytesRead = 0;
+    if (mFile != nullptr) {
+        while (bytesRead < numBytes) {
+            size_t count = fread(buffer + bytesRead, 1, numBytes - bytesRead, mFile);
+            if (count == 0) {
+                // Loop back to the beginning of the file. Give up if it is empty.
+                rewind(mFile);
+                count = fread(buffer + bytesRead, 1, numBytes - bytesRead, mFile);
+                if (count == 0) break;
+            }
+            bytesRead += static_cast<int32_t>(count);
+        }
+    }
+    memset(buffer + bytesRead, 0, numBytes - bytesRead);
+}
+
+void AudioStreamNull::writeOutputFile(const uint8_t *buffer, int32_t numFrames) {
+    if (mFile != nullptr && numFrames > 0) {
+        fwrite(buffer, getBytesPerFrame(), numFrames, mFile);
+    }
+}
+
+// Called by fireDataCallback() when the app reads or writes through the FIFO.
+// The file is read into or written from the FIFO storage so the data is not copied
+// through the callback buffer.
+DataCallbackResult AudioStreamNull::onDefaultCallback(void *audioData, int numFrames) {
+    FifoBuffer *fifo = getFifoBuffer();
+    int32_t framesTransferred = 0;
+    if (getDirection() == Direction::Output) {
+        FifoBuffer::Regions regions = fifo->acquireReadRegions(numFrames);
+        for (int i = 0; i < 2; i++) {
+            writeOutputFile(regions.data[i], regions.numFrames[i]);
+        }
+        framesTransferred = regions.getNumFrames();
+        fifo->commitRead(framesTransferred);
+        // Write silence for the missing frames, like FifoBuffer::readNow().
+        const int32_t framesLeft = numFrames - framesTransferred;
+        if (mFile != nullptr && framesLeft > 0) {
+            memset(audioData, 0, fifo->convertFramesToBytes(framesLeft));
+            writeOutputFile(static_cast<uint8_t *>(audioData), framesLeft);
+        }
+    } else {
+        FifoBuffer::Regions regions = fifo->acquireWriteRegions(numFrames);
+        for (int i = 0; i < 2; i++) {
+            readInputFile(regions.data[i], regions.numFrames[i]);
+        }
+        framesTransferred = regions.getNumFrames();
+        fifo->commitWrite(framesTransferred);
+    }
+    return finishDefaultCallback(framesTransferred, numFrames);
+}
+
+void AudioStreamNull::runTimerThread() {
+    const int64_t startNanos = mStartTimeNanos.load();
+    const int64_t startPosition = mStartPosition.load();
+    const bool isOutput = getDirection() == Direction::Output;
+    mTimerThreadId.store(std::this_thread::get_id());
+
+    // With a FIFO the file is handled by onDefaultCallback().
+    const bool isFileInCallbackBuffer = !usingFIFO();
+
+    while (mThreadEnabled.load()) {
+        if (!isOutput && isFileInCallbackBuffer) {
+            readInputFile(mCallbackBuffer.get(), mFramesPerTimerCallback);
+        }
+        DataCallbackResult result = fireDataCallback(mCallbackBuffer.get(),
+                                                     mFramesPerTimerCallback);
+        if (result != DataCallbackResult::Continue) {
+            if (result != DataCallbackResult::Stop) {
+                LOGW("Oboe callback returned unexpected value = %d", static_cast<int>(result));
+            }
+            mThreadEnabled.store(false);
+            setState(StreamState::Stopped);
+            break;
+        }
+        if (isOutput && isFileInCallbackBuffer) {
+            writeOutputFile(mCallbackBuffer.get(), mFramesPerTimerCallback);
+        }
+        // Update Oboe client position with frames handled by the callback.
+        if (!usingFIFO()) {
+            if (isOutput) {
+                mFramesWritten += mFramesPerTimerCallback;
+            } else {
+                mFramesRead += mFramesPerTimerCallback;
+            }
+        }
+        int64_t position = mFramesProcessedByServer.fetch_add(mFramesPerTimerCallback)
+                + mFramesPerTimerCallback;
+
+        if (mSpeed > 0.0) {
+            // Calculate the wake up time from the position so the timer does not drift.
+            AudioClock::sleepUntilNanoTime(startNanos + framesToNanos(position - startPosition));
+        }
+    }
+}
+
+} // namespace oboe
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OBOE_AUDIO_STREAM_NULL_H_
+#define OBOE_AUDIO_STREAM_NULL_H_
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+#include "oboe/Oboe.h"
+#include "opensles/AudioStreamBuffered.h"
+
+namespace oboe {
+
+/**
+ * INTERNAL USE ONLY
+ *
+ * A stream with no audio device that is used by host builds.
+ *
+ * A timer thread calls the data callback with one burst at a time.
+ * Output data is discarded or written to a file.
+ * Input data is silence or read from a file.
+ * The timer and the timestamps are based on the number of frames processed
+ * so the behavior does not depend on the speed of the machine.
+ *
+ * See NullAudioBackend for the settings.
+ *
+ * Do not instantiate this class directly.
+ * Use an AudioStreamBuilder to create one.
+ */
+class AudioStreamNull : public AudioStreamBuffered {
+public:
+
+    explicit AudioStreamNull(const AudioStreamBuilder &builder);
+
+    virtual ~AudioStreamNull();
+
+    Result open() override;
+    Result close() override;
+
+    Result requestStart() override;
+    Result requestPause() override;
+    Result requestFlush() override;
+    Result requestStop() override;
+
+    StreamState getState() override { return mState.load(); }
+
+    Result waitForStateChange(StreamState currentState,
+                              StreamState *nextState,
+                              int64_t timeoutNanoseconds) override;
+
+    ResultWithValue<int32_t> setBufferSizeInFrames(int32_t requestedFrames) override;
+
+    Result getTimestamp(clockid_t clockId,
+                        int64_t *framePosition,
+                        int64_t *timeNanoseconds) override;
+
+    /**
+     * The null backend is not a real audio API.
+     *
+     * @return AudioApi::Unspecified
+     */
+    AudioApi getAudioApi() const override {
+        return AudioApi::Unspecified;
+    }
+
+protected:
+
+    Result updateServiceFrameCounter() override { return Result::OK; }
+
+    // Reads or writes the file directly from the FIFO storage.
+    DataCallbackResult onDefaultCallback(void *audioData, int numFrames) override;
+
+    void updateFramesRead() override;
+    void updateFramesWritten() override;
+
+private:
+
+    void setState(StreamState state) {
+        mState.store(state);
+    }
+
+    // Start or stop the timer thread. These must be called under mLock.
+    void startThread_l();
+    void stopThread_l();
+    Result requestStopOrPause_l(StreamState transientState, StreamState finalState);
+
+    void runTimerThread();
+
+    // Read or write frames from or to the file.
+    void readInputFile(uint8_t *buffer, int32_t numFrames);
+    void writeOutputFile(const uint8_t *buffer, int32_t numFrames);
+
+    int64_t framesToNanos(int64_t frames) const;
+
+    static constexpr int32_t kDefaultBurstsPerBuffer = 16;
+
+    std::atomic<StreamState>   mState{StreamState::Uninitialized};
+    std::thread                mThread;
+    std::atomic<bool>          mThreadEnabled{false};
+    // Set by the thread itself so a callback can tell that it is running on the timer thread.
+    std::atomic<std::thread::id> mTimerThreadId{};
+
+    std::unique_ptr<uint8_t[]> mCallbackBuffer;
+    int32_t                    mFramesPerTimerCallback = 0;
+    double                     mSpeed = 1.0;
+    FILE                      *mFile = nullptr;
+
+    // Frames consumed or produced by the imaginary device.
+    std::atomic<int64_t>       mFramesProcessedByServer{0};
+    // Frames processed before the last start, used to calculate timestamps.
+    std::atomic<int64_t>       mStartPosition{0};
+    std::atomic<int64_t>       mStartTimeNanos{0};
+};
+
+} // namespace oboe
+
+#endif // OBOE_AUDIO_STREAM_NULL_H_
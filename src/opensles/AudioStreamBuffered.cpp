@@ -56,7 +56,9 @@ void AudioStreamBuffered::allocateFifo() {
             }
         }
 
-        mFifoBuffer = std::make_unique<FifoBuffer>(getBytesPerFrame(), capacityFrames);
+        // The app writes or reads on one thread and the callback uses the other end.
+        mFifoBuffer = std::make_unique<FifoBuffer>(getBytesPerFrame(), capacityFrames,
+                                                   true /* singleProducerSingleConsumer */);
         mBufferCapacityInFrames = capacityFrames;
         mBufferSizeInFrames = mBufferCapacityInFrames;
     }
@@ -85,7 +87,11 @@ DataCallbackResult AudioStreamBuffered::onDefaultCallback(void *audioData, int n
         // Read from audioData and write to the FIFO
         framesTransferred = mFifoBuffer->write(audioData, numFrames); // There is no writeNow()
     }
+    return finishDefaultCallback(framesTransferred, numFrames);
+}
 
+DataCallbackResult AudioStreamBuffered::finishDefaultCallback(int32_t framesTransferred,
+                                                              int32_t numFrames) {
     if (framesTransferred < numFrames) {
         LOGD("AudioStreamBuffered::%s(): xrun! framesTransferred = %d, numFrames = %d",
                 __func__, framesTransferred, numFrames);
@@ -260,8 +266,9 @@ ResultWithValue<int32_t> AudioStreamBuffered::setBufferSizeInFrames(int32_t requ
         return ResultWithValue<int32_t>(Result::ErrorUnimplemented);
     }
 
-    if (requestedFrames > mFifoBuffer->getBufferCapacityInFrames()) {
-        requestedFrames = mFifoBuffer->getBufferCapacityInFrames();
+    const int32_t capacityFrames = static_cast<int32_t>(mFifoBuffer->getBufferCapacityInFrames());
+    if (requestedFrames > capacityFrames) {
+        requestedFrames = capacityFrames;
     } else if (requestedFrames < getFramesPerBurst()) {
         requestedFrames = getFramesPerBurst();
     }
@@ -62,6 +62,12 @@ protected:
     // If there is no callback then we need a FIFO between the App and OpenSL ES.
     bool usingFIFO() const { return !isDataCallbackSpecified(); }
 
+    // For a backend that overrides onDefaultCallback() to use the FIFO regions in place.
+    FifoBuffer *getFifoBuffer() const { return mFifoBuffer.get(); }
+
+    // End onDefaultCallback(). Count an xrun if fewer frames than requested were transferred.
+    DataCallbackResult finishDefaultCallback(int32_t framesTransferred, int32_t numFrames);
+
     virtual Result updateServiceFrameCounter() = 0;
 
     void updateFramesRead() override;
@@ -0,0 +1,494 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Measure the quality and the cost of each resampler implementation.
+ *
+ * Sine waves are converted by each implementation, at each Quality and rate pair,
+ * and the output is compared with an ideal sine wave.
+ * The results are printed as a table. See README.md for the definition of each column.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "flowgraph/resampler/CascadedResampler.h"
+#include "flowgraph/resampler/LinearResampler.h"
+#include "flowgraph/resampler/MultiChannelResampler.h"
+#include "flowgraph/resampler/PolyphaseResamplerMono.h"
+#include "flowgraph/resampler/SincResamplerChannels.h"
+#include "flowgraph/resampler/VariableRatioResampler.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+namespace {
+
+constexpr int32_t kDefaultMinTimeMillis = 100;
+
+// Output frames that are skipped so the filters are full, then analyzed.
+constexpr int32_t kSettleFrames = 4096;
+constexpr int32_t kAnalysisFrames = 8192;
+
+constexpr int32_t kNumTones = 32;
+constexpr double kToneAmplitude = 0.5; // -6 dBFS
+constexpr double kThdToneHz = 997.0; // not a divisor of common rates
+constexpr double kDelayToneHz = 50.0; // long period so the delay is not ambiguous
+
+// Fraction of the lower Nyquist frequency that is treated as the passband.
+// The downsampling filter has its cutoff at 0.7 of the output Nyquist.
+constexpr double kUpsamplingPassband = 0.8;
+constexpr double kDownsamplingPassband = 0.6;
+
+const std::pair<int32_t, int32_t> kRatePairs[] = {
+        {44100, 48000},
+        {48000, 44100},
+        {16000, 48000},
+        {48000, 16000},
+        {44100, 96000},
+        {11025, 48000},
+        {44100, 192000},
+};
+
+const MultiChannelResampler::Quality kAllQualities[] = {
+        MultiChannelResampler::Quality::Fastest,
+        MultiChannelResampler::Quality::Low,
+        MultiChannelResampler::Quality::Medium,
+        MultiChannelResampler::Quality::High,
+        MultiChannelResampler::Quality::Best,
+};
+
+enum class Implementation {
+    Linear,
+    Polyphase,
+    Sinc,
+    Cascaded,
+    VariableRatio,
+};
+
+const Implementation kAllImplementations[] = {
+        Implementation::Linear,
+        Implementation::Polyphase,
+        Implementation::Sinc,
+        Implementation::Cascaded,
+        Implementation::VariableRatio,
+};
+
+const char *getImplementationName(Implementation implementation) {
+    switch (implementation) {
+        case Implementation::Linear: return "linear";
+        case Implementation::Polyphase: return "polyphase";
+        case Implementation::Sinc: return "sinc";
+        case Implementation::Cascaded: return "cascaded";
+        case Implementation::VariableRatio: return "variable";
+    }
+    return "?";
+}
+
+const char *getQualityName(MultiChannelResampler::Quality quality) {
+    switch (quality) {
+        case MultiChannelResampler::Quality::Fastest: return "fastest";
+        case MultiChannelResampler::Quality::Low: return "low";
+        case MultiChannelResampler::Quality::Medium: return "medium";
+        case MultiChannelResampler::Quality::High: return "high";
+        case MultiChannelResampler::Quality::Best: return "best";
+    }
+    return "?";
+}
+
+// Same mapping as MultiChannelResampler::make().
+int32_t getNumTaps(MultiChannelResampler::Quality quality) {
+    switch (quality) {
+        case MultiChannelResampler::Quality::Fastest: return 2;
+        case MultiChannelResampler::Quality::Low: return 4;
+        case MultiChannelResampler::Quality::Medium: return 8;
+        case MultiChannelResampler::Quality::High: return 16;
+        case MultiChannelResampler::Quality::Best: return 32;
+    }
+    return 8;
+}
+
+struct AnalysisCase {
+    Implementation implementation;
+    MultiChannelResampler::Quality quality;
+    int32_t inputRate;
+    int32_t outputRate;
+    bool isDefault; // true if MultiChannelResampler::make() would use this implementation
+
+    std::string getName() const {
+        return std::string(getImplementationName(implementation)) + "/"
+                + getQualityName(quality) + "/"
+                + std::to_string(inputRate) + "_" + std::to_string(outputRate);
+    }
+
+    /**
+     * Build a mono resampler of this type.
+     * @return resampler or nullptr if the type cannot be used for these parameters
+     */
+    MultiChannelResampler *build() const {
+        MultiChannelResampler::Builder builder;
+        builder.setChannelCount(1)
+                ->setInputRate(inputRate)
+                ->setOutputRate(outputRate)
+                ->setNumTaps(getNumTaps(quality));
+        const bool isLinear = (builder.getNumTaps() == 2);
+        switch (implementation) {
+            case Implementation::Linear:
+                return isLinear ? new LinearResampler(builder) : nullptr;
+            case Implementation::Polyphase:
+                return isLinear ? nullptr : new PolyphaseResamplerMono(builder);
+            case Implementation::Sinc:
+                return isLinear ? nullptr : new SincResamplerChannels<1>(builder);
+            case Implementation::Cascaded:
+                return CascadedResampler::planStages(builder).empty()
+                        ? nullptr : new CascadedResampler(builder);
+            case Implementation::VariableRatio:
+                return isLinear ? nullptr
+                        : new VariableRatioResampler(builder, (double) inputRate / outputRate);
+        }
+        return nullptr;
+    }
+};
+
+struct AnalysisResult {
+    double passbandHz = 0.0;
+    double rippleDecibels = 0.0;      // peak to peak gain in the passband
+    double rejectionDecibels = 0.0;   // worst image or alias, relative to the tone
+    double thdPlusNoiseDecibels = 0.0;
+    double delayFrames = 0.0;         // in output frames
+    double nanosPerFrame = 0.0;
+};
+
+struct Options {
+    std::string filter;
+    int32_t minTimeMillis = kDefaultMinTimeMillis;
+};
+
+/***************************************************************************/
+// Signal analysis
+
+/**
+ * Convert a mono signal one frame at a time.
+ */
+std::vector<float> convert(MultiChannelResampler &resampler, const std::vector<float> &input) {
+    std::vector<float> output;
+    size_t inputCursor = 0;
+    while (inputCursor < input.size()) {
+        if (resampler.isWriteNeeded()) {
+            resampler.writeNextFrame(&input[inputCursor++]);
+        } else {
+            float sample = 0.0f;
+            resampler.readNextFrame(&sample);
+            output.push_back(sample);
+        }
+    }
+    return output;
+}
+
+struct ToneFit {
+    double amplitude = 0.0;
+    double phase = 0.0;         // radians, relative to the phase at output frame zero
+    double residualRms = 0.0;   // what is left after removing the tone and DC
+};
+
+/**
+ * Fit a sine wave plus DC to part of a signal with least squares.
+ * The frequency is known so this is a linear fit of three basis functions.
+ */
+ToneFit fitTone(const std::vector<float> &signal, int32_t start, int32_t numFrames,
+                double cyclesPerFrame) {
+    double basis[3][3] = {};
+    double projection[3] = {};
+    for (int32_t i = start; i < start + numFrames; i++) {
+        const double radians = 2.0 * M_PI * cyclesPerFrame * i;
+        const double functions[3] = {sin(radians), cos(radians), 1.0};
+        for (int row = 0; row < 3; row++) {
+            for (int column = 0; column < 3; column++) {
+                basis[row][column] += functions[row] * functions[column];
+            }
+            projection[row] += functions[row] * signal[i];
+        }
+    }
+    // Solve the 3x3 normal equations with Gaussian elimination.
+    for (int pivot = 0; pivot < 3; pivot++) {
+        for (int row = pivot + 1; row < 3; row++) {
+            const double scale = basis[row][pivot] / basis[pivot][pivot];
+            for (int column = pivot; column < 3; column++) {
+                basis[row][column] -= scale * basis[pivot][column];
+            }
+            projection[row] -= scale * projection[pivot];
+        }
+    }
+    double weights[3];
+    for (int row = 2; row >= 0; row--) {
+        double sum = projection[row];
+        for (int column = row + 1; column < 3; column++) {
+            sum -= basis[row][column] * weights[column];
+        }
+        weights[row] = sum / basis[row][row];
+    }
+
+    double residualPower = 0.0;
+    for (int32_t i = start; i < start + numFrames; i++) {
+        const double radians = 2.0 * M_PI * cyclesPerFrame * i;
+        const double error = signal[i]
+                - (weights[0] * sin(radians) + weights[1] * cos(radians) + weights[2]);
+        residualPower += error * error;
+    }
+    ToneFit fit;
+    // a*sin(x) + b*cos(x) = amplitude * sin(x + phase)
+    fit.amplitude = hypot(weights[0], weights[1]);
+    fit.phase = atan2(weights[1], weights[0]);
+    fit.residualRms = sqrt(residualPower / numFrames);
+    return fit;
+}
+
+double toDecibels(double ratio) {
+    return 20.0 * log10(std::max(ratio, 1.0e-12));
+}
+
+/**
+ * Convert a tone and fit a tone of the same frequency to the output.
+ * @return false if the resampler could not be built
+ */
+bool measureTone(const AnalysisCase &analysisCase, double frequency, ToneFit *fit,
+                 double *rms) {
+    std::unique_ptr<MultiChannelResampler> resampler(analysisCase.build());
+    if (!resampler) {
+        return false;
+    }
+    const int32_t numOutputFrames = kSettleFrames + kAnalysisFrames;
+    // Add some input for the frames held in the filters.
+    const int32_t numInputFrames = (int32_t) (((int64_t) numOutputFrames
+            * analysisCase.inputRate) / analysisCase.outputRate) + 1024;
+    std::vector<float> input(numInputFrames);
+    for (int32_t i = 0; i < numInputFrames; i++) {
+        input[i] = (float) (kToneAmplitude
+                * sin(2.0 * M_PI * frequency * i / analysisCase.inputRate));
+    }
+    std::vector<float> output = convert(*resampler, input);
+    *fit = fitTone(output, kSettleFrames, kAnalysisFrames,
+                   frequency / analysisCase.outputRate);
+    double power = 0.0;
+    for (int32_t i = kSettleFrames; i < numOutputFrames; i++) {
+        power += (double) output[i] * output[i];
+    }
+    *rms = sqrt(power / kAnalysisFrames);
+    return true;
+}
+
+double measureNanosPerFrame(const AnalysisCase &analysisCase, const Options &options) {
+    using Clock = std::chrono::steady_clock;
+    constexpr int32_t kFramesPerIteration = 4096;
+    std::unique_ptr<MultiChannelResampler> resampler(analysisCase.build());
+    const int32_t numInputFrames = (int32_t) (((int64_t) kFramesPerIteration
+            * analysisCase.inputRate) / analysisCase.outputRate);
+    std::vector<float> input(numInputFrames);
+    for (int32_t i = 0; i < numInputFrames; i++) {
+        input[i] = (float) sin(i * 0.1);
+    }
+    std::vector<float> output(kFramesPerIteration);
+    const int64_t minNanos = (int64_t) options.minTimeMillis * 1000000;
+    int64_t frames = 0;
+    int64_t elapsedNanos = 0;
+    Clock::time_point start = Clock::now();
+    do {
+        const float *inputCursor = input.data();
+        int32_t inputLeft = numInputFrames;
+        int32_t framesProduced = 0;
+        while (inputLeft > 0 && framesProduced < kFramesPerIteration) {
+            MultiChannelResampler::ProcessResult result = resampler->process(
+                    inputCursor, inputLeft, &output[framesProduced],
+                    kFramesPerIteration - framesProduced);
+            inputCursor += result.framesConsumed;
+            inputLeft -= result.framesConsumed;
+            framesProduced += result.framesProduced;
+        }
+        frames += framesProduced;
+        elapsedNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - start).count();
+    } while (elapsedNanos < minNanos);
+    return (frames > 0) ? (double) elapsedNanos / frames : 0.0;
+}
+
+AnalysisResult analyze(const AnalysisCase &analysisCase, const Options &options) {
+    AnalysisResult result;
+    const bool isUpsampling = analysisCase.outputRate > analysisCase.inputRate;
+    const double inputNyquist = 0.5 * analysisCase.inputRate;
+    const double outputNyquist = 0.5 * analysisCase.outputRate;
+    result.passbandHz = std::min(inputNyquist, outputNyquist)
+            * (isUpsampling ? kUpsamplingPassband : kDownsamplingPassband);
+
+    // Sweep the passband. When upsampling anything but the tone is an image.
+    double minGain = 1.0e9;
+    double maxGain = 0.0;
+    double worstUnwanted = 0.0;
+    for (int i = 1; i <= kNumTones; i++) {
+        const double frequency = result.passbandHz * i / kNumTones;
+        ToneFit fit;
+        double rms;
+        measureTone(analysisCase, frequency, &fit, &rms);
+        const double gain = fit.amplitude / kToneAmplitude;
+        minGain = std::min(minGain, gain);
+        maxGain = std::max(maxGain, gain);
+        if (isUpsampling) {
+            worstUnwanted = std::max(worstUnwanted, fit.residualRms / (fit.amplitude * M_SQRT1_2));
+        }
+    }
+    result.rippleDecibels = toDecibels(maxGain) - toDecibels(minGain);
+
+    // When downsampling, tones above the output Nyquist frequency can only appear as aliases.
+    if (!isUpsampling) {
+        const double toneRms = kToneAmplitude * M_SQRT1_2;
+        for (int i = 0; i < kNumTones; i++) {
+            const double frequency = outputNyquist
+                    + (0.95 * inputNyquist - outputNyquist) * i / (kNumTones - 1);
+            ToneFit fit;
+            double rms;
+            measureTone(analysisCase, frequency, &fit, &rms);
+            worstUnwanted = std::max(worstUnwanted, rms / toneRms);
+        }
+    }
+    result.rejectionDecibels = -toDecibels(worstUnwanted);
+
+    ToneFit fit;
+    double rms;
+    measureTone(analysisCase, kThdToneHz, &fit, &rms);
+    result.thdPlusNoiseDecibels = toDecibels(fit.residualRms / (fit.amplitude * M_SQRT1_2));
+
+    // A delay of d seconds shifts the phase of the output by -2 * pi * f * d.
+    measureTone(analysisCase, kDelayToneHz, &fit, &rms);
+    double delayCycles = -fit.phase / (2.0 * M_PI);
+    delayCycles -= floor(delayCycles);
+    result.delayFrames = delayCycles * analysisCase.outputRate / kDelayToneHz;
+
+    result.nanosPerFrame = measureNanosPerFrame(analysisCase, options);
+    return result;
+}
+
+/***************************************************************************/
+// Cases and output
+
+std::vector<AnalysisCase> makeCases() {
+    std::vector<AnalysisCase> cases;
+    for (const auto &rates : kRatePairs) {
+        for (MultiChannelResampler::Quality quality : kAllQualities) {
+            // Find out which type make() uses.
+            std::unique_ptr<MultiChannelResampler> defaultResampler(
+                    MultiChannelResampler::make(1, rates.first, rates.second, quality));
+            for (Implementation implementation : kAllImplementations) {
+                AnalysisCase analysisCase{implementation, quality, rates.first, rates.second,
+                                          false};
+                std::unique_ptr<MultiChannelResampler> resampler(analysisCase.build());
+                if (!resampler) continue;
+                // The variable ratio resampler is never chosen by make().
+                MultiChannelResampler *defaultType = defaultResampler.get();
+                switch (implementation) {
+                    case Implementation::Linear:
+                        analysisCase.isDefault =
+                                dynamic_cast<LinearResampler *>(defaultType) != nullptr;
+                        break;
+                    case Implementation::Polyphase:
+                        analysisCase.isDefault =
+                                dynamic_cast<PolyphaseResamplerMono *>(defaultType) != nullptr;
+                        break;
+                    case Implementation::Sinc:
+                        analysisCase.isDefault =
+                                dynamic_cast<SincResamplerChannels<1> *>(defaultType) != nullptr;
+                        break;
+                    case Implementation::Cascaded:
+                        analysisCase.isDefault =
+                                dynamic_cast<CascadedResampler *>(defaultType) != nullptr;
+                        break;
+                    case Implementation::VariableRatio:
+                        break;
+                }
+                cases.push_back(analysisCase);
+            }
+        }
+    }
+    return cases;
+}
+
+void printHeader() {
+    printf("%-12s %-8s %4s %13s %1s %8s %9s %10s %9s %9s %9s\n",
+           "type", "quality", "taps", "rates", "*", "pass_hz", "ripple_db", "reject_db",
+           "thdn_db", "delay", "ns/frame");
+}
+
+void printRow(const AnalysisCase &analysisCase, const AnalysisResult &result) {
+    std::string rates = std::to_string(analysisCase.inputRate) + ">"
+            + std::to_string(analysisCase.outputRate);
+    printf("%-12s %-8s %4d %13s %1s %8.0f %9.3f %10.1f %9.1f %9.1f %9.1f\n",
+           getImplementationName(analysisCase.implementation),
+           getQualityName(analysisCase.quality),
+           getNumTaps(analysisCase.quality),
+           rates.c_str(),
+           analysisCase.isDefault ? "*" : "",
+           result.passbandHz,
+           result.rippleDecibels,
+           result.rejectionDecibels,
+           result.thdPlusNoiseDecibels,
+           result.delayFrames,
+           result.nanosPerFrame);
+    fflush(stdout);
+}
+
+void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [options]\n", program);
+    fprintf(stderr, "  --filter TEXT      only run cases whose name contains TEXT\n");
+    fprintf(stderr, "  --min-time-ms N    time spent measuring the speed, default %d\n",
+            kDefaultMinTimeMillis);
+}
+
+bool parseOptions(int argc, char **argv, Options *options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1) < argc;
+        if (arg == "--filter" && hasValue) {
+            options->filter = argv[++i];
+        } else if (arg == "--min-time-ms" && hasValue) {
+            options->minTimeMillis = std::max(1, atoi(argv[++i]));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printHeader();
+    for (const AnalysisCase &analysisCase : makeCases()) {
+        if (analysisCase.getName().find(options.filter) == std::string::npos) continue;
+        printRow(analysisCase, analyze(analysisCase, options));
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,867 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Microbenchmarks for the flowgraph nodes and the resamplers.
+ *
+ * Each case is measured in several repetitions. The median and the minimum
+ * time per output frame are reported as JSON. See README.md for the schema.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/DenormalGuard.h"
+#include "flowgraph/ChannelCountConverter.h"
+#include "flowgraph/ClipToRange.h"
+#include "flowgraph/FlowGraphNode.h"
+#include "flowgraph/LayoutConverter.h"
+#include "flowgraph/Limiter.h"
+#include "flowgraph/ManyToMultiConverter.h"
+#include "flowgraph/MonoBlend.h"
+#include "flowgraph/MonoToMultiConverter.h"
+#include "flowgraph/MultiToManyConverter.h"
+#include "flowgraph/MultiToMonoConverter.h"
+#include "flowgraph/PcmConversion.h"
+#include "flowgraph/RampLinear.h"
+#include "flowgraph/SampleRateConverter.h"
+#include "flowgraph/SinkFloat.h"
+#include "flowgraph/SinkFused.h"
+#include "flowgraph/SinkI16.h"
+#include "flowgraph/SinkI24.h"
+#include "flowgraph/SinkI32.h"
+#include "flowgraph/SinkI8_24.h"
+#include "flowgraph/SourceFloat.h"
+#include "flowgraph/SourceI16.h"
+#include "flowgraph/SourceI24.h"
+#include "flowgraph/SourceI32.h"
+#include "flowgraph/SourceI8_24.h"
+#include "flowgraph/resampler/CascadedResampler.h"
+#include "flowgraph/resampler/LinearResampler.h"
+#include "flowgraph/resampler/MultiChannelResampler.h"
+#include "flowgraph/resampler/PolyphaseResampler.h"
+#include "flowgraph/resampler/PolyphaseResamplerChannels.h"
+#include "flowgraph/resampler/PolyphaseResamplerMono.h"
+#include "flowgraph/resampler/PolyphaseResamplerStereo.h"
+#include "flowgraph/resampler/SincResampler.h"
+#include "flowgraph/resampler/SincResamplerChannels.h"
+#include "flowgraph/resampler/SincResamplerStereo.h"
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+namespace {
+
+// Increment this if the meaning of a field changes or a field is removed.
+constexpr const char *kSchema = "oboe-flowgraph-benchmark/1";
+
+constexpr int32_t kFramesPerIteration = 4096;
+constexpr int32_t kNumRepetitions = 5;
+constexpr int32_t kDefaultMinTimeMillis = 250;
+
+/**
+ * Holds a configured graph or resampler and processes kFramesPerIteration output frames.
+ */
+class BenchmarkRunner {
+public:
+    virtual ~BenchmarkRunner() = default;
+
+    /**
+     * @return number of output frames produced
+     */
+    virtual int32_t runIteration() = 0;
+};
+
+struct BenchmarkCase {
+    std::string name;  // unique and stable between releases
+    std::string group;
+    std::vector<std::pair<std::string, std::string>> params;
+    std::function<std::unique_ptr<BenchmarkRunner>()> setup;
+};
+
+struct BenchmarkResult {
+    int64_t framesProcessed = 0;
+    double nanosPerFrameMedian = 0.0;
+    double nanosPerFrameMin = 0.0;
+};
+
+struct Options {
+    std::string filter;
+    std::string outputPath;
+    int32_t minTimeMillis = kDefaultMinTimeMillis;
+    int32_t blockSize = kDefaultBufferSize;
+    bool pull = false;
+    bool listOnly = false;
+};
+
+// How the graphs are run. This is copied from the Options into each case.
+struct GraphConfig {
+    int32_t blockSize;
+    bool pull; // pull the data recursively instead of building a FlowGraphSchedule
+};
+
+/***************************************************************************/
+// PCM formats
+
+enum class Format {
+    Float,
+    I16,
+    I24,
+    I32,
+    I8_24,
+};
+
+const Format kAllFormats[] = {Format::Float, Format::I16, Format::I24, Format::I32,
+                              Format::I8_24};
+
+const char *getFormatName(Format format) {
+    switch (format) {
+        case Format::Float: return "float";
+        case Format::I16: return "i16";
+        case Format::I24: return "i24";
+        case Format::I32: return "i32";
+        case Format::I8_24: return "i8_24";
+    }
+    return "?";
+}
+
+int32_t getBytesPerSample(Format format) {
+    switch (format) {
+        case Format::I16: return sizeof(int16_t);
+        case Format::I24: return PcmConversion::kBytesPerI24Packed;
+        case Format::Float:
+        case Format::I32:
+        case Format::I8_24:
+        default:
+            return sizeof(int32_t);
+    }
+}
+
+std::unique_ptr<FlowGraphSourceBuffered> makeSource(Format format, int32_t channelCount) {
+    switch (format) {
+        case Format::Float: return std::make_unique<SourceFloat>(channelCount);
+        case Format::I16: return std::make_unique<SourceI16>(channelCount);
+        case Format::I24: return std::make_unique<SourceI24>(channelCount);
+        case Format::I32: return std::make_unique<SourceI32>(channelCount);
+        case Format::I8_24: return std::make_unique<SourceI8_24>(channelCount);
+    }
+    return nullptr;
+}
+
+std::unique_ptr<FlowGraphSink> makeSink(Format format, int32_t channelCount) {
+    switch (format) {
+        case Format::Float: return std::make_unique<SinkFloat>(channelCount);
+        case Format::I16: return std::make_unique<SinkI16>(channelCount);
+        case Format::I24: return std::make_unique<SinkI24>(channelCount);
+        case Format::I32: return std::make_unique<SinkI32>(channelCount);
+        case Format::I8_24: return std::make_unique<SinkI8_24>(channelCount);
+    }
+    return nullptr;
+}
+
+/**
+ * Fill a buffer with deterministic noise below full scale.
+ */
+std::vector<float> makeSignal(int32_t numSamples) {
+    std::vector<float> signal(numSamples);
+    uint32_t seed = 1234;
+    for (float &sample : signal) {
+        seed = (seed * 1664525u) + 1013904223u;
+        sample = (((seed >> 8) * (1.0f / (1 << 24))) * 1.8f) - 0.9f;
+    }
+    return signal;
+}
+
+std::vector<uint8_t> makeInput(Format format, int32_t numSamples) {
+    std::vector<float> signal = makeSignal(numSamples);
+    std::vector<uint8_t> bytes(numSamples * getBytesPerSample(format));
+    switch (format) {
+        case Format::Float:
+            memcpy(bytes.data(), signal.data(), bytes.size());
+            break;
+        case Format::I16:
+            PcmConversion::convertFloatToI16(signal.data(), (int16_t *) bytes.data(), numSamples);
+            break;
+        case Format::I24:
+            PcmConversion::convertFloatToP24(signal.data(), bytes.data(), numSamples);
+            break;
+        case Format::I32:
+            PcmConversion::convertFloatToI32(signal.data(), (int32_t *) bytes.data(), numSamples);
+            break;
+        case Format::I8_24:
+            PcmConversion::convertFloatToQ8_23(signal.data(), (int32_t *) bytes.data(),
+                                               numSamples);
+            break;
+    }
+    return bytes;
+}
+
+/***************************************************************************/
+// Runners
+
+/**
+ * Pulls data from a sink. The source is refilled before every iteration.
+ */
+class GraphRunner : public BenchmarkRunner {
+public:
+    GraphRunner(Format sourceFormat, int32_t sourceChannelCount, int32_t numSourceFrames)
+            : mNumSourceFrames(numSourceFrames) {
+        mSource = makeSource(sourceFormat, sourceChannelCount);
+        mInput = makeInput(sourceFormat, numSourceFrames * sourceChannelCount);
+        mLastOutput = &mSource->output;
+    }
+
+    /**
+     * Connect the node after the last node added.
+     * @return the node
+     */
+    template <class T>
+    T *add(std::unique_ptr<T> node) {
+        T *raw = node.get();
+        mLastOutput->connect(&raw->input);
+        mLastOutput = &raw->output;
+        mNodes.push_back(std::move(node));
+        return raw;
+    }
+
+    void setSink(std::unique_ptr<FlowGraphSink> sink, int32_t bytesPerFrame,
+                 const GraphConfig &graph) {
+        mLastOutput->connect(&sink->input);
+        setConnectedSink(std::move(sink), bytesPerFrame, graph);
+    }
+
+    /**
+     * Use a sink that has already been connected.
+     */
+    void setConnectedSink(std::unique_ptr<FlowGraphSink> sink, int32_t bytesPerFrame,
+                          const GraphConfig &graph) {
+        mSink = std::move(sink);
+        mSink->pullSetFramesPerBuffer(graph.blockSize);
+        if (!graph.pull) {
+            mSink->buildSchedule();
+        }
+        mOutput.resize(kFramesPerIteration * bytesPerFrame);
+    }
+
+    FlowGraphPortFloatOutput *getLastOutput() {
+        return mLastOutput;
+    }
+
+    void setLastOutput(FlowGraphPortFloatOutput *output) {
+        mLastOutput = output;
+    }
+
+    /**
+     * Keep a node alive that is not connected with add().
+     */
+    void keep(std::unique_ptr<FlowGraphNode> node) {
+        mNodes.push_back(std::move(node));
+    }
+
+    int32_t runIteration() override {
+        mSource->setData(mInput.data(), mNumSourceFrames);
+        return mSink->read(mOutput.data(), kFramesPerIteration);
+    }
+
+private:
+    const int32_t mNumSourceFrames;
+    std::unique_ptr<FlowGraphSourceBuffered> mSource;
+    std::vector<std::unique_ptr<FlowGraphNode>> mNodes;
+    std::unique_ptr<FlowGraphSink> mSink;
+    std::vector<uint8_t> mInput;
+    std::vector<uint8_t> mOutput;
+    FlowGraphPortFloatOutput *mLastOutput = nullptr;
+};
+
+/**
+ * Calls MultiChannelResampler::process() directly.
+ */
+class ResamplerRunner : public BenchmarkRunner {
+public:
+    ResamplerRunner(int32_t channelCount, int32_t inputRate, int32_t outputRate,
+                    MultiChannelResampler::Quality quality)
+            : mChannelCount(channelCount) {
+        mResampler.reset(MultiChannelResampler::make(channelCount, inputRate, outputRate,
+                                                     quality));
+        // Enough input to produce a full iteration of output.
+        mNumInputFrames = (int32_t) (((int64_t) kFramesPerIteration * inputRate) / outputRate);
+        mInput = makeSignal(mNumInputFrames * channelCount);
+        mOutput.resize(kFramesPerIteration * channelCount);
+    }
+
+    int32_t runIteration() override {
+        const float *input = mInput.data();
+        int32_t inputLeft = mNumInputFrames;
+        int32_t framesProduced = 0;
+        while (inputLeft > 0 && framesProduced < kFramesPerIteration) {
+            MultiChannelResampler::ProcessResult result = mResampler->process(
+                    input, inputLeft,
+                    &mOutput[framesProduced * mChannelCount],
+                    kFramesPerIteration - framesProduced);
+            input += result.framesConsumed * mChannelCount;
+            inputLeft -= result.framesConsumed;
+            framesProduced += result.framesProduced;
+        }
+        return framesProduced;
+    }
+
+    MultiChannelResampler *getResampler() {
+        return mResampler.get();
+    }
+
+private:
+    const int32_t mChannelCount;
+    int32_t mNumInputFrames = 0;
+    std::unique_ptr<MultiChannelResampler> mResampler;
+    std::vector<float> mInput;
+    std::vector<float> mOutput;
+};
+
+const char *getResamplerTypeName(MultiChannelResampler *resampler) {
+    // Check the derived classes first.
+    if (dynamic_cast<CascadedResampler *>(resampler)) return "Cascaded";
+    if (dynamic_cast<PolyphaseResamplerMono *>(resampler)) return "PolyphaseMono";
+    if (dynamic_cast<PolyphaseResamplerStereo *>(resampler)) return "PolyphaseStereo";
+    if (dynamic_cast<PolyphaseResamplerChannels<4> *>(resampler)) return "Polyphase4";
+    if (dynamic_cast<PolyphaseResamplerChannels<6> *>(resampler)) return "Polyphase6";
+    if (dynamic_cast<PolyphaseResamplerChannels<8> *>(resampler)) return "Polyphase8";
+    if (dynamic_cast<PolyphaseResampler *>(resampler)) return "Polyphase";
+    if (dynamic_cast<SincResamplerStereo *>(resampler)) return "SincStereo";
+    if (dynamic_cast<SincResamplerChannels<1> *>(resampler)) return "SincMono";
+    if (dynamic_cast<SincResamplerChannels<4> *>(resampler)) return "Sinc4";
+    if (dynamic_cast<SincResamplerChannels<6> *>(resampler)) return "Sinc6";
+    if (dynamic_cast<SincResamplerChannels<8> *>(resampler)) return "Sinc8";
+    if (dynamic_cast<SincResampler *>(resampler)) return "Sinc";
+    if (dynamic_cast<LinearResampler *>(resampler)) return "Linear";
+    return "Unknown";
+}
+
+const char *getQualityName(MultiChannelResampler::Quality quality) {
+    switch (quality) {
+        case MultiChannelResampler::Quality::Fastest: return "fastest";
+        case MultiChannelResampler::Quality::Low: return "low";
+        case MultiChannelResampler::Quality::Medium: return "medium";
+        case MultiChannelResampler::Quality::High: return "high";
+        case MultiChannelResampler::Quality::Best: return "best";
+    }
+    return "?";
+}
+
+/**
+ * A resonant two-pole filter with no input, like the tail of a synthesizer note or an echo.
+ * The state starts in the subnormal range so the samples show the cost of a decay to silence.
+ */
+class DecayRunner : public BenchmarkRunner {
+public:
+    explicit DecayRunner(bool isGuarded)
+            : mIsGuarded(isGuarded)
+            , mOutput(kFramesPerIteration) {}
+
+    int32_t runIteration() override {
+        oboe::DenormalGuard guard(mIsGuarded);
+        float y1 = kInitialValue;
+        float y2 = 0.0f;
+        for (float &sample : mOutput) {
+            const float y = (kFeedback1 * y1) - (kFeedback2 * y2);
+            y2 = y1;
+            y1 = y;
+            sample = y;
+        }
+        return kFramesPerIteration;
+    }
+
+private:
+    // Poles at a radius of 0.9999 and 1 kHz at 48 kHz. That rings for several seconds.
+    static constexpr float kFeedback1 = 1.98269f; // 2 * r * cos(2 * pi * 1000 / 48000)
+    static constexpr float kFeedback2 = 0.99980f; // r * r
+    static constexpr float kInitialValue = 1.0e-39f;
+
+    const bool mIsGuarded;
+    std::vector<float> mOutput;
+};
+
+/***************************************************************************/
+// Cases
+
+std::string channelsName(int32_t channelCount) {
+    return std::to_string(channelCount) + "ch";
+}
+
+std::string channelsName(int32_t inputChannelCount, int32_t outputChannelCount) {
+    return std::to_string(inputChannelCount) + "to" + std::to_string(outputChannelCount) + "ch";
+}
+
+void addSourceAndSinkCases(std::vector<BenchmarkCase> &cases, const Options &options) {
+    for (Format format : kAllFormats) {
+        for (int32_t channelCount : {1, 2, 4, 6, 8}) {
+            const GraphConfig graph{options.blockSize, options.pull};
+            cases.push_back({
+                    std::string("source/") + getFormatName(format) + "/"
+                            + channelsName(channelCount),
+                    "source",
+                    {{"format", getFormatName(format)},
+                     {"channels", std::to_string(channelCount)}},
+                    [=]() {
+                        auto runner = std::make_unique<GraphRunner>(format, channelCount,
+                                                                    kFramesPerIteration);
+                        runner->setSink(std::make_unique<SinkFloat>(channelCount),
+                                        channelCount * sizeof(float), graph);
+                        return runner;
+                    }});
+        }
+    }
+    for (Format format : kAllFormats) {
+        for (int32_t channelCount : {1, 2, 4, 6, 8}) {
+            const GraphConfig graph{options.blockSize, options.pull};
+            cases.push_back({
+                    std::string("sink/") + getFormatName(format) + "/"
+                            + channelsName(channelCount),
+                    "sink",
+                    {{"format", getFormatName(format)},
+                     {"channels", std::to_string(channelCount)}},
+                    [=]() {
+                        auto runner = std::make_unique<GraphRunner>(Format::Float, channelCount,
+                                                                    kFramesPerIteration);
+                        runner->setSink(makeSink(format, channelCount),
+                                        channelCount * getBytesPerSample(format), graph);
+                        return runner;
+                    }});
+        }
+    }
+}
+
+void addNodeCase(std::vector<BenchmarkCase> &cases, const std::string &nodeName,
+                 int32_t inputChannelCount, int32_t outputChannelCount, const Options &options,
+                 std::function<void(GraphRunner &)> connect) {
+    const GraphConfig graph{options.blockSize, options.pull};
+    cases.push_back({
+            "node/" + nodeName + "/" + channelsName(inputChannelCount, outputChannelCount),
+            "node",
+            {{"node", nodeName},
+             {"input_channels", std::to_string(inputChannelCount)},
+             {"output_channels", std::to_string(outputChannelCount)}},
+            [=]() {
+                auto runner = std::make_unique<GraphRunner>(Format::Float, inputChannelCount,
+                                                            kFramesPerIteration);
+                connect(*runner);
+                runner->setSink(std::make_unique<SinkFloat>(outputChannelCount),
+                                outputChannelCount * sizeof(float), graph);
+                return runner;
+            }});
+}
+
+void addNodeCases(std::vector<BenchmarkCase> &cases, const Options &options) {
+    addNodeCase(cases, "mono_to_multi", 1, 2, options, [](GraphRunner &runner) {
+        runner.add(std::make_unique<MonoToMultiConverter>(2));
+    });
+    addNodeCase(cases, "multi_to_mono", 2, 1, options, [](GraphRunner &runner) {
+        runner.add(std::make_unique<MultiToMonoConverter>(2));
+    });
+    addNodeCase(cases, "channel_count", 2, 6, options, [](GraphRunner &runner) {
+        runner.add(std::make_unique<ChannelCountConverter>(2, 6));
+    });
+    addNodeCase(cases, "channel_count", 6, 2, options, [](GraphRunner &runner) {
+        runner.add(std::make_unique<ChannelCountConverter>(6, 2));
+    });
+    addNodeCase(cases, "multi_to_many_to_multi", 2, 2, options, [](GraphRunner &runner) {
+        auto multiToMany = std::make_unique<MultiToManyConverter>(2);
+        auto manyToMulti = std::make_unique<ManyToMultiConverter>(2);
+        runner.getLastOutput()->connect(&multiToMany->input);
+        for (int channel = 0; channel < 2; channel++) {
+            multiToMany->outputs[channel]->connect(manyToMulti->inputs[channel].get());
+        }
+        runner.setLastOutput(&manyToMulti->output);
+        runner.keep(std::move(multiToMany));
+        runner.keep(std::move(manyToMulti));
+    });
+    for (int32_t channelCount : {2, 8}) {
+        addNodeCase(cases, "deinterleave_interleave", channelCount, channelCount, options,
+                    [channelCount](GraphRunner &runner) {
+            runner.add(std::make_unique<LayoutConverter>(channelCount,
+                                                         FlowGraphPort::Layout::Interleaved,
+                                                         FlowGraphPort::Layout::Planar));
+            runner.add(std::make_unique<LayoutConverter>(channelCount,
+                                                         FlowGraphPort::Layout::Planar,
+                                                         FlowGraphPort::Layout::Interleaved));
+        });
+    }
+    addNodeCase(cases, "mono_blend", 2, 2, options, [](GraphRunner &runner) {
+        runner.add(std::make_unique<MonoBlend>(2));
+    });
+    addNodeCase(cases, "ramp_linear", 2, 2, options, [](GraphRunner &runner) {
+        RampLinear *ramp = runner.add(std::make_unique<RampLinear>(2));
+        ramp->setLengthInFrames(kFramesPerIteration * 2);
+        ramp->setTarget(0.5f); // ramps during the first iterations
+    });
+    addNodeCase(cases, "limiter", 2, 2, options, [](GraphRunner &runner) {
+        runner.add(std::make_unique<Limiter>(2));
+    });
+    addNodeCase(cases, "clip_to_range", 2, 2, options, [](GraphRunner &runner) {
+        ClipToRange *clip = runner.add(std::make_unique<ClipToRange>(2));
+        clip->setMinimum(-0.5f);
+        clip->setMaximum(0.5f);
+    });
+
+    // MonoToMultiConverter fused into an I16 sink.
+    const GraphConfig graph{options.blockSize, options.pull};
+    cases.push_back({
+            "node/sink_fused_i16/" + channelsName(1, 2),
+            "node",
+            {{"node", "sink_fused_i16"},
+             {"input_channels", "1"},
+             {"output_channels", "2"}},
+            [=]() {
+                auto runner = std::make_unique<GraphRunner>(Format::Float, 1,
+                                                            kFramesPerIteration);
+                auto monoToStereo = std::make_unique<MonoToMultiConverter>(2);
+                auto sink = std::make_unique<SinkFused>(1, SinkFused::Format::I16);
+                sink->fuse(*monoToStereo);
+                runner->getLastOutput()->connect(&sink->input);
+                runner->keep(std::move(monoToStereo));
+                runner->setConnectedSink(std::move(sink), 2 * sizeof(int16_t), graph);
+                return runner;
+            }});
+}
+
+const std::pair<int32_t, int32_t> kRatePairs[] = {
+        {44100, 48000},
+        {48000, 44100},
+        {16000, 48000},
+        {48000, 16000},
+        {44100, 96000},
+        {11025, 48000},
+        {44100, 192000},
+};
+
+const MultiChannelResampler::Quality kAllQualities[] = {
+        MultiChannelResampler::Quality::Fastest,
+        MultiChannelResampler::Quality::Low,
+        MultiChannelResampler::Quality::Medium,
+        MultiChannelResampler::Quality::High,
+        MultiChannelResampler::Quality::Best,
+};
+
+void addResamplerCases(std::vector<BenchmarkCase> &cases) {
+    for (MultiChannelResampler::Quality quality : kAllQualities) {
+        for (int32_t channelCount : {1, 2, 4, 6, 8}) {
+            for (const auto &rates : kRatePairs) {
+                // Build one now to find out which type and kernel it uses.
+                ResamplerRunner probe(channelCount, rates.first, rates.second, quality);
+                MultiChannelResampler *resampler = probe.getResampler();
+                cases.push_back({
+                        std::string("resampler/") + getQualityName(quality) + "/"
+                                + channelsName(channelCount) + "/"
+                                + std::to_string(rates.first) + "_"
+                                + std::to_string(rates.second),
+                        "resampler",
+                        {{"type", getResamplerTypeName(resampler)},
+                         {"quality", getQualityName(quality)},
+                         {"taps", std::to_string(resampler->getNumTaps())},
+                         {"kernel", ResamplerKernels::getTypeName(
+                                 resampler->getKernelType())},
+                         {"channels", std::to_string(channelCount)},
+                         {"input_rate", std::to_string(rates.first)},
+                         {"output_rate", std::to_string(rates.second)}},
+                        [=]() {
+                            return std::make_unique<ResamplerRunner>(
+                                    channelCount, rates.first, rates.second, quality);
+                        }});
+            }
+        }
+    }
+}
+
+struct ChainSpec {
+    Format sourceFormat;
+    int32_t sourceChannelCount;
+    int32_t sourceRate;
+    Format sinkFormat;
+    int32_t sinkChannelCount;
+    int32_t sinkRate;
+    MultiChannelResampler::Quality quality;
+};
+
+const ChainSpec kChains[] = {
+        {Format::I16, 2, 48000, Format::Float, 2, 48000, MultiChannelResampler::Quality::Medium},
+        {Format::Float, 2, 48000, Format::I16, 2, 48000, MultiChannelResampler::Quality::Medium},
+        {Format::I16, 1, 48000, Format::Float, 2, 48000, MultiChannelResampler::Quality::Medium},
+        {Format::Float, 2, 44100, Format::I16, 2, 48000, MultiChannelResampler::Quality::Medium},
+        {Format::Float, 1, 44100, Format::Float, 2, 48000, MultiChannelResampler::Quality::High},
+        {Format::I16, 2, 48000, Format::Float, 1, 16000, MultiChannelResampler::Quality::Medium},
+        {Format::Float, 6, 48000, Format::Float, 2, 48000, MultiChannelResampler::Quality::Medium},
+        {Format::I24, 2, 96000, Format::I32, 2, 48000, MultiChannelResampler::Quality::High},
+};
+
+/**
+ * Connect the same nodes, in the same order, as DataConversionFlowGraph::configure().
+ * The resampler is owned here because SampleRateConverter only holds a reference.
+ */
+class ChainRunner : public GraphRunner {
+public:
+    ChainRunner(const ChainSpec &spec, const GraphConfig &graph)
+            : GraphRunner(spec.sourceFormat, spec.sourceChannelCount,
+                          (int32_t) (((int64_t) kFramesPerIteration * spec.sourceRate)
+                                     / spec.sinkRate) + 64) {
+        int32_t channelCount = spec.sourceChannelCount;
+        if (spec.sourceChannelCount > spec.sinkChannelCount) {
+            if (spec.sinkChannelCount == 1) {
+                add(std::make_unique<MultiToMonoConverter>(spec.sourceChannelCount));
+            } else {
+                add(std::make_unique<ChannelCountConverter>(spec.sourceChannelCount,
+                                                            spec.sinkChannelCount));
+            }
+            channelCount = spec.sinkChannelCount;
+        }
+        if (spec.sourceRate != spec.sinkRate) {
+            mResampler.reset(MultiChannelResampler::make(channelCount, spec.sourceRate,
+                                                         spec.sinkRate, spec.quality));
+            add(std::make_unique<SampleRateConverter>(channelCount, *mResampler));
+        }
+        if (spec.sourceChannelCount < spec.sinkChannelCount) {
+            if (spec.sourceChannelCount == 1) {
+                add(std::make_unique<MonoToMultiConverter>(spec.sinkChannelCount));
+            } else {
+                add(std::make_unique<ChannelCountConverter>(spec.sourceChannelCount,
+                                                            spec.sinkChannelCount));
+            }
+        }
+        setSink(makeSink(spec.sinkFormat, spec.sinkChannelCount),
+                spec.sinkChannelCount * getBytesPerSample(spec.sinkFormat), graph);
+    }
+
+private:
+    std::unique_ptr<MultiChannelResampler> mResampler;
+};
+
+void addChainCases(std::vector<BenchmarkCase> &cases, const Options &options) {
+    for (const ChainSpec &spec : kChains) {
+        std::string name = std::string("chain/")
+                + getFormatName(spec.sourceFormat) + "_"
+                + channelsName(spec.sourceChannelCount) + "_"
+                + std::to_string(spec.sourceRate) + "/"
+                + getFormatName(spec.sinkFormat) + "_"
+                + channelsName(spec.sinkChannelCount) + "_"
+                + std::to_string(spec.sinkRate);
+        const GraphConfig graph{options.blockSize, options.pull};
+        cases.push_back({
+                name,
+                "chain",
+                {{"source_format", getFormatName(spec.sourceFormat)},
+                 {"source_channels", std::to_string(spec.sourceChannelCount)},
+                 {"source_rate", std::to_string(spec.sourceRate)},
+                 {"sink_format", getFormatName(spec.sinkFormat)},
+                 {"sink_channels", std::to_string(spec.sinkChannelCount)},
+                 {"sink_rate", std::to_string(spec.sinkRate)},
+                 {"quality", getQualityName(spec.quality)}},
+                [=]() {
+                    return std::make_unique<ChainRunner>(spec, graph);
+                }});
+    }
+}
+
+void addDenormalCases(std::vector<BenchmarkCase> &cases) {
+    for (bool isGuarded : {false, true}) {
+        cases.push_back({
+                std::string("denormal/decay/") + (isGuarded ? "guarded" : "unguarded"),
+                "denormal",
+                {{"guarded", isGuarded ? "true" : "false"}},
+                [=]() {
+                    return std::make_unique<DecayRunner>(isGuarded);
+                }});
+    }
+}
+
+/***************************************************************************/
+// Measurement and output
+
+double measureNanosPerFrame(BenchmarkRunner &runner, int64_t minNanos, int64_t *framesProcessed) {
+    using Clock = std::chrono::steady_clock;
+    int64_t frames = 0;
+    int64_t elapsedNanos = 0;
+    Clock::time_point start = Clock::now();
+    do {
+        frames += runner.runIteration();
+        elapsedNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - start).count();
+    } while (elapsedNanos < minNanos);
+    *framesProcessed += frames;
+    return (frames > 0) ? (double) elapsedNanos / frames : 0.0;
+}
+
+BenchmarkResult runCase(const BenchmarkCase &benchmarkCase, const Options &options) {
+    std::unique_ptr<BenchmarkRunner> runner = benchmarkCase.setup();
+    const int64_t nanosPerRepetition = (int64_t) options.minTimeMillis * 1000000
+            / kNumRepetitions;
+    int64_t warmupFrames = 0;
+    measureNanosPerFrame(*runner, nanosPerRepetition / 4, &warmupFrames); // warm up caches
+
+    BenchmarkResult result;
+    std::vector<double> samples;
+    for (int i = 0; i < kNumRepetitions; i++) {
+        samples.push_back(measureNanosPerFrame(*runner, nanosPerRepetition,
+                                               &result.framesProcessed));
+    }
+    std::sort(samples.begin(), samples.end());
+    result.nanosPerFrameMedian = samples[samples.size() / 2];
+    result.nanosPerFrameMin = samples[0];
+    return result;
+}
+
+void writeJsonString(FILE *file, const std::string &text) {
+    fputc('"', file);
+    for (char c : text) {
+        if (c == '"' || c == '\\') fputc('\\', file);
+        fputc(c, file);
+    }
+    fputc('"', file);
+}
+
+void writeJson(FILE *file, const Options &options,
+               const std::vector<std::pair<const BenchmarkCase *, BenchmarkResult>> &results) {
+    fprintf(file, "{\n");
+    fprintf(file, "  \"schema\": ");
+    writeJsonString(file, kSchema);
+    fprintf(file, ",\n  \"config\": {\n");
+    fprintf(file, "    \"frames_per_iteration\": %d,\n", kFramesPerIteration);
+    fprintf(file, "    \"repetitions\": %d,\n", kNumRepetitions);
+    fprintf(file, "    \"min_time_ms\": %d,\n", options.minTimeMillis);
+    fprintf(file, "    \"block_size\": %d,\n", options.blockSize);
+    fprintf(file, "    \"scheduled\": %s,\n", options.pull ? "false" : "true");
+    fprintf(file, "    \"resampler_kernel\": ");
+    writeJsonString(file, ResamplerKernels::getTypeName(ResamplerKernels::select().type));
+    fprintf(file, ",\n    \"pcm_conversion\": ");
+    writeJsonString(file, PcmConversion::getImplementationName());
+    fprintf(file, ",\n    \"limiter\": ");
+    writeJsonString(file, Limiter::getImplementationName());
+    fprintf(file, ",\n    \"clip_to_range\": ");
+    writeJsonString(file, ClipToRange::getImplementationName());
+    fprintf(file, "\n  },\n  \"results\": [");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkCase &benchmarkCase = *results[i].first;
+        const BenchmarkResult &result = results[i].second;
+        fprintf(file, "%s\n    {\n      \"name\": ", (i == 0) ? "" : ",");
+        writeJsonString(file, benchmarkCase.name);
+        fprintf(file, ",\n      \"group\": ");
+        writeJsonString(file, benchmarkCase.group);
+        fprintf(file, ",\n      \"params\": {");
+        for (size_t p = 0; p < benchmarkCase.params.size(); p++) {
+            fprintf(file, "%s", (p == 0) ? "" : ", ");
+            writeJsonString(file, benchmarkCase.params[p].first);
+            fprintf(file, ": ");
+            writeJsonString(file, benchmarkCase.params[p].second);
+        }
+        fprintf(file, "},\n");
+        fprintf(file, "      \"frames\": %lld,\n", (long long) result.framesProcessed);
+        fprintf(file, "      \"ns_per_frame\": %.3f,\n", result.nanosPerFrameMedian);
+        fprintf(file, "      \"ns_per_frame_min\": %.3f,\n", result.nanosPerFrameMin);
+        double framesPerSecond = (result.nanosPerFrameMedian > 0.0)
+                ? 1.0e9 / result.nanosPerFrameMedian
+                : 0.0;
+        fprintf(file, "      \"frames_per_second\": %.0f\n    }", framesPerSecond);
+    }
+    fprintf(file, "\n  ]\n}\n");
+}
+
+void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [options]\n", program);
+    fprintf(stderr, "  --filter TEXT      only run cases whose name contains TEXT\n");
+    fprintf(stderr, "  --min-time-ms N    time spent measuring each case, default %d\n",
+            kDefaultMinTimeMillis);
+    fprintf(stderr, "  --block-size N     frames per flowgraph port buffer, default %d\n",
+            kDefaultBufferSize);
+    fprintf(stderr, "  --pull             pull the data recursively instead of using a schedule\n");
+    fprintf(stderr, "  --output FILE      write the JSON to FILE instead of stdout\n");
+    fprintf(stderr, "  --list             list the case names and exit\n");
+}
+
+bool parseOptions(int argc, char **argv, Options *options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1) < argc;
+        if (arg == "--filter" && hasValue) {
+            options->filter = argv[++i];
+        } else if (arg == "--min-time-ms" && hasValue) {
+            options->minTimeMillis = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--block-size" && hasValue) {
+            options->blockSize = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--pull") {
+            options->pull = true;
+        } else if (arg == "--output" && hasValue) {
+            options->outputPath = argv[++i];
+        } else if (arg == "--list") {
+            options->listOnly = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<BenchmarkCase> cases;
+    addSourceAndSinkCases(cases, options);
+    addNodeCases(cases, options);
+    addResamplerCases(cases);
+    addChainCases(cases, options);
+    addDenormalCases(cases);
+
+    std::vector<std::pair<const BenchmarkCase *, BenchmarkResult>> results;
+    for (const BenchmarkCase &benchmarkCase : cases) {
+        if (benchmarkCase.name.find(options.filter) == std::string::npos) continue;
+        if (options.listOnly) {
+            printf("%s\n", benchmarkCase.name.c_str());
+            continue;
+        }
+        BenchmarkResult result = runCase(benchmarkCase, options);
+        fprintf(stderr, "%-48s %10.3f ns/frame\n", benchmarkCase.name.c_str(),
+                result.nanosPerFrameMedian);
+        results.emplace_back(&benchmarkCase, result);
+    }
+    if (options.listOnly) {
+        return EXIT_SUCCESS;
+    }
+
+    FILE *file = stdout;
+    if (!options.outputPath.empty()) {
+        file = fopen(options.outputPath.c_str(), "w");
+        if (file == nullptr) {
+            fprintf(stderr, "ERROR - cannot open %s\n", options.outputPath.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+    writeJson(file, options, results);
+    if (file != stdout) {
+        fclose(file);
+    }
+    return EXIT_SUCCESS;
+}
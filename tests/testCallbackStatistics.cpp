@@ -0,0 +1,112 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Test the histograms that record the timing of the data callbacks.
+ */
+
+#include <gtest/gtest.h>
+
+#include "oboe/CallbackStatistics.h"
+#include "oboe/Definitions.h"
+
+using namespace oboe;
+
+TEST(TestHistogram, buckets_are_contiguous) {
+    EXPECT_EQ(0, Histogram::getBucketLowerBound(0));
+    for (int32_t i = 1; i < Histogram::kNumBuckets; i++) {
+        ASSERT_EQ(Histogram::getBucketUpperBound(i - 1) + 1, Histogram::getBucketLowerBound(i))
+                << "bucket " << i;
+        const int64_t lower = Histogram::getBucketLowerBound(i);
+        ASSERT_EQ(i, Histogram::getBucketIndex(lower));
+        ASSERT_EQ(i, Histogram::getBucketIndex(Histogram::getBucketUpperBound(i)));
+        // A bucket is at most 1/16 of its lower bound wide.
+        if (i < Histogram::kNumBuckets - 1) {
+            const int64_t width = Histogram::getBucketUpperBound(i) + 1 - lower;
+            ASSERT_LE(width * Histogram::kSubBucketCount, std::max<int64_t>(lower, 16));
+        }
+    }
+    EXPECT_EQ(0, Histogram::getBucketIndex(-5));
+    EXPECT_EQ(Histogram::kNumBuckets - 1, Histogram::getBucketIndex(INT64_MAX));
+    EXPECT_EQ(INT64_MAX, Histogram::getBucketUpperBound(Histogram::kNumBuckets - 1));
+}
+
+TEST(TestHistogram, percentiles) {
+    Histogram histogram;
+    EXPECT_EQ(0, histogram.getPercentile(50));
+    for (int64_t value = 1; value <= 1000; value++) {
+        histogram.record(value * 1000);
+    }
+    EXPECT_EQ(1000, histogram.getCount());
+    EXPECT_EQ(1000000, histogram.getMaximum());
+    // The estimate is never below the exact value and at most 1/16 above it.
+    for (double percent : {1.0, 50.0, 99.0, 99.9}) {
+        const double exact = percent * 10.0 * 1000;
+        const int64_t estimate = histogram.getPercentile(percent);
+        EXPECT_GE(estimate, exact) << percent;
+        EXPECT_LE(estimate, exact * (1.0 + 1.0 / Histogram::kSubBucketCount)) << percent;
+    }
+    EXPECT_EQ(1000000, histogram.getPercentile(100));
+}
+
+TEST(TestHistogram, reset) {
+    Histogram histogram;
+    histogram.record(5);
+    histogram.record(500);
+    EXPECT_EQ(2, histogram.getCount());
+    histogram.reset();
+    EXPECT_EQ(0, histogram.getCount());
+    EXPECT_EQ(0, histogram.getMaximum());
+    histogram.record(7);
+    EXPECT_EQ(1, histogram.getCount());
+    EXPECT_EQ(7, histogram.getMaximum());
+    EXPECT_EQ(7, histogram.getPercentile(50));
+}
+
+TEST(TestCallbackStatistics, lateness_follows_schedule) {
+    constexpr int32_t kSampleRate = 48000;
+    constexpr int32_t kFramesPerBurst = 48;
+    constexpr int64_t kPeriodNanos = kNanosPerMillisecond;
+    CallbackStatistics statistics;
+    int64_t begin = 5 * kNanosPerSecond;
+    for (int i = 0; i < 100; i++) {
+        // Every tenth callback is woken up 300 usec late.
+        const int64_t delay = (i % 10 == 5) ? 300 * kNanosPerMicrosecond : 0;
+        statistics.recordCallback(begin + delay, begin + delay + 20 * kNanosPerMicrosecond,
+                                  kFramesPerBurst, kSampleRate);
+        begin += kPeriodNanos;
+    }
+    EXPECT_EQ(100, statistics.getDurationNanos().getCount());
+    EXPECT_EQ(99, statistics.getIntervalNanos().getCount());
+    EXPECT_EQ(99, statistics.getLatenessNanos().getCount());
+    EXPECT_EQ(kFramesPerBurst, statistics.getFramesPerCallback().getPercentile(50));
+    EXPECT_EQ(20 * kNanosPerMicrosecond, statistics.getDurationNanos().getMaximum());
+    EXPECT_GE(statistics.getIntervalNanos().getPercentile(50), kPeriodNanos);
+    EXPECT_LE(statistics.getIntervalNanos().getPercentile(50),
+              kPeriodNanos + kPeriodNanos / Histogram::kSubBucketCount);
+    // The late callbacks are measured against the schedule, not the previous callback.
+    EXPECT_LT(statistics.getLatenessNanos().getPercentile(50), kNanosPerMicrosecond);
+    EXPECT_NEAR(300 * kNanosPerMicrosecond, statistics.getLatenessNanos().getMaximum(),
+                kNanosPerMicrosecond);
+
+    // A long gap, for example after a pause, restarts the schedule.
+    statistics.reset();
+    statistics.recordCallback(begin + 10 * kNanosPerSecond, begin + 10 * kNanosPerSecond,
+                              kFramesPerBurst, kSampleRate);
+    EXPECT_EQ(1, statistics.getDurationNanos().getCount());
+    EXPECT_EQ(0, statistics.getIntervalNanos().getCount());
+    EXPECT_EQ(0, statistics.getLatenessNanos().getCount());
+}
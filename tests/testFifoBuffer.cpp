@@ -0,0 +1,250 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Test FifoBuffer with the default controller and the SPSC controller.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "oboe/FifoBuffer.h"
+#include "fifo/FifoControllerSpsc.h"
+
+using namespace oboe;
+
+constexpr uint32_t kBytesPerFrame = sizeof(int32_t);
+
+static void checkWriteReadWraps(bool isSpsc, uint32_t capacity) {
+    FifoBuffer fifo(kBytesPerFrame, capacity, isSpsc);
+    ASSERT_EQ(capacity, fifo.getBufferCapacityInFrames());
+
+    // Write and read odd sizes so the data wraps around the end of the storage.
+    std::vector<int32_t> source(capacity);
+    std::vector<int32_t> destination(capacity);
+    int32_t nextWrite = 0;
+    int32_t nextRead = 0;
+    for (int pass = 0; pass < 20; pass++) {
+        int32_t numFrames = 1 + ((pass * 37) % (capacity - 1));
+        for (int32_t i = 0; i < numFrames; i++) {
+            source[i] = nextWrite + i;
+        }
+        ASSERT_EQ(numFrames, fifo.write(source.data(), numFrames));
+        nextWrite += numFrames;
+        ASSERT_EQ(static_cast<uint32_t>(numFrames), fifo.getFullFramesAvailable());
+        ASSERT_EQ(numFrames, fifo.read(destination.data(), capacity));
+        for (int32_t i = 0; i < numFrames; i++) {
+            ASSERT_EQ(nextRead++, destination[i]);
+        }
+    }
+    EXPECT_EQ(static_cast<uint64_t>(nextWrite), fifo.getWriteCounter());
+    EXPECT_EQ(static_cast<uint64_t>(nextRead), fifo.getReadCounter());
+}
+
+static void checkFullAndEmpty(bool isSpsc, uint32_t capacity) {
+    FifoBuffer fifo(kBytesPerFrame, capacity, isSpsc);
+    std::vector<int32_t> data(capacity * 2, 7);
+
+    // Only the capacity can be written.
+    EXPECT_EQ(static_cast<int32_t>(capacity), fifo.write(data.data(), capacity * 2));
+    EXPECT_EQ(0, fifo.write(data.data(), 1));
+
+    // readNow() zeroes the part it could not read.
+    std::vector<int32_t> destination(capacity * 2, -1);
+    EXPECT_EQ(static_cast<int32_t>(capacity), fifo.readNow(destination.data(), capacity * 2));
+    EXPECT_EQ(7, destination[capacity - 1]);
+    EXPECT_EQ(0, destination[capacity]);
+    EXPECT_EQ(0, fifo.read(destination.data(), 1));
+}
+
+static void checkSetCounters(bool isSpsc, uint32_t capacity) {
+    FifoBuffer fifo(kBytesPerFrame, capacity, isSpsc);
+    fifo.setWriteCounter(1000);
+    fifo.setReadCounter(1000 - 3);
+    EXPECT_EQ(3u, fifo.getFullFramesAvailable());
+    std::vector<int32_t> data(capacity);
+    EXPECT_EQ(static_cast<int32_t>(capacity - 3), fifo.write(data.data(), capacity));
+    // An underflowed FIFO has no data.
+    fifo.setReadCounter(2000);
+    EXPECT_EQ(0u, fifo.getFullFramesAvailable());
+}
+
+static void checkRegionsWrap(bool isSpsc, uint32_t capacity) {
+    FifoBuffer fifo(kBytesPerFrame, capacity, isSpsc);
+    int32_t nextWrite = 0;
+    int32_t nextRead = 0;
+    for (int pass = 0; pass < 20; pass++) {
+        int32_t numFrames = 1 + ((pass * 37) % (capacity - 1));
+        // Render directly into the FIFO.
+        FifoBuffer::Regions writeRegions = fifo.acquireWriteRegions(numFrames);
+        ASSERT_EQ(numFrames, writeRegions.getNumFrames());
+        for (int i = 0; i < 2; i++) {
+            int32_t *data = reinterpret_cast<int32_t *>(writeRegions.data[i]);
+            for (int32_t frame = 0; frame < writeRegions.numFrames[i]; frame++) {
+                data[frame] = nextWrite++;
+            }
+        }
+        // Nothing is visible until the write is committed.
+        ASSERT_EQ(0u, fifo.getFullFramesAvailable());
+        fifo.commitWrite(numFrames);
+        ASSERT_EQ(static_cast<uint32_t>(numFrames), fifo.getFullFramesAvailable());
+
+        // Consume in place, one frame less than is available.
+        FifoBuffer::Regions readRegions = fifo.acquireReadRegions(capacity);
+        ASSERT_EQ(numFrames, readRegions.getNumFrames());
+        int32_t framesToConsume = numFrames - 1;
+        for (int i = 0; i < 2 && framesToConsume > 0; i++) {
+            const int32_t *data = reinterpret_cast<const int32_t *>(readRegions.data[i]);
+            int32_t framesInRegion = std::min(framesToConsume, readRegions.numFrames[i]);
+            for (int32_t frame = 0; frame < framesInRegion; frame++) {
+                ASSERT_EQ(nextRead++, data[frame]);
+            }
+            framesToConsume -= framesInRegion;
+        }
+        fifo.commitRead(numFrames - 1);
+        // The frame that was not committed is still there.
+        int32_t last = -1;
+        ASSERT_EQ(1, fifo.read(&last, 1));
+        ASSERT_EQ(nextRead++, last);
+    }
+    EXPECT_EQ(static_cast<uint64_t>(nextWrite), fifo.getWriteCounter());
+    EXPECT_EQ(static_cast<uint64_t>(nextRead), fifo.getReadCounter());
+}
+
+static void checkRegionsFull(bool isSpsc, uint32_t capacity) {
+    FifoBuffer fifo(kBytesPerFrame, capacity, isSpsc);
+    EXPECT_EQ(0, fifo.acquireReadRegions(10).getNumFrames());
+    EXPECT_EQ(0, fifo.acquireWriteRegions(0).getNumFrames());
+
+    FifoBuffer::Regions regions = fifo.acquireWriteRegions(capacity * 2);
+    EXPECT_EQ(static_cast<int32_t>(capacity), regions.getNumFrames());
+    EXPECT_EQ(0, regions.numFrames[1]);
+    fifo.commitWrite(regions.getNumFrames());
+    EXPECT_EQ(0, fifo.acquireWriteRegions(1).getNumFrames());
+}
+
+/**
+ * One thread writes a sequence while another thread reads it back and checks it.
+ * The throughput is printed so the controllers can be compared.
+ */
+static void checkTwoThreadStress(bool isSpsc, uint32_t capacity) {
+    constexpr int32_t kTotalFrames = 2 * 1024 * 1024;
+    FifoBuffer fifo(kBytesPerFrame, capacity, isSpsc);
+    std::atomic<bool> failed{false};
+
+    auto startTime = std::chrono::steady_clock::now();
+    std::thread writer([&]() {
+        std::vector<int32_t> buffer(capacity);
+        int32_t next = 0;
+        int32_t chunk = 1;
+        while (next < kTotalFrames && !failed) {
+            int32_t numFrames = std::min(chunk, kTotalFrames - next);
+            for (int32_t i = 0; i < numFrames; i++) {
+                buffer[i] = next + i;
+            }
+            int32_t written = fifo.write(buffer.data(), numFrames);
+            // Frames that were not written are written again on the next pass.
+            next += written;
+            if (written == 0) {
+                std::this_thread::yield(); // in case both threads share one CPU
+            }
+            chunk = (chunk % (capacity / 2)) + 1;
+        }
+    });
+
+    std::vector<int32_t> buffer(capacity);
+    int32_t expected = 0;
+    int32_t chunk = 3;
+    while (expected < kTotalFrames && !failed) {
+        int32_t numRead = fifo.read(buffer.data(), chunk);
+        for (int32_t i = 0; i < numRead; i++) {
+            if (buffer[i] != expected + i) {
+                failed = true;
+                break;
+            }
+        }
+        expected += numRead;
+        if (numRead == 0) {
+            std::this_thread::yield();
+        }
+        chunk = (chunk % (capacity / 2)) + 1;
+    }
+    writer.join();
+    auto elapsed = std::chrono::steady_clock::now() - startTime;
+
+    ASSERT_FALSE(failed) << "data was corrupted near frame " << expected;
+    ASSERT_EQ(static_cast<uint64_t>(kTotalFrames), fifo.getReadCounter());
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    printf("%s capacity %u: %.1f Mframes/second\n", isSpsc ? "SPSC   " : "default",
+           capacity, kTotalFrames / (seconds * 1.0e6));
+}
+
+TEST(TestFifoBuffer, write_read_wraps) {
+    checkWriteReadWraps(false, 256);
+    checkWriteReadWraps(false, 250);
+    checkWriteReadWraps(true, 256);
+    checkWriteReadWraps(true, 250);
+}
+
+TEST(TestFifoBuffer, full_and_empty) {
+    checkFullAndEmpty(false, 256);
+    checkFullAndEmpty(false, 250);
+    checkFullAndEmpty(true, 256);
+    checkFullAndEmpty(true, 250);
+}
+
+TEST(TestFifoBuffer, set_counters) {
+    checkSetCounters(false, 256);
+    checkSetCounters(false, 250);
+    checkSetCounters(true, 256);
+    checkSetCounters(true, 250);
+}
+
+TEST(TestFifoBuffer, two_thread_stress) {
+    checkTwoThreadStress(false, 256);
+    checkTwoThreadStress(false, 250);
+    checkTwoThreadStress(true, 256);
+    checkTwoThreadStress(true, 250);
+}
+
+TEST(TestFifoBuffer, regions_wrap) {
+    checkRegionsWrap(false, 256);
+    checkRegionsWrap(false, 250);
+    checkRegionsWrap(true, 256);
+    checkRegionsWrap(true, 250);
+}
+
+TEST(TestFifoBuffer, regions_full_and_empty) {
+    checkRegionsFull(false, 256);
+    checkRegionsFull(true, 250);
+}
+
+TEST(TestFifoControllerSpsc, mask_for_power_of_two) {
+    EXPECT_TRUE(FifoControllerSpsc(1024).isMasked());
+    EXPECT_FALSE(FifoControllerSpsc(1000).isMasked());
+    EXPECT_FALSE(FifoControllerSpsc(1).isMasked());
+}
+
+TEST(TestFifoControllerSpsc, counters_on_separate_cache_lines) {
+    EXPECT_EQ(0u, alignof(FifoControllerSpsc) % FifoControllerSpsc::kCacheLineSizeBytes);
+    EXPECT_GE(sizeof(FifoControllerSpsc), 3 * FifoControllerSpsc::kCacheLineSizeBytes);
+}
@@ -18,22 +18,40 @@
  * Test FlowGraph
  */
 
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <vector>
 #include "stdio.h"
 
 #include <gtest/gtest.h>
 #include <oboe/Oboe.h>
 
+#include "flowgraph/ChannelCountConverter.h"
+#include "flowgraph/ChannelMixer.h"
 #include "flowgraph/ClipToRange.h"
+#include "flowgraph/FlowGraphSchedule.h"
+#include "flowgraph/FlowGraphWorkerPool.h"
+#include "flowgraph/GraphCrossfader.h"
+#include "flowgraph/LayoutConverter.h"
 #include "flowgraph/Limiter.h"
+#include "flowgraph/ManyToMultiConverter.h"
 #include "flowgraph/MonoToMultiConverter.h"
+#include "flowgraph/MultiToManyConverter.h"
+#include "flowgraph/ParameterAutomation.h"
+#include "flowgraph/PcmConversion.h"
 #include "flowgraph/SourceFloat.h"
 #include "flowgraph/RampLinear.h"
+#include "flowgraph/SampleRateConverter.h"
 #include "flowgraph/SinkFloat.h"
+#include "flowgraph/SinkFused.h"
 #include "flowgraph/SinkI16.h"
 #include "flowgraph/SinkI24.h"
 #include "flowgraph/SinkI32.h"
 #include "flowgraph/SourceI16.h"
 #include "flowgraph/SourceI24.h"
+#include "common/DataConversionFlowGraph.h"
 
 using namespace oboe::flowgraph;
 
@@ -267,3 +285,1139 @@ TEST(test_flowgraph, module_limiter_nan) {
         EXPECT_NEAR(expected[i], output[i], tolerance);
     }
 }
+
+// A NaN holds the previous output of its own channel in both layouts and when fused.
+TEST(test_flowgraph, module_limiter_nan_layouts) {
+    constexpr int kChannelCount = 3;
+    constexpr int kNumFrames = 41;
+    constexpr int kFramesPerBuffer = 16; // so the hold carries across blocks
+    float input[kNumFrames * kChannelCount];
+    float expected[kNumFrames * kChannelCount];
+    for (int channel = 0; channel < kChannelCount; channel++) {
+        float lastValidOutput = 0.0f;
+        for (int frame = 0; frame < kNumFrames; frame++) {
+            const int i = frame * kChannelCount + channel;
+            // Runs of NaN of different lengths in each channel, including at the start.
+            const bool isNan = ((frame + channel) % (channel + 3)) < (channel + 1);
+            input[i] = isNan ? NAN : (channel + 1) * 0.7f * ((frame % 5) - 2);
+            if (!isNan) {
+                lastValidOutput = Limiter::processFloat(input[i]);
+            }
+            expected[i] = lastValidOutput;
+        }
+    }
+
+    for (FlowGraphPort::Layout layout : {FlowGraphPort::Layout::Interleaved,
+                                         FlowGraphPort::Layout::Planar}) {
+        float output[kNumFrames * kChannelCount] = {};
+        SourceFloat sourceFloat{kChannelCount};
+        Limiter limiter{kChannelCount};
+        SinkFloat sinkFloat{kChannelCount};
+        limiter.input.setLayout(layout);
+        limiter.output.setLayout(layout);
+        sourceFloat.setData(input, kNumFrames);
+        auto toPlanar = LayoutConverter::connect(sourceFloat.output, limiter.input);
+        auto toInterleaved = LayoutConverter::connect(limiter.output, sinkFloat.input);
+        sinkFloat.pullSetFramesPerBuffer(kFramesPerBuffer);
+        ASSERT_EQ(kNumFrames, sinkFloat.read(output, kNumFrames));
+        for (int i = 0; i < kNumFrames * kChannelCount; i++) {
+            ASSERT_EQ(expected[i], output[i])
+                    << "planar = " << (layout == FlowGraphPort::Layout::Planar) << ", i = " << i;
+        }
+    }
+
+    float output[kNumFrames * kChannelCount] = {};
+    SourceFloat sourceFloat{kChannelCount};
+    Limiter limiter{kChannelCount};
+    SinkFused sinkFused{kChannelCount, SinkFused::Format::Float};
+    ASSERT_TRUE(sinkFused.fuse(limiter));
+    sourceFloat.setData(input, kNumFrames);
+    sourceFloat.output.connect(&sinkFused.input);
+    sinkFused.pullSetFramesPerBuffer(kFramesPerBuffer);
+    ASSERT_EQ(kNumFrames, sinkFused.read(output, kNumFrames));
+    for (int i = 0; i < kNumFrames * kChannelCount; i++) {
+        ASSERT_EQ(expected[i], output[i]) << "fused, i = " << i;
+    }
+}
+
+// Call check() with blocks of float bit patterns. Every pattern from denseBegin to denseEnd
+// is used with either sign. The other patterns are sampled.
+static void forEachFloatBlock(uint32_t denseBegin, uint32_t denseEnd,
+                              const std::function<void(const float *, int32_t)> &check) {
+    constexpr int kBlockSize = 4099; // odd so the scalar tail is used
+    constexpr uint32_t kStride = 1 << 12;
+    std::vector<float> block;
+    block.reserve(kBlockSize);
+    auto add = [&](uint32_t bits) {
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        block.push_back(value);
+        if (block.size() == kBlockSize) {
+            check(block.data(), kBlockSize);
+            block.clear();
+        }
+    };
+    for (uint32_t sign : {0u, 0x80000000u}) {
+        for (uint32_t bits = denseBegin; bits < denseEnd; bits++) {
+            add(sign | bits);
+        }
+    }
+    for (uint64_t bits = 0; bits <= UINT32_MAX; bits += kStride - 1) {
+        add(static_cast<uint32_t>(bits));
+    }
+    check(block.data(), static_cast<int32_t>(block.size()));
+}
+
+static uint32_t getFloatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+TEST(test_flowgraph, module_limiter_simd_matches_scalar) {
+    printf("Limiter uses %s\n", Limiter::getImplementationName());
+    std::vector<float> output;
+    float lastValidOutput = 0.0f;
+    float expectedLastValidOutput = 0.0f;
+    // All of [1.0, 2.0), which has the spline and the knee.
+    forEachFloatBlock(0x3F800000u, 0x40000000u, [&](const float *input, int32_t numSamples) {
+        output.resize(numSamples);
+        lastValidOutput = Limiter::limit(input, output.data(), numSamples, lastValidOutput);
+        for (int32_t i = 0; i < numSamples; i++) {
+            if (!std::isnan(input[i])) {
+                expectedLastValidOutput = Limiter::processFloat(input[i]);
+            }
+            ASSERT_EQ(getFloatBits(expectedLastValidOutput), getFloatBits(output[i]))
+                    << "input = " << input[i] << ", bits = " << getFloatBits(input[i]);
+        }
+        ASSERT_EQ(getFloatBits(expectedLastValidOutput), getFloatBits(lastValidOutput));
+    });
+}
+
+TEST(test_flowgraph, module_limiter_nan_patterns) {
+    // Every pattern of NaNs in 8 samples, at every alignment.
+    constexpr int kNumSamples = 12;
+    for (int offset = 0; offset < 4; offset++) {
+        for (int pattern = 0; pattern < 256; pattern++) {
+            float input[kNumSamples];
+            float output[kNumSamples];
+            for (int i = 0; i < kNumSamples; i++) {
+                const int bit = i - offset;
+                const bool isNan = bit >= 0 && bit < 8 && ((pattern >> bit) & 1) != 0;
+                input[i] = isNan ? NAN : (i + 1) * 0.1f;
+            }
+            Limiter::limit(input, output, kNumSamples, -1.0f);
+            float expected = -1.0f;
+            for (int i = 0; i < kNumSamples; i++) {
+                if (!std::isnan(input[i])) {
+                    expected = Limiter::processFloat(input[i]);
+                }
+                ASSERT_EQ(expected, output[i])
+                        << "offset = " << offset << ", pattern = " << pattern << ", i = " << i;
+            }
+        }
+    }
+}
+
+TEST(test_flowgraph, module_clip_to_range_simd_matches_scalar) {
+    printf("ClipToRange uses %s\n", ClipToRange::getImplementationName());
+    std::vector<float> output;
+    for (auto range : {std::make_pair(kDefaultMinHeadroom, kDefaultMaxHeadroom),
+                       std::make_pair(-1.2f, 1.7f),
+                       std::make_pair(0.0f, 0.0f)}) {
+        forEachFloatBlock(0, 0, [&](const float *input, int32_t numSamples) {
+            output.resize(numSamples);
+            ClipToRange::clip(input, output.data(), numSamples, range.first, range.second);
+            for (int32_t i = 0; i < numSamples; i++) {
+                const float expected = std::min(range.second, std::max(range.first, input[i]));
+                ASSERT_EQ(getFloatBits(expected), getFloatBits(output[i]))
+                        << "input = " << input[i] << ", bits = " << getFloatBits(input[i]);
+            }
+        });
+    }
+}
+
+TEST(test_flowgraph, module_sink_fused_channels) {
+    static const int16_t input[] = {100, -200, 300, -400, 500, -600, 32767, -32768};
+    constexpr int kNumInputFrames = 4; // stereo
+    int16_t expected[kNumInputFrames * 4] = {};
+    int16_t output[kNumInputFrames * 4] = {};
+
+    // Reference graph with separate nodes.
+    SourceI16 source1{2};
+    ChannelCountConverter converter1{2, 4};
+    SinkI16 sink1{4};
+    source1.setData(input, kNumInputFrames);
+    source1.output.connect(&converter1.input);
+    converter1.output.connect(&sink1.input);
+    ASSERT_EQ(kNumInputFrames, sink1.read(expected, kNumInputFrames));
+
+    // Same graph with the converter fused into the sink.
+    SourceI16 source2{2};
+    ChannelCountConverter converter2{2, 4};
+    SinkFused sink2{2, SinkFused::Format::I16};
+    ASSERT_TRUE(sink2.fuse(converter2));
+    ASSERT_EQ(4, sink2.getOutputChannelCount());
+    source2.setData(input, kNumInputFrames);
+    source2.output.connect(&sink2.input);
+    ASSERT_EQ(kNumInputFrames, sink2.read(output, kNumInputFrames));
+
+    for (int i = 0; i < kNumInputFrames * 4; i++) {
+        EXPECT_EQ(expected[i], output[i]);
+    }
+    // Channels wrap around.
+    EXPECT_EQ(input[0], output[2]);
+    EXPECT_EQ(input[1], output[3]);
+}
+
+TEST(test_flowgraph, module_sink_fused_operations) {
+    constexpr int kNumFrames = 50;
+    constexpr int kRampSize = 7;
+    float input[kNumFrames];
+    for (int i = 0; i < kNumFrames; i++) {
+        input[i] = (i == 20) ? NAN : (i - 25) * 0.1f;
+    }
+    float expected[kNumFrames * 2] = {};
+    float output[kNumFrames * 2] = {};
+
+    SourceFloat source1{1};
+    RampLinear ramp1{1};
+    Limiter limiter1{1};
+    ClipToRange clip1{1};
+    MonoToMultiConverter monoToStereo1{2};
+    SinkFloat sink1{2};
+    ramp1.setLengthInFrames(kRampSize);
+    ramp1.setTarget(0.5f);
+    clip1.setMinimum(-1.2f);
+    clip1.setMaximum(1.3f);
+    source1.setData(input, kNumFrames);
+    source1.output.connect(&ramp1.input);
+    ramp1.output.connect(&limiter1.input);
+    limiter1.output.connect(&clip1.input);
+    clip1.output.connect(&monoToStereo1.input);
+    monoToStereo1.output.connect(&sink1.input);
+
+    SourceFloat source2{1};
+    RampLinear ramp2{1};
+    Limiter limiter2{1};
+    ClipToRange clip2{1};
+    MonoToMultiConverter monoToStereo2{2};
+    SinkFused sink2{1, SinkFused::Format::Float};
+    ramp2.setLengthInFrames(kRampSize);
+    ramp2.setTarget(0.5f);
+    clip2.setMinimum(-1.2f);
+    clip2.setMaximum(1.3f);
+    ASSERT_TRUE(sink2.fuse(ramp2));
+    ASSERT_TRUE(sink2.fuse(limiter2));
+    ASSERT_TRUE(sink2.fuse(clip2));
+    ASSERT_TRUE(sink2.fuse(monoToStereo2));
+    source2.setData(input, kNumFrames);
+    source2.output.connect(&sink2.input);
+
+    // Read part of the data then start a ramp in the middle.
+    constexpr int kFirstRead = 11;
+    ASSERT_EQ(kFirstRead, sink1.read(expected, kFirstRead));
+    ASSERT_EQ(kFirstRead, sink2.read(output, kFirstRead));
+    ramp1.setTarget(3.0f);
+    ramp2.setTarget(3.0f);
+    constexpr int kSecondRead = kNumFrames - kFirstRead;
+    ASSERT_EQ(kSecondRead, sink1.read(&expected[kFirstRead * 2], kSecondRead));
+    ASSERT_EQ(kSecondRead, sink2.read(&output[kFirstRead * 2], kSecondRead));
+
+    for (int i = 0; i < kNumFrames * 2; i++) {
+        EXPECT_EQ(expected[i], output[i]) << "i = " << i;
+    }
+}
+
+TEST(test_flowgraph, module_sink_fused_rejects) {
+    SourceFloat source{2};
+    ChannelCountConverter converter{1, 2}; // wrong input channel count
+    SinkFused sink{2, SinkFused::Format::Float};
+    EXPECT_FALSE(sink.fuse(converter));
+    EXPECT_FALSE(sink.fuse(source)); // sources cannot be fused
+}
+
+TEST(test_flowgraph, module_set_frames_per_buffer) {
+    constexpr int kNumFrames = 100;
+    constexpr int kFramesPerBuffer = 64;
+    float input[kNumFrames];
+    float output[kNumFrames * 2] = {};
+    for (int i = 0; i < kNumFrames; i++) {
+        input[i] = i * 0.01f;
+    }
+    SourceFloat sourceFloat{1};
+    MonoToMultiConverter monoToStereo{2};
+    SinkFloat sinkFloat{2};
+    sourceFloat.setData(input, kNumFrames);
+    sourceFloat.output.connect(&monoToStereo.input);
+    monoToStereo.output.connect(&sinkFloat.input);
+
+    sinkFloat.pullSetFramesPerBuffer(kFramesPerBuffer);
+    EXPECT_EQ(kFramesPerBuffer, sourceFloat.output.getFramesPerBuffer());
+    EXPECT_EQ(kFramesPerBuffer, monoToStereo.input.getFramesPerBuffer());
+    EXPECT_EQ(kFramesPerBuffer, monoToStereo.output.getFramesPerBuffer());
+    EXPECT_EQ(kFramesPerBuffer, sinkFloat.input.getFramesPerBuffer());
+
+    // The source should only be pulled twice. The call count starts at zero.
+    ASSERT_EQ(kNumFrames, sinkFloat.read(output, kNumFrames));
+    EXPECT_EQ(1, sourceFloat.getLastCallCount());
+    for (int i = 0; i < kNumFrames; i++) {
+        EXPECT_EQ(input[i], output[i * 2]);
+        EXPECT_EQ(input[i], output[i * 2 + 1]);
+    }
+}
+
+TEST(test_flowgraph, module_set_frames_per_buffer_keeps_value) {
+    constexpr int kNumFrames = 40;
+    constexpr float value = 0.25f;
+    float output[kNumFrames] = {};
+    RampLinear rampLinear{1};
+    SinkFloat sinkFloat{1};
+    rampLinear.input.setValue(value);
+    rampLinear.setTarget(2.0f);
+    rampLinear.output.connect(&sinkFloat.input);
+
+    // The value set on the unconnected input must survive the resize.
+    sinkFloat.pullSetFramesPerBuffer(32);
+    ASSERT_EQ(kNumFrames, sinkFloat.read(output, kNumFrames));
+    for (int i = 0; i < kNumFrames; i++) {
+        EXPECT_EQ(value * 2.0f, output[i]) << "i = " << i;
+    }
+}
+
+TEST(test_flowgraph, layout_interleave_round_trip) {
+    for (int32_t channelCount = 1; channelCount <= 9; channelCount++) {
+        for (int32_t numFrames : {1, 2, 3, 7, 64, 67}) {
+            const int32_t channelStride = numFrames + 5; // not a multiple of the SIMD width
+            std::vector<float> interleaved(numFrames * channelCount);
+            for (size_t i = 0; i < interleaved.size(); i++) {
+                interleaved[i] = static_cast<float>(i);
+            }
+            std::vector<float> planar(channelStride * channelCount, -1.0f);
+            LayoutConverter::deinterleave(interleaved.data(), planar.data(),
+                                          channelCount, numFrames, channelStride);
+            for (int32_t channel = 0; channel < channelCount; channel++) {
+                for (int32_t frame = 0; frame < numFrames; frame++) {
+                    ASSERT_EQ(interleaved[frame * channelCount + channel],
+                              planar[channel * channelStride + frame])
+                            << "channels = " << channelCount << ", frames = " << numFrames;
+                }
+                // The gap between the channels is not touched.
+                for (int32_t frame = numFrames; frame < channelStride; frame++) {
+                    ASSERT_EQ(-1.0f, planar[channel * channelStride + frame]);
+                }
+            }
+            std::vector<float> output(interleaved.size(), -1.0f);
+            LayoutConverter::interleave(planar.data(), channelStride, output.data(),
+                                        channelCount, numFrames);
+            ASSERT_EQ(interleaved, output)
+                    << "channels = " << channelCount << ", frames = " << numFrames;
+        }
+    }
+}
+
+// Run the same filters with interleaved and planar ports and compare the results.
+TEST(test_flowgraph, module_planar_filters) {
+    constexpr int kChannelCount = 3;
+    constexpr int kNumFrames = 100;
+    constexpr int kFramesPerBuffer = 16;
+    constexpr int kRampFrames = 37; // more than one buffer
+    float input[kNumFrames * kChannelCount];
+    for (int i = 0; i < kNumFrames * kChannelCount; i++) {
+        input[i] = ((i % 7) - 3) * 0.6f;
+    }
+    float expected[kNumFrames * kChannelCount] = {};
+    float output[kNumFrames * kChannelCount] = {};
+
+    for (FlowGraphPort::Layout layout : {FlowGraphPort::Layout::Interleaved,
+                                         FlowGraphPort::Layout::Planar}) {
+        SourceFloat sourceFloat{kChannelCount};
+        ClipToRange clipper{kChannelCount};
+        RampLinear rampLinear{kChannelCount};
+        Limiter limiter{kChannelCount};
+        SinkFloat sinkFloat{kChannelCount};
+        for (FlowGraphPortFloat *port : std::vector<FlowGraphPortFloat *>{
+                &clipper.input, &clipper.output, &rampLinear.input, &rampLinear.output,
+                &limiter.input, &limiter.output}) {
+            port->setLayout(layout);
+        }
+        sourceFloat.setData(input, kNumFrames);
+        clipper.setMinimum(-1.2f);
+        clipper.setMaximum(1.7f);
+        rampLinear.setLengthInFrames(kRampFrames);
+        rampLinear.setTarget(0.5f);
+
+        auto toPlanar = LayoutConverter::connect(sourceFloat.output, clipper.input);
+        clipper.output.connect(&rampLinear.input);
+        rampLinear.output.connect(&limiter.input);
+        auto toInterleaved = LayoutConverter::connect(limiter.output, sinkFloat.input);
+        EXPECT_EQ(layout == FlowGraphPort::Layout::Planar, toPlanar != nullptr);
+        EXPECT_EQ(layout == FlowGraphPort::Layout::Planar, toInterleaved != nullptr);
+        sinkFloat.pullSetFramesPerBuffer(kFramesPerBuffer);
+
+        float *destination = (layout == FlowGraphPort::Layout::Planar) ? output : expected;
+        ASSERT_EQ(5, sinkFloat.read(destination, 5));
+        rampLinear.setTarget(2.0f);
+        ASSERT_EQ(kNumFrames - 5, sinkFloat.read(destination + 5 * kChannelCount,
+                                                 kNumFrames - 5));
+    }
+    for (int i = 0; i < kNumFrames * kChannelCount; i++) {
+        ASSERT_NEAR(expected[i], output[i], 0.00001f) << "i = " << i;
+    }
+}
+
+TEST(test_flowgraph, module_planar_split_and_merge) {
+    constexpr int kChannelCount = 5;
+    constexpr int kNumFrames = 50;
+    float input[kNumFrames * kChannelCount];
+    float output[kNumFrames * kChannelCount] = {};
+    for (int i = 0; i < kNumFrames * kChannelCount; i++) {
+        input[i] = i * 0.001f;
+    }
+    SourceFloat sourceFloat{kChannelCount};
+    MultiToManyConverter splitter{kChannelCount};
+    ManyToMultiConverter merger{kChannelCount};
+    SinkFloat sinkFloat{kChannelCount};
+    splitter.input.setLayout(FlowGraphPort::Layout::Planar);
+    merger.output.setLayout(FlowGraphPort::Layout::Planar);
+
+    sourceFloat.setData(input, kNumFrames);
+    auto toPlanar = LayoutConverter::connect(sourceFloat.output, splitter.input);
+    for (int ch = 0; ch < kChannelCount; ch++) {
+        splitter.outputs[ch]->connect(merger.inputs[ch].get());
+    }
+    auto toInterleaved = LayoutConverter::connect(merger.output, sinkFloat.input);
+    ASSERT_NE(nullptr, toPlanar);
+    ASSERT_NE(nullptr, toInterleaved);
+
+    ASSERT_EQ(kNumFrames, sinkFloat.read(output, kNumFrames));
+    for (int i = 0; i < kNumFrames * kChannelCount; i++) {
+        ASSERT_EQ(input[i], output[i]) << "i = " << i;
+    }
+}
+
+// A graph that splits into two branches and merges them again.
+class BranchedGraph {
+public:
+    explicit BranchedGraph(const float *input, int32_t numFrames) {
+        source.setData(input, numFrames);
+        source.output.connect(&splitter.input);
+        splitter.outputs[0]->connect(&clipper.input);
+        splitter.outputs[1]->connect(&ramp.input);
+        clipper.output.connect(merger.inputs[0].get());
+        ramp.output.connect(merger.inputs[1].get());
+        merger.output.connect(&limiter.input);
+        limiter.output.connect(&sink.input);
+        clipper.setMinimum(-0.3f);
+        clipper.setMaximum(0.4f);
+        ramp.setLengthInFrames(13);
+        ramp.setTarget(0.25f);
+    }
+
+    SourceFloat source{2};
+    MultiToManyConverter splitter{2};
+    ClipToRange clipper{1};
+    RampLinear ramp{1};
+    ManyToMultiConverter merger{2};
+    Limiter limiter{2};
+    SinkFloat sink{2};
+};
+
+TEST(test_flowgraph, schedule_order) {
+    float input[2] = {};
+    BranchedGraph graph(input, 1);
+    FlowGraphSchedule schedule;
+    schedule.build(graph.sink);
+    ASSERT_EQ(7, schedule.getNodeCount());
+    EXPECT_EQ(&graph.source, schedule.getNode(0));
+    EXPECT_EQ(&graph.splitter, schedule.getNode(1));
+    EXPECT_EQ(&graph.merger, schedule.getNode(4));
+    EXPECT_EQ(&graph.limiter, schedule.getNode(5));
+    EXPECT_EQ(&graph.sink, schedule.getNode(6));
+}
+
+TEST(test_flowgraph, schedule_matches_pull) {
+    constexpr int kNumFrames = 101; // ends in the middle of a block
+    float input[kNumFrames * 2];
+    for (int i = 0; i < kNumFrames * 2; i++) {
+        input[i] = sinf(i * 0.3f) * 1.6f;
+    }
+    float expected[kNumFrames * 2] = {};
+    float output[kNumFrames * 2] = {};
+    for (bool scheduled : {false, true}) {
+        BranchedGraph graph(input, kNumFrames);
+        graph.sink.pullSetFramesPerBuffer(16);
+        if (scheduled) {
+            graph.sink.buildSchedule();
+            ASSERT_NE(nullptr, graph.sink.getSchedule());
+        }
+        float *destination = scheduled ? output : expected;
+        ASSERT_EQ(7, graph.sink.read(destination, 7));
+        graph.ramp.setTarget(1.5f); // ramps across several blocks
+        // Ask for more than the source has.
+        ASSERT_EQ(kNumFrames - 7, graph.sink.read(destination + 7 * 2, kNumFrames));
+    }
+    for (int i = 0; i < kNumFrames * 2; i++) {
+        ASSERT_EQ(expected[i], output[i]) << "i = " << i;
+    }
+}
+
+TEST(test_flowgraph, schedule_branches) {
+    float input[2] = {};
+    BranchedGraph graph(input, 1);
+    FlowGraphSchedule schedule;
+    schedule.build(graph.sink);
+    // The clipper and the ramp are the branches. The splitter feeds both.
+    EXPECT_EQ(2, schedule.getBranchCount());
+
+    // Two sources merged into one sink.
+    SourceFloat left{1};
+    SourceFloat right{1};
+    RampLinear ramp{1};
+    ManyToMultiConverter merger{2};
+    SinkFloat sink{2};
+    left.output.connect(merger.inputs[0].get());
+    right.output.connect(&ramp.input);
+    ramp.output.connect(merger.inputs[1].get());
+    merger.output.connect(&sink.input);
+    schedule.build(sink);
+    EXPECT_EQ(2, schedule.getBranchCount());
+    EXPECT_EQ(&merger, schedule.getNode(3));
+}
+
+TEST(test_flowgraph, worker_pool_runs_every_task) {
+    for (int32_t numWorkers : {0, 1, 3}) {
+        FlowGraphWorkerPool pool(numWorkers, false);
+        EXPECT_EQ(numWorkers, pool.getWorkerCount());
+        for (int32_t numTasks : {0, 1, 2, 7, 100}) {
+            std::vector<std::atomic<int32_t>> counts(numTasks);
+            for (int pass = 0; pass < 20; pass++) {
+                pool.run([](void *context, int32_t taskIndex) {
+                    auto *taskCounts = static_cast<std::atomic<int32_t> *>(context);
+                    taskCounts[taskIndex]++;
+                }, counts.data(), numTasks);
+            }
+            for (int32_t i = 0; i < numTasks; i++) {
+                ASSERT_EQ(20, counts[i].load()) << "workers = " << numWorkers << ", i = " << i;
+            }
+        }
+    }
+}
+
+TEST(test_flowgraph, worker_pool_back_to_back_batches) {
+    // Workers often wake up after their batch is done. They must never run a task
+    // from an older batch with the function or context of a newer one.
+    constexpr int kNumPasses = 5000;
+    FlowGraphWorkerPool pool(3, false);
+    std::vector<std::atomic<int32_t>> evenCounts(3);
+    std::vector<std::atomic<int32_t>> oddCounts(5);
+    for (int pass = 0; pass < kNumPasses; pass++) {
+        std::vector<std::atomic<int32_t>> &counts = (pass & 1) ? oddCounts : evenCounts;
+        pool.run([](void *context, int32_t taskIndex) {
+            static_cast<std::atomic<int32_t> *>(context)[taskIndex]++;
+        }, counts.data(), static_cast<int32_t>(counts.size()));
+    }
+    for (const std::atomic<int32_t> &count : evenCounts) {
+        EXPECT_EQ(kNumPasses / 2, count.load());
+    }
+    for (const std::atomic<int32_t> &count : oddCounts) {
+        EXPECT_EQ(kNumPasses / 2, count.load());
+    }
+}
+
+TEST(test_flowgraph, schedule_parallel_matches_serial) {
+    constexpr int kNumFrames = 301;
+    float input[kNumFrames * 2];
+    for (int i = 0; i < kNumFrames * 2; i++) {
+        input[i] = sinf(i * 0.7f) * 1.2f;
+    }
+    float expected[kNumFrames * 2] = {};
+    float output[kNumFrames * 2] = {};
+    FlowGraphWorkerPool pool(2, false);
+    for (bool parallel : {false, true}) {
+        BranchedGraph graph(input, kNumFrames);
+        graph.sink.pullSetFramesPerBuffer(32);
+        graph.sink.buildSchedule();
+        if (parallel) {
+            graph.sink.getSchedule()->setWorkerPool(&pool, 0); // even for small blocks
+        }
+        float *destination = parallel ? output : expected;
+        ASSERT_EQ(11, graph.sink.read(destination, 11));
+        graph.ramp.setTarget(1.5f);
+        ASSERT_EQ(kNumFrames - 11, graph.sink.read(destination + 11 * 2, kNumFrames));
+    }
+    for (int i = 0; i < kNumFrames * 2; i++) {
+        ASSERT_EQ(expected[i], output[i]) << "i = " << i;
+    }
+}
+
+TEST(test_flowgraph, schedule_with_rate_converter) {
+    constexpr int kNumInputFrames = 500;
+    constexpr int kNumOutputFrames = 400;
+    float input[kNumInputFrames];
+    for (int i = 0; i < kNumInputFrames; i++) {
+        input[i] = sinf(i * 0.05f);
+    }
+    float expected[kNumOutputFrames] = {};
+    float output[kNumOutputFrames] = {};
+    for (bool scheduled : {false, true}) {
+        using oboe::resampler::MultiChannelResampler;
+        std::unique_ptr<MultiChannelResampler> resampler(MultiChannelResampler::make(
+                1, 44100, 48000, MultiChannelResampler::Quality::Medium));
+        SourceFloat sourceFloat{1};
+        ClipToRange clipper{1};
+        SampleRateConverter converter{1, *resampler};
+        SinkFloat sinkFloat{1};
+        sourceFloat.setData(input, kNumInputFrames);
+        sourceFloat.output.connect(&clipper.input);
+        clipper.output.connect(&converter.input);
+        converter.output.connect(&sinkFloat.input);
+        if (scheduled) {
+            sinkFloat.buildSchedule();
+            // The converter pulls its own input so its upstream nodes are not scheduled.
+            ASSERT_EQ(2, sinkFloat.getSchedule()->getNodeCount());
+        }
+        float *destination = scheduled ? output : expected;
+        ASSERT_EQ(kNumOutputFrames, sinkFloat.read(destination, kNumOutputFrames));
+    }
+    for (int i = 0; i < kNumOutputFrames; i++) {
+        ASSERT_EQ(expected[i], output[i]) << "i = " << i;
+    }
+}
+
+// A section that multiplies by a constant gain.
+class GainSection : public GraphCrossfader::Section {
+public:
+    explicit GainSection(float gain)
+            : Section(1, 1)
+            , mRamp(1) {
+        mRamp.setTarget(gain);
+        source.output.connect(&mRamp.input);
+        mRamp.output.connect(&sink.input);
+    }
+
+private:
+    RampLinear mRamp;
+};
+
+TEST(test_flowgraph, crossfader_swaps_sections) {
+    constexpr int kBlockSize = 16;
+    constexpr int kCrossfadeFrames = 20;
+    constexpr int kNumFrames = 100;
+    float input[kNumFrames];
+    for (int i = 0; i < kNumFrames; i++) {
+        input[i] = 1.0f + i;
+    }
+    SourceFloat sourceFloat{1};
+    GraphCrossfader crossfader{1, 1};
+    SinkFloat sinkFloat{1};
+    sourceFloat.setData(input, kNumFrames);
+    sourceFloat.output.connect(&crossfader.input);
+    crossfader.output.connect(&sinkFloat.input);
+    sinkFloat.pullSetFramesPerBuffer(kBlockSize);
+    crossfader.setCrossfadeLengthInFrames(kCrossfadeFrames);
+
+    // Nothing has been published so the output is silent.
+    float output[kNumFrames] = {};
+    ASSERT_EQ(kBlockSize, sinkFloat.read(output, kBlockSize));
+    EXPECT_EQ(0.0f, output[kBlockSize - 1]);
+
+    // The first section starts without a crossfade.
+    ASSERT_TRUE(crossfader.publish(std::make_unique<GainSection>(1.0f)));
+    ASSERT_EQ(2 * kBlockSize, sinkFloat.read(output, 2 * kBlockSize));
+    EXPECT_EQ(1, crossfader.getSwapCount());
+    for (int i = 0; i < 2 * kBlockSize; i++) {
+        ASSERT_EQ(input[i], output[i]) << "i = " << i;
+    }
+
+    // The second section is faded in and reads the same input frames.
+    ASSERT_TRUE(crossfader.publish(std::make_unique<GainSection>(0.5f)));
+    const int numFramesLeft = kNumFrames - 2 * kBlockSize;
+    ASSERT_EQ(numFramesLeft, sinkFloat.read(output, numFramesLeft));
+    EXPECT_EQ(2, crossfader.getSwapCount());
+    for (int i = 0; i < numFramesLeft; i++) {
+        const float x = input[i + 2 * kBlockSize];
+        const float gain = (i < kCrossfadeFrames)
+                ? 1.0f - 0.5f * i / kCrossfadeFrames
+                : 0.5f;
+        ASSERT_NEAR(x * gain, output[i], 0.0001f) << "i = " << i;
+    }
+    crossfader.reclaim();
+}
+
+TEST(test_flowgraph, crossfader_publish_during_crossfade) {
+    constexpr int kBlockSize = 16;
+    constexpr int kCrossfadeFrames = 64;
+    constexpr int kNumFrames = 256;
+    float input[kNumFrames];
+    std::fill(input, input + kNumFrames, 1.0f);
+    SourceFloat sourceFloat{1};
+    GraphCrossfader crossfader{1, 1};
+    SinkFloat sinkFloat{1};
+    sourceFloat.setData(input, kNumFrames);
+    sourceFloat.output.connect(&crossfader.input);
+    crossfader.output.connect(&sinkFloat.input);
+    sinkFloat.pullSetFramesPerBuffer(kBlockSize);
+    crossfader.setCrossfadeLengthInFrames(kCrossfadeFrames);
+
+    float output[kNumFrames] = {};
+    ASSERT_TRUE(crossfader.publish(std::make_unique<GainSection>(1.0f)));
+    ASSERT_EQ(kBlockSize, sinkFloat.read(output, kBlockSize));
+    ASSERT_TRUE(crossfader.publish(std::make_unique<GainSection>(0.5f)));
+    ASSERT_EQ(kBlockSize, sinkFloat.read(output, kBlockSize));
+    // Publish while the second section is still being faded in.
+    // The third one must be picked up without another call to publish() or reclaim().
+    ASSERT_TRUE(crossfader.publish(std::make_unique<GainSection>(0.25f)));
+    const int numFramesLeft = kNumFrames - 2 * kBlockSize;
+    ASSERT_EQ(numFramesLeft, sinkFloat.read(output, numFramesLeft));
+    EXPECT_EQ(3, crossfader.getSwapCount());
+    EXPECT_NEAR(0.25f, output[numFramesLeft - 1], 0.0001f);
+    crossfader.reclaim();
+}
+
+TEST(test_flowgraph, crossfader_rejects_channel_mismatch) {
+    GraphCrossfader crossfader{2, 2};
+    EXPECT_FALSE(crossfader.publish(std::make_unique<GainSection>(1.0f)));
+}
+
+TEST(test_flowgraph, live_sample_rate_quality_change) {
+    constexpr int kNumInputFrames = 8000;
+    constexpr int kBlockSize = 192;
+    float input[kNumInputFrames];
+    for (int i = 0; i < kNumInputFrames; i++) {
+        input[i] = 0.5f * sinf(i * 2.0f * M_PI * 20.0f / 44100.0f);
+    }
+    // Same converters without live reconfiguration.
+    oboe::DataConversionFlowGraph reference;
+    ASSERT_EQ(oboe::Result::OK, reference.configure(
+            oboe::AudioFormat::Float, 1, 44100, oboe::AudioFormat::Float, 1, 48000,
+            oboe::SampleRateConversionQuality::Medium, kBlockSize));
+    reference.setSource(input, kNumInputFrames);
+    float expected[kBlockSize * 10];
+    ASSERT_EQ(kBlockSize * 10, reference.read(expected, kBlockSize * 10, 0));
+
+    oboe::DataConversionFlowGraph graph;
+    graph.setLiveReconfigurationEnabled(true);
+    ASSERT_EQ(oboe::Result::OK, graph.configure(
+            oboe::AudioFormat::Float, 1, 44100, oboe::AudioFormat::Float, 1, 48000,
+            oboe::SampleRateConversionQuality::Medium, kBlockSize));
+    ASSERT_NE(nullptr, graph.getCrossfader());
+    graph.setSource(input, kNumInputFrames);
+    float output[kBlockSize * 10];
+    ASSERT_EQ(kBlockSize * 4, graph.read(output, kBlockSize * 4, 0));
+    ASSERT_EQ(oboe::Result::OK,
+              graph.setSampleRateConversionQuality(oboe::SampleRateConversionQuality::Best));
+    ASSERT_EQ(kBlockSize * 6, graph.read(&output[kBlockSize * 4], kBlockSize * 6, 0));
+    EXPECT_EQ(2, graph.getCrossfader()->getSwapCount());
+
+    // Identical before the change. After it the longer filter adds some latency
+    // but there is no jump in the output.
+    for (int i = 0; i < kBlockSize * 4; i++) {
+        ASSERT_EQ(expected[i], output[i]) << "i = " << i;
+    }
+    for (int i = kBlockSize * 4; i < kBlockSize * 10; i++) {
+        ASSERT_NEAR(expected[i], output[i], 0.02f) << "i = " << i;
+        ASSERT_NEAR(output[i - 1], output[i], 0.01f) << "i = " << i;
+    }
+
+    oboe::DataConversionFlowGraph fixed;
+    EXPECT_EQ(oboe::Result::ErrorInvalidState,
+              fixed.setSampleRateConversionQuality(oboe::SampleRateConversionQuality::Best));
+}
+
+static std::vector<float> makeMixerMatrix(oboe::ChannelMask input, oboe::ChannelMask output) {
+    return ChannelMixer::makeMatrix(static_cast<uint32_t>(input), static_cast<uint32_t>(output));
+}
+
+TEST(test_flowgraph, mixer_matrix_presets) {
+    constexpr float kMinus3dB = static_cast<float>(M_SQRT1_2);
+    using oboe::ChannelMask;
+    // Rows are output channels.
+    std::vector<float> gains = makeMixerMatrix(ChannelMask::Mono, ChannelMask::Stereo);
+    EXPECT_EQ((std::vector<float>{1.0f, 1.0f}), gains);
+
+    gains = makeMixerMatrix(ChannelMask::Stereo, ChannelMask::Mono);
+    EXPECT_EQ((std::vector<float>{0.5f, 0.5f}), gains);
+
+    gains = makeMixerMatrix(ChannelMask::Stereo, ChannelMask::Quad);
+    ASSERT_EQ(8u, gains.size());
+    EXPECT_EQ(1.0f, gains[0]);
+    EXPECT_EQ(0.0f, gains[1]);
+    EXPECT_NEAR(kMinus3dB, gains[4], 0.0001f); // BackLeft from FrontLeft
+    EXPECT_NEAR(kMinus3dB, gains[7], 0.0001f); // BackRight from FrontRight
+
+    // L, R, C, LFE, BL, BR. The rows are scaled so they cannot clip.
+    gains = makeMixerMatrix(ChannelMask::CM5Point1, ChannelMask::Stereo);
+    ASSERT_EQ(12u, gains.size());
+    const float sum = 1.0f + kMinus3dB + 0.5f + kMinus3dB;
+    EXPECT_NEAR(1.0f / sum, gains[0], 0.0001f);
+    EXPECT_EQ(0.0f, gains[1]);
+    EXPECT_NEAR(kMinus3dB / sum, gains[2], 0.0001f);
+    EXPECT_NEAR(0.5f / sum, gains[3], 0.0001f);
+    EXPECT_NEAR(kMinus3dB / sum, gains[4], 0.0001f);
+    EXPECT_EQ(0.0f, gains[5]);
+    for (int o = 0; o < 2; o++) {
+        float rowSum = 0.0f;
+        for (int i = 0; i < 6; i++) {
+            rowSum += gains[o * 6 + i];
+        }
+        EXPECT_NEAR(1.0f, rowSum, 0.0001f);
+    }
+    // Swap the sides for the right channel.
+    EXPECT_EQ(gains[0], gains[6 + 1]);
+    EXPECT_EQ(gains[4], gains[6 + 5]);
+}
+
+static void checkChannelMixer(int32_t inputChannelCount, int32_t outputChannelCount,
+                              FlowGraphPort::Layout layout) {
+    constexpr int kNumFrames = 101;
+    constexpr int kFramesPerBuffer = 32;
+    std::vector<float> input(kNumFrames * inputChannelCount);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = ((i % 11) - 5) * 0.1f;
+    }
+    std::vector<float> gains(inputChannelCount * outputChannelCount);
+    for (size_t i = 0; i < gains.size(); i++) {
+        gains[i] = (i % 3 == 1) ? 0.0f : (i % 5) * 0.25f; // includes zero and unity gains
+    }
+
+    SourceFloat sourceFloat{inputChannelCount};
+    ChannelMixer mixer{inputChannelCount, outputChannelCount};
+    SinkFloat sinkFloat{outputChannelCount};
+    mixer.input.setLayout(layout);
+    mixer.output.setLayout(layout);
+    ASSERT_TRUE(mixer.setMatrix(gains));
+    sourceFloat.setData(input.data(), kNumFrames);
+    auto toPlanar = LayoutConverter::connect(sourceFloat.output, mixer.input);
+    auto toInterleaved = LayoutConverter::connect(mixer.output, sinkFloat.input);
+    sinkFloat.pullSetFramesPerBuffer(kFramesPerBuffer);
+
+    std::vector<float> output(kNumFrames * outputChannelCount);
+    ASSERT_EQ(kNumFrames, sinkFloat.read(output.data(), kNumFrames));
+    for (int frame = 0; frame < kNumFrames; frame++) {
+        for (int o = 0; o < outputChannelCount; o++) {
+            float expected = 0.0f;
+            for (int i = 0; i < inputChannelCount; i++) {
+                expected += gains[o * inputChannelCount + i]
+                        * input[frame * inputChannelCount + i];
+            }
+            ASSERT_NEAR(expected, output[frame * outputChannelCount + o], 0.00001f)
+                    << "frame = " << frame << ", o = " << o;
+        }
+    }
+}
+
+TEST(test_flowgraph, module_channel_mixer) {
+    printf("ChannelMixer uses %s\n", ChannelMixer::getImplementationName());
+    for (FlowGraphPort::Layout layout : {FlowGraphPort::Layout::Interleaved,
+                                         FlowGraphPort::Layout::Planar}) {
+        checkChannelMixer(6, 2, layout);
+        checkChannelMixer(2, 8, layout);
+        checkChannelMixer(3, 3, layout);
+    }
+}
+
+TEST(test_flowgraph, module_channel_mixer_rejects) {
+    ChannelMixer mixer{6, 2};
+    EXPECT_FALSE(mixer.setMatrix(std::vector<float>(6)));
+    // The identity is kept.
+    EXPECT_EQ(1.0f, mixer.getGain(1, 1));
+    EXPECT_EQ(0.0f, mixer.getGain(1, 0));
+    EXPECT_TRUE(mixer.setMatrix(std::vector<float>(12, 0.5f)));
+    EXPECT_EQ(0.5f, mixer.getGain(1, 0));
+}
+
+TEST(test_flowgraph, downmix_with_channel_masks) {
+    constexpr int kNumFrames = 64;
+    constexpr int kInputChannelCount = 6;
+    float input[kNumFrames * kInputChannelCount] = {};
+    for (int i = 0; i < kNumFrames; i++) {
+        input[i * kInputChannelCount + 2] = 0.5f; // centre only
+    }
+    float output[kNumFrames * 2] = {};
+
+    // Without masks the first two channels are copied so the centre is lost.
+    oboe::DataConversionFlowGraph copier;
+    ASSERT_EQ(oboe::Result::OK, copier.configure(
+            oboe::AudioFormat::Float, kInputChannelCount, 48000,
+            oboe::AudioFormat::Float, 2, 48000,
+            oboe::SampleRateConversionQuality::None, kNumFrames));
+    copier.setSource(input, kNumFrames);
+    ASSERT_EQ(kNumFrames, copier.read(output, kNumFrames, 0));
+    EXPECT_EQ(0.0f, output[kNumFrames]);
+
+    oboe::DataConversionFlowGraph mixer;
+    mixer.setChannelMasks(oboe::ChannelMask::CM5Point1, oboe::ChannelMask::Stereo);
+    ASSERT_EQ(oboe::Result::OK, mixer.configure(
+            oboe::AudioFormat::Float, kInputChannelCount, 48000,
+            oboe::AudioFormat::Float, 2, 48000,
+            oboe::SampleRateConversionQuality::None, kNumFrames));
+    mixer.setSource(input, kNumFrames);
+    ASSERT_EQ(kNumFrames, mixer.read(output, kNumFrames, 0));
+    const float centerGain = makeMixerMatrix(oboe::ChannelMask::CM5Point1,
+                                             oboe::ChannelMask::Stereo)[2];
+    for (int i = 0; i < kNumFrames * 2; i++) {
+        ASSERT_NEAR(0.5f * centerGain, output[i], 0.00001f) << "i = " << i;
+    }
+}
+
+TEST(test_flowgraph, automation_curves) {
+    printf("ParameterAutomation uses %s\n", ParameterAutomation::getImplementationName());
+    ParameterAutomation automation(1.0f);
+    ASSERT_TRUE(automation.setValueAtFrame(10, 2.0f));
+    ASSERT_TRUE(automation.linearRampToValueAtFrame(30, 4.0f));
+    ASSERT_TRUE(automation.exponentialRampToValueAtFrame(70, 64.0f));
+    ASSERT_TRUE(automation.linearRampToValueAtFrame(80, 0.0f));
+    ASSERT_TRUE(automation.exponentialRampToValueAtFrame(90, 1.0f)); // from zero so linear
+    // Events must be in order.
+    EXPECT_FALSE(automation.setValueAtFrame(85, 1.0f));
+
+    constexpr int kNumFrames = 100;
+    float values[kNumFrames];
+    // Render in odd sizes so the curves cross the blocks.
+    for (int frame = 0; frame < kNumFrames; ) {
+        const int numFrames = std::min(7, kNumFrames - frame);
+        automation.render(&values[frame], numFrames);
+        frame += numFrames;
+    }
+    EXPECT_EQ(kNumFrames, automation.getFramePosition());
+    EXPECT_EQ(1.0f, automation.getValue());
+
+    for (int frame = 0; frame < kNumFrames; frame++) {
+        float expected;
+        if (frame < 10) {
+            expected = 1.0f;
+        } else if (frame < 30) {
+            expected = 2.0f + 2.0f * (frame - 10) / 20.0f;
+        } else if (frame < 70) {
+            expected = 4.0f * powf(2.0f, (frame - 30) / 10.0f);
+        } else if (frame < 80) {
+            expected = 64.0f - 64.0f * (frame - 70) / 10.0f;
+        } else if (frame < 90) {
+            expected = (frame - 80) / 10.0f;
+        } else {
+            expected = 1.0f;
+        }
+        ASSERT_NEAR(expected, values[frame], expected * 0.0001f + 0.00001f)
+                << "frame = " << frame;
+    }
+}
+
+TEST(test_flowgraph, automation_queue) {
+    ParameterAutomation automation(0.0f, 4);
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(automation.setValueAtFrame(i, i));
+    }
+    EXPECT_FALSE(automation.setValueAtFrame(10, 10.0f)); // full
+    float values[2];
+    automation.render(values, 2);
+    EXPECT_EQ(0.0f, values[0]);
+    EXPECT_EQ(1.0f, values[1]);
+    // Events that are late take effect immediately.
+    EXPECT_TRUE(automation.setValueAtFrame(5, 5.0f));
+    EXPECT_TRUE(automation.setValueAtFrame(5, 6.0f));
+    automation.render(values, 2);
+    EXPECT_EQ(2.0f, values[0]);
+    EXPECT_EQ(3.0f, values[1]);
+    automation.render(values, 2);
+    EXPECT_EQ(3.0f, values[0]);
+    EXPECT_EQ(6.0f, values[1]);
+}
+
+TEST(test_flowgraph, automation_drives_port) {
+    constexpr int kChannelCount = 2;
+    constexpr int kNumFrames = 50;
+    float expected[kNumFrames * kChannelCount] = {};
+    float output[kNumFrames * kChannelCount] = {};
+    for (FlowGraphPort::Layout layout : {FlowGraphPort::Layout::Interleaved,
+                                         FlowGraphPort::Layout::Planar}) {
+        for (bool scheduled : {false, true}) {
+            ParameterAutomation automation(0.0f);
+            automation.linearRampToValueAtFrame(40, 1.0f);
+            ClipToRange clipper{kChannelCount};
+            SinkFloat sinkFloat{kChannelCount};
+            clipper.input.setLayout(layout);
+            clipper.output.setLayout(layout);
+            clipper.input.setAutomation(&automation);
+            auto toInterleaved = LayoutConverter::connect(clipper.output, sinkFloat.input);
+            sinkFloat.pullSetFramesPerBuffer(16);
+            if (scheduled) {
+                sinkFloat.buildSchedule();
+            }
+            float *destination = (layout == FlowGraphPort::Layout::Planar || scheduled)
+                    ? output : expected;
+            ASSERT_EQ(kNumFrames, sinkFloat.read(destination, kNumFrames));
+            EXPECT_EQ(kNumFrames, automation.getFramePosition());
+            if (destination == output) {
+                for (int i = 0; i < kNumFrames * kChannelCount; i++) {
+                    ASSERT_EQ(expected[i], output[i]) << "i = " << i;
+                }
+            }
+        }
+    }
+    for (int frame = 0; frame < kNumFrames; frame++) {
+        const float value = std::min(1.0f, frame / 40.0f);
+        ASSERT_NEAR(value, expected[frame * kChannelCount], 0.00001f) << "frame = " << frame;
+        ASSERT_EQ(expected[frame * kChannelCount], expected[frame * kChannelCount + 1]);
+    }
+}
+
+// Float values that exercise the clipping and rounding of the PCM conversions.
+static std::vector<float> makePcmTestValues() {
+    std::vector<float> values = {
+            0.0f, -0.0f, 1.0f, -1.0f, 0.5f, -0.5f, 1.5f, -1.5f,
+            1.0e30f, -1.0e30f, INFINITY, -INFINITY,
+            nextafterf(1.0f, 0.0f), nextafterf(-1.0f, 0.0f),
+            nextafterf(1.0f, 2.0f), nextafterf(-1.0f, -2.0f)};
+    // Ties and near ties for each format.
+    for (float scale : {32768.0f, (float) (1 << 23), 2147483648.0f}) {
+        for (int i = -40; i <= 40; i++) {
+            float tie = (i + 0.5f) / scale;
+            values.push_back(tie);
+            values.push_back(nextafterf(tie, 0.0f));
+            values.push_back(nextafterf(tie, 1.0f));
+        }
+    }
+    // Pseudo-random values slightly beyond full scale.
+    uint32_t seed = 1234;
+    for (int i = 0; i < 10000; i++) {
+        seed = (seed * 1664525u) + 1013904223u;
+        values.push_back(((seed >> 8) * (1.0f / (1 << 24)) * 2.4f) - 1.2f);
+    }
+    return values;
+}
+
+TEST(test_flowgraph, pcm_i16_round_trip) {
+    std::vector<int16_t> input(65536);
+    for (int i = 0; i < 65536; i++) {
+        input[i] = (int16_t) (i - 32768);
+    }
+    std::vector<float> floats(input.size());
+    std::vector<float> expectedFloats(input.size());
+    std::vector<int16_t> output(input.size());
+    PcmConversion::convertI16ToFloat(input.data(), floats.data(), (int32_t) input.size());
+    PcmConversion::Scalar::convertI16ToFloat(input.data(), expectedFloats.data(),
+                                             (int32_t) input.size());
+    PcmConversion::convertFloatToI16(floats.data(), output.data(), (int32_t) input.size());
+    for (size_t i = 0; i < input.size(); i++) {
+        ASSERT_EQ(expectedFloats[i], floats[i]) << "i = " << i;
+        ASSERT_EQ(input[i], output[i]) << "i = " << i;
+    }
+}
+
+TEST(test_flowgraph, pcm_p24_round_trip) {
+    constexpr int32_t kNumSamples = 1 << 24;
+    std::vector<uint8_t> input(kNumSamples * PcmConversion::kBytesPerI24Packed);
+    uint8_t *byteData = input.data();
+    for (int32_t i = 0; i < kNumSamples; i++) {
+        byteData = PcmConversion::writeP24(i - (1 << 23), byteData);
+    }
+    std::vector<float> floats(kNumSamples);
+    std::vector<float> expectedFloats(kNumSamples);
+    std::vector<uint8_t> output(input.size());
+    PcmConversion::convertP24ToFloat(input.data(), floats.data(), kNumSamples);
+    PcmConversion::Scalar::convertP24ToFloat(input.data(), expectedFloats.data(), kNumSamples);
+    PcmConversion::convertFloatToP24(floats.data(), output.data(), kNumSamples);
+    ASSERT_EQ(expectedFloats, floats);
+    ASSERT_EQ(input, output);
+}
+
+TEST(test_flowgraph, pcm_q8_23_round_trip) {
+    constexpr int32_t kNumSamples = 1 << 24;
+    std::vector<int32_t> input(kNumSamples);
+    for (int32_t i = 0; i < kNumSamples; i++) {
+        input[i] = i - (1 << 23);
+    }
+    std::vector<float> floats(kNumSamples);
+    std::vector<float> expectedFloats(kNumSamples);
+    std::vector<int32_t> output(kNumSamples);
+    PcmConversion::convertQ8_23ToFloat(input.data(), floats.data(), kNumSamples);
+    PcmConversion::Scalar::convertQ8_23ToFloat(input.data(), expectedFloats.data(), kNumSamples);
+    PcmConversion::convertFloatToQ8_23(floats.data(), output.data(), kNumSamples);
+    ASSERT_EQ(expectedFloats, floats);
+    ASSERT_EQ(input, output);
+}
+
+TEST(test_flowgraph, pcm_i32_round_trip) {
+    // Every 24-bit value shifted to the top of the word converts exactly.
+    constexpr int32_t kNumSamples = 1 << 24;
+    std::vector<int32_t> input(kNumSamples);
+    for (int32_t i = 0; i < kNumSamples; i++) {
+        input[i] = (int32_t) ((uint32_t) i << 8);
+    }
+    std::vector<float> floats(kNumSamples);
+    std::vector<float> expectedFloats(kNumSamples);
+    std::vector<int32_t> output(kNumSamples);
+    PcmConversion::convertI32ToFloat(input.data(), floats.data(), kNumSamples);
+    PcmConversion::Scalar::convertI32ToFloat(input.data(), expectedFloats.data(), kNumSamples);
+    PcmConversion::convertFloatToI32(floats.data(), output.data(), kNumSamples);
+    ASSERT_EQ(expectedFloats, floats);
+    ASSERT_EQ(input, output);
+}
+
+// The SIMD conversions must match the scalar reference, including the tails.
+TEST(test_flowgraph, pcm_simd_matches_scalar) {
+    const std::vector<float> values = makePcmTestValues();
+    const int32_t numValues = (int32_t) values.size();
+    for (int32_t offset = 0; offset < 9; offset++) {
+        const float *source = values.data() + offset;
+        const int32_t numSamples = numValues - offset - (offset * 3 % 7);
+
+        std::vector<int16_t> shorts(numSamples), expectedShorts(numSamples);
+        PcmConversion::convertFloatToI16(source, shorts.data(), numSamples);
+        PcmConversion::Scalar::convertFloatToI16(source, expectedShorts.data(), numSamples);
+        ASSERT_EQ(expectedShorts, shorts) << "offset = " << offset;
+
+        std::vector<uint8_t> bytes(numSamples * PcmConversion::kBytesPerI24Packed);
+        std::vector<uint8_t> expectedBytes(bytes.size());
+        PcmConversion::convertFloatToP24(source, bytes.data(), numSamples);
+        PcmConversion::Scalar::convertFloatToP24(source, expectedBytes.data(), numSamples);
+        ASSERT_EQ(expectedBytes, bytes) << "offset = " << offset;
+
+        std::vector<int32_t> ints(numSamples), expectedInts(numSamples);
+        PcmConversion::convertFloatToI32(source, ints.data(), numSamples);
+        PcmConversion::Scalar::convertFloatToI32(source, expectedInts.data(), numSamples);
+        ASSERT_EQ(expectedInts, ints) << "offset = " << offset;
+
+        PcmConversion::convertFloatToQ8_23(source, ints.data(), numSamples);
+        PcmConversion::Scalar::convertFloatToQ8_23(source, expectedInts.data(), numSamples);
+        ASSERT_EQ(expectedInts, ints) << "offset = " << offset;
+    }
+}
+
+TEST(test_flowgraph, pcm_dither) {
+    const std::vector<float> values = makePcmTestValues();
+    const int32_t numSamples = (int32_t) values.size();
+    std::vector<int16_t> plain(numSamples), dithered(numSamples), expected(numSamples);
+    PcmConversion::convertFloatToI16(values.data(), plain.data(), numSamples);
+
+    PcmDither dither1;
+    PcmDither dither2;
+    PcmConversion::convertFloatToI16(values.data(), dithered.data(), numSamples, &dither1);
+    PcmConversion::Scalar::convertFloatToI16(values.data(), expected.data(), numSamples,
+                                             &dither2);
+    ASSERT_EQ(expected, dithered);
+    int numChanged = 0;
+    for (int i = 0; i < numSamples; i++) {
+        ASSERT_LE(abs(dithered[i] - plain[i]), 1) << "i = " << i;
+        if (dithered[i] != plain[i]) numChanged++;
+    }
+    EXPECT_GT(numChanged, 0);
+
+    std::vector<uint8_t> bytes(numSamples * PcmConversion::kBytesPerI24Packed);
+    std::vector<uint8_t> expectedBytes(bytes.size());
+    PcmConversion::convertFloatToP24(values.data(), bytes.data(), numSamples, &dither1);
+    PcmConversion::Scalar::convertFloatToP24(values.data(), expectedBytes.data(), numSamples,
+                                             &dither2);
+    ASSERT_EQ(expectedBytes, bytes);
+}
+
+TEST(test_flowgraph, pcm_convert_float_to_pcm16) {
+    static const float input[] = {1.0f, 0.5f, -0.25f, -1.0f, 0.0f, 53.9f, -87.2f};
+    static const int16_t expected[] = {32767, 16384, -8192, -32768, 0, 32767, -32768};
+    int16_t output[7] = {};
+    oboe::convertFloatToPcm16(input, output, 7);
+    for (int i = 0; i < 7; i++) {
+        EXPECT_EQ(expected[i], output[i]);
+    }
+}
@@ -0,0 +1,404 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Test the null audio backend that is used when Oboe is built for a host.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <oboe/Oboe.h>
+#include <oboe/NullAudioBackend.h>
+
+#include "common/DenormalGuard.h"
+
+using namespace oboe;
+
+// Count the frames and stop after a limit. Output writes a ramp.
+class CountingCallback : public AudioStreamDataCallback {
+public:
+    explicit CountingCallback(int64_t maxFrames) : mMaxFrames(maxFrames) {}
+
+    DataCallbackResult onAudioReady(AudioStream *oboeStream,
+                                    void *audioData,
+                                    int32_t numFrames) override {
+        const int32_t samplesPerFrame = oboeStream->getChannelCount();
+        float *floatData = static_cast<float *>(audioData);
+        for (int i = 0; i < numFrames * samplesPerFrame; i++) {
+            if (oboeStream->getDirection() == Direction::Output) {
+                floatData[i] = mNextValue;
+                mNextValue += 1.0f;
+            } else {
+                received.push_back(floatData[i]);
+            }
+        }
+        callbackCount++;
+        mFrameCount += numFrames;
+        return (mFrameCount >= mMaxFrames) ? DataCallbackResult::Stop
+                                           : DataCallbackResult::Continue;
+    }
+
+    std::atomic<int32_t> callbackCount{0};
+    std::vector<float> received;
+
+private:
+    const int64_t mMaxFrames;
+    int64_t mFrameCount = 0;
+    float mNextValue = 0.0f;
+};
+
+class NullStream : public ::testing::Test {
+protected:
+    void SetUp() override {
+        NullAudioBackend::reset();
+        NullAudioBackend::setSpeed(0.0); // as fast as possible
+    }
+
+    void TearDown() override {
+        if (mStream != nullptr) {
+            mStream->close();
+        }
+        NullAudioBackend::reset();
+    }
+
+    // Wait until the callback stops the stream.
+    void waitForStop() {
+        StreamState next = StreamState::Unknown;
+        mStream->waitForStateChange(StreamState::Started, &next, kNanosPerSecond);
+        ASSERT_EQ(StreamState::Stopped, next);
+    }
+
+    AudioStreamBuilder mBuilder;
+    std::shared_ptr<AudioStream> mStream;
+};
+
+TEST_F(NullStream, open_uses_default_values) {
+    ASSERT_EQ(Result::OK, mBuilder.openStream(mStream));
+    EXPECT_EQ(StreamState::Open, mStream->getState());
+    EXPECT_EQ(AudioApi::Unspecified, mStream->getAudioApi());
+    EXPECT_EQ(DefaultStreamValues::SampleRate, mStream->getSampleRate());
+    EXPECT_EQ(DefaultStreamValues::ChannelCount, mStream->getChannelCount());
+    EXPECT_EQ(DefaultStreamValues::FramesPerBurst, mStream->getFramesPerBurst());
+    EXPECT_EQ(AudioFormat::Float, mStream->getFormat());
+}
+
+TEST_F(NullStream, callback_stops_stream) {
+    const int64_t maxFrames = 48000;
+    CountingCallback callback(maxFrames);
+    mBuilder.setDataCallback(&callback);
+    ASSERT_EQ(Result::OK, mBuilder.openStream(mStream));
+    ASSERT_EQ(Result::OK, mStream->requestStart());
+    waitForStop();
+    const int32_t burst = mStream->getFramesPerBurst();
+    const int32_t expectedCallbacks = (maxFrames + burst - 1) / burst;
+    EXPECT_EQ(expectedCallbacks, callback.callbackCount.load());
+    // The buffer from the callback that returned Stop is not played.
+    const int64_t expectedFrames = (expectedCallbacks - 1) * burst;
+    EXPECT_EQ(expectedFrames, mStream->getFramesWritten());
+    EXPECT_EQ(expectedFrames, mStream->getFramesRead());
+}
+
+TEST_F(NullStream, output_file) {
+    const char *path = "oboe_null_output.raw";
+    NullAudioBackend::setOutputFile(path);
+    const int64_t maxFrames = 1000;
+    CountingCallback callback(maxFrames);
+    mBuilder.setChannelCount(1)->setFramesPerDataCallback(100)->setDataCallback(&callback);
+    ASSERT_EQ(Result::OK, mBuilder.openStream(mStream));
+    ASSERT_EQ(Result::OK, mStream->requestStart());
+    waitForStop();
+    mStream->close();
+    mStream.reset();
+
+    // Only the buffers for which the callback returned Continue are played.
+    FILE *file = fopen(path, "rb");
+    ASSERT_NE(nullptr, file);
+    std::vector<float> data(maxFrames);
+    size_t numRead = fread(data.data(), sizeof(float), data.size(), file);
+    fclose(file);
+    remove(path);
+    ASSERT_EQ(static_cast<size_t>(maxFrames - 100), numRead);
+    for (size_t i = 0; i < numRead; i++) {
+        ASSERT_EQ(static_cast<float>(i), data[i]);
+    }
+}
+
+TEST_F(NullStream, input_file_loops) {
+    const char *path = "oboe_null_input.raw";
+    const float fileData[] = {1.0f, 2.0f, 3.0f};
+    FILE *file = fopen(path, "wb");
+    ASSERT_NE(nullptr, file);
+    fwrite(fileData, sizeof(float), 3, file);
+    fclose(file);
+    NullAudioBackend::setInputFile(path);
+
+    CountingCallback callback(100);
+    mBuilder.setDirection(Direction::Input)
+            ->setChannelCount(1)
+            ->setFramesPerDataCallback(50)
+            ->setDataCallback(&callback);
+    ASSERT_EQ(Result::OK, mBuilder.openStream(mStream));
+    ASSERT_EQ(Result::OK, mStream->requestStart());
+    waitForStop();
+    remove(path);
+    ASSERT_EQ(100u, callback.received.size());
+    for (size_t i = 0; i < callback.received.size(); i++) {
+        ASSERT_EQ(fileData[i % 3], callback.received[i]);
+    }
+}
+
+TEST_F(NullStream, blocking_write_to_output_file) {
+    const char *path = "oboe_null_blocking_output.raw";
+    NullAudioBackend::setOutputFile(path);
+    mBuilder.setChannelCount(1);
+    ASSERT_EQ(Result::OK, mBuilder.openStream(mStream));
+    ASSERT_EQ(Result::OK, mStream->requestStart());
+    const int32_t numFrames = mStream->getFramesPerBurst() * 40; // more than the FIFO holds
+    std::vector<float> data(numFrames);
+    for (int32_t i = 0; i < numFrames; i++) {
+        data[i] = static_cast<float>(i + 1); // zero is silence
+    }
+    auto result = mStream->write(data.data(), numFrames, kNanosPerSecond);
+    ASSERT_TRUE(result);
+    ASSERT_EQ(numFrames, result.value());
+    // Let the timer drain the FIFO.
+    while (mStream->getFramesRead() < numFrames) {
+        usleep(1000);
+    }
+    mStream->close();
+    mStream.reset();
+
+    // The written frames are in order, with silence wherever the FIFO ran dry.
+    FILE *file = fopen(path, "rb");
+    ASSERT_NE(nullptr, file);
+    float value = 0.0f;
+    int32_t expected = 1;
+    while (fread(&value, sizeof(float), 1, file) == 1) {
+        if (value != 0.0f) {
+            ASSERT_EQ(static_cast<float>(expected), value);
+            expected++;
+        }
+    }
+    fclose(file);
+    remove(path);
+    EXPECT_EQ(numFrames + 1, expected);
+}
+
+TEST_F(NullStream, blocking_read_from_input_file) {
+    const char *path = "oboe_null_blocking_input.raw";
+    const float fileData[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f};
+    FILE *file = fopen(path, "wb");
+    ASSERT_NE(nullptr, file);
+    fwrite(fileData, sizeof(float), std::size(fileData), file);
+    fclose(file);
+    NullAudioBackend::setInputFile(path);
+
+    mBuilder.setDirection(Direction::Input)->setChannelCount(1);
+    ASSERT_EQ(Result::OK, mBuilder.openStream(mStream));
+    ASSERT_EQ(Result::OK, mStream->requestStart());
+    // Wait until the FIFO is full so the timer has frames that do not fit.
+    usleep(20 * 1000);
+    const int32_t numFrames = mStream->getBufferCapacityInFrames() * 2;
+    std::vector<float> data(numFrames);
+    auto result = mStream->read(data.data(), numFrames, kNanosPerSecond);
+    remove(path);
+    ASSERT_TRUE(result);
+    ASSERT_EQ(numFrames, result.value());
+    // The file is only read for frames that fit in the FIFO so none are skipped.
+    for (int32_t i = 0; i < numFrames; i++) {
+        ASSERT_EQ(fileData[i % std::size(fileData)], data[i]) << "i = " << i;
+    }
+}
+
+TEST_F(NullStream, missing_input_file) {
+    NullAudioBackend::setInputFile("oboe_null_missing/input.raw");
+    mBuilder.setDirection(Direction::Input);
+    EXPECT_EQ(Result::ErrorInternal, mBuilder.openStream(mStream));
+}
+
+TEST_F(NullStream, blocking_write) {
+    ASSERT_EQ(Result::OK, mBuilder.openStream(mStream));
+    ASSERT_EQ(Result::OK, mStream->requestStart());
+    const int32_t numFrames = mStream->getFramesPerBurst() * 4;
+    std::vector<float> data(numFrames * mStream->getChannelCount());
+    auto result = mStream->write(data.data(), numFrames, kNanosPerSecond);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(numFrames, result.value());
+    EXPECT_EQ(numFrames, mStream->getFramesWritten());
+    EXPECT_EQ(Result::OK, mStream->requestStop());
+}
+
+TEST_F(NullStream, sample_rate_conversion) {
+    CountingCallback callback(44100);
+    mBuilder.setSampleRate(44100)
+            ->setPerformanceMode(PerformanceMode::LowLatency)
+            ->setSampleRateConversionQuality(SampleRateConversionQuality::Medium)
+            ->setDataCallback(&callback);
+    ASSERT_EQ(Result::OK, mBuilder.openStream(mStream));
+    // The null device runs at the default rate so a FilterAudioStream converts the rate.
+    EXPECT_EQ(44100, mStream->getSampleRate());
+    ASSERT_EQ(Result::OK, mStream->requestStart());
+    waitForStop();
+    // The last callback is not counted and the child burst is not a multiple of the callback.
+    EXPECT_NEAR(44100, mStream->getFramesWritten(), 2 * DefaultStreamValues::FramesPerBurst);
+}
+
+TEST_F(NullStream, live_sample_rate_quality_change) {
+    NullAudioBackend::setSpeed(4.0);
+    CountingCallback callback(48000 * 60);
+    mBuilder.setSampleRate(44100)
+            ->setPerformanceMode(PerformanceMode::LowLatency)
+            ->setSampleRateConversionQuality(SampleRateConversionQuality::Medium)
+            ->setLiveReconfigurationEnabled(true)
+            ->setDataCallback(&callback);
+    ASSERT_EQ(Result::OK, mBuilder.openStream(mStream));
+    EXPECT_TRUE(mStream->isLiveReconfigurationEnabled());
+    ASSERT_EQ(Result::OK, mStream->requestStart());
+    while (callback.callbackCount < 4) {
+        usleep(1000);
+    }
+    // Change the quality while the callback is running.
+    EXPECT_EQ(Result::ErrorIllegalArgument,
+              mStream->setSampleRateConversionQuality(SampleRateConversionQuality::None));
+    ASSERT_EQ(Result::OK,
+              mStream->setSampleRateConversionQuality(SampleRateConversionQuality::Best));
+    EXPECT_EQ(SampleRateConversionQuality::Best, mStream->getSampleRateConversionQuality());
+    const int32_t callbackCount = callback.callbackCount;
+    while (callback.callbackCount < callbackCount + 4) {
+        usleep(1000);
+    }
+    ASSERT_EQ(Result::OK,
+              mStream->setSampleRateConversionQuality(SampleRateConversionQuality::Fastest));
+    EXPECT_EQ(Result::OK, mStream->stop());
+}
+
+TEST_F(NullStream, sample_rate_quality_fixed_without_live_reconfiguration) {
+    mBuilder.setSampleRate(44100)
+            ->setSampleRateConversionQuality(SampleRateConversionQuality::Medium);
+    ASSERT_EQ(Result::OK, mBuilder.openStream(mStream));
+    EXPECT_EQ(Result::ErrorInvalidState,
+              mStream->setSampleRateConversionQuality(SampleRateConversionQuality::Best));
+    EXPECT_EQ(SampleRateConversionQuality::Medium, mStream->getSampleRateConversionQuality());
+}
+
+TEST_F(NullStream, timestamps_follow_position) {
+    NullAudioBackend::setSpeed(4.0);
+    CountingCallback callback(48000);
+    mBuilder.setDataCallback(&callback);
+    ASSERT_EQ(Result::OK, mBuilder.openStream(mStream));
+    ASSERT_EQ(Result::OK, mStream->requestStart());
+    int64_t position1 = 0;
+    int64_t time1 = 0;
+    Result result = Result::ErrorUnavailable;
+    for (int i = 0; i < 100 && result != Result::OK; i++) {
+        usleep(1000);
+        result = mStream->getTimestamp(CLOCK_MONOTONIC, &position1, &time1);
+    }
+    ASSERT_EQ(Result::OK, result);
+    usleep(10 * 1000);
+    int64_t position2 = 0;
+    int64_t time2 = 0;
+    ASSERT_EQ(Result::OK, mStream->getTimestamp(CLOCK_MONOTONIC, &position2, &time2));
+    ASSERT_GT(position2, position1);
+    // At 4x speed one second of frames takes 250 msec.
+    const double nanosPerFrame = kNanosPerSecond / (4.0 * mStream->getSampleRate());
+    EXPECT_NEAR((position2 - position1) * nanosPerFrame, time2 - time1, 2.0);
+}
+
+// Halve a subnormal in the callback. That gives zero if subnormals are flushed.
+class DenormalCallback : public AudioStreamDataCallback {
+public:
+    DataCallbackResult onAudioReady(AudioStream * /*oboeStream*/,
+                                    void *audioData,
+                                    int32_t numFrames) override {
+        volatile float tiny = 1.0e-39f;
+        result = tiny * 0.5f;
+        memset(audioData, 0, numFrames * sizeof(float) * DefaultStreamValues::ChannelCount);
+        return DataCallbackResult::Stop;
+    }
+
+    std::atomic<float> result{-1.0f};
+};
+
+TEST_F(NullStream, denormal_protection) {
+    if (!DenormalGuard::isSupported()) {
+        GTEST_SKIP() << "subnormals cannot be flushed on this CPU";
+    }
+    for (bool enabled : {false, true}) {
+        DenormalCallback callback;
+        mBuilder.setDataCallback(&callback)->setDenormalProtectionEnabled(enabled);
+        ASSERT_EQ(Result::OK, mBuilder.openStream(mStream));
+        EXPECT_EQ(enabled, mStream->isDenormalProtectionEnabled());
+        ASSERT_EQ(Result::OK, mStream->requestStart());
+        waitForStop();
+        if (enabled) {
+            EXPECT_EQ(0.0f, callback.result.load());
+        } else {
+            EXPECT_EQ(0.5e-39f, callback.result.load());
+        }
+        mStream->close();
+        mStream.reset();
+    }
+}
+
+TEST_F(NullStream, callback_statistics) {
+    constexpr int32_t kFramesPerCallback = 64;
+    CountingCallback callback(kFramesPerCallback * 20);
+    mBuilder.setDataCallback(&callback)
+            ->setFramesPerDataCallback(kFramesPerCallback)
+            ->setCallbackStatisticsEnabled(true);
+    ASSERT_EQ(Result::OK, mBuilder.openStream(mStream));
+    EXPECT_TRUE(mStream->isCallbackStatisticsEnabled());
+    ASSERT_EQ(Result::OK, mStream->requestStart());
+    waitForStop();
+
+    const CallbackStatistics &statistics = mStream->getCallbackStatistics();
+    const int32_t callbackCount = callback.callbackCount;
+    EXPECT_EQ(callbackCount, statistics.getFramesPerCallback().getCount());
+    EXPECT_EQ(kFramesPerCallback, statistics.getFramesPerCallback().getPercentile(50));
+    EXPECT_EQ(callbackCount, statistics.getDurationNanos().getCount());
+    EXPECT_EQ(callbackCount - 1, statistics.getIntervalNanos().getCount());
+    EXPECT_EQ(callbackCount - 1, statistics.getLatenessNanos().getCount());
+}
+
+TEST_F(NullStream, callback_statistics_disabled) {
+    CountingCallback callback(1000);
+    mBuilder.setDataCallback(&callback);
+    ASSERT_EQ(Result::OK, mBuilder.openStream(mStream));
+    ASSERT_EQ(Result::OK, mStream->requestStart());
+    waitForStop();
+    EXPECT_GT(callback.callbackCount, 0);
+    EXPECT_EQ(0, mStream->getCallbackStatistics().getDurationNanos().getCount());
+}
+
+TEST_F(NullStream, tracer_records_callbacks) {
+    CountingCallback callback(1000);
+    mBuilder.setDataCallback(&callback);
+    ASSERT_EQ(Result::OK, mBuilder.openStream(mStream));
+    Tracer::clear();
+    Tracer::setEnabled(true);
+    ASSERT_EQ(Result::OK, mStream->requestStart());
+    waitForStop();
+    Tracer::setEnabled(false);
+    const std::string json = Tracer::exportChromeJson();
+    Tracer::clear();
+    EXPECT_NE(std::string::npos, json.find("\"name\":\"oboe data callback\""));
+}
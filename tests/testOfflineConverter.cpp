@@ -0,0 +1,159 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Test converting buffers and files with OfflineConverter.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <oboe/Oboe.h>
+
+using namespace oboe;
+
+constexpr int32_t kChannelCount = 2;
+
+// A chirp so that every output frame depends on the phase of the resampler.
+static std::vector<float> makeSignal(int64_t numFrames) {
+    std::vector<float> signal(numFrames * kChannelCount);
+    for (int64_t i = 0; i < numFrames; i++) {
+        const double phase = 0.0001 * i * i / 2000.0;
+        signal[i * kChannelCount] = 0.5f * static_cast<float>(sin(phase));
+        signal[i * kChannelCount + 1] = 0.25f * static_cast<float>(cos(3.0 * phase));
+    }
+    return signal;
+}
+
+static std::vector<float> convertFloat(OfflineConverter &converter,
+                                       const std::vector<float> &input) {
+    const int64_t numInputFrames = input.size() / kChannelCount;
+    const int64_t numOutputFrames = converter.getOutputFrameCount(numInputFrames);
+    std::vector<float> output(numOutputFrames * kChannelCount, -9.0f);
+    auto result = converter.convert(input.data(), numInputFrames, output.data(), numOutputFrames);
+    EXPECT_EQ(Result::OK, result.error());
+    EXPECT_EQ(numOutputFrames, result.value());
+    return output;
+}
+
+static void checkChunksMatchSinglePass(int32_t inputRate, int32_t outputRate,
+                                       SampleRateConversionQuality quality) {
+    const std::vector<float> input = makeSignal(20000);
+    OfflineConverter::Format inputFormat{AudioFormat::Float, kChannelCount, inputRate};
+    OfflineConverter::Format outputFormat{AudioFormat::Float, kChannelCount, outputRate};
+
+    OfflineConverter single(inputFormat, outputFormat, quality);
+    single.setFramesPerChunk(INT32_MAX);
+    const std::vector<float> expected = convertFloat(single, input);
+
+    OfflineConverter chunked(inputFormat, outputFormat, quality);
+    chunked.setFramesPerChunk(1000);
+    chunked.setThreadCount(3);
+    chunked.setFramesPerBlock(97);
+    const std::vector<float> actual = convertFloat(chunked, input);
+
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(expected[i], actual[i]) << "rate " << inputRate << " to " << outputRate
+                << ", quality " << static_cast<int>(quality) << ", sample " << i;
+    }
+}
+
+TEST(TestOfflineConverter, output_frame_count) {
+    OfflineConverter converter({AudioFormat::Float, 1, 44100}, {AudioFormat::Float, 1, 48000});
+    EXPECT_EQ(0, converter.getOutputFrameCount(0));
+    EXPECT_EQ(48000, converter.getOutputFrameCount(44100));
+    EXPECT_EQ(2, converter.getOutputFrameCount(1));
+}
+
+TEST(TestOfflineConverter, chunks_match_single_pass) {
+    const SampleRateConversionQuality qualities[] = {
+            SampleRateConversionQuality::Fastest,
+            SampleRateConversionQuality::Medium,
+            SampleRateConversionQuality::Best,
+    };
+    for (SampleRateConversionQuality quality : qualities) {
+        checkChunksMatchSinglePass(44100, 48000, quality);
+        checkChunksMatchSinglePass(48000, 44100, quality);
+        checkChunksMatchSinglePass(16000, 48000, quality);
+        checkChunksMatchSinglePass(11025, 48000, quality); // uses a cascade
+        checkChunksMatchSinglePass(48000, 48000, quality);
+    }
+}
+
+TEST(TestOfflineConverter, matches_stream_latency) {
+    // Upsampling a step by 2 delays it by the latency of the resampler,
+    // which the output keeps, and the tail is padded with silence.
+    std::vector<float> input(1000 * kChannelCount, 1.0f);
+    OfflineConverter converter({AudioFormat::Float, kChannelCount, 24000},
+                               {AudioFormat::Float, kChannelCount, 48000});
+    const std::vector<float> output = convertFloat(converter, input);
+    ASSERT_EQ(2000u * kChannelCount, output.size());
+    EXPECT_NEAR(0.0f, output[0], 0.01f);
+    EXPECT_NEAR(1.0f, output[1000 * kChannelCount], 0.01f);
+}
+
+TEST(TestOfflineConverter, format_and_channels) {
+    const int16_t input[] = {0, 16384, -16384, 32767};
+    std::vector<float> output(8, -9.0f);
+    OfflineConverter converter({AudioFormat::I16, 1, 48000}, {AudioFormat::Float, 2, 48000});
+    auto result = converter.convert(input, 4, output.data(), 4);
+    ASSERT_EQ(Result::OK, result.error());
+    ASSERT_EQ(4, result.value());
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(input[i] / 32768.0f, output[i * 2]);
+        EXPECT_EQ(input[i] / 32768.0f, output[i * 2 + 1]);
+    }
+}
+
+TEST(TestOfflineConverter, output_too_small) {
+    std::vector<float> input(100 * kChannelCount);
+    std::vector<float> output(100 * kChannelCount);
+    OfflineConverter converter({AudioFormat::Float, kChannelCount, 44100},
+                               {AudioFormat::Float, kChannelCount, 48000});
+    auto result = converter.convert(input.data(), 100, output.data(), 100);
+    EXPECT_EQ(Result::ErrorOutOfRange, result.error());
+}
+
+TEST(TestOfflineConverter, convert_file) {
+    const char *inputPath = "oboe_offline_input.raw";
+    const char *outputPath = "oboe_offline_output.raw";
+    const std::vector<float> input = makeSignal(5000);
+    FILE *file = fopen(inputPath, "wb");
+    ASSERT_NE(nullptr, file);
+    fwrite(input.data(), sizeof(float), input.size(), file);
+    fclose(file);
+
+    OfflineConverter::Format inputFormat{AudioFormat::Float, kChannelCount, 48000};
+    OfflineConverter::Format outputFormat{AudioFormat::I16, kChannelCount, 32000};
+    OfflineConverter converter(inputFormat, outputFormat);
+    ASSERT_EQ(Result::OK, converter.convertFile(inputPath, outputPath));
+
+    std::vector<int16_t> expected(converter.getOutputFrameCount(5000) * kChannelCount);
+    ASSERT_TRUE(converter.convert(input.data(), 5000, expected.data(), expected.size()));
+    std::vector<int16_t> actual(expected.size() + 1);
+    file = fopen(outputPath, "rb");
+    ASSERT_NE(nullptr, file);
+    size_t numRead = fread(actual.data(), sizeof(int16_t), actual.size(), file);
+    fclose(file);
+    remove(inputPath);
+    remove(outputPath);
+    ASSERT_EQ(expected.size(), numRead);
+    EXPECT_EQ(0, memcmp(expected.data(), actual.data(), numRead * sizeof(int16_t)));
+}
@@ -20,11 +20,18 @@
 
 #include "math.h"
 #include "stdio.h"
+#include <functional>
 
 #include <gtest/gtest.h>
 #include <oboe/Oboe.h>
 
+#include "flowgraph/resampler/CascadedResampler.h"
+#include "flowgraph/resampler/CoefficientTableCache.h"
 #include "flowgraph/resampler/MultiChannelResampler.h"
+#include "flowgraph/resampler/PolyphaseResamplerChannels.h"
+#include "flowgraph/resampler/ResamplerKernels.h"
+#include "flowgraph/resampler/SincResamplerChannels.h"
+#include "flowgraph/resampler/VariableRatioResampler.h"
 
 using namespace oboe::resampler;
 
@@ -114,8 +121,12 @@ static void checkResampler(int32_t sourceRate, int32_t sinkRate,
     int sinkZeroCrossingCount = countZeroCrossingsWithHysteresis(outputBuffer.get(), numRead);
     // The sine wave may be cut off partially. This may cause multiple crossing
     // differences when upsampling.
-    const int kMaxZeroCrossingDelta = std::max(sinkRate / sourceRate / 2, 1);
-    EXPECT_LE(abs(sourceZeroCrossingCount - sinkZeroCrossingCount), kMaxZeroCrossingDelta);
+    int maxZeroCrossingDelta = std::max(sinkRate / sourceRate / 2, 1);
+    // A cascade delays the signal by both of its filters so about twice as much is cut off.
+    if (dynamic_cast<CascadedResampler *>(mcResampler.get()) != nullptr) {
+        maxZeroCrossingDelta *= 2;
+    }
+    EXPECT_LE(abs(sourceZeroCrossingCount - sinkZeroCrossingCount), maxZeroCrossingDelta);
 
     // Detect glitches by looking for spikes in the second derivative.
     output = outputBuffer.get();
@@ -223,3 +234,362 @@ TEST(test_resampler, resampler_48000_44100_best) {
 TEST(test_resampler, resampler_44100_11025_best) {
     checkResampler(44100, 11025, MultiChannelResampler::Quality::Best);
 }
+
+// Run a multi-channel sine wave through a resampler and return the output.
+static std::vector<float> runResampler(int32_t channelCount,
+                                       int32_t sourceRate,
+                                       int32_t sinkRate,
+                                       int32_t numTaps,
+                                       bool simdEnabled) {
+    const int kNumInputFrames = 2000;
+    std::vector<float> input(static_cast<size_t>(kNumInputFrames) * channelCount);
+    for (int frame = 0; frame < kNumInputFrames; frame++) {
+        for (int channel = 0; channel < channelCount; channel++) {
+            input[frame * channelCount + channel] = sinf(frame * 0.05f * (channel + 1));
+        }
+    }
+
+    MultiChannelResampler::Builder builder;
+    builder.setChannelCount(channelCount)
+            ->setInputRate(sourceRate)
+            ->setOutputRate(sinkRate)
+            ->setNumTaps(numTaps)
+            ->setSimdEnabled(simdEnabled);
+    std::unique_ptr<MultiChannelResampler> resampler(builder.build());
+
+    std::vector<float> output;
+    std::vector<float> frame(channelCount);
+    const float *inputFrame = input.data();
+    int inputFramesLeft = kNumInputFrames;
+    while (inputFramesLeft > 0) {
+        if (resampler->isWriteNeeded()) {
+            resampler->writeNextFrame(inputFrame);
+            inputFrame += channelCount;
+            inputFramesLeft--;
+        } else {
+            resampler->readNextFrame(frame.data());
+            output.insert(output.end(), frame.begin(), frame.end());
+        }
+    }
+    return output;
+}
+
+// The SIMD kernels reorder the summation so allow a small error.
+static void checkSimdMatchesScalar(int32_t channelCount, int32_t sourceRate, int32_t sinkRate) {
+    const int32_t kNumTaps = 32;
+    std::vector<float> scalar = runResampler(channelCount, sourceRate, sinkRate,
+                                             kNumTaps, false);
+    std::vector<float> simd = runResampler(channelCount, sourceRate, sinkRate,
+                                           kNumTaps, true);
+    ASSERT_EQ(scalar.size(), simd.size());
+    for (size_t i = 0; i < scalar.size(); i++) {
+        ASSERT_NEAR(scalar[i], simd[i], 1.0e-5f) << "channels = " << channelCount
+                << ", index = " << i;
+    }
+}
+
+TEST(test_resampler, resampler_kernels_simd_polyphase) {
+    printf("resampler kernels = %s\n",
+           ResamplerKernels::getTypeName(ResamplerKernels::select().type));
+    for (int channelCount : {1, 2, 3, 4, 6, 8, 11, 16}) {
+        checkSimdMatchesScalar(channelCount, 44100, 48000);
+    }
+}
+
+TEST(test_resampler, resampler_kernels_simd_sinc) {
+    // 44100 to 47999 has a denominator that is too big for the polyphase resampler.
+    for (int channelCount : {1, 2, 3, 4, 6, 8, 11, 16}) {
+        checkSimdMatchesScalar(channelCount, 44100, 47999);
+    }
+}
+
+TEST(test_resampler, resampler_fixed_channel_types) {
+    const auto quality = MultiChannelResampler::Quality::High;
+    std::unique_ptr<MultiChannelResampler> resampler;
+    resampler.reset(MultiChannelResampler::make(6, 44100, 48000, quality));
+    EXPECT_NE(nullptr, dynamic_cast<PolyphaseResamplerChannels<6> *>(resampler.get()));
+    resampler.reset(MultiChannelResampler::make(8, 44100, 48000, quality));
+    EXPECT_NE(nullptr, dynamic_cast<PolyphaseResamplerChannels<8> *>(resampler.get()));
+    resampler.reset(MultiChannelResampler::make(1, 44100, 47999, quality));
+    EXPECT_NE(nullptr, dynamic_cast<SincResamplerChannels<1> *>(resampler.get()));
+    resampler.reset(MultiChannelResampler::make(4, 44100, 47999, quality));
+    EXPECT_NE(nullptr, dynamic_cast<SincResamplerChannels<4> *>(resampler.get()));
+    // Other channel counts use the generic loops.
+    resampler.reset(MultiChannelResampler::make(5, 44100, 48000, quality));
+    EXPECT_EQ(nullptr, dynamic_cast<PolyphaseResamplerChannels<4> *>(resampler.get()));
+    EXPECT_EQ(nullptr, dynamic_cast<PolyphaseResamplerChannels<6> *>(resampler.get()));
+}
+
+TEST(test_resampler, resampler_kernels_scalar_exact) {
+    // The scalar kernels must match a straightforward tap-by-channel loop exactly.
+    const int32_t kNumTaps = 16;
+    const int32_t kChannels = 5;
+    float x[kNumTaps * kChannels];
+    float coefficients[kNumTaps];
+    for (int i = 0; i < kNumTaps * kChannels; i++) {
+        x[i] = sinf(i * 0.37f);
+    }
+    for (int i = 0; i < kNumTaps; i++) {
+        coefficients[i] = cosf(i * 0.11f);
+    }
+    float expected[kChannels] = {};
+    for (int tap = 0; tap < kNumTaps; tap++) {
+        for (int channel = 0; channel < kChannels; channel++) {
+            expected[channel] += x[tap * kChannels + channel] * coefficients[tap];
+        }
+    }
+    float actual[kChannels];
+    ResamplerKernels::getScalar().dotMulti(x, coefficients, kNumTaps, kChannels, actual);
+    for (int channel = 0; channel < kChannels; channel++) {
+        EXPECT_EQ(expected[channel], actual[channel]);
+    }
+}
+
+// Convert using process() with irregular block sizes and compare with the per-frame API.
+static void checkProcessMatchesFrames(int32_t channelCount, int32_t sourceRate,
+                                      int32_t sinkRate, MultiChannelResampler::Quality quality) {
+    const int kNumInputFrames = 1000;
+    std::vector<float> input(static_cast<size_t>(kNumInputFrames) * channelCount);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = sinf(i * 0.031f);
+    }
+
+    std::unique_ptr<MultiChannelResampler> frameResampler(
+            MultiChannelResampler::make(channelCount, sourceRate, sinkRate, quality));
+    std::vector<float> expected;
+    std::vector<float> frame(channelCount);
+    for (int i = 0; i < kNumInputFrames; ) {
+        if (frameResampler->isWriteNeeded()) {
+            frameResampler->writeNextFrame(&input[i * channelCount]);
+            i++;
+        } else {
+            frameResampler->readNextFrame(frame.data());
+            expected.insert(expected.end(), frame.begin(), frame.end());
+        }
+    }
+    while (!frameResampler->isWriteNeeded()) {
+        frameResampler->readNextFrame(frame.data());
+        expected.insert(expected.end(), frame.begin(), frame.end());
+    }
+
+    std::unique_ptr<MultiChannelResampler> blockResampler(
+            MultiChannelResampler::make(channelCount, sourceRate, sinkRate, quality));
+    std::vector<float> actual(expected.size() + 64 * channelCount);
+    const int kBlockSizes[] = {1, 7, 64, 3, 128};
+    int blockIndex = 0;
+    int inputCursor = 0;
+    int outputCursor = 0;
+    while (inputCursor < kNumInputFrames) {
+        const int inputFrames = std::min(kBlockSizes[blockIndex++ % 5],
+                                         kNumInputFrames - inputCursor);
+        const int outputCapacity = kBlockSizes[blockIndex % 5];
+        MultiChannelResampler::ProcessResult result = blockResampler->process(
+                &input[inputCursor * channelCount], inputFrames,
+                &actual[outputCursor * channelCount], outputCapacity);
+        inputCursor += result.framesConsumed;
+        outputCursor += result.framesProduced;
+    }
+    // Drain the remaining output.
+    MultiChannelResampler::ProcessResult result = blockResampler->process(
+            nullptr, 0, &actual[outputCursor * channelCount], 64);
+    outputCursor += result.framesProduced;
+
+    ASSERT_EQ(expected.size(), static_cast<size_t>(outputCursor * channelCount));
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(expected[i], actual[i]) << "index = " << i;
+    }
+}
+
+TEST(test_resampler, resampler_process_block) {
+    const MultiChannelResampler::Quality qualities[] = {
+        MultiChannelResampler::Quality::Fastest,
+        MultiChannelResampler::Quality::Medium,
+        MultiChannelResampler::Quality::Best
+    };
+    for (auto quality : qualities) {
+        for (int channelCount : {1, 2, 5}) {
+            checkProcessMatchesFrames(channelCount, 44100, 48000, quality);
+            checkProcessMatchesFrames(channelCount, 48000, 44100, quality);
+            checkProcessMatchesFrames(channelCount, 44100, 47999, quality);
+        }
+    }
+}
+
+TEST(test_resampler, resampler_cascaded_plan) {
+    MultiChannelResampler::Builder builder;
+    builder.setNumTaps(32);
+    // A single polyphase stage fits in the table so it is not split.
+    builder.setInputRate(44100)->setOutputRate(48000);
+    EXPECT_TRUE(CascadedResampler::planStages(builder).empty());
+    // Upsampling runs the fractional stage at the input rate.
+    builder.setInputRate(11025)->setOutputRate(48000);
+    EXPECT_EQ(std::vector<int32_t>({11025, 12000, 48000}),
+              CascadedResampler::planStages(builder));
+    builder.setInputRate(44100)->setOutputRate(192000);
+    EXPECT_EQ(std::vector<int32_t>({44100, 48000, 192000}),
+              CascadedResampler::planStages(builder));
+    // Downsampling is never split.
+    builder.setInputRate(32000)->setOutputRate(11025);
+    EXPECT_TRUE(CascadedResampler::planStages(builder).empty());
+    // The linear resampler is never split.
+    builder.setNumTaps(2)->setInputRate(11025)->setOutputRate(48000);
+    EXPECT_TRUE(CascadedResampler::planStages(builder).empty());
+
+    std::unique_ptr<MultiChannelResampler> resampler(MultiChannelResampler::make(
+            2, 11025, 48000, MultiChannelResampler::Quality::Best));
+    CascadedResampler *cascaded = dynamic_cast<CascadedResampler *>(resampler.get());
+    ASSERT_NE(nullptr, cascaded);
+    EXPECT_EQ(2, cascaded->getNumStages());
+}
+
+TEST(test_resampler, resampler_cascaded_process_block) {
+    for (int channelCount : {1, 2, 6}) {
+        checkProcessMatchesFrames(channelCount, 11025, 48000,
+                                  MultiChannelResampler::Quality::High);
+        checkProcessMatchesFrames(channelCount, 8000, 44100,
+                                  MultiChannelResampler::Quality::Best);
+    }
+}
+
+TEST(test_resampler, resampler_coefficient_cache) {
+    CoefficientTableCache &cache = CoefficientTableCache::getInstance();
+    const int32_t numTablesBefore = cache.getNumTables();
+    {
+        // These have the same reduced ratio so they should share one table.
+        std::unique_ptr<MultiChannelResampler> resampler1(MultiChannelResampler::make(
+                2, 44100, 48000, MultiChannelResampler::Quality::High));
+        std::unique_ptr<MultiChannelResampler> resampler2(MultiChannelResampler::make(
+                6, 88200, 96000, MultiChannelResampler::Quality::High));
+        EXPECT_EQ(numTablesBefore + 1, cache.getNumTables());
+
+        // Different number of taps needs a different table.
+        std::unique_ptr<MultiChannelResampler> resampler3(MultiChannelResampler::make(
+                2, 44100, 48000, MultiChannelResampler::Quality::Best));
+        EXPECT_EQ(numTablesBefore + 2, cache.getNumTables());
+    }
+    // Tables are released when the last resampler is deleted.
+    EXPECT_EQ(numTablesBefore, cache.getNumTables());
+}
+
+// Feed a sine wave through a VariableRatioResampler one frame at a time.
+// The ratio is changed by changeRatio() before each output frame.
+static int32_t runVariableRatio(VariableRatioResampler &resampler,
+                                const std::vector<float> &input,
+                                std::vector<float> &output,
+                                const std::function<void(int32_t)> &changeRatio) {
+    int32_t inputCursor = 0;
+    while (inputCursor < static_cast<int32_t>(input.size())) {
+        if (resampler.isWriteNeeded()) {
+            resampler.writeNextFrame(&input[inputCursor++]);
+        } else {
+            changeRatio(static_cast<int32_t>(output.size()));
+            float value = 0.0f;
+            resampler.readNextFrame(&value);
+            output.push_back(value);
+        }
+    }
+    return inputCursor;
+}
+
+TEST(test_resampler, resampler_variable_ratio_constant) {
+    const double kFramesPerCycle = 61.7;
+    std::vector<float> input(20000);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = sin(i * 2.0 * M_PI / kFramesPerCycle);
+    }
+    const int inputZeroCrossings = countZeroCrossingsWithHysteresis(input.data(),
+                                                                    input.size());
+    for (double ratio : {0.5, 1.0, 1.25, 2.0}) {
+        MultiChannelResampler::Builder builder;
+        builder.setNumTaps(16);
+        VariableRatioResampler resampler(builder, 2.0);
+        resampler.setRatio(ratio);
+        EXPECT_EQ(ratio, resampler.getRatio());
+        std::vector<float> output;
+        runVariableRatio(resampler, input, output, [](int32_t) {});
+
+        // The same cycles are played faster or slower.
+        EXPECT_NEAR(input.size() / ratio, output.size(), 2) << "ratio = " << ratio;
+        int outputZeroCrossings = countZeroCrossingsWithHysteresis(output.data(),
+                                                                   output.size());
+        EXPECT_NEAR(inputZeroCrossings, outputZeroCrossings, 2) << "ratio = " << ratio;
+
+        // Look for glitches after the FIR has been primed.
+        float peak = 0.0f;
+        for (size_t i = 100; i < output.size(); i++) {
+            peak = std::max(peak, fabsf(output[i]));
+        }
+        EXPECT_NEAR(1.0f, peak, 0.05f) << "ratio = " << ratio;
+    }
+}
+
+TEST(test_resampler, resampler_variable_ratio_ramp) {
+    std::vector<float> input(20000);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = sinf(i * 0.05f);
+    }
+    MultiChannelResampler::Builder builder;
+    builder.setNumTaps(8);
+    VariableRatioResampler resampler(builder, 2.0);
+    EXPECT_EQ(1.0, resampler.getRatio());
+
+    // Glide from 1.0 to 2.0 over 4000 output frames.
+    const int32_t kRampFrames = 4000;
+    const int32_t kRampStart = 1000;
+    std::vector<float> output;
+    runVariableRatio(resampler, input, output, [&](int32_t outputIndex) {
+        if (outputIndex == kRampStart) {
+            resampler.rampRatio(2.0, kRampFrames);
+        }
+    });
+    EXPECT_FALSE(resampler.isRamping());
+    EXPECT_EQ(2.0, resampler.getRatio());
+    // Frames in the ramp use an average ratio of 1.5.
+    const double expectedOutput = kRampStart + kRampFrames
+            + (input.size() - kRampStart - (kRampFrames * 1.5)) / 2.0;
+    EXPECT_NEAR(expectedOutput, output.size(), 3);
+
+    // There should be no sudden jumps in the output.
+    for (size_t i = 20; i < output.size(); i++) {
+        ASSERT_LT(fabsf(output[i] - output[i - 1]), 0.11f) << "index = " << i;
+    }
+}
+
+// process() must follow a ramp the same way as the frame by frame API.
+TEST(test_resampler, resampler_variable_ratio_process) {
+    std::vector<float> input(3000);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = sinf(i * 0.03f);
+    }
+    MultiChannelResampler::Builder builder;
+    builder.setNumTaps(16)->setInputRate(44100)->setOutputRate(48000);
+
+    VariableRatioResampler frameResampler(builder, 1.5);
+    frameResampler.rampRatio(1.5, 500);
+    std::vector<float> expected;
+    runVariableRatio(frameResampler, input, expected, [](int32_t) {});
+    while (!frameResampler.isWriteNeeded()) {
+        float value = 0.0f;
+        frameResampler.readNextFrame(&value);
+        expected.push_back(value);
+    }
+
+    VariableRatioResampler blockResampler(builder, 1.5);
+    blockResampler.rampRatio(1.5, 500);
+    std::vector<float> actual(expected.size() + 64);
+    int inputCursor = 0;
+    int outputCursor = 0;
+    while (inputCursor < static_cast<int>(input.size())) {
+        const int inputFrames = std::min(37, static_cast<int>(input.size()) - inputCursor);
+        MultiChannelResampler::ProcessResult result = blockResampler.process(
+                &input[inputCursor], inputFrames, &actual[outputCursor], 29);
+        inputCursor += result.framesConsumed;
+        outputCursor += result.framesProduced;
+    }
+    // Drain the remaining output.
+    outputCursor += blockResampler.process(nullptr, 0, &actual[outputCursor], 64).framesProduced;
+    ASSERT_EQ(expected.size(), static_cast<size_t>(outputCursor));
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(expected[i], actual[i]) << "index = " << i;
+    }
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Test the binary ring buffer tracer and its JSON export.
+ */
+
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "oboe/Tracer.h"
+
+using namespace oboe;
+
+static int32_t countOccurrences(const std::string &text, const std::string &pattern) {
+    int32_t count = 0;
+    for (size_t position = text.find(pattern); position != std::string::npos;
+            position = text.find(pattern, position + pattern.size())) {
+        count++;
+    }
+    return count;
+}
+
+class TestTracer : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Tracer::setEnabled(false);
+        Tracer::clear();
+    }
+
+    void TearDown() override {
+        Tracer::setEnabled(false);
+        Tracer::clear();
+    }
+};
+
+TEST_F(TestTracer, intern_string) {
+    const uint32_t first = Tracer::internString("tracer test name");
+    const uint32_t second = Tracer::internString("tracer test other name");
+    EXPECT_NE(0u, first);
+    EXPECT_NE(first, second);
+    EXPECT_EQ(first, Tracer::internString("tracer test name"));
+    EXPECT_STREQ("tracer test name", Tracer::getString(first));
+    EXPECT_STREQ("unknown", Tracer::getString(0));
+    EXPECT_STREQ("unknown", Tracer::getString(Tracer::kMaxNames));
+}
+
+TEST_F(TestTracer, disabled_records_nothing) {
+    const uint32_t name = Tracer::internString("tracer test disabled");
+    Tracer::beginSection(name);
+    Tracer::setCounter(name, 3);
+    Tracer::endSection();
+    EXPECT_EQ(0, countOccurrences(Tracer::exportChromeJson(), "\"ph\""));
+}
+
+TEST_F(TestTracer, sections_and_counters) {
+    const uint32_t section = Tracer::internString("tracer \"test\" section");
+    const uint32_t counter = Tracer::internString("tracer test counter");
+    Tracer::setEnabled(true);
+    {
+        ScopedTraceSection scoped(section);
+        Tracer::setCounter(counter, 42);
+    }
+    Tracer::setEnabled(false);
+
+    const std::string json = Tracer::exportChromeJson();
+    EXPECT_EQ(0u, json.find("{\"traceEvents\":["));
+    EXPECT_EQ(1, countOccurrences(json, "\"name\":\"tracer \\\"test\\\" section\""));
+    EXPECT_EQ(1, countOccurrences(json, "\"ph\":\"B\""));
+    EXPECT_EQ(1, countOccurrences(json, "\"ph\":\"E\""));
+    EXPECT_EQ(1, countOccurrences(json, "\"args\":{\"value\":42}"));
+    // The events are in time order.
+    EXPECT_LT(json.find("\"ph\":\"B\""), json.find("\"ph\":\"C\""));
+    EXPECT_LT(json.find("\"ph\":\"C\""), json.find("\"ph\":\"E\""));
+
+    Tracer::clear();
+    EXPECT_EQ(0, countOccurrences(Tracer::exportChromeJson(), "\"ph\""));
+}
+
+TEST_F(TestTracer, ring_keeps_latest_records) {
+    const uint32_t section = Tracer::internString("tracer test long section");
+    const uint32_t counter = Tracer::internString("tracer test counter");
+    Tracer::setEnabled(true);
+    Tracer::beginSection(section);
+    for (int32_t i = 0; i < Tracer::kRecordsPerThread; i++) {
+        Tracer::setCounter(counter, i);
+    }
+    Tracer::endSection();
+    Tracer::setEnabled(false);
+
+    const std::string json = Tracer::exportChromeJson();
+    // The begin was overwritten so the end is dropped too.
+    EXPECT_EQ(0, countOccurrences(json, "\"ph\":\"B\""));
+    EXPECT_EQ(0, countOccurrences(json, "\"ph\":\"E\""));
+    // The oldest record in a full ring could be in the middle of being overwritten
+    // so it is not exported either.
+    EXPECT_EQ(Tracer::kRecordsPerThread - 2, countOccurrences(json, "\"ph\":\"C\""));
+    EXPECT_EQ(0, countOccurrences(json, "\"args\":{\"value\":1}"));
+    EXPECT_EQ(1, countOccurrences(json, "\"args\":{\"value\":2}"));
+}
+
+TEST_F(TestTracer, threads_use_separate_rings) {
+    constexpr int kNumThreads = 4;
+    constexpr int kSectionsPerThread = 200;
+    const uint32_t section = Tracer::internString("tracer test thread section");
+    Tracer::reserveRings(kNumThreads + 1);
+    Tracer::setEnabled(true);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kNumThreads; i++) {
+        threads.emplace_back([section]() {
+            for (int j = 0; j < kSectionsPerThread; j++) {
+                ScopedTraceSection scoped(section);
+            }
+        });
+    }
+    // Exporting while the threads are recording must be safe.
+    Tracer::exportChromeJson();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    Tracer::setEnabled(false);
+
+    const std::string json = Tracer::exportChromeJson();
+    EXPECT_EQ(kNumThreads * kSectionsPerThread, countOccurrences(json, "\"ph\":\"B\""));
+    EXPECT_EQ(kNumThreads * kSectionsPerThread, countOccurrences(json, "\"ph\":\"E\""));
+    std::set<std::string> threadIds;
+    for (size_t position = json.find("\"tid\":"); position != std::string::npos;
+            position = json.find("\"tid\":", position + 1)) {
+        threadIds.insert(json.substr(position, json.find('}', position) - position));
+    }
+    EXPECT_EQ(static_cast<size_t>(kNumThreads), threadIds.size());
+    EXPECT_EQ(0, Tracer::getDroppedEventCount());
+}
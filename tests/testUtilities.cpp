@@ -18,6 +18,8 @@
 #include <oboe/Definitions.h>
 #include <oboe/Utilities.h>
 
+#include "common/DenormalGuard.h"
+
 /**
  * Tests needing to be written:
  *
@@ -38,3 +40,22 @@ TEST_F(UtilityFunctions, ConvertsFloatToSizeOf4Bytes){
     int32_t sizeInBytes = oboe::convertFormatToSizeInBytes(AudioFormat::Float);
     ASSERT_EQ(sizeInBytes, 4);
 }
+
+TEST(DenormalGuard, flushes_and_restores) {
+    if (!DenormalGuard::isSupported()) {
+        GTEST_SKIP() << "subnormals cannot be flushed on this CPU";
+    }
+    volatile float tiny = 1.0e-39f;
+    {
+        DenormalGuard disabled(false);
+        EXPECT_NE(0.0f, tiny * 0.5f);
+        DenormalGuard guard(true);
+        EXPECT_EQ(0.0f, tiny * 0.5f);
+        {
+            DenormalGuard nested(true);
+            EXPECT_EQ(0.0f, tiny * 0.5f);
+        }
+        EXPECT_EQ(0.0f, tiny * 0.5f); // still inside the outer guard
+    }
+    EXPECT_NE(0.0f, tiny * 0.5f);
+}